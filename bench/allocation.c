@@ -0,0 +1,119 @@
+#include "bench.h"
+
+#include <string.h>
+
+#include "runtime/runtime.h"
+#include "runtime/gc.h"
+#include "model/object.h"
+
+/*
+ * Allocation throughput: carve small objects from the nursery with seg_runtime_allocate(), and
+ * compare against malloc() for the same sizes. Objects are touched as they're allocated, so that
+ * neither allocator gets credit for memory it hasn't delivered. The malloc() objects are freed in
+ * batches to keep its heap from growing without bound, and that cost is included; the nursery
+ * reaches a safepoint after each batch, which empties it with a minor collection once it's full.
+ * Nothing is reachable, so the collections copy nothing.
+ */
+
+#define OBJECTS 1000000
+#define BATCH 10000
+
+static const size_t sizes[] = { 16, 32, 64, 128 };
+
+static void *batch[BATCH];
+
+static void run_malloc(size_t size)
+{
+  char label[48];
+  uint64_t sink = 0;
+
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < OBJECTS; i += BATCH) {
+    for (int j = 0; j < BATCH; j++) {
+      batch[j] = malloc(size);
+      if (batch[j] == NULL) {
+        fprintf(stderr, "Unable to allocate.\n");
+        exit(1);
+      }
+      memset(batch[j], 0, sizeof(uint64_t));
+      sink += (uintptr_t) batch[j] & 0xff;
+    }
+    for (int j = 0; j < BATCH; j++) {
+      free(batch[j]);
+    }
+  }
+
+  snprintf(label, sizeof(label), "malloc %zu bytes", size);
+  bench_report(label, bench_now_ns() - start, OBJECTS);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+}
+
+static void run_nursery(size_t size)
+{
+  char label[48];
+  seg_runtime *r;
+  uint64_t sink = 0;
+
+  BENCH_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < OBJECTS; i += BATCH) {
+    for (int j = 0; j < BATCH; j++) {
+      void *p;
+      BENCH_TRY(seg_runtime_allocate(r, SEG_MEMORY_BUFFERS, SEG_ALLOC_YOUNG, size, &p));
+      memset(p, 0, sizeof(uint64_t));
+      sink += (uintptr_t) p & 0xff;
+    }
+    BENCH_TRY(seg_gc_safepoint(gc));
+  }
+
+  snprintf(label, sizeof(label), "nursery %zu bytes", size);
+  bench_report(label, bench_now_ns() - start, OBJECTS);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  seg_delete_runtime(r);
+}
+
+/* Allocate the objects a program would: strings too long to be immediates. */
+static void run_strings(void)
+{
+  seg_runtime *r;
+  seg_object out;
+  uint64_t sink = 0;
+
+  BENCH_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < OBJECTS; i += BATCH) {
+    for (int j = 0; j < BATCH; j++) {
+      BENCH_TRY(seg_cstring(r, "a string that isn't immediate", &out));
+      sink += (uintptr_t) SEG_TOPOINTER(out) & 0xff;
+    }
+    BENCH_TRY(seg_gc_safepoint(gc));
+  }
+  bench_report("seg_string", bench_now_ns() - start, OBJECTS);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  seg_delete_runtime(r);
+}
+
+int main(void)
+{
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    run_malloc(sizes[i]);
+    run_nursery(sizes[i]);
+  }
+  run_strings();
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include "bench.h"
+
+#include "runtime/runtime.h"
+#include "runtime/gc.h"
+#include "runtime/nursery.h"
+#include "model/object.h"
+#include "model/layout.h"
+
+/*
+ * Write barrier overhead: store objects into slots with seg_slot_atput(), which tells the collector
+ * about stores that make an old object refer to a young one, and compare against a bounds-checked
+ * store that skips the barrier. Then measure how the pause of a minor collection grows with the
+ * old generation, when only a few old objects have been written since the last one, and when
+ * every one of them has (which is what each minor collection cost before the barrier existed).
+ */
+
+#define STORES 10000000
+#define SLOTS 1024
+#define DIRTY 100
+#define ROUNDS 20
+
+static const uint64_t heap_sizes[] = { 1000, 10000, 100000, 1000000 };
+
+static void new_array(seg_runtime *r, uint64_t length, seg_object *out)
+{
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  BENCH_TRY(seg_slotted(r, boots->array_class, out));
+  BENCH_TRY(seg_slotted_grow(r, out, length));
+}
+
+/* The store that seg_slot_atput() would make without a barrier. */
+static seg_err raw_atput(seg_object slotted, uint64_t index, seg_object value)
+{
+  seg_object_slotted *casted = (seg_object_slotted*) slotted.pointer;
+
+  if (index >= casted->length) {
+    return SEG_RANGE("Attempt to mutate invalid slot index");
+  }
+
+  casted->slots[index] = value;
+  return SEG_OK;
+}
+
+static void run_raw(const char *label, seg_object array, seg_object value)
+{
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < STORES; i++) {
+    BENCH_TRY(raw_atput(array, i % SLOTS, value));
+  }
+  bench_report(label, bench_now_ns() - start, STORES);
+}
+
+static void run_atput(const char *label, seg_runtime *r, seg_object array, seg_object value)
+{
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 0; i < STORES; i++) {
+    BENCH_TRY(seg_slot_atput(r, array, i % SLOTS, value));
+  }
+  bench_report(label, bench_now_ns() - start, STORES);
+}
+
+static void run_stores(void)
+{
+  seg_runtime *r;
+  BENCH_TRY(seg_new_runtime(&r));
+
+  /* Arrays too large for the nursery are allocated old. */
+  seg_object young_array, old_array, old_string, young_string, integer;
+  new_array(r, SLOTS, &young_array);
+  new_array(r, SEG_NURSERY_MAX_OBJECT / sizeof(seg_object), &old_array);
+  BENCH_TRY(seg_cstring(r, "a string that's promoted", &old_string));
+  BENCH_TRY(seg_gc_push_root(seg_runtime_gc(r), &old_string));
+  BENCH_TRY(seg_gc_collect(seg_runtime_gc(r), SEG_GC_MINOR));
+
+  BENCH_TRY(seg_cstring(r, "a string that stays young", &young_string));
+  BENCH_TRY(seg_integer(r, 42, &integer));
+
+  run_raw("store without barrier", young_array, young_string);
+  run_atput("atput immediate", r, young_array, integer);
+  run_atput("atput young into young", r, young_array, young_string);
+  run_atput("atput young into old", r, old_array, young_string);
+  run_atput("atput old into old", r, old_array, old_string);
+
+  seg_gc_pop_roots(seg_runtime_gc(r), 1);
+  seg_delete_runtime(r);
+}
+
+static void run_pauses(uint64_t objects)
+{
+  char label[48];
+  seg_runtime *r;
+  BENCH_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+
+  /* Fill the old generation with small arrays, all reachable from one large one. */
+  seg_object holder, element, string;
+  new_array(r, objects, &holder);
+  BENCH_TRY(seg_gc_push_root(gc, &holder));
+  for (uint64_t i = 0; i < objects; i++) {
+    new_array(r, 4, &element);
+    BENCH_TRY(seg_slot_atput(r, holder, i, element));
+    BENCH_TRY(seg_gc_safepoint(gc));
+  }
+  BENCH_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  uint64_t dirty = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    for (uint64_t i = 0; i < DIRTY; i++) {
+      BENCH_TRY(seg_slot_at(holder, (i * 7919 + (uint64_t) round) % objects, &element));
+      BENCH_TRY(seg_cstring(r, "a string stored into an old array", &string));
+      BENCH_TRY(seg_slot_atput(r, element, 0, string));
+    }
+
+    uint64_t start = bench_now_ns();
+    BENCH_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+    dirty += bench_now_ns() - start;
+  }
+  snprintf(label, sizeof(label), "minor, %lu old, %d dirty", (unsigned long) objects, DIRTY);
+  bench_report(label, dirty, ROUNDS);
+
+  uint64_t all = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    for (uint64_t i = 0; i < objects; i++) {
+      BENCH_TRY(seg_slot_at(holder, i, &element));
+      BENCH_TRY(seg_gc_write_barrier_bulk(gc, element));
+    }
+
+    uint64_t start = bench_now_ns();
+    BENCH_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+    all += bench_now_ns() - start;
+  }
+  snprintf(label, sizeof(label), "minor, %lu old, all dirty", (unsigned long) objects);
+  bench_report(label, all, ROUNDS);
+
+  seg_gc_pop_roots(gc, 1);
+  seg_delete_runtime(r);
+}
+
+int main(void)
+{
+  run_stores();
+  for (size_t i = 0; i < sizeof(heap_sizes) / sizeof(heap_sizes[0]); i++) {
+    run_pauses(heap_sizes[i]);
+  }
+  return 0;
+}
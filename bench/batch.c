@@ -0,0 +1,153 @@
+#include "bench.h"
+
+#include <stdbool.h>
+
+#include "ds/ptrtable.h"
+#include "ds/plugtable.h"
+
+/*
+ * Compare single-key lookups against batched lookups, which hash a batch of keys and prefetch
+ * their buckets before resolving any of them. Tables are filled with 1K, 1M and 10M word keys,
+ * then probed in a random order so that large tables miss the cache on nearly every lookup.
+ */
+
+#define LOOKUPS 4000000
+#define CALL_SIZE 256
+
+static const size_t sizes[] = { 1000, 1000000, 10000000 };
+
+static uint64_t rng_state = 0x243f6a8885a308d3ull;
+
+static uint64_t next_random(void)
+{
+  /* xorshift64 */
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static bool word_equal(const void *left, const void *right)
+{
+  return *(const uint64_t *) left == *(const uint64_t *) right;
+}
+
+static uint32_t word_hash(const void *key)
+{
+  return seg_hash(SEG_HASH_WIDE, key, sizeof(uint64_t), 0);
+}
+
+static void report(const char *table, size_t size, const char *mode, uint64_t elapsed_ns)
+{
+  char label[64];
+  snprintf(label, sizeof(label), "%-9s %8lu %s", table, (unsigned long) size, mode);
+  bench_report(label, elapsed_ns, LOOKUPS);
+}
+
+static void run_ptrtable(size_t size, uint64_t *keys, const void **probes, void **out)
+{
+  seg_ptrtable *table;
+  uintptr_t sink = 0;
+
+  BENCH_TRY(seg_new_ptrtable(16, sizeof(uint64_t), &table));
+
+  for (size_t i = 0; i < size; i++) {
+    probes[i] = &keys[i];
+  }
+
+  for (size_t i = 0; i < size; i += CALL_SIZE) {
+    size_t count = size - i < CALL_SIZE ? size - i : CALL_SIZE;
+    BENCH_TRY(seg_ptrtable_put_many(table, probes + i, (void **) probes + i, count, out));
+  }
+
+  for (size_t i = 0; i < LOOKUPS; i++) {
+    probes[i] = &keys[next_random() % size];
+  }
+
+  uint64_t start = bench_now_ns();
+  for (size_t i = 0; i < LOOKUPS; i++) {
+    sink += (uintptr_t) seg_ptrtable_get(table, probes[i]);
+  }
+  report("ptrtable", size, "get", bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (size_t i = 0; i < LOOKUPS; i += CALL_SIZE) {
+    seg_ptrtable_get_many(table, probes + i, CALL_SIZE, out);
+    sink += (uintptr_t) out[CALL_SIZE - 1];
+  }
+  report("ptrtable", size, "get_many", bench_now_ns() - start);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  seg_delete_ptrtable(table);
+}
+
+static void run_plugtable(size_t size, uint64_t *keys, const void **probes, void **out)
+{
+  seg_plugtable *table;
+  uintptr_t sink = 0;
+
+  BENCH_TRY(seg_new_plugtable(16, &word_equal, &word_hash, &table));
+
+  for (size_t i = 0; i < size; i++) {
+    probes[i] = &keys[i];
+  }
+
+  for (size_t i = 0; i < size; i += CALL_SIZE) {
+    size_t count = size - i < CALL_SIZE ? size - i : CALL_SIZE;
+    BENCH_TRY(seg_plugtable_put_many(table, probes + i, (void **) probes + i, count, out));
+  }
+
+  for (size_t i = 0; i < LOOKUPS; i++) {
+    probes[i] = &keys[next_random() % size];
+  }
+
+  uint64_t start = bench_now_ns();
+  for (size_t i = 0; i < LOOKUPS; i++) {
+    sink += (uintptr_t) seg_plugtable_get(table, probes[i]);
+  }
+  report("plugtable", size, "get", bench_now_ns() - start);
+
+  start = bench_now_ns();
+  for (size_t i = 0; i < LOOKUPS; i += CALL_SIZE) {
+    seg_plugtable_get_many(table, probes + i, CALL_SIZE, out);
+    sink += (uintptr_t) out[CALL_SIZE - 1];
+  }
+  report("plugtable", size, "get_many", bench_now_ns() - start);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  seg_delete_plugtable(table);
+}
+
+int main(void)
+{
+  size_t largest = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+  size_t probe_count = largest > LOOKUPS ? largest : LOOKUPS;
+
+  uint64_t *keys = malloc(sizeof(uint64_t) * largest);
+  const void **probes = malloc(sizeof(void *) * probe_count);
+  void **out = malloc(sizeof(void *) * CALL_SIZE);
+  if (keys == NULL || probes == NULL || out == NULL) {
+    fprintf(stderr, "Unable to allocate benchmark keys.\n");
+    return 1;
+  }
+
+  for (size_t i = 0; i < largest; i++) {
+    keys[i] = next_random();
+  }
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    run_ptrtable(sizes[s], keys, probes, out);
+    run_plugtable(sizes[s], keys, probes, out);
+  }
+
+  free(keys);
+  free(probes);
+  free(out);
+  return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/* clock_gettime() is POSIX, not C11. This header must be included before any system headers. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "errors.h"
+
+/*
+ * Shared helpers for the microbenchmarks in this directory. Benchmarks are only meaningful when
+ * the core objects were compiled with optimization enabled: build them with `make OPTIMIZE=1`.
+ */
+
+/* Read a monotonic clock in nanoseconds. */
+static inline uint64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/* Abort the benchmark if a segment call fails. */
+#define BENCH_TRY(expr) do { \
+  seg_err bench_err = (expr); \
+  if (bench_err != SEG_OK) { \
+    fprintf(stderr, "%s\n", bench_err->message); \
+    exit(1); \
+  } \
+} while (0)
+
+/* Print one benchmark measurement. */
+static inline void bench_report(const char *label, uint64_t elapsed_ns, uint64_t operations)
+{
+  printf("%-32s %10.2f ns/op\n", label, elapsed_ns / (double) operations);
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include "bench.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define HEAP_IN_USE 1
+#endif
+
+#include "ds/stringtable.h"
+#include "ds/ptrtable.h"
+#include "ds/plugtable.h"
+
+/*
+ * Steady-state churn: hold a fixed number of live keys in each table while replacing one of them
+ * with a never-before-seen key on every iteration. Throughput, capacity, the heap bytes in use
+ * (where glibc can report them) and the process's resident set size are reported at intervals.
+ * Capacity and heap usage should stay flat once the table has warmed up. RSS may creep slightly as
+ * the allocator fragments.
+ */
+
+#define LIVE 10000
+#define ITERATIONS 2000000
+#define INTERVAL 400000
+
+/* Resident set size in KiB, or 0 if it can't be determined on this platform. */
+static uint64_t resident_kb(void)
+{
+  uint64_t pages = 0, resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm == NULL) {
+    return 0;
+  }
+
+  if (fscanf(statm, "%lu %lu", (unsigned long *) &pages, (unsigned long *) &resident) != 2) {
+    resident = 0;
+  }
+  fclose(statm);
+
+  return resident * 4;
+}
+
+/* Heap bytes currently allocated, in KiB, or 0 if the allocator can't say. */
+static uint64_t heap_kb(void)
+{
+#ifdef HEAP_IN_USE
+  return mallinfo2().uordblks / 1024;
+#else
+  return 0;
+#endif
+}
+
+static void report(const char *name, uint64_t i, uint64_t elapsed_ns, uint64_t capacity)
+{
+  printf(
+    "%-12s %8lu ops %8.1f ns/op  capacity %8lu  heap %8lu KiB  rss %8lu KiB\n",
+    name,
+    (unsigned long) i,
+    elapsed_ns / (double) INTERVAL,
+    (unsigned long) capacity,
+    (unsigned long) heap_kb(),
+    (unsigned long) resident_kb()
+  );
+}
+
+static void churn_stringtable(void)
+{
+  static char keys[LIVE][24];
+  seg_stringtable *table;
+  void *out;
+
+  BENCH_TRY(seg_new_stringtable(16, &table));
+
+  for (int i = 0; i < LIVE; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+    BENCH_TRY(seg_stringtable_put(table, keys[i], strlen(keys[i]), keys[i], &out));
+  }
+
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 1; i <= ITERATIONS; i++) {
+    char *key = keys[i % LIVE];
+    BENCH_TRY(seg_stringtable_remove(table, key, strlen(key), &out));
+
+    snprintf(key, sizeof(keys[0]), "key%lu", (unsigned long) (i + LIVE));
+    BENCH_TRY(seg_stringtable_put(table, key, strlen(key), key, &out));
+
+    if (i % INTERVAL == 0) {
+      report("stringtable", i, bench_now_ns() - start, seg_stringtable_capacity(table));
+      start = bench_now_ns();
+    }
+  }
+
+  seg_delete_stringtable(table);
+}
+
+static void churn_ptrtable(void)
+{
+  static uint64_t keys[LIVE];
+  seg_ptrtable *table;
+  void *out;
+
+  BENCH_TRY(seg_new_ptrtable(16, sizeof(uint64_t), &table));
+
+  for (int i = 0; i < LIVE; i++) {
+    keys[i] = i;
+    BENCH_TRY(seg_ptrtable_put(table, &keys[i], &keys[i], &out));
+  }
+
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 1; i <= ITERATIONS; i++) {
+    uint64_t *key = &keys[i % LIVE];
+    BENCH_TRY(seg_ptrtable_remove(table, key, &out));
+
+    *key = i + LIVE;
+    BENCH_TRY(seg_ptrtable_put(table, key, key, &out));
+
+    if (i % INTERVAL == 0) {
+      report("ptrtable", i, bench_now_ns() - start, seg_ptrtable_capacity(table));
+      start = bench_now_ns();
+    }
+  }
+
+  seg_delete_ptrtable(table);
+}
+
+static bool word_equal(const void *left, const void *right)
+{
+  return *(const uint64_t *) left == *(const uint64_t *) right;
+}
+
+static uint32_t word_hash(const void *key)
+{
+  return seg_hash(SEG_HASH_WIDE, key, sizeof(uint64_t), 0);
+}
+
+static void churn_plugtable(void)
+{
+  static uint64_t keys[LIVE];
+  seg_plugtable *table;
+  void *out;
+
+  BENCH_TRY(seg_new_plugtable(16, &word_equal, &word_hash, &table));
+
+  for (int i = 0; i < LIVE; i++) {
+    keys[i] = i;
+    BENCH_TRY(seg_plugtable_put(table, &keys[i], &keys[i], &out));
+  }
+
+  uint64_t start = bench_now_ns();
+  for (uint64_t i = 1; i <= ITERATIONS; i++) {
+    uint64_t *key = &keys[i % LIVE];
+    BENCH_TRY(seg_plugtable_remove(table, key, &out));
+
+    *key = i + LIVE;
+    BENCH_TRY(seg_plugtable_put(table, key, key, &out));
+
+    if (i % INTERVAL == 0) {
+      report("plugtable", i, bench_now_ns() - start, seg_plugtable_capacity(table));
+      start = bench_now_ns();
+    }
+  }
+
+  seg_delete_plugtable(table);
+}
+
+int main(void)
+{
+  printf("%d live keys, one replaced per iteration\n", LIVE);
+  churn_stringtable();
+  churn_ptrtable();
+  churn_plugtable();
+  return 0;
+}
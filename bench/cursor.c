@@ -0,0 +1,177 @@
+#include "bench.h"
+
+#include <string.h>
+
+#include "runtime/runtime.h"
+#include "runtime/symboltable.h"
+#include "ds/stringtable.h"
+#include "ds/ptrtable.h"
+
+/*
+ * Compare callback iteration through `each` against cursor iteration with begin/next/done. Each
+ * table holds a million entries, and each pass visits all of them, so the difference is the cost
+ * of the indirect call per entry against the cost of resuming the walk. The "half" pass stops
+ * halfway through, which `each` can only do by returning an error from its callback.
+ */
+
+#define ENTRIES 1000000
+#define PASSES 10
+
+static uint64_t symbol_sink;
+
+static seg_err count_symbol(seg_object symbol, void *state)
+{
+  (*(uint64_t *) state) += (uintptr_t) SEG_TOPOINTER(symbol) & 0xff;
+  return SEG_OK;
+}
+
+static seg_err count_string(const char *key, const uint64_t key_length, void *value, void *state)
+{
+  (*(uint64_t *) state) += key_length;
+  return SEG_OK;
+}
+
+static seg_err count_word(const void *key, void *value, void *state)
+{
+  (*(uint64_t *) state) += (uintptr_t) value & 0xff;
+  return SEG_OK;
+}
+
+static void run_symboltable(void)
+{
+  char name[32];
+  seg_runtime *r;
+  seg_object out;
+
+  BENCH_TRY(seg_new_runtime(&r));
+  seg_symboltable *table = seg_runtime_symboltable(r);
+
+  for (int i = 0; i < ENTRIES; i++) {
+    snprintf(name, sizeof(name), "iterated_symbol_%d", i);
+    BENCH_TRY(seg_symboltable_cintern(table, name, &out));
+  }
+
+  uint64_t start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    BENCH_TRY(seg_symboltable_each(table, &count_symbol, &symbol_sink));
+  }
+  bench_report("symboltable each", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    seg_hashtable_cursor c;
+    seg_symboltable_begin(table, &c);
+    for (; ! seg_hashtable_done(&c); seg_symboltable_next(table, &c)) {
+      symbol_sink += (uintptr_t) c.value & 0xff;
+    }
+  }
+  bench_report("symboltable cursor", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    uint64_t seen = 0;
+    seg_hashtable_cursor c;
+    seg_symboltable_begin(table, &c);
+    for (; ! seg_hashtable_done(&c); seg_symboltable_next(table, &c)) {
+      if (++seen == ENTRIES / 2) {
+        break;
+      }
+    }
+    symbol_sink += seen;
+  }
+  bench_report("symboltable cursor half", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  seg_delete_runtime(r);
+}
+
+static void run_stringtable(void)
+{
+  char name[32];
+  void *out;
+  seg_stringtable *table;
+  uint64_t sink = 0;
+
+  BENCH_TRY(seg_new_stringtable(16, &table));
+
+  for (int i = 0; i < ENTRIES; i++) {
+    snprintf(name, sizeof(name), "iterated_string_%d", i);
+    BENCH_TRY(seg_stringtable_put(table, name, strlen(name), NULL, &out));
+  }
+
+  uint64_t start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    BENCH_TRY(seg_stringtable_each(table, &count_string, &sink));
+  }
+  bench_report("stringtable each", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    seg_hashtable_cursor c;
+    seg_stringtable_begin(table, &c);
+    for (; ! seg_hashtable_done(&c); seg_stringtable_next(table, &c)) {
+      sink += c.key_length;
+    }
+  }
+  bench_report("stringtable cursor", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  seg_delete_stringtable(table);
+}
+
+static void run_ptrtable(void)
+{
+  void *out;
+  seg_ptrtable *table;
+  uint64_t sink = 0;
+
+  uint64_t *keys = malloc(sizeof(uint64_t) * ENTRIES);
+  if (keys == NULL) {
+    fprintf(stderr, "Unable to allocate benchmark keys.\n");
+    exit(1);
+  }
+
+  BENCH_TRY(seg_new_ptrtable(16, sizeof(uint64_t), &table));
+
+  for (int i = 0; i < ENTRIES; i++) {
+    keys[i] = (uint64_t) i * 2654435761u;
+    BENCH_TRY(seg_ptrtable_put(table, &keys[i], &keys[i], &out));
+  }
+
+  uint64_t start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    BENCH_TRY(seg_ptrtable_each(table, &count_word, &sink));
+  }
+  bench_report("ptrtable each", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    seg_hashtable_cursor c;
+    seg_ptrtable_begin(table, &c);
+    for (; ! seg_hashtable_done(&c); seg_ptrtable_next(table, &c)) {
+      sink += (uintptr_t) c.value & 0xff;
+    }
+  }
+  bench_report("ptrtable cursor", bench_now_ns() - start, (uint64_t) ENTRIES * PASSES);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  seg_delete_ptrtable(table);
+  free(keys);
+}
+
+int main(void)
+{
+  run_symboltable();
+  run_stringtable();
+  run_ptrtable();
+
+  if (symbol_sink == 1) {
+    printf("\n");
+  }
+  return 0;
+}
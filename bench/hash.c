@@ -0,0 +1,61 @@
+#include "bench.h"
+
+#include "ds/hash.h"
+
+/*
+ * Measure the throughput of each hash algorithm across key lengths typical of identifiers (4-32
+ * bytes) and of long string literals. Keys are drawn from a shared buffer at varying offsets, so
+ * that most of them are unaligned, as interned names within source text are.
+ */
+
+#define BUFFER_SIZE 65536
+#define TARGET_BYTES (256ull * 1024 * 1024)
+
+static const size_t lengths[] = { 4, 7, 8, 12, 16, 24, 32, 64, 256, 1024, 4096 };
+
+int main(void)
+{
+  static char buffer[BUFFER_SIZE + 4096];
+  uint64_t state = 0x9e3779b97f4a7c15ull;
+
+  for (size_t i = 0; i < sizeof(buffer); i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    buffer[i] = (char) state;
+  }
+
+  printf("crc32c uses %s\n", seg_hash_crc32c_hardware() ? "sse4.2" : "a lookup table");
+  printf("%-8s %6s %12s %12s\n", "hash", "length", "ns/hash", "MB/s");
+
+  for (int a = SEG_HASH_MURMUR3; a <= SEG_HASH_CRC32C; a++) {
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+      size_t length = lengths[l];
+      uint64_t iterations = TARGET_BYTES / length;
+      if (iterations > 20000000) {
+        iterations = 20000000;
+      }
+
+      uint32_t sink = 0;
+      size_t offset = 0;
+
+      uint64_t start = bench_now_ns();
+      for (uint64_t i = 0; i < iterations; i++) {
+        sink += seg_hash((seg_hash_algorithm) a, buffer + offset, length, (uint32_t) i);
+        offset = (offset + 61) & (BUFFER_SIZE - 1);
+      }
+      uint64_t elapsed = bench_now_ns() - start;
+
+      printf(
+        "%-8s %6zu %12.2f %12.1f%s\n",
+        seg_hash_name((seg_hash_algorithm) a),
+        length,
+        elapsed / (double) iterations,
+        (iterations * length) / (elapsed / 1000.0),
+        sink == 1 ? "!" : ""
+      );
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include "bench.h"
+
+#include "runtime/runtime.h"
+#include "runtime/gc.h"
+#include "model/object.h"
+#include "model/integer.h"
+
+/*
+ * Integer arithmetic: fibonacci and factorial, first within the immediate range, where each
+ * operation should cost little more than the native one it wraps, then far beyond it. fib(78) and
+ * 18! are the largest that stay immediate. Large factorials are computed both by multiplying a
+ * growing product by each factor in turn, and by multiplying balanced halves of the range together,
+ * which is where Karatsuba multiplication pays off.
+ */
+
+#define SMALL_RUNS 1000000
+#define FIB_SMALL 78
+#define FACT_SMALL 18
+
+#define FIB_LARGE 20000
+#define FACT_LARGE 5000
+#define FACT_TREE 50000
+
+static void run_native_small(void)
+{
+  uint64_t sink = 0;
+
+  uint64_t start = bench_now_ns();
+  for (int run = 0; run < SMALL_RUNS; run++) {
+    int64_t a = 0, b = 1 + (sink & 1);
+    for (int i = 1; i < FIB_SMALL; i++) {
+      int64_t next = a + b;
+      a = b;
+      b = next;
+    }
+    sink += (uint64_t) b;
+  }
+  bench_report("int64_t fib(78)", bench_now_ns() - start, (uint64_t) SMALL_RUNS * (FIB_SMALL - 1));
+
+  start = bench_now_ns();
+  for (int run = 0; run < SMALL_RUNS; run++) {
+    int64_t product = 1 + (sink & 1);
+    for (int64_t i = 2; i <= FACT_SMALL; i++) {
+      product *= i;
+    }
+    sink += (uint64_t) product;
+  }
+  bench_report("int64_t 18!", bench_now_ns() - start, (uint64_t) SMALL_RUNS * (FACT_SMALL - 1));
+
+  if (sink == 1) {
+    printf("\n");
+  }
+}
+
+static void run_immediate_small(seg_runtime *r)
+{
+  uint64_t sink = 0;
+  seg_object a, b, next, factor;
+
+  uint64_t start = bench_now_ns();
+  for (int run = 0; run < SMALL_RUNS; run++) {
+    BENCH_TRY(seg_integer(r, 0, &a));
+    BENCH_TRY(seg_integer(r, 1 + (sink & 1), &b));
+    for (int i = 1; i < FIB_SMALL; i++) {
+      BENCH_TRY(seg_integer_add(r, a, b, &next));
+      a = b;
+      b = next;
+    }
+    sink += (uintptr_t) SEG_TOPOINTER(b);
+  }
+  bench_report(
+    "seg_integer fib(78)", bench_now_ns() - start, (uint64_t) SMALL_RUNS * (FIB_SMALL - 1)
+  );
+
+  start = bench_now_ns();
+  for (int run = 0; run < SMALL_RUNS; run++) {
+    BENCH_TRY(seg_integer(r, 1 + (sink & 1), &a));
+    for (int64_t i = 2; i <= FACT_SMALL; i++) {
+      BENCH_TRY(seg_integer(r, i, &factor));
+      BENCH_TRY(seg_integer_mul(r, a, factor, &a));
+    }
+    sink += (uintptr_t) SEG_TOPOINTER(a);
+  }
+  bench_report("seg_integer 18!", bench_now_ns() - start, (uint64_t) SMALL_RUNS * (FACT_SMALL - 1));
+
+  if (sink == 1) {
+    printf("\n");
+  }
+}
+
+static void run_fibonacci_large(seg_runtime *r)
+{
+  seg_gc *gc = seg_runtime_gc(r);
+  seg_object a, b, next;
+
+  BENCH_TRY(seg_integer(r, 0, &a));
+  BENCH_TRY(seg_integer(r, 1, &b));
+  BENCH_TRY(seg_gc_push_root(gc, &a));
+  BENCH_TRY(seg_gc_push_root(gc, &b));
+
+  uint64_t start = bench_now_ns();
+  for (int i = 1; i < FIB_LARGE; i++) {
+    BENCH_TRY(seg_integer_add(r, a, b, &next));
+    a = b;
+    b = next;
+    BENCH_TRY(seg_gc_safepoint(gc));
+  }
+  bench_report("seg_integer fib(20000)", bench_now_ns() - start, FIB_LARGE - 1);
+
+  seg_gc_pop_roots(gc, 2);
+}
+
+static void run_factorial_large(seg_runtime *r)
+{
+  seg_gc *gc = seg_runtime_gc(r);
+  seg_object product, factor;
+
+  BENCH_TRY(seg_integer(r, 1, &product));
+  BENCH_TRY(seg_gc_push_root(gc, &product));
+
+  uint64_t start = bench_now_ns();
+  for (int64_t i = 2; i <= FACT_LARGE; i++) {
+    BENCH_TRY(seg_integer(r, i, &factor));
+    BENCH_TRY(seg_integer_mul(r, product, factor, &product));
+    BENCH_TRY(seg_gc_safepoint(gc));
+  }
+  bench_report("seg_integer 5000!", bench_now_ns() - start, FACT_LARGE - 1);
+
+  seg_gc_pop_roots(gc, 1);
+}
+
+/* The product of every integer from low to high, splitting the range in half. */
+static void product_tree(seg_runtime *r, int64_t low, int64_t high, seg_object *out)
+{
+  if (high - low < 8) {
+    BENCH_TRY(seg_integer(r, low, out));
+    for (int64_t i = low + 1; i <= high; i++) {
+      seg_object factor;
+      BENCH_TRY(seg_integer(r, i, &factor));
+      BENCH_TRY(seg_integer_mul(r, *out, factor, out));
+    }
+    return;
+  }
+
+  // Allocation never collects, so the halves needn't be rooted.
+  seg_object left, right;
+  int64_t middle = low + (high - low) / 2;
+  product_tree(r, low, middle, &left);
+  product_tree(r, middle + 1, high, &right);
+  BENCH_TRY(seg_integer_mul(r, left, right, out));
+}
+
+static void run_factorial_tree(seg_runtime *r)
+{
+  seg_object product;
+
+  uint64_t start = bench_now_ns();
+  product_tree(r, 1, FACT_TREE, &product);
+  bench_report("seg_integer 50000! (tree)", bench_now_ns() - start, 1);
+
+  BENCH_TRY(seg_gc_safepoint(seg_runtime_gc(r)));
+}
+
+int main(void)
+{
+  seg_runtime *r;
+  BENCH_TRY(seg_new_runtime(&r));
+
+  run_native_small();
+
+  seg_memory_usage before, after;
+  seg_runtime_memory(r, &before);
+  run_immediate_small(r);
+  seg_runtime_memory(r, &after);
+  printf("%-32s %10lu\n", "allocations while immediate",
+    (unsigned long) (after.buffers.count - before.buffers.count));
+
+  run_fibonacci_large(r);
+  run_factorial_large(r);
+  run_factorial_tree(r);
+
+  seg_delete_runtime(r);
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include "bench.h"
+
+#include <stdbool.h>
+
+#include "ds/hash.h"
+#include "ds/plugtable.h"
+
+/*
+ * Compare the bucket and ordered plugtable layouts. Small maps model keyword arguments: each map
+ * of 2 to 8 entries is created, filled, probed for every key and iterated, as a call site would.
+ * They're created either at their final size or as small tables that keep their entries inline.
+ * Large maps are filled with a million keys, then probed and iterated. Memory is the table's own
+ * accounting from seg_plugtable_stats.
+ */
+
+#define SMALL_MAPS 200000
+#define LARGE_KEYS 1000000
+#define LARGE_LOOKUPS 4000000
+
+static uint64_t rng_state = 0x243f6a8885a308d3ull;
+
+static uint64_t next_random(void)
+{
+  /* xorshift64 */
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static bool word_equal(const void *left, const void *right)
+{
+  return *(const uint64_t *) left == *(const uint64_t *) right;
+}
+
+static uint32_t word_hash(const void *key)
+{
+  return seg_hash(SEG_HASH_WIDE, key, sizeof(uint64_t), 0);
+}
+
+static seg_err counting_iterator(const void *key, void *value, void *state)
+{
+  (*(uint64_t *) state)++;
+  return SEG_OK;
+}
+
+static const char *layout_name(seg_plugtable_layout layout)
+{
+  return layout == SEG_PLUGTABLE_ORDERED ? "ordered" : "buckets";
+}
+
+static void run_small(seg_plugtable_layout layout, int size, bool small, uint64_t *keys)
+{
+  char label[64];
+  void *out;
+  uint64_t visited = 0;
+  uintptr_t sink = 0;
+  seg_hashtable_stats stats;
+
+  uint64_t start = bench_now_ns();
+  for (int m = 0; m < SMALL_MAPS; m++) {
+    seg_plugtable *table;
+    uint64_t capacity = small ? 0 : size;
+    BENCH_TRY(seg_new_plugtable_layout(capacity, layout, &word_equal, &word_hash, &table));
+
+    for (int i = 0; i < size; i++) {
+      BENCH_TRY(seg_plugtable_put(table, &keys[i], &keys[i], &out));
+    }
+    for (int i = 0; i < size; i++) {
+      sink += (uintptr_t) seg_plugtable_get(table, &keys[i]);
+    }
+    BENCH_TRY(seg_plugtable_each(table, &counting_iterator, &visited));
+
+    if (m == 0) {
+      seg_plugtable_stats(table, &stats);
+    }
+    seg_delete_plugtable(table);
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  snprintf(label, sizeof(label), "%s%s %d entries",
+    layout_name(layout), small ? " inline" : "", size);
+  printf("%-32s %10.2f ns/map %8lu bytes/map\n",
+    label, elapsed / (double) SMALL_MAPS, (unsigned long) stats.bytes);
+
+  if (sink == 1 || visited == 1) {
+    printf("\n");
+  }
+}
+
+static void run_large(seg_plugtable_layout layout, uint64_t *keys, uint64_t *order)
+{
+  char label[64];
+  void *out;
+  uint64_t visited = 0;
+  uintptr_t sink = 0;
+  seg_hashtable_stats stats;
+  seg_plugtable *table;
+
+  BENCH_TRY(seg_new_plugtable_layout(16, layout, &word_equal, &word_hash, &table));
+
+  uint64_t start = bench_now_ns();
+  for (size_t i = 0; i < LARGE_KEYS; i++) {
+    BENCH_TRY(seg_plugtable_put(table, &keys[i], &keys[i], &out));
+  }
+  snprintf(label, sizeof(label), "%s 1M put", layout_name(layout));
+  bench_report(label, bench_now_ns() - start, LARGE_KEYS);
+
+  start = bench_now_ns();
+  for (size_t i = 0; i < LARGE_LOOKUPS; i++) {
+    sink += (uintptr_t) seg_plugtable_get(table, &keys[order[i]]);
+  }
+  snprintf(label, sizeof(label), "%s 1M get", layout_name(layout));
+  bench_report(label, bench_now_ns() - start, LARGE_LOOKUPS);
+
+  start = bench_now_ns();
+  BENCH_TRY(seg_plugtable_each(table, &counting_iterator, &visited));
+  snprintf(label, sizeof(label), "%s 1M each", layout_name(layout));
+  bench_report(label, bench_now_ns() - start, LARGE_KEYS);
+
+  start = bench_now_ns();
+  for (size_t i = 0; i < LARGE_KEYS; i += 2) {
+    BENCH_TRY(seg_plugtable_remove(table, &keys[i], &out));
+  }
+  snprintf(label, sizeof(label), "%s 1M remove half", layout_name(layout));
+  bench_report(label, bench_now_ns() - start, LARGE_KEYS / 2);
+
+  seg_plugtable_stats(table, &stats);
+  printf("%-32s %10lu bytes before compaction\n", layout_name(layout), (unsigned long) stats.bytes);
+
+  start = bench_now_ns();
+  BENCH_TRY(seg_plugtable_compact(table));
+  snprintf(label, sizeof(label), "%s 1M compact", layout_name(layout));
+  bench_report(label, bench_now_ns() - start, LARGE_KEYS / 2);
+
+  if (sink == 1 || visited == 1) {
+    printf("\n");
+  }
+
+  seg_delete_plugtable(table);
+}
+
+int main(void)
+{
+  uint64_t *keys = malloc(sizeof(uint64_t) * LARGE_KEYS);
+  uint64_t *order = malloc(sizeof(uint64_t) * LARGE_LOOKUPS);
+  if (keys == NULL || order == NULL) {
+    fprintf(stderr, "Unable to allocate benchmark keys.\n");
+    return 1;
+  }
+
+  for (size_t i = 0; i < LARGE_KEYS; i++) {
+    keys[i] = next_random();
+  }
+  for (size_t i = 0; i < LARGE_LOOKUPS; i++) {
+    order[i] = next_random() % LARGE_KEYS;
+  }
+
+  for (int size = 2; size <= 8; size += 2) {
+    run_small(SEG_PLUGTABLE_BUCKETS, size, false, keys);
+    run_small(SEG_PLUGTABLE_ORDERED, size, false, keys);
+    run_small(SEG_PLUGTABLE_ORDERED, size, true, keys);
+  }
+
+  run_large(SEG_PLUGTABLE_BUCKETS, keys, order);
+  run_large(SEG_PLUGTABLE_ORDERED, keys, order);
+
+  free(keys);
+  free(order);
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+
+#include "ds/ptrtable.h"
+
+/*
+ * Compare the ptrtable key strategies on 8-byte keys: the generic murmur3 and memcmp path against
+ * the word and identity specializations. Each table is filled with the same keys, then probed for
+ * every key in a shuffled order, for hits, and for keys that are absent.
+ */
+
+#define KEY_COUNT 100000
+#define ROUNDS 20
+
+static uint64_t rng_state = 0x243f6a8885a308d3ull;
+
+static uint64_t next_random(void)
+{
+  /* xorshift64 */
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static void run(const char *name, seg_ptrtable_keys keys, uint64_t *present, uint64_t *absent,
+  size_t *order)
+{
+  char label[64];
+  seg_ptrtable *table;
+  void *out;
+  uintptr_t sink = 0;
+
+  BENCH_TRY(seg_new_ptrtable_keyed(16, sizeof(uint64_t), keys, SEG_HASH_DEFAULT, &table));
+
+  uint64_t start = bench_now_ns();
+  for (size_t i = 0; i < KEY_COUNT; i++) {
+    BENCH_TRY(seg_ptrtable_put(table, &present[i], &present[i], &out));
+  }
+  snprintf(label, sizeof(label), "%s put", name);
+  bench_report(label, bench_now_ns() - start, KEY_COUNT);
+
+  start = bench_now_ns();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+      sink += (uintptr_t) seg_ptrtable_get(table, &present[order[i]]);
+    }
+  }
+  snprintf(label, sizeof(label), "%s get (hit)", name);
+  bench_report(label, bench_now_ns() - start, (uint64_t) KEY_COUNT * ROUNDS);
+
+  start = bench_now_ns();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+      sink += (uintptr_t) seg_ptrtable_get(table, &absent[order[i]]);
+    }
+  }
+  snprintf(label, sizeof(label), "%s get (miss)", name);
+  bench_report(label, bench_now_ns() - start, (uint64_t) KEY_COUNT * ROUNDS);
+
+  if (sink == 1) {
+    /* Keep the lookups from being optimized away. */
+    printf("!\n");
+  }
+
+  seg_delete_ptrtable(table);
+}
+
+int main(void)
+{
+  uint64_t *present = malloc(sizeof(uint64_t) * KEY_COUNT);
+  uint64_t *absent = malloc(sizeof(uint64_t) * KEY_COUNT);
+  size_t *order = malloc(sizeof(size_t) * KEY_COUNT);
+
+  if (present == NULL || absent == NULL || order == NULL) {
+    fprintf(stderr, "Unable to allocate benchmark keys.\n");
+    return 1;
+  }
+
+  for (size_t i = 0; i < KEY_COUNT; i++) {
+    /* Even words are present and odd words are absent, so their contents never collide. */
+    present[i] = next_random() & ~1ull;
+    absent[i] = next_random() | 1ull;
+    order[i] = i;
+  }
+
+  for (size_t i = KEY_COUNT - 1; i > 0; i--) {
+    size_t j = next_random() % (i + 1);
+    size_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+
+  printf("%d keys, %d lookup rounds\n", KEY_COUNT, ROUNDS);
+  run("bytes", SEG_PTRTABLE_KEYS_BYTES, present, absent, order);
+  run("word", SEG_PTRTABLE_KEYS_WORD, present, absent, order);
+  run("identity", SEG_PTRTABLE_KEYS_IDENTITY, present, absent, order);
+
+  free(present);
+  free(absent);
+  free(order);
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include "bench.h"
+
+#include <string.h>
+
+#include "runtime/runtime.h"
+#include "runtime/symboltable.h"
+#include "ds/ptrtable.h"
+
+/*
+ * Symbol IDs: the cost of interning a name and then finding its ID, and of the lookups that a
+ * selector-indexed dispatch table would make. "ptrtable dispatch" finds a value keyed by symbol
+ * identity, as a hashed method cache would; "array dispatch" finds the same value by indexing an
+ * array with the symbol's ID.
+ */
+
+#define NAMES 100000
+#define PASSES 10
+
+static char names[NAMES][24];
+static seg_object symbols[NAMES];
+static uint32_t ids[NAMES];
+
+int main(void)
+{
+  seg_runtime *r;
+  uint64_t sink = 0;
+
+  for (int i = 0; i < NAMES; i++) {
+    snprintf(names[i], sizeof(names[i]), "selector_name_%d", i);
+  }
+
+  BENCH_TRY(seg_new_runtime(&r));
+  seg_symboltable *table = seg_runtime_symboltable(r);
+
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < NAMES; i++) {
+    BENCH_TRY(seg_symboltable_cintern(table, names[i], &symbols[i]));
+    BENCH_TRY(seg_symboltable_id(table, symbols[i], &ids[i]));
+  }
+  bench_report("intern+id cold", bench_now_ns() - start, NAMES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      seg_object sym;
+      uint32_t id;
+      BENCH_TRY(seg_symboltable_cintern(table, names[i], &sym));
+      BENCH_TRY(seg_symboltable_id(table, sym, &id));
+      sink += id;
+    }
+  }
+  bench_report("intern+id warm", bench_now_ns() - start, (uint64_t) NAMES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      uint32_t id;
+      BENCH_TRY(seg_symboltable_id(table, symbols[i], &id));
+      sink += id;
+    }
+  }
+  bench_report("symbol to id", bench_now_ns() - start, (uint64_t) NAMES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      sink += (uintptr_t) SEG_TOPOINTER(seg_symboltable_symbol(table, ids[i])) & 0xff;
+    }
+  }
+  bench_report("id to symbol", bench_now_ns() - start, (uint64_t) NAMES * PASSES);
+
+  seg_object immediate;
+  BENCH_TRY(seg_symboltable_cintern(table, "size", &immediate));
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      uint32_t id;
+      BENCH_TRY(seg_symboltable_id(table, immediate, &id));
+      sink += id;
+    }
+  }
+  bench_report("immediate to id", bench_now_ns() - start, (uint64_t) NAMES * PASSES);
+
+  /* Compare a dispatch table keyed by symbol identity against one indexed by symbol ID. */
+  seg_ptrtable *methods;
+  void *previous;
+  BENCH_TRY(seg_new_ptrtable_keyed(
+    16, 0, SEG_PTRTABLE_KEYS_IDENTITY, SEG_HASH_DEFAULT, &methods
+  ));
+
+  uint32_t limit = seg_symboltable_id_limit(table);
+  void **slots = calloc(limit, sizeof(void *));
+  if (slots == NULL) {
+    fprintf(stderr, "Unable to allocate dispatch array.\n");
+    exit(1);
+  }
+
+  for (int i = 0; i < NAMES; i++) {
+    BENCH_TRY(seg_ptrtable_put(methods, SEG_TOPOINTER(symbols[i]), &names[i], &previous));
+    slots[ids[i]] = &names[i];
+  }
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      sink += (uintptr_t) seg_ptrtable_get(methods, SEG_TOPOINTER(symbols[i])) & 0xff;
+    }
+  }
+  bench_report("ptrtable dispatch", bench_now_ns() - start, (uint64_t) NAMES * PASSES);
+
+  start = bench_now_ns();
+  for (int pass = 0; pass < PASSES; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      uint32_t id;
+      BENCH_TRY(seg_symboltable_id(table, symbols[i], &id));
+      sink += (uintptr_t) slots[id] & 0xff;
+    }
+  }
+  bench_report("array dispatch", bench_now_ns() - start, (uint64_t) NAMES * PASSES);
+
+  if (sink == 1) {
+    printf("\n");
+  }
+
+  free(slots);
+  seg_delete_ptrtable(methods);
+  seg_delete_runtime(r);
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "bench.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "runtime/runtime.h"
+#include "runtime/symboltable.h"
+
+/*
+ * Symbol images: the cost of starting a runtime that needs a given set of symbols, either by
+ * interning each of them or by mapping an image that was written by an earlier run. "rebuild"
+ * creates a runtime and interns every name; "load" creates a runtime and loads the image; "load
+ * + lookup" also finds every name, touching each imaged symbol once.
+ */
+
+#define MAX_NAMES 1000000
+
+static char names[MAX_NAMES][24];
+
+static void run(int count, const char *path)
+{
+  char label[64];
+  seg_runtime *r;
+  seg_object out;
+
+  uint64_t start = bench_now_ns();
+  BENCH_TRY(seg_new_runtime(&r));
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  for (int i = 0; i < count; i++) {
+    BENCH_TRY(seg_symboltable_cintern(table, names[i], &out));
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+  snprintf(label, sizeof(label), "rebuild %d", count);
+  bench_report(label, elapsed, count);
+
+  BENCH_TRY(seg_symboltable_write_image(table, path));
+  seg_delete_runtime(r);
+
+  start = bench_now_ns();
+  BENCH_TRY(seg_new_runtime(&r));
+  BENCH_TRY(seg_symboltable_load_image(seg_runtime_symboltable(r), path));
+  elapsed = bench_now_ns() - start;
+  snprintf(label, sizeof(label), "load %d", count);
+  bench_report(label, elapsed, count);
+  seg_delete_runtime(r);
+
+  start = bench_now_ns();
+  BENCH_TRY(seg_new_runtime(&r));
+  table = seg_runtime_symboltable(r);
+  BENCH_TRY(seg_symboltable_load_image(table, path));
+  for (int i = 0; i < count; i++) {
+    BENCH_TRY(seg_symboltable_cintern(table, names[i], &out));
+  }
+  elapsed = bench_now_ns() - start;
+  snprintf(label, sizeof(label), "load + lookup %d", count);
+  bench_report(label, elapsed, count);
+  seg_delete_runtime(r);
+}
+
+int main(void)
+{
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/segment-bench-%d.img", (int) getpid());
+
+  for (int i = 0; i < MAX_NAMES; i++) {
+    snprintf(names[i], sizeof(names[i]), "startup_symbol_%d", i);
+  }
+
+  for (int count = 1000; count <= MAX_NAMES; count *= 10) {
+    run(count, path);
+  }
+
+  remove(path);
+  return 0;
+}
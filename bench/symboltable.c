@@ -0,0 +1,100 @@
+#include "bench.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "runtime/runtime.h"
+#include "runtime/symboltable.h"
+
+/*
+ * Symboltable scaling: every thread interns the same set of names, each starting at a different
+ * offset, as parallel parsers of related source files would. "cold" rounds start from an empty
+ * table, so threads race to create each symbol; "warm" rounds intern names that already exist.
+ * Throughput is reported as total interns per second across all threads.
+ */
+
+#define NAMES 100000
+#define WARM_PASSES 10
+#define MAX_THREADS 16
+
+static char names[NAMES][24];
+
+typedef struct {
+  seg_symboltable *table;
+  int offset;
+  int passes;
+} worker_state;
+
+static void *worker(void *arg)
+{
+  worker_state *state = arg;
+  seg_object out;
+
+  for (int pass = 0; pass < state->passes; pass++) {
+    for (int i = 0; i < NAMES; i++) {
+      const char *name = names[(i + state->offset) % NAMES];
+      BENCH_TRY(seg_symboltable_cintern(state->table, name, &out));
+    }
+  }
+
+  return NULL;
+}
+
+static uint64_t run(seg_symboltable *table, int thread_count, int passes)
+{
+  pthread_t threads[MAX_THREADS];
+  worker_state states[MAX_THREADS];
+
+  uint64_t start = bench_now_ns();
+  for (int t = 0; t < thread_count; t++) {
+    states[t].table = table;
+    states[t].offset = t * (NAMES / thread_count);
+    states[t].passes = passes;
+    pthread_create(&threads[t], NULL, worker, &states[t]);
+  }
+
+  for (int t = 0; t < thread_count; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  return bench_now_ns() - start;
+}
+
+static void report(const char *phase, int thread_count, uint64_t elapsed_ns, uint64_t operations)
+{
+  printf(
+    "%-5s %2d threads %10.2f Mops/s %8.2f ns/op\n",
+    phase,
+    thread_count,
+    operations / (elapsed_ns / 1000.0),
+    elapsed_ns / (double) operations * thread_count
+  );
+}
+
+int main(void)
+{
+  for (int i = 0; i < NAMES; i++) {
+    snprintf(names[i], sizeof(names[i]), "symbol_name_%d", i);
+  }
+
+  for (int thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2) {
+    seg_runtime *r;
+    BENCH_TRY(seg_new_runtime(&r));
+    seg_symboltable *table = seg_runtime_symboltable(r);
+
+    uint64_t cold = run(table, thread_count, 1);
+    report("cold", thread_count, cold, (uint64_t) NAMES * thread_count);
+
+    uint64_t warm = run(table, thread_count, WARM_PASSES);
+    report("warm", thread_count, warm, (uint64_t) NAMES * WARM_PASSES * thread_count);
+
+    if (seg_symboltable_count(table) < NAMES) {
+      fprintf(stderr, "Expected at least %d symbols.\n", NAMES);
+      return 1;
+    }
+
+    seg_delete_runtime(r);
+  }
+
+  return 0;
+}
@@ -0,0 +1,637 @@
+#include "bench.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "ds/hash.h"
+#include "ds/stringtable.h"
+#include "ds/ptrtable.h"
+#include "ds/plugtable.h"
+
+/*
+ * Harness for the hashtables that the runtime is built on. Each of stringtable, ptrtable and
+ * plugtable is measured for insert, hit, miss, iterate and resize, under three key distributions:
+ *
+ *   uniform - random keys, each accessed once, in random order.
+ *   zipf    - the same keys, accessed with Zipfian (s = 1) frequency, so a few keys are very hot.
+ *   ident   - short identifiers with shared prefixes, like "get_name" or "set_value_3", in random
+ *             order. Ptrtables are keyed by the address of each identifier, as identity tables
+ *             keyed by symbol are.
+ *
+ * Every measurement is taken `--repeat` times after `--warmup` discarded runs, and is reported as
+ * percentiles of ns per operation. `--json` writes the results in a form that `--baseline` reads
+ * back, to compare a build against a saved run:
+ *
+ *   make bench-save OPTIMIZE=1      # on the old build
+ *   make bench OPTIMIZE=1           # on the new one; exits nonzero if a p50 regressed
+ */
+
+#define DEFAULT_SIZE 100000
+#define DEFAULT_REPEAT 20
+#define DEFAULT_WARMUP 3
+#define DEFAULT_THRESHOLD 10.0
+
+#define MAX_NAME 64
+#define MAX_BASELINES 256
+#define KEY_BUFFER 32
+
+typedef enum { DIST_UNIFORM, DIST_ZIPF, DIST_IDENT, DIST_COUNT } key_dist;
+static const char *dist_names[] = { "uniform", "zipf", "ident" };
+
+typedef enum { OP_INSERT, OP_HIT, OP_MISS, OP_ITERATE, OP_RESIZE, OP_COUNT } table_op;
+static const char *op_names[] = { "insert", "hit", "miss", "iterate", "resize" };
+
+/*
+ * The keys of one distribution. Present keys are inserted and then found; absent keys are never
+ * inserted. `stream` lists present key indices in the order in which they're inserted and found.
+ */
+typedef struct {
+  size_t count;
+
+  char (*strings)[KEY_BUFFER];
+  size_t *lengths;
+  uint64_t *words;
+
+  char (*absent_strings)[KEY_BUFFER];
+  size_t *absent_lengths;
+  uint64_t *absent_words;
+
+  size_t *stream;
+} key_set;
+
+/*
+ * One table implementation. Each function runs a whole pass over the key set, so that the
+ * indirect call is paid once per measurement rather than once per operation.
+ */
+typedef struct {
+  const char *name;
+  void *(*fill)(key_set *keys);
+  uint64_t (*hit)(void *table, key_set *keys);
+  uint64_t (*miss)(void *table, key_set *keys);
+  uint64_t (*iterate)(void *table);
+  void (*resize)(void *table);
+  void (*delete)(void *table);
+} table_kind;
+
+typedef struct {
+  char name[MAX_NAME];
+  double p50;
+} baseline;
+
+static uint64_t rng_state = 0x243f6a8885a308d3ull;
+
+static uint64_t next_random(void)
+{
+  /* xorshift64 */
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static void *bench_alloc(size_t size)
+{
+  void *p = malloc(size);
+  if (p == NULL) {
+    fprintf(stderr, "Unable to allocate benchmark keys.\n");
+    exit(1);
+  }
+  return p;
+}
+
+static void shuffle(size_t *order, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    order[i] = i;
+  }
+  for (size_t i = count - 1; i > 0; i--) {
+    size_t j = next_random() % (i + 1);
+    size_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+}
+
+/* Build a Zipfian access stream: rank k is drawn with probability proportional to 1 / k. */
+static void zipf_stream(size_t *stream, size_t count)
+{
+  double *cdf = bench_alloc(sizeof(double) * count);
+  size_t *rank_to_key = bench_alloc(sizeof(size_t) * count);
+
+  double total = 0;
+  for (size_t k = 0; k < count; k++) {
+    total += 1.0 / (double) (k + 1);
+    cdf[k] = total;
+  }
+
+  /* Scatter the hot ranks through the key set, so that they aren't also the first inserted. */
+  shuffle(rank_to_key, count);
+
+  for (size_t i = 0; i < count; i++) {
+    double u = (next_random() >> 11) * (1.0 / 9007199254740992.0) * total;
+    size_t low = 0, high = count - 1;
+    while (low < high) {
+      size_t middle = (low + high) / 2;
+      if (cdf[middle] < u) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    stream[i] = rank_to_key[low];
+  }
+
+  free(rank_to_key);
+  free(cdf);
+}
+
+static const char *verbs[] = { "get", "set", "is", "has", "on", "to", "with", "as" };
+static const char *nouns[] = {
+  "name", "value", "index", "count", "child", "parent", "buffer", "length",
+  "key", "size", "first", "last", "next", "class", "method", "block"
+};
+
+static size_t identifier(char *out, size_t i, bool absent)
+{
+  const char *verb = verbs[i % 8];
+  const char *noun = nouns[(i / 8) % 16];
+  size_t serial = i / 128;
+  int written;
+
+  /* Absent identifiers are capitalized, so they share lengths and suffixes with present ones. */
+  if (serial == 0) {
+    written = snprintf(out, KEY_BUFFER, "%s_%s", verb, noun);
+  } else {
+    written = snprintf(out, KEY_BUFFER, "%s_%s_%zu", verb, noun, serial);
+  }
+  if (absent) {
+    out[0] -= 'a' - 'A';
+  }
+  return (size_t) written;
+}
+
+static void build_keys(key_set *keys, key_dist dist, size_t count)
+{
+  keys->count = count;
+  keys->strings = bench_alloc(sizeof(*keys->strings) * count);
+  keys->lengths = bench_alloc(sizeof(size_t) * count);
+  keys->words = bench_alloc(sizeof(uint64_t) * count);
+  keys->absent_strings = bench_alloc(sizeof(*keys->absent_strings) * count);
+  keys->absent_lengths = bench_alloc(sizeof(size_t) * count);
+  keys->absent_words = bench_alloc(sizeof(uint64_t) * count);
+  keys->stream = bench_alloc(sizeof(size_t) * count);
+
+  for (size_t i = 0; i < count; i++) {
+    if (dist == DIST_IDENT) {
+      keys->lengths[i] = identifier(keys->strings[i], i, false);
+      keys->absent_lengths[i] = identifier(keys->absent_strings[i], i, true);
+      keys->words[i] = (uintptr_t) keys->strings[i];
+      keys->absent_words[i] = (uintptr_t) keys->absent_strings[i];
+    } else {
+      keys->words[i] = next_random();
+      keys->absent_words[i] = next_random();
+      keys->lengths[i] = (size_t) snprintf(
+        keys->strings[i], KEY_BUFFER, "%016llx", (unsigned long long) keys->words[i]
+      );
+      keys->absent_lengths[i] = (size_t) snprintf(
+        keys->absent_strings[i], KEY_BUFFER, "%016llx", (unsigned long long) keys->absent_words[i]
+      );
+    }
+  }
+
+  if (dist == DIST_ZIPF) {
+    zipf_stream(keys->stream, count);
+  } else {
+    shuffle(keys->stream, count);
+  }
+}
+
+static void delete_keys(key_set *keys)
+{
+  free(keys->strings);
+  free(keys->lengths);
+  free(keys->words);
+  free(keys->absent_strings);
+  free(keys->absent_lengths);
+  free(keys->absent_words);
+  free(keys->stream);
+}
+
+/* stringtable */
+
+static void *stringtable_fill(key_set *keys)
+{
+  seg_stringtable *table;
+  void *out;
+
+  BENCH_TRY(seg_new_stringtable(16, &table));
+  for (size_t i = 0; i < keys->count; i++) {
+    size_t k = keys->stream[i];
+    BENCH_TRY(seg_stringtable_put(
+      table, keys->strings[k], keys->lengths[k], &keys->words[k], &out
+    ));
+  }
+  return table;
+}
+
+static uint64_t stringtable_hit(void *table, key_set *keys)
+{
+  uint64_t sink = 0;
+  for (size_t i = 0; i < keys->count; i++) {
+    size_t k = keys->stream[i];
+    sink += (uintptr_t) seg_stringtable_get(table, keys->strings[k], keys->lengths[k]);
+  }
+  return sink;
+}
+
+static uint64_t stringtable_miss(void *table, key_set *keys)
+{
+  uint64_t sink = 0;
+  for (size_t i = 0; i < keys->count; i++) {
+    sink += (uintptr_t) seg_stringtable_get(
+      table, keys->absent_strings[i], keys->absent_lengths[i]
+    );
+  }
+  return sink;
+}
+
+static uint64_t stringtable_iterate(void *table)
+{
+  uint64_t sink = 0;
+  seg_hashtable_cursor c;
+  seg_stringtable_begin(table, &c);
+  for (; ! seg_hashtable_done(&c); seg_stringtable_next(table, &c)) {
+    sink += (uintptr_t) c.value;
+  }
+  return sink;
+}
+
+static void stringtable_resize(void *table)
+{
+  BENCH_TRY(seg_stringtable_resize(table, seg_stringtable_capacity(table) * 2));
+}
+
+static void stringtable_delete(void *table)
+{
+  seg_delete_stringtable(table);
+}
+
+/* ptrtable */
+
+static void *ptrtable_fill(key_set *keys)
+{
+  seg_ptrtable *table;
+  void *out;
+
+  BENCH_TRY(seg_new_ptrtable_keyed(
+    16, sizeof(uint64_t), SEG_PTRTABLE_KEYS_WORD, SEG_HASH_DEFAULT, &table
+  ));
+  for (size_t i = 0; i < keys->count; i++) {
+    size_t k = keys->stream[i];
+    BENCH_TRY(seg_ptrtable_put(table, &keys->words[k], &keys->words[k], &out));
+  }
+  return table;
+}
+
+static uint64_t ptrtable_hit(void *table, key_set *keys)
+{
+  uint64_t sink = 0;
+  for (size_t i = 0; i < keys->count; i++) {
+    sink += (uintptr_t) seg_ptrtable_get(table, &keys->words[keys->stream[i]]);
+  }
+  return sink;
+}
+
+static uint64_t ptrtable_miss(void *table, key_set *keys)
+{
+  uint64_t sink = 0;
+  for (size_t i = 0; i < keys->count; i++) {
+    sink += (uintptr_t) seg_ptrtable_get(table, &keys->absent_words[i]);
+  }
+  return sink;
+}
+
+static uint64_t ptrtable_iterate(void *table)
+{
+  uint64_t sink = 0;
+  seg_hashtable_cursor c;
+  for (seg_ptrtable_begin(table, &c); ! seg_hashtable_done(&c); seg_ptrtable_next(table, &c)) {
+    sink += (uintptr_t) c.value;
+  }
+  return sink;
+}
+
+static void ptrtable_resize(void *table)
+{
+  BENCH_TRY(seg_ptrtable_resize(table, seg_ptrtable_capacity(table) * 2));
+}
+
+static void ptrtable_delete(void *table)
+{
+  seg_delete_ptrtable(table);
+}
+
+/* plugtable, keyed by NUL-terminated strings */
+
+static bool plug_equal(const void *left, const void *right)
+{
+  return ! strcmp(left, right);
+}
+
+static uint32_t plug_hash(const void *key)
+{
+  return seg_hash(SEG_HASH_DEFAULT, key, strlen(key), 0);
+}
+
+static void *plugtable_fill(key_set *keys)
+{
+  seg_plugtable *table;
+  void *out;
+
+  BENCH_TRY(seg_new_plugtable(16, &plug_equal, &plug_hash, &table));
+  for (size_t i = 0; i < keys->count; i++) {
+    size_t k = keys->stream[i];
+    BENCH_TRY(seg_plugtable_put(table, keys->strings[k], &keys->words[k], &out));
+  }
+  return table;
+}
+
+static uint64_t plugtable_hit(void *table, key_set *keys)
+{
+  uint64_t sink = 0;
+  for (size_t i = 0; i < keys->count; i++) {
+    sink += (uintptr_t) seg_plugtable_get(table, keys->strings[keys->stream[i]]);
+  }
+  return sink;
+}
+
+static uint64_t plugtable_miss(void *table, key_set *keys)
+{
+  uint64_t sink = 0;
+  for (size_t i = 0; i < keys->count; i++) {
+    sink += (uintptr_t) seg_plugtable_get(table, keys->absent_strings[i]);
+  }
+  return sink;
+}
+
+static uint64_t plugtable_iterate(void *table)
+{
+  uint64_t sink = 0;
+  seg_hashtable_cursor c;
+  for (seg_plugtable_begin(table, &c); ! seg_hashtable_done(&c); seg_plugtable_next(table, &c)) {
+    sink += (uintptr_t) c.value;
+  }
+  return sink;
+}
+
+static void plugtable_resize(void *table)
+{
+  BENCH_TRY(seg_plugtable_resize(table, seg_plugtable_capacity(table) * 2));
+}
+
+static void plugtable_delete(void *table)
+{
+  seg_delete_plugtable(table);
+}
+
+static const table_kind kinds[] = {
+  {
+    "stringtable", &stringtable_fill, &stringtable_hit, &stringtable_miss, &stringtable_iterate,
+    &stringtable_resize, &stringtable_delete
+  },
+  {
+    "ptrtable", &ptrtable_fill, &ptrtable_hit, &ptrtable_miss, &ptrtable_iterate,
+    &ptrtable_resize, &ptrtable_delete
+  },
+  {
+    "plugtable", &plugtable_fill, &plugtable_hit, &plugtable_miss, &plugtable_iterate,
+    &plugtable_resize, &plugtable_delete
+  }
+};
+
+/* Kept global, so that the compiler can't discard the lookups that feed it. */
+static uint64_t result_sink;
+
+/*
+ * Time one pass of `op`. Tables that an operation consumes, insert and resize, are built and
+ * discarded outside of the timed region; the others share `filled`.
+ */
+static uint64_t measure(const table_kind *kind, table_op op, key_set *keys, void *filled)
+{
+  uint64_t start, elapsed;
+  void *table;
+
+  switch (op) {
+    case OP_INSERT:
+      start = bench_now_ns();
+      table = kind->fill(keys);
+      elapsed = bench_now_ns() - start;
+      kind->delete(table);
+      return elapsed;
+    case OP_HIT:
+      start = bench_now_ns();
+      result_sink += kind->hit(filled, keys);
+      return bench_now_ns() - start;
+    case OP_MISS:
+      start = bench_now_ns();
+      result_sink += kind->miss(filled, keys);
+      return bench_now_ns() - start;
+    case OP_ITERATE:
+      start = bench_now_ns();
+      result_sink += kind->iterate(filled);
+      return bench_now_ns() - start;
+    case OP_RESIZE:
+      table = kind->fill(keys);
+      start = bench_now_ns();
+      kind->resize(table);
+      elapsed = bench_now_ns() - start;
+      kind->delete(table);
+      return elapsed;
+    default:
+      return 0;
+  }
+}
+
+static int compare_doubles(const void *left, const void *right)
+{
+  double l = *(const double *) left, r = *(const double *) right;
+  return (l > r) - (l < r);
+}
+
+/* Nearest-rank percentile of sorted samples. */
+static double percentile(const double *sorted, int count, int p)
+{
+  int rank = (p * count + 99) / 100;
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static int load_baselines(const char *path, baseline *out)
+{
+  char line[256];
+  int count = 0;
+
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Unable to open baseline <%s>.\n", path);
+    exit(1);
+  }
+
+  /* Each result is on its own line, as written by --json. */
+  while (fgets(line, sizeof(line), file) != NULL && count < MAX_BASELINES) {
+    double min;
+    if (sscanf(line, " { \"name\": \"%63[^\"]\", \"min\": %lf, \"p50\": %lf",
+        out[count].name, &min, &out[count].p50) == 3) {
+      count++;
+    }
+  }
+
+  fclose(file);
+  return count;
+}
+
+static void usage(const char *progname)
+{
+  fprintf(stderr,
+    "Usage: %s [--json] [--baseline FILE] [--threshold PERCENT] [--only SUBSTRING]\n"
+    "          [--size N] [--repeat N] [--warmup N]\n", progname);
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  bool json = false;
+  const char *baseline_path = NULL;
+  const char *only = NULL;
+  double threshold = DEFAULT_THRESHOLD;
+  size_t size = DEFAULT_SIZE;
+  int repeat = DEFAULT_REPEAT;
+  int warmup = DEFAULT_WARMUP;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+
+    if (! strcmp(argv[i], "--json")) {
+      json = true;
+    } else if (! strcmp(argv[i], "--baseline") && has_value) {
+      baseline_path = argv[++i];
+    } else if (! strcmp(argv[i], "--threshold") && has_value) {
+      threshold = atof(argv[++i]);
+    } else if (! strcmp(argv[i], "--only") && has_value) {
+      only = argv[++i];
+    } else if (! strcmp(argv[i], "--size") && has_value) {
+      size = (size_t) strtoull(argv[++i], NULL, 10);
+    } else if (! strcmp(argv[i], "--repeat") && has_value) {
+      repeat = atoi(argv[++i]);
+    } else if (! strcmp(argv[i], "--warmup") && has_value) {
+      warmup = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  if (size < 2 || repeat < 1 || warmup < 0) {
+    usage(argv[0]);
+  }
+
+  baseline baselines[MAX_BASELINES];
+  int baseline_count = baseline_path != NULL ? load_baselines(baseline_path, baselines) : 0;
+  int regressions = 0;
+  bool first = true;
+
+  double *samples = bench_alloc(sizeof(double) * repeat);
+
+  if (json) {
+    printf(
+      "{\"size\": %zu, \"repeat\": %d, \"warmup\": %d, \"results\": [\n", size, repeat, warmup
+    );
+  } else {
+    printf("%-32s %10s %10s %10s %10s", "ns/op", "min", "p50", "p90", "p99");
+    printf(baseline_path != NULL ? " %10s\n" : "\n", "vs p50");
+  }
+
+  for (int d = 0; d < DIST_COUNT; d++) {
+    key_set keys;
+    build_keys(&keys, (key_dist) d, size);
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+      const table_kind *kind = &kinds[k];
+      void *filled = kind->fill(&keys);
+
+      for (int op = 0; op < OP_COUNT; op++) {
+        char name[MAX_NAME];
+        snprintf(name, sizeof(name), "%s/%s/%s", kind->name, dist_names[d], op_names[op]);
+        if (only != NULL && strstr(name, only) == NULL) {
+          continue;
+        }
+
+        for (int i = 0; i < warmup; i++) {
+          measure(kind, (table_op) op, &keys, filled);
+        }
+        for (int i = 0; i < repeat; i++) {
+          samples[i] = measure(kind, (table_op) op, &keys, filled) / (double) size;
+        }
+        qsort(samples, repeat, sizeof(double), &compare_doubles);
+
+        double p50 = percentile(samples, repeat, 50);
+        double p90 = percentile(samples, repeat, 90);
+        double p99 = percentile(samples, repeat, 99);
+
+        if (json) {
+          printf(
+            "%s  {\"name\": \"%s\", \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f}",
+            first ? "" : ",\n", name, samples[0], p50, p90, p99
+          );
+          first = false;
+        } else {
+          printf("%-32s %10.2f %10.2f %10.2f %10.2f", name, samples[0], p50, p90, p99);
+        }
+
+        if (baseline_path != NULL) {
+          const baseline *match = NULL;
+          for (int b = 0; b < baseline_count; b++) {
+            if (! strcmp(baselines[b].name, name)) {
+              match = &baselines[b];
+            }
+          }
+
+          if (match == NULL) {
+            if (! json) {
+              printf(" %10s\n", "new");
+            }
+          } else {
+            double change = (p50 / match->p50 - 1.0) * 100.0;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            if (! json) {
+              printf(" %+9.1f%%%s\n", change, regressed ? "  REGRESSED" : "");
+            }
+          }
+        } else if (! json) {
+          printf("\n");
+        }
+      }
+
+      kind->delete(filled);
+    }
+
+    delete_keys(&keys);
+  }
+
+  if (json) {
+    printf("\n]}\n");
+  }
+
+  if (result_sink == 1) {
+    printf("\n");
+  }
+
+  free(samples);
+
+  if (regressions > 0) {
+    fprintf(
+      stderr, "%d benchmarks regressed by more than %.1f%% at p50.\n", regressions, threshold
+    );
+    return 1;
+  }
+  return 0;
+}
@@ -7,6 +7,7 @@
 
 struct seg_ast_visitor {
   seg_integer_handler visit_integer;
+  seg_float_handler visit_float;
   seg_string_handler visit_string;
   seg_symbol_handler visit_symbol;
 
@@ -26,6 +27,7 @@ seg_ast_visitor seg_new_ast_visitor()
   seg_ast_visitor visitor = malloc(sizeof(struct seg_ast_visitor));
 
   visitor->visit_integer = (seg_integer_handler) &visit_null;
+  visitor->visit_float = (seg_float_handler) &visit_null;
   visitor->visit_string = (seg_string_handler) &visit_null;
   visitor->visit_symbol = (seg_symbol_handler) &visit_null;
 
@@ -45,6 +47,11 @@ void seg_ast_visit_integer(seg_ast_visitor visitor, seg_integer_handler visit)
   visitor->visit_integer = visit;
 }
 
+void seg_ast_visit_float(seg_ast_visitor visitor, seg_float_handler visit)
+{
+  visitor->visit_float = visit;
+}
+
 void seg_ast_visit_string(seg_ast_visitor visitor, seg_string_handler visit)
 {
   visitor->visit_string = visit;
@@ -104,6 +111,9 @@ static void visit_expr(seg_expr_node *root, seg_ast_visitor visitor, void *state
   case SEG_INTEGER:
     (*(visitor->visit_integer))(&(root->child.integer), state);
     break;
+  case SEG_FLOAT:
+    (*(visitor->visit_float))(&(root->child.floating), state);
+    break;
   case SEG_STRING:
     (*(visitor->visit_string))(&(root->child.string), state);
     break;
@@ -143,3 +153,74 @@ void seg_delete_ast_visitor(seg_ast_visitor visitor)
 {
   free(visitor);
 }
+
+/* Memory */
+
+typedef struct {
+  uint64_t nodes;
+  uint64_t bytes;
+} memory_state;
+
+static void add_expr(memory_state *state)
+{
+  state->nodes++;
+  state->bytes += sizeof(seg_expr_node);
+}
+
+static void measure_leaf(void *node, void *state)
+{
+  add_expr(state);
+}
+
+static void measure_string(seg_string_node *node, void *state)
+{
+  add_expr(state);
+  ((memory_state *) state)->bytes += node->length;
+}
+
+static void measure_methodcall(seg_methodcall_node *node, void *state)
+{
+  memory_state *m = state;
+  add_expr(m);
+
+  for (seg_arg_list *arg = node->args; arg != NULL; arg = arg->next) {
+    m->nodes++;
+    m->bytes += sizeof(seg_arg_list);
+  }
+}
+
+static void measure_block(seg_block_node *node, void *state)
+{
+  memory_state *m = state;
+  add_expr(m);
+
+  for (seg_parameter_list *param = node->parameters; param != NULL; param = param->next) {
+    m->nodes++;
+    m->bytes += sizeof(seg_parameter_list);
+  }
+}
+
+void seg_ast_memory(seg_block_node *root, uint64_t *nodes, uint64_t *bytes)
+{
+  memory_state state = { 0, 0 };
+
+  if (root != NULL) {
+    seg_ast_visitor visitor = seg_new_ast_visitor();
+    seg_ast_visit_integer(visitor, (seg_integer_handler) &measure_leaf);
+    seg_ast_visit_float(visitor, (seg_float_handler) &measure_leaf);
+    seg_ast_visit_string(visitor, &measure_string);
+    seg_ast_visit_symbol(visitor, (seg_symbol_handler) &measure_leaf);
+    seg_ast_visit_var(visitor, (seg_var_handler) &measure_leaf);
+    seg_ast_visit_methodcall(visitor, SEG_VISIT_PRE, &measure_methodcall);
+    seg_ast_visit_block(visitor, SEG_VISIT_PRE, &measure_block);
+
+    seg_ast_visit(visitor, root, &state);
+    seg_delete_ast_visitor(visitor);
+
+    /* The root block is allocated on its own, rather than within an expression node. */
+    state.bytes -= sizeof(seg_expr_node) - sizeof(seg_block_node);
+  }
+
+  *nodes = state.nodes;
+  *bytes = state.bytes;
+}
@@ -10,6 +10,7 @@
 
 typedef enum {
   SEG_INTEGER,
+  SEG_FLOAT,
   SEG_STRING,
   SEG_SYMBOL,
   SEG_VAR,
@@ -27,6 +28,10 @@ typedef struct {
   int64_t value;
 } seg_integer_node;
 
+typedef struct {
+  double value;
+} seg_float_node;
+
 typedef struct {
   const char *value;
   uint64_t length;
@@ -76,6 +81,7 @@ typedef struct {
 typedef struct seg_expr_node {
   union {
     seg_integer_node integer;
+    seg_float_node floating;
     seg_string_node string;
     seg_symbol_node symbol;
     seg_var_node var;
@@ -101,6 +107,7 @@ typedef enum {
 } seg_visit_when;
 
 typedef void (*seg_integer_handler)(seg_integer_node *node, void *state);
+typedef void (*seg_float_handler)(seg_float_node *node, void *state);
 typedef void (*seg_string_handler)(seg_string_node *node, void *state);
 typedef void (*seg_symbol_handler)(seg_symbol_node *node, void *state);
 typedef void (*seg_methodcall_handler)(seg_methodcall_node *node, void *state);
@@ -110,6 +117,7 @@ typedef void (*seg_block_handler)(seg_block_node *node, void *state);
 seg_ast_visitor seg_new_ast_visitor();
 
 void seg_ast_visit_integer(seg_ast_visitor visitor, seg_integer_handler visit);
+void seg_ast_visit_float(seg_ast_visitor visitor, seg_float_handler visit);
 void seg_ast_visit_string(seg_ast_visitor visitor, seg_string_handler visit);
 void seg_ast_visit_symbol(seg_ast_visitor visitor, seg_symbol_handler visit);
 void seg_ast_visit_methodcall(
@@ -128,4 +136,12 @@ void seg_ast_visit(
 
 void seg_delete_ast_visitor(seg_ast_visitor visitor);
 
+/* Memory */
+
+/*
+  Count the nodes of an AST, including argument and parameter list entries,
+  and the bytes allocated for them and for their string literals.
+ */
+void seg_ast_memory(seg_block_node *root, uint64_t *nodes, uint64_t *bytes);
+
 #endif
@@ -42,6 +42,14 @@ static void print_integer(seg_integer_node *node, void *state)
   fprintf(pstate->out, "INTEGER: %lld\n", node->value);
 }
 
+static void print_float(seg_float_node *node, void *state)
+{
+  printer_state *pstate = (printer_state *) state;
+  print_prefix(pstate);
+
+  fprintf(pstate->out, "FLOAT: %.17g\n", node->value);
+}
+
 static void print_string(seg_string_node *node, void *state)
 {
   printer_state *pstate = (printer_state *) state;
@@ -130,6 +138,7 @@ void seg_print_ast(seg_block_node *root, FILE *outf)
     seg_ast_visitor visitor = seg_new_ast_visitor();
 
     seg_ast_visit_integer(visitor, &print_integer);
+    seg_ast_visit_float(visitor, &print_float);
     seg_ast_visit_string(visitor, &print_string);
     seg_ast_visit_symbol(visitor, &print_symbol);
 
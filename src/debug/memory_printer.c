@@ -0,0 +1,64 @@
+#include <stdio.h>
+
+#include "debug/memory_printer.h"
+#include "runtime/gc.h"
+
+static void print_tally(const char *name, seg_memory_tally *tally, const char *unit)
+{
+  printf(" %-12s %12lu bytes in %lu %s\n",
+    name,
+    (unsigned long) tally->bytes,
+    (unsigned long) tally->count,
+    unit);
+}
+
+void seg_print_memory(seg_runtime *runtime)
+{
+  seg_memory_usage usage;
+  seg_runtime_memory(runtime, &usage);
+
+  printf("memory usage:\n");
+  print_tally("runtime:", &usage.runtime, "runtimes");
+  print_tally("symboltable:", &usage.symboltable, "symbols");
+  print_tally("images:", &usage.images, "symbols");
+  print_tally("buffers:", &usage.buffers, "objects");
+  print_tally("slotted:", &usage.slotted, "objects");
+  print_tally("nursery:", &usage.nursery, "regions");
+  print_tally("direct:", &usage.direct, "objects");
+  print_tally("ast:", &usage.ast, "nodes");
+  printf(" %-12s %12lu bytes\n", "total:", (unsigned long) usage.total_bytes);
+}
+
+static void print_pauses(const char *name, uint64_t count, uint64_t pause_ns)
+{
+  printf(" %-12s %12lu collections in %.3f ms\n",
+    name,
+    (unsigned long) count,
+    pause_ns / 1e6);
+}
+
+void seg_print_collections(seg_runtime *runtime)
+{
+  seg_gc_stats stats;
+  seg_gc_statistics(seg_runtime_gc(runtime), &stats);
+
+  printf("garbage collection:\n");
+  print_pauses("minor:", stats.minor_collections, stats.minor_pause_ns);
+  print_pauses("major:", stats.major_collections, stats.major_pause_ns);
+  printf(" %-12s %12.3f ms\n", "max pause:", stats.max_pause_ns / 1e6);
+  printf(" %-12s %12lu bytes\n", "promoted:", (unsigned long) stats.bytes_promoted);
+  printf(" %-12s %12lu objects\n", "remembered:", (unsigned long) stats.remembered_objects);
+  printf(" %-12s %12lu bytes in %lu objects and %lu symbols\n",
+    "reclaimed:",
+    (unsigned long) stats.bytes_reclaimed,
+    (unsigned long) stats.objects_reclaimed,
+    (unsigned long) stats.symbols_reclaimed);
+  printf(" %-12s %12lu of %lu bytes\n",
+    "young:",
+    (unsigned long) stats.young_bytes,
+    (unsigned long) stats.young_capacity);
+  printf(" %-12s %12lu bytes in %lu objects\n",
+    "old:",
+    (unsigned long) stats.old_bytes,
+    (unsigned long) stats.old_objects);
+}
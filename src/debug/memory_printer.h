@@ -0,0 +1,16 @@
+#ifndef MEMORY_PRINTER
+#define MEMORY_PRINTER
+
+#include "runtime/runtime.h"
+
+/*
+ * Print the memory held by each of a runtime's subsystems to stdout.
+ */
+void seg_print_memory(seg_runtime *runtime);
+
+/*
+ * Print a runtime's garbage collection statistics to stdout.
+ */
+void seg_print_collections(seg_runtime *runtime);
+
+#endif
@@ -2,24 +2,25 @@
 
 #include "debug/symbol_printer.h"
 
-static seg_err print_symbol(seg_object symbol, void *state)
+void seg_print_symboltable(seg_symboltable *table)
 {
-  char *name;
-  uint64_t length;
-  seg_err err;
+  seg_hashtable_cursor c;
 
-  err = seg_buffer_contents(&symbol, &name, &length);
-  if (err != SEG_OK) {
-    return err;
-  }
+  for (
+    seg_symboltable_begin(table, &c);
+    ! seg_hashtable_done(&c);
+    seg_symboltable_next(table, &c)
+  ) {
+    seg_object symbol = seg_symboltable_cursor_symbol(&c);
+    char *name;
+    uint64_t length;
 
-  printf("symbol: [%*s]\n", (int) length, name);
-  return SEG_OK;
-}
+    if (seg_buffer_contents(&symbol, &name, &length) != SEG_OK) {
+      break;
+    }
 
-void seg_print_symboltable(seg_symboltable *table)
-{
-  seg_symboltable_each(table, print_symbol, NULL);
+    printf("symbol: [%*s]\n", (int) length, name);
+  }
 
   seg_hashtable_settings *settings = seg_symboltable_get_settings(table);
   uint64_t count = seg_symboltable_count(table);
@@ -32,6 +33,46 @@ void seg_print_symboltable(seg_symboltable *table)
   printf(" settings: bucket growth factor = %lu\n",
     (unsigned long) settings->bucket_growth_factor);
   printf(" settings: maximum load = %f\n", settings->max_load);
+  printf(" settings: minimum load = %f\n", settings->min_load);
   printf(" settings: table growth factor = %lu\n",
     (unsigned long) settings->table_growth_factor);
+  printf(" settings: incremental resize step = %lu\n",
+    (unsigned long) settings->incremental_resize_step);
+
+  seg_hashtable_stats stats;
+  seg_symboltable_stats(table, &stats);
+  seg_print_hashtable_stats(&stats, "slots");
+}
+
+static double ratio(uint64_t numerator, uint64_t denominator)
+{
+  return denominator > 0 ? numerator / (double) denominator : 0.0;
+}
+
+void seg_print_hashtable_stats(seg_hashtable_stats *stats, const char *length_unit)
+{
+  seg_hashtable_counters *counters = &(stats->counters);
+
+  printf(" slots: %lu allocated, %lu empty (%.1f%%), %lu tombstones\n",
+    (unsigned long) stats->slots,
+    (unsigned long) stats->empty_slots,
+    ratio(stats->empty_slots, stats->slots) * 100.0,
+    (unsigned long) stats->tombstones);
+  printf(" memory: %lu bytes\n", (unsigned long) stats->bytes);
+
+  printf(" length histogram (%s):", length_unit);
+  for (int i = 0; i < SEG_HT_HISTOGRAM_BINS; i++) {
+    const char *overflow = i == SEG_HT_HISTOGRAM_BINS - 1 ? "+" : "";
+    printf(" %d%s=%lu", i, overflow, (unsigned long) stats->histogram[i]);
+  }
+  printf("\n maximum length: %lu\n", (unsigned long) stats->max_length);
+
+  printf(" lookups: %lu hits averaging %.2f probes, %lu misses averaging %.2f probes\n",
+    (unsigned long) counters->hits,
+    ratio(counters->hit_probes, counters->hits),
+    (unsigned long) counters->misses,
+    ratio(counters->miss_probes, counters->misses));
+  printf(" resizes: %lu taking %.3f ms\n",
+    (unsigned long) counters->resizes,
+    counters->resize_ns / 1e6);
 }
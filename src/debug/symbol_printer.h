@@ -1,6 +1,7 @@
 #ifndef SYMBOL_PRINTER
 #define SYMBOL_PRINTER
 
+#include "ds/hashtable.h"
 #include "runtime/symboltable.h"
 
 /*
@@ -8,4 +9,10 @@
  */
 void seg_print_symboltable(seg_symboltable *table);
 
+/*
+ * Print a hashtable statistics snapshot to stdout. `length_unit` names what the histogram
+ * measures: "entries" for bucket lengths, or "slots" or "groups" for probe distances.
+ */
+void seg_print_hashtable_stats(seg_hashtable_stats *stats, const char *length_unit);
+
 #endif
@@ -0,0 +1,371 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds/buckets.h"
+
+static seg_bucket_entry *bk_append_within(
+  seg_bucket *buckets,
+  uint64_t capacity,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  seg_err *err
+) {
+  seg_bucket *buck = &(buckets[hashcode % capacity]);
+
+  if (buck->content == NULL) {
+    /* Create an empty bucket. */
+    buck->capacity = settings->init_bucket_capacity;
+    buck->length = 0;
+    buck->content = calloc(buck->capacity, sizeof(seg_bucket_entry));
+
+    if (buck->content == NULL) {
+      *err = SEG_NOMEM("Unable to allocate hashtable bucket.");
+      return NULL;
+    }
+  } else if (buck->length >= buck->capacity) {
+    /* Expand an existing bucket that has filled. */
+    size_t ncapacity = buck->capacity * settings->bucket_growth_factor;
+    seg_bucket_entry *ncontent = realloc(buck->content, sizeof(seg_bucket_entry) * ncapacity);
+
+    if (ncontent == NULL) {
+      *err = SEG_NOMEM("Unable to expand an existing hashtable bucket.");
+      return NULL;
+    }
+
+    memset(ncontent + buck->capacity, 0, sizeof(seg_bucket_entry) * (ncapacity - buck->capacity));
+    buck->content = ncontent;
+    buck->capacity = ncapacity;
+  }
+
+  seg_bucket_entry *e = &(buck->content[buck->length]);
+  buck->length++;
+
+  e->hashcode = hashcode;
+  e->key = key;
+  e->value = NULL;
+
+  return e;
+}
+
+static void bk_free_within(seg_bucket *buckets, uint64_t capacity)
+{
+  for (uint64_t b = 0; b < capacity; b++) {
+    free(buckets[b].content);
+  }
+  free(buckets);
+}
+
+/*
+ * Move up to `limit` buckets' worth of entries from the previous bucket array into the current
+ * one, or all remaining buckets if `limit` is zero. Release the previous buckets once they've been
+ * completely drained.
+ *
+ * Entries are moved from the end of each bucket, and each is dropped from it as soon as its copy
+ * exists, so a migration that fails partway through a bucket can be retried without moving any
+ * entry twice.
+ */
+static seg_err bk_migrate(seg_buckets *b, const seg_hashtable_settings *settings, uint64_t limit)
+{
+  seg_err err = SEG_OK;
+
+  uint64_t end = b->migrated + limit;
+  if (end > b->previous_capacity || limit == 0) {
+    end = b->previous_capacity;
+  }
+
+  for (uint64_t i = b->migrated; i < end; i++) {
+    seg_bucket *buck = &(b->previous[i]);
+
+    while (buck->length > 0) {
+      seg_bucket_entry *e = &(buck->content[buck->length - 1]);
+      seg_bucket_entry *ne = bk_append_within(
+        b->buckets, b->capacity, settings, e->hashcode, e->key, &err
+      );
+      if (ne == NULL) {
+        return err;
+      }
+      ne->value = e->value;
+      buck->length--;
+    }
+
+    free(buck->content);
+    buck->content = NULL;
+    buck->length = 0;
+    buck->capacity = 0;
+
+    b->migrated = i + 1;
+  }
+
+  if (b->migrated >= b->previous_capacity) {
+    free(b->previous);
+    b->previous = NULL;
+    b->previous_capacity = 0;
+    b->migrated = 0;
+  }
+
+  return SEG_OK;
+}
+
+/*
+ * Move a cursor forward from its current position to the nearest entry, crossing from the buckets
+ * being migrated into the current ones if necessary.
+ */
+static void bk_seek(seg_buckets *b, seg_hashtable_cursor *cursor)
+{
+  while (true) {
+    seg_bucket *buckets = cursor->storage;
+    uint64_t capacity = buckets == b->previous ? b->previous_capacity : b->capacity;
+
+    while (cursor->position < capacity) {
+      seg_bucket *buck = &(buckets[cursor->position]);
+
+      if (cursor->offset < buck->length) {
+        seg_bucket_entry *ent = &(buck->content[cursor->offset]);
+        cursor->key = ent->key;
+        cursor->value = ent->value;
+        return;
+      }
+
+      cursor->position++;
+      cursor->offset = 0;
+    }
+
+    if (buckets != b->previous) {
+      cursor->done = true;
+      return;
+    }
+
+    cursor->storage = b->buckets;
+    cursor->position = 0;
+    cursor->offset = 0;
+  }
+}
+
+seg_err seg_buckets_init(seg_buckets *b, uint64_t capacity)
+{
+  b->count = 0;
+  b->capacity = capacity;
+  b->initial_capacity = capacity;
+  b->previous = NULL;
+  b->previous_capacity = 0;
+  b->migrated = 0;
+  memset(&b->counters, 0, sizeof(seg_hashtable_counters));
+
+  b->buckets = calloc(capacity, sizeof(seg_bucket));
+  if (b->buckets == NULL) {
+    return SEG_NOMEM("Unable to allocate hashtable buckets.");
+  }
+
+  return SEG_OK;
+}
+
+seg_err seg_buckets_append(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  seg_bucket_entry **out
+) {
+  seg_err err = SEG_OK;
+
+  *out = bk_append_within(b->buckets, b->capacity, settings, hashcode, key, &err);
+  return err;
+}
+
+seg_err seg_buckets_migrate_step(seg_buckets *b, const seg_hashtable_settings *settings)
+{
+  if (b->previous != NULL) {
+    uint64_t start = seg_hashtable_clock_ns();
+    seg_err err = bk_migrate(b, settings, settings->incremental_resize_step);
+    b->counters.resize_ns += seg_hashtable_clock_ns() - start;
+    return err;
+  }
+  return SEG_OK;
+}
+
+static seg_err bk_resize(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  bool incremental
+) {
+  seg_err err;
+
+  /* Only one migration may be in flight at a time. Finish any that's already underway. */
+  if (b->previous != NULL) {
+    err = bk_migrate(b, settings, 0);
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
+
+  if (b->capacity == capacity) {
+    return SEG_OK;
+  }
+
+  seg_bucket *nbuckets = calloc(capacity, sizeof(seg_bucket));
+  if (nbuckets == NULL) {
+    return SEG_NOMEM("Unable to allocate resized hashtable buckets.");
+  }
+
+  b->previous = b->buckets;
+  b->previous_capacity = b->capacity;
+  b->migrated = 0;
+
+  b->buckets = nbuckets;
+  b->capacity = capacity;
+  b->counters.resizes++;
+
+  if (! incremental) {
+    return bk_migrate(b, settings, 0);
+  }
+
+  return SEG_OK;
+}
+
+seg_err seg_buckets_resize(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  bool incremental
+) {
+  uint64_t start = seg_hashtable_clock_ns();
+  seg_err err = bk_resize(b, settings, capacity, incremental);
+  b->counters.resize_ns += seg_hashtable_clock_ns() - start;
+
+  return err;
+}
+
+seg_err seg_buckets_trigger_dynamic_resize(seg_buckets *b, const seg_hashtable_settings *settings)
+{
+  float load = b->count / (float) b->capacity;
+  if (load >= settings->max_load) {
+    bool incremental = settings->incremental_resize_step > 0;
+    uint64_t capacity = b->capacity * settings->table_growth_factor;
+
+    return seg_buckets_resize(b, settings, capacity, incremental);
+  }
+  return SEG_OK;
+}
+
+/*
+ * Return true if `ent` lies within the content of `buck`.
+ */
+static bool bk_contains(seg_bucket *buck, seg_bucket_entry *ent)
+{
+  return buck->content != NULL && ent >= buck->content && ent < buck->content + buck->length;
+}
+
+void seg_buckets_remove(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  seg_bucket_entry *ent
+) {
+  seg_bucket *buck = &(b->buckets[ent->hashcode % b->capacity]);
+  if (! bk_contains(buck, ent)) {
+    /* The entry hasn't been migrated yet. */
+    buck = &(b->previous[ent->hashcode % b->previous_capacity]);
+  }
+
+  seg_bucket_entry *last = &(buck->content[buck->length - 1]);
+  if (ent != last) {
+    *ent = *last;
+  }
+  buck->length--;
+  b->count--;
+
+  /*
+   * Give back bucket space that's gone unused, with the same hysteresis as the table itself, so
+   * that a bucket that was briefly crowded doesn't stay oversized forever.
+   */
+  size_t factor = settings->bucket_growth_factor;
+  size_t ncapacity = factor > 1 ? buck->capacity / factor : 0;
+  if (ncapacity >= settings->init_bucket_capacity && buck->length <= ncapacity / factor) {
+    seg_bucket_entry *ncontent = realloc(buck->content, sizeof(seg_bucket_entry) * ncapacity);
+    if (ncontent != NULL) {
+      buck->content = ncontent;
+      buck->capacity = ncapacity;
+    }
+  }
+}
+
+seg_err seg_buckets_trigger_dynamic_shrink(seg_buckets *b, const seg_hashtable_settings *settings)
+{
+  uint32_t factor = settings->table_growth_factor;
+
+  if (settings->min_load <= 0 || factor < 2 || b->capacity <= b->initial_capacity) {
+    return SEG_OK;
+  }
+
+  float load = b->count / (float) b->capacity;
+  if (load < settings->min_load) {
+    bool incremental = settings->incremental_resize_step > 0;
+    uint64_t capacity = b->capacity / factor;
+    if (capacity < b->initial_capacity) {
+      capacity = b->initial_capacity;
+    }
+
+    return seg_buckets_resize(b, settings, capacity, incremental);
+  }
+
+  return SEG_OK;
+}
+
+void seg_buckets_begin(seg_buckets *b, seg_hashtable_cursor *cursor)
+{
+  /* Drained buckets are empty. */
+  cursor->storage = b->previous != NULL ? b->previous : b->buckets;
+  cursor->position = 0;
+  cursor->offset = 0;
+  cursor->key_length = 0;
+  cursor->done = false;
+
+  bk_seek(b, cursor);
+}
+
+void seg_buckets_next(seg_buckets *b, seg_hashtable_cursor *cursor)
+{
+  cursor->offset++;
+  bk_seek(b, cursor);
+}
+
+static void bk_stats_within(seg_bucket *buckets, uint64_t capacity, seg_hashtable_stats *stats)
+{
+  stats->slots += capacity;
+  stats->bytes += sizeof(seg_bucket) * capacity;
+
+  for (uint64_t b = 0; b < capacity; b++) {
+    seg_bucket *buck = &(buckets[b]);
+
+    if (buck->length == 0) {
+      stats->empty_slots++;
+    }
+    seg_hashtable_histogram_add(stats, buck->length);
+    stats->bytes += sizeof(seg_bucket_entry) * buck->capacity;
+  }
+}
+
+void seg_buckets_stats(seg_buckets *b, seg_hashtable_stats *stats)
+{
+  memset(stats, 0, sizeof(seg_hashtable_stats));
+  stats->count = b->count;
+  stats->capacity = b->capacity;
+  stats->counters = b->counters;
+
+  bk_stats_within(b->buckets, b->capacity, stats);
+  if (b->previous != NULL) {
+    /* Drained buckets are empty, but they remain allocated until the migration completes. */
+    bk_stats_within(b->previous, b->previous_capacity, stats);
+  }
+}
+
+void seg_buckets_free(seg_buckets *b)
+{
+  if (b->previous != NULL) {
+    bk_free_within(b->previous, b->previous_capacity);
+    b->previous = NULL;
+  }
+  bk_free_within(b->buckets, b->capacity);
+  b->buckets = NULL;
+}
@@ -0,0 +1,232 @@
+#ifndef BUCKETS_H
+#define BUCKETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "errors.h"
+#include "ds/hashtable.h"
+
+/*
+ * Separately chained bucket storage shared by the hashtables whose keys are opaque pointers:
+ * seg_ptrtable and seg_plugtable. Everything that doesn't need to inspect a key lives here as
+ * ordinary functions. Key lookup is generated for each kind of key by SEG_BUCKETS_DEFINE_FIND, so
+ * that each table's hash and equality tests are inlined into its probe loop.
+ */
+
+typedef struct {
+  uint32_t hashcode;
+  const void *key;
+  void *value;
+} seg_bucket_entry;
+
+typedef struct {
+  size_t length;
+  size_t capacity;
+  seg_bucket_entry *content;
+} seg_bucket;
+
+typedef struct {
+  uint64_t count;
+  uint64_t capacity;
+  uint64_t initial_capacity;
+  seg_bucket *buckets;
+
+  /* Buckets being drained by an incremental resize, or NULL if none is in progress. */
+  seg_bucket *previous;
+  uint64_t previous_capacity;
+  uint64_t migrated;
+
+  seg_hashtable_counters counters;
+} seg_buckets;
+
+/*
+ * Allocate `capacity` empty buckets.
+ *
+ * SEG_NOMEM: If the allocation fails.
+ */
+seg_err seg_buckets_init(seg_buckets *b, uint64_t capacity);
+
+/*
+ * Append a new entry to the bucket that `hashcode` selects, allocating or expanding the bucket as
+ * necessary. The caller is responsible for verifying that `key` isn't already present, and for
+ * adjusting the count.
+ *
+ * SEG_NOMEM: If the bucket can't be allocated or expanded.
+ */
+seg_err seg_buckets_append(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  seg_bucket_entry **out
+);
+
+/*
+ * Advance any incremental resize that's in progress. Call at the start of each mutating operation,
+ * before any entry pointers are handed out.
+ */
+seg_err seg_buckets_migrate_step(seg_buckets *b, const seg_hashtable_settings *settings);
+
+/*
+ * Replace the current buckets with `capacity` fresh ones. If `incremental` is true, existing
+ * entries are left in place to be migrated by later calls to `seg_buckets_migrate_step`;
+ * otherwise, they're all moved immediately.
+ */
+seg_err seg_buckets_resize(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  bool incremental
+);
+
+/*
+ * A new element has been added. Calculate the new load and trigger a capacity extension if
+ * necessary.
+ */
+seg_err seg_buckets_trigger_dynamic_resize(seg_buckets *b, const seg_hashtable_settings *settings);
+
+/*
+ * Remove an entry located by a find function, moving the last entry of its bucket into its place,
+ * and adjust the count. Buckets that have emptied out are trimmed. Pointers to other entries in
+ * the same bucket are invalidated.
+ */
+void seg_buckets_remove(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  seg_bucket_entry *ent
+);
+
+/*
+ * An element has been removed. If the load has fallen below `min_load`, shrink the bucket array,
+ * but never below the capacity it was initialized with.
+ */
+seg_err seg_buckets_trigger_dynamic_shrink(seg_buckets *b, const seg_hashtable_settings *settings);
+
+/*
+ * Position a cursor on the first entry, or mark it done if there are none. Entries that haven't
+ * been migrated yet are visited first. Empty buckets are skipped.
+ */
+void seg_buckets_begin(seg_buckets *b, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next entry, or mark it done if there are no more.
+ */
+void seg_buckets_next(seg_buckets *b, seg_hashtable_cursor *cursor);
+
+/*
+ * Fill in the portions of `stats` that describe bucket storage: everything except the memory used
+ * by the table that owns it and by its keys.
+ */
+void seg_buckets_stats(seg_buckets *b, seg_hashtable_stats *stats);
+
+/*
+ * Release all bucket storage.
+ */
+void seg_buckets_free(seg_buckets *b);
+
+/*
+ * Define a static function `NAME` that locates the entry for `key` within bucket storage, or
+ * returns NULL if there is none. `EQUAL(stored, key, context)` must evaluate to true when a stored
+ * key matches the key being sought. `context` is passed through unchanged to `EQUAL`. Each lookup
+ * is recorded in the storage's counters, along with the number of entries it examined.
+ */
+#define SEG_BUCKETS_DEFINE_FIND(NAME, CONTEXT_TYPE, EQUAL) \
+  static inline seg_bucket_entry *NAME##_within( \
+    seg_bucket *buckets, \
+    uint64_t capacity, \
+    uint32_t hashcode, \
+    const void *key, \
+    CONTEXT_TYPE context, \
+    uint64_t *probes \
+  ) { \
+    seg_bucket *buck = &(buckets[hashcode % capacity]); \
+    (void) context; \
+    for (size_t i = 0; i < buck->length; i++) { \
+      seg_bucket_entry *ent = &(buck->content[i]); \
+      if (ent->hashcode == hashcode && EQUAL(ent->key, key, context)) { \
+        *probes += i + 1; \
+        return ent; \
+      } \
+    } \
+    *probes += buck->length; \
+    return NULL; \
+  } \
+  \
+  static inline seg_bucket_entry *NAME( \
+    seg_buckets *b, \
+    uint32_t hashcode, \
+    const void *key, \
+    CONTEXT_TYPE context \
+  ) { \
+    uint64_t probes = 0; \
+    seg_bucket_entry *ent = NAME##_within( \
+      b->buckets, b->capacity, hashcode, key, context, &probes \
+    ); \
+    if (ent == NULL && b->previous != NULL) { \
+      ent = NAME##_within(b->previous, b->previous_capacity, hashcode, key, context, &probes); \
+    } \
+    seg_hashtable_count_lookup(&b->counters, ent != NULL, probes); \
+    return ent; \
+  }
+
+/* Number of keys whose buckets are prefetched together by batched operations. */
+#define SEG_BUCKETS_BATCH 16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SEG_BUCKETS_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define SEG_BUCKETS_PREFETCH(address) ((void) (address))
+#endif
+
+/*
+ * Prefetch the bucket that `hashcode` selects. Batched operations call this for every key in a
+ * batch before resolving any of them, so that their cache misses overlap instead of queueing.
+ */
+static inline void seg_buckets_prefetch(seg_buckets *b, uint32_t hashcode)
+{
+  SEG_BUCKETS_PREFETCH(&(b->buckets[hashcode % b->capacity]));
+}
+
+/*
+ * Prefetch the entries of the bucket that `hashcode` selects. Call this once the bucket itself has
+ * had time to arrive from `seg_buckets_prefetch`.
+ */
+static inline void seg_buckets_prefetch_entries(seg_buckets *b, uint32_t hashcode)
+{
+  SEG_BUCKETS_PREFETCH(b->buckets[hashcode % b->capacity].content);
+}
+
+/*
+ * Complete a find-or-create operation: report `found` if a find function defined by
+ * SEG_BUCKETS_DEFINE_FIND located an existing entry, or append and count a new one otherwise.
+ */
+static inline seg_err seg_buckets_find_or_create(
+  seg_buckets *b,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  seg_bucket_entry *found,
+  seg_bucket_entry **ent,
+  bool *created
+) {
+  seg_err err;
+
+  if (found != NULL) {
+    *ent = found;
+    *created = false;
+    return SEG_OK;
+  }
+
+  err = seg_buckets_append(b, settings, hashcode, key, ent);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  b->count++;
+  *created = true;
+  return SEG_OK;
+}
+
+#endif
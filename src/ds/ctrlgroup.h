@@ -0,0 +1,143 @@
+#ifndef CTRLGROUP_H
+#define CTRLGROUP_H
+
+#include <stdint.h>
+
+/*
+ * Control-byte group matching for open-addressed hashtables.
+ *
+ * Each slot in an open-addressed table is described by a single control byte. A control byte with
+ * its high bit clear marks a full slot and holds the low seven bits of that slot's hashcode; the
+ * remaining values mark empty or deleted slots. Slots are probed a group at a time: every control
+ * byte in a group is compared against a hash fragment at once, producing a bitmask with one bit
+ * per matching slot.
+ *
+ * The group width depends on the widest vector instructions available at compile time. Control
+ * byte arrays must be aligned to SEG_CTRLGROUP_WIDTH and sized to a multiple of it.
+ */
+
+#define SEG_CTRL_EMPTY ((int8_t) -128)
+#define SEG_CTRL_DELETED ((int8_t) -2)
+
+/* Extract the seven-bit fragment of a hashcode that's stored in a full slot's control byte. */
+#define SEG_CTRL_H2(hashcode) ((int8_t) ((hashcode) & 0x7f))
+
+/* Extract the portion of a hashcode used to choose a slot group. */
+#define SEG_CTRL_H1(hashcode) ((hashcode) >> 7)
+
+/* True if a control byte marks a full slot. */
+#define SEG_CTRL_ISFULL(ctrl) ((ctrl) >= 0)
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define SEG_CTRLGROUP_WIDTH 32
+
+typedef uint32_t seg_ctrlmask;
+
+static inline seg_ctrlmask seg_ctrlgroup_match(const int8_t *group, int8_t h2)
+{
+  __m256i ctrl = _mm256_load_si256((const __m256i *) group);
+  return (seg_ctrlmask) _mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(h2)));
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_empty(const int8_t *group)
+{
+  return seg_ctrlgroup_match(group, SEG_CTRL_EMPTY);
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_available(const int8_t *group)
+{
+  /* Empty and deleted slots are the only ones with their high bit set. */
+  __m256i ctrl = _mm256_load_si256((const __m256i *) group);
+  return (seg_ctrlmask) _mm256_movemask_epi8(ctrl);
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_full(const int8_t *group)
+{
+  return ~seg_ctrlgroup_match_available(group);
+}
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define SEG_CTRLGROUP_WIDTH 16
+
+typedef uint32_t seg_ctrlmask;
+
+static inline seg_ctrlmask seg_ctrlgroup_match(const int8_t *group, int8_t h2)
+{
+  __m128i ctrl = _mm_load_si128((const __m128i *) group);
+  return (seg_ctrlmask) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_empty(const int8_t *group)
+{
+  return seg_ctrlgroup_match(group, SEG_CTRL_EMPTY);
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_available(const int8_t *group)
+{
+  __m128i ctrl = _mm_load_si128((const __m128i *) group);
+  return (seg_ctrlmask) _mm_movemask_epi8(ctrl);
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_full(const int8_t *group)
+{
+  return ~seg_ctrlgroup_match_available(group) & 0xffff;
+}
+
+#else
+
+/* Portable fallback: compare each control byte in turn. */
+
+#define SEG_CTRLGROUP_WIDTH 8
+
+typedef uint32_t seg_ctrlmask;
+
+static inline seg_ctrlmask seg_ctrlgroup_match(const int8_t *group, int8_t h2)
+{
+  seg_ctrlmask mask = 0;
+  for (int i = 0; i < SEG_CTRLGROUP_WIDTH; i++) {
+    if (group[i] == h2) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_empty(const int8_t *group)
+{
+  return seg_ctrlgroup_match(group, SEG_CTRL_EMPTY);
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_available(const int8_t *group)
+{
+  seg_ctrlmask mask = 0;
+  for (int i = 0; i < SEG_CTRLGROUP_WIDTH; i++) {
+    if (! SEG_CTRL_ISFULL(group[i])) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+}
+
+static inline seg_ctrlmask seg_ctrlgroup_match_full(const int8_t *group)
+{
+  return ~seg_ctrlgroup_match_available(group) & 0xff;
+}
+
+#endif
+
+/* Return the index of the lowest set bit in a nonzero match mask. */
+static inline unsigned seg_ctrlmask_first(seg_ctrlmask mask)
+{
+  return (unsigned) __builtin_ctz(mask);
+}
+
+/* Clear the lowest set bit in a match mask. */
+#define SEG_CTRLMASK_NEXT(mask) ((mask) & ((mask) - 1))
+
+#endif
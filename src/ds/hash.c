@@ -0,0 +1,265 @@
+#include <string.h>
+
+#include "ds/hash.h"
+#include "ds/murmur.h"
+
+/* Unaligned little-endian loads. */
+
+static inline uint64_t hs_read64(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(uint64_t));
+  return v;
+}
+
+static inline uint64_t hs_read32(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(uint32_t));
+  return v;
+}
+
+/* Read one to three bytes into a single word. */
+static inline uint64_t hs_read_small(const uint8_t *p, size_t length)
+{
+  return (((uint64_t) p[0]) << 16) | (((uint64_t) p[length >> 1]) << 8) | p[length - 1];
+}
+
+/* SEG_HASH_WIDE */
+
+static const uint64_t hs_secret[4] = {
+  0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+/*
+ * Multiply two words into a 128-bit product. Replace `a` with its low half and `b` with its high
+ * half.
+ */
+static inline void hs_multiply(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+  __extension__ unsigned __int128 r = *a;
+  r *= *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t lo = t + (rm1 << 32);
+  uint64_t carry = (t < rl) + (lo < t);
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+/* Multiply two words and fold the 128-bit product back into one. */
+static inline uint64_t hs_mix(uint64_t a, uint64_t b)
+{
+  hs_multiply(&a, &b);
+  return a ^ b;
+}
+
+uint64_t seg_hash_wide(const void *key, size_t length, uint64_t seed)
+{
+  const uint8_t *p = (const uint8_t *) key;
+  uint64_t a, b;
+
+  seed ^= hs_mix(seed ^ hs_secret[0], hs_secret[1]);
+
+  if (length <= 16) {
+    if (length >= 4) {
+      /* Two overlapping pairs of four-byte reads cover every byte of a 4-16 byte key. */
+      size_t offset = (length >> 3) << 2;
+      a = (hs_read32(p) << 32) | hs_read32(p + offset);
+      b = (hs_read32(p + length - 4) << 32) | hs_read32(p + length - 4 - offset);
+    } else if (length > 0) {
+      a = hs_read_small(p, length);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t remaining = length;
+
+    if (remaining > 48) {
+      /* Three independent lanes keep the multipliers busy on long keys. */
+      uint64_t lane1 = seed, lane2 = seed;
+      do {
+        seed = hs_mix(hs_read64(p) ^ hs_secret[1], hs_read64(p + 8) ^ seed);
+        lane1 = hs_mix(hs_read64(p + 16) ^ hs_secret[2], hs_read64(p + 24) ^ lane1);
+        lane2 = hs_mix(hs_read64(p + 32) ^ hs_secret[3], hs_read64(p + 40) ^ lane2);
+        p += 48;
+        remaining -= 48;
+      } while (remaining > 48);
+      seed ^= lane1 ^ lane2;
+    }
+
+    while (remaining > 16) {
+      seed = hs_mix(hs_read64(p) ^ hs_secret[1], hs_read64(p + 8) ^ seed);
+      p += 16;
+      remaining -= 16;
+    }
+
+    /* The final sixteen bytes, which may overlap bytes that have already been mixed. */
+    a = hs_read64(p + remaining - 16);
+    b = hs_read64(p + remaining - 8);
+  }
+
+  a ^= hs_secret[1];
+  b ^= seed;
+  hs_multiply(&a, &b);
+  return hs_mix(a ^ hs_secret[0] ^ length, b ^ hs_secret[1]);
+}
+
+/* SEG_HASH_CRC32C */
+
+static const uint32_t hs_crc32c_table[256] = {
+  0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+  0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+  0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+  0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+  0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+  0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+  0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+  0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+  0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+  0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+  0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+  0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+  0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+  0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+  0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+  0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+  0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+  0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+  0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+  0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+  0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+  0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+  0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+  0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+  0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+  0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+  0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+  0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+  0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+  0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+  0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+  0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+  0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+  0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+  0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+  0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+  0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+  0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+  0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+  0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+  0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+  0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+  0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351
+};
+
+static uint32_t hs_crc32c_software(const uint8_t *p, size_t length, uint32_t crc)
+{
+  for (size_t i = 0; i < length; i++) {
+    crc = hs_crc32c_table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+#define HS_CRC32C_HARDWARE 1
+
+#include <nmmintrin.h>
+
+__attribute__((target("sse4.2")))
+static uint32_t hs_crc32c_hardware(const uint8_t *p, size_t length, uint32_t crc)
+{
+  uint64_t crc64 = crc;
+
+  while (length >= 8) {
+    crc64 = _mm_crc32_u64(crc64, hs_read64(p));
+    p += 8;
+    length -= 8;
+  }
+
+  crc = (uint32_t) crc64;
+  if (length >= 4) {
+    crc = _mm_crc32_u32(crc, (uint32_t) hs_read32(p));
+    p += 4;
+    length -= 4;
+  }
+
+  while (length > 0) {
+    crc = _mm_crc32_u8(crc, *p);
+    p++;
+    length--;
+  }
+
+  return crc;
+}
+
+#endif
+
+bool seg_hash_crc32c_hardware(void)
+{
+#ifdef HS_CRC32C_HARDWARE
+  return __builtin_cpu_supports("sse4.2");
+#else
+  return false;
+#endif
+}
+
+uint32_t seg_hash_crc32c(const void *key, size_t length, uint32_t seed)
+{
+  const uint8_t *p = (const uint8_t *) key;
+  uint32_t crc = ~seed;
+
+#ifdef HS_CRC32C_HARDWARE
+  if (__builtin_cpu_supports("sse4.2")) {
+    return ~hs_crc32c_hardware(p, length, crc);
+  }
+#endif
+
+  return ~hs_crc32c_software(p, length, crc);
+}
+
+/* Dispatch. */
+
+uint32_t seg_hash(seg_hash_algorithm algorithm, const void *key, size_t length, uint32_t seed)
+{
+  switch (algorithm) {
+  case SEG_HASH_WIDE:
+    {
+      uint64_t h = seg_hash_wide(key, length, seed);
+      return (uint32_t) (h ^ (h >> 32));
+    }
+  case SEG_HASH_CRC32C:
+    return seg_hash_crc32c(key, length, seed);
+  default:
+    return murmur3_32(key, (uint32_t) length, seed);
+  }
+}
+
+static const char *hs_names[] = { "murmur3", "wide", "crc32c" };
+
+const char *seg_hash_name(seg_hash_algorithm algorithm)
+{
+  if (algorithm > SEG_HASH_CRC32C) {
+    return "unknown";
+  }
+  return hs_names[algorithm];
+}
+
+bool seg_hash_parse(const char *name, seg_hash_algorithm *out)
+{
+  for (int i = 0; i <= SEG_HASH_CRC32C; i++) {
+    if (strcmp(name, hs_names[i]) == 0) {
+      *out = (seg_hash_algorithm) i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,57 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Family of byte-string hash functions that a hashtable may be constructed with. Every member
+ * accepts a seed and produces the 32-bit hashcodes that the tables store.
+ *
+ * SEG_HASH_MURMUR3: MurmurHash3 (x86, 32-bit). Reads four bytes at a time.
+ * SEG_HASH_WIDE: A wyhash-style 64-bit hash built on 64x64->128 bit multiplies. Reads eight bytes
+ *   at a time and handles keys of sixteen bytes or fewer without a loop.
+ * SEG_HASH_CRC32C: CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the processor
+ *   supports it, and a lookup table otherwise.
+ */
+typedef enum {
+  SEG_HASH_MURMUR3,
+  SEG_HASH_WIDE,
+  SEG_HASH_CRC32C
+} seg_hash_algorithm;
+
+#define SEG_HASH_DEFAULT SEG_HASH_WIDE
+
+/*
+ * Hash `length` bytes at `key` with the chosen algorithm.
+ */
+uint32_t seg_hash(seg_hash_algorithm algorithm, const void *key, size_t length, uint32_t seed);
+
+/*
+ * Compute the full 64-bit SEG_HASH_WIDE hash of `length` bytes at `key`.
+ */
+uint64_t seg_hash_wide(const void *key, size_t length, uint64_t seed);
+
+/*
+ * Compute the CRC32C of `length` bytes at `key`, starting from `seed`. A seed of zero produces the
+ * standard checksum.
+ */
+uint32_t seg_hash_crc32c(const void *key, size_t length, uint32_t seed);
+
+/*
+ * Return true if seg_hash_crc32c uses the processor's crc32 instruction.
+ */
+bool seg_hash_crc32c_hardware(void);
+
+/*
+ * Return a short, human-readable name for a hash algorithm.
+ */
+const char *seg_hash_name(seg_hash_algorithm algorithm);
+
+/*
+ * Parse a name produced by `seg_hash_name`. Return false if `name` isn't recognized.
+ */
+bool seg_hash_parse(const char *name, seg_hash_algorithm *out);
+
+#endif
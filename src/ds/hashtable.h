@@ -2,6 +2,8 @@
 #define HASHTABLE_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
 
 #include "errors.h"
 
@@ -9,10 +11,10 @@
  * Settings that control the growth behavior of a hashtable.
  */
 typedef struct {
-  /* The initial capacity of newly allocated buckets. */
+  /* The initial capacity of newly allocated buckets. Unused by open-addressed tables. */
   uint32_t init_bucket_capacity;
 
-  /* Factor by which bucket capacity will increase when filled. */
+  /* Factor by which bucket capacity will increase when filled. Unused by open-addressed tables. */
   uint32_t bucket_growth_factor;
 
   /* Load factor at which automatic resizing will be triggered. */
@@ -20,6 +22,19 @@ typedef struct {
 
   /* Amount by which the table's bucket capacity will grow when `max_load_factor` is reached. */
   uint32_t table_growth_factor;
+
+  /*
+   * If nonzero, automatic resizes are performed incrementally: each subsequent mutating operation
+   * migrates at most this many buckets from the old storage to the new, while lookups consult
+   * both. If zero, the table is rehashed all at once by the put that triggers the resize.
+   */
+  uint32_t incremental_resize_step;
+
+  /*
+   * Load factor below which a remove shrinks the table by `table_growth_factor`. A table never
+   * shrinks below the capacity it was created with. Zero disables shrinking.
+   */
+  float min_load;
 } seg_hashtable_settings;
 
 /* Default settings for a newly initialized table. */
@@ -28,5 +43,130 @@ typedef struct {
 #define SEG_HT_BUCKET_GROWTH_FACTOR 2
 #define SEG_HT_MAX_LOAD 0.75
 #define SEG_HT_TABLE_GROWTH_FACTOR 2
+#define SEG_HT_INCREMENTAL_RESIZE_STEP 0
+#define SEG_HT_MIN_LOAD 0.125
+
+/*
+ * Running totals that a hashtable accumulates as it's used.
+ */
+typedef struct {
+  /* Lookups that found their key, and the entries or slot groups they examined in total. */
+  uint64_t hits;
+  uint64_t hit_probes;
+
+  /* Lookups that didn't find their key, and the entries or slot groups they examined in total. */
+  uint64_t misses;
+  uint64_t miss_probes;
+
+  /* Resizes begun, and the wall-clock time spent moving entries into resized storage. */
+  uint64_t resizes;
+  uint64_t resize_ns;
+} seg_hashtable_counters;
+
+/* Number of bins in a seg_hashtable_stats length histogram. The last bin collects the overflow. */
+#define SEG_HT_HISTOGRAM_BINS 8
+
+/*
+ * A snapshot of a hashtable's shape and usage, for tuning its settings.
+ *
+ * For tables with separately chained buckets, `histogram[n]` counts the buckets that hold `n`
+ * entries and `max_length` is the length of the longest bucket. For open-addressed tables,
+ * `histogram[n]` counts the entries that are stored `n` probe steps away from their home position
+ * and `max_length` is the longest such distance.
+ */
+typedef struct {
+  uint64_t count;
+  uint64_t capacity;
+
+  /* Buckets or slots allocated, and how many of them hold nothing. */
+  uint64_t slots;
+  uint64_t empty_slots;
+
+  /* Slots left behind by removed entries that still lengthen probe sequences. */
+  uint64_t tombstones;
+
+  uint64_t histogram[SEG_HT_HISTOGRAM_BINS];
+  uint64_t max_length;
+
+  seg_hashtable_counters counters;
+
+  /* Heap bytes owned by the table, including its keys if it copies them. */
+  uint64_t bytes;
+} seg_hashtable_stats;
+
+/*
+ * Position within an external iteration over a hashtable's entries. Position a cursor on the first
+ * entry with the table's `begin` function, then read the current entry and advance to the next
+ * with the table's `next` function until `seg_hashtable_done` reports that none remain:
+ *
+ *   seg_hashtable_cursor c;
+ *   for (seg_ptrtable_begin(table, &c); ! seg_hashtable_done(&c); seg_ptrtable_next(table, &c)) {
+ *     ...
+ *   }
+ *
+ * Cursors visit entries in the same order as the table's `each` function, and may be abandoned at
+ * any point without cleanup. Unless a table documents otherwise, modifying it invalidates every
+ * cursor over it.
+ */
+typedef struct {
+  /* The current entry. `key_length` is only set by tables whose keys vary in length. */
+  const void *key;
+  uint64_t key_length;
+  void *value;
+  bool done;
+
+  /* The storage being walked and the position within it. Private to the table. */
+  void *storage;
+  uint64_t position;
+  uint64_t offset;
+} seg_hashtable_cursor;
+
+/*
+ * Return true once a cursor has moved past the final entry.
+ */
+static inline bool seg_hashtable_done(const seg_hashtable_cursor *cursor)
+{
+  return cursor->done;
+}
+
+/*
+ * Record the outcome of a single lookup.
+ */
+static inline void seg_hashtable_count_lookup(
+  seg_hashtable_counters *counters,
+  bool hit,
+  uint64_t probes
+) {
+  if (hit) {
+    counters->hits++;
+    counters->hit_probes += probes;
+  } else {
+    counters->misses++;
+    counters->miss_probes += probes;
+  }
+}
+
+/*
+ * Add `length` to the appropriate bin of a stats histogram.
+ */
+static inline void seg_hashtable_histogram_add(seg_hashtable_stats *stats, uint64_t length)
+{
+  uint64_t bin = length < SEG_HT_HISTOGRAM_BINS ? length : SEG_HT_HISTOGRAM_BINS - 1;
+  stats->histogram[bin]++;
+
+  if (length > stats->max_length) {
+    stats->max_length = length;
+  }
+}
+
+/*
+ * Read a wall clock in nanoseconds, to time resizes.
+ */
+static inline uint64_t seg_hashtable_clock_ns(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
 
 #endif
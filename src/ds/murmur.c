@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 
 #include "murmur.h"
 
@@ -17,27 +18,30 @@ uint32_t murmur3_32(const char* key, uint32_t length, uint32_t seed)
   static const uint32_t n = 0xe6546b64;
 
   uint32_t hash = seed;
+  uint32_t remaining = length;
 
-  uint32_t *keydata = (uint32_t*) key; //used to extract 32 bits at a time
-  int keydata_it = 0;
+  const uint8_t *keydata = (const uint8_t*) key;
 
-  while (length >= 4)
+  while (remaining >= 4)
   {
-    uint32_t k = keydata[keydata_it++];
-    length -= 4;
+    /* Keys may be unaligned. memcpy compiles down to a single load where that's permitted. */
+    uint32_t k;
+    memcpy(&k, keydata, sizeof(uint32_t));
+    keydata += 4;
+    remaining -= 4;
 
     k *= c1;
     k = (k << r1) | (k >> (32-r1));
     k *= c2;
 
     hash ^= k;
-    hash = ((hash << r2) | (hash >> (32-r2)) * m) + n;
+    hash = ((hash << r2) | (hash >> (32-r2))) * m + n;
   }
 
-  const uint8_t *tail = (const uint8_t*)(keydata + keydata_it*4);
+  const uint8_t *tail = keydata;
   uint32_t k1 = 0;
 
-  switch(length & 3) {
+  switch(remaining & 3) {
   case 3:
     k1 ^= tail[2] << 16;
   case 2:
@@ -0,0 +1,339 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds/ordered.h"
+
+/* Smallest index size. Small enough for a few keyword arguments to fit in a single cache line. */
+#define ORD_MIN_INDEX_SIZE 8
+
+/* Deleted entries have their key replaced with the address of this sentinel. */
+static const char ord_deleted;
+
+/*
+ * Number of entries that fit in the dense array alongside an index of `index_size` elements. At
+ * least one index element is always left empty, so that every probe sequence terminates.
+ */
+static uint64_t ord_usable_for(const seg_hashtable_settings *settings, uint64_t index_size)
+{
+  float max_load = settings->max_load;
+  if (max_load > 0.9f) {
+    max_load = 0.9f;
+  } else if (max_load < 0.1f) {
+    max_load = 0.1f;
+  }
+
+  uint64_t usable = (uint64_t) (index_size * max_load);
+  if (usable < 1) {
+    usable = 1;
+  } else if (usable >= index_size) {
+    usable = index_size - 1;
+  }
+  return usable;
+}
+
+/*
+ * Number of bytes needed for each index element to hold any offset into a dense array of `usable`
+ * entries, as well as the negative sentinels.
+ */
+static uint8_t ord_width_for(uint64_t usable)
+{
+  if (usable <= INT8_MAX) {
+    return 1;
+  } else if (usable <= INT16_MAX) {
+    return 2;
+  } else if (usable <= INT32_MAX) {
+    return 4;
+  }
+  return 8;
+}
+
+/*
+ * Round `index_size` up to a power of two that leaves room for more than `count` entries.
+ */
+static uint64_t ord_fit(const seg_hashtable_settings *settings, uint64_t index_size, uint64_t count)
+{
+  uint64_t fitted = ORD_MIN_INDEX_SIZE;
+  while (fitted < index_size || ord_usable_for(settings, fitted) <= count) {
+    fitted <<= 1;
+  }
+  return fitted;
+}
+
+/*
+ * Locate the first index slot along `hashcode`'s probe sequence that doesn't refer to an entry.
+ */
+static uint64_t ord_find_free_slot(seg_ordered *o, uint32_t hashcode)
+{
+  uint64_t mask = o->index_size - 1;
+  uint64_t perturb = hashcode;
+  uint64_t slot = hashcode & mask;
+
+  while (seg_ordered_index_get(o, slot) >= 0) {
+    perturb >>= SEG_ORDERED_PERTURB_SHIFT;
+    slot = (slot * 5 + perturb + 1) & mask;
+  }
+  return slot;
+}
+
+/*
+ * Rebuild the storage around an index of `index_size` elements. Deleted entries are squeezed out
+ * of the dense array without disturbing the order of the others, and every tombstone is cleared.
+ * The caller must ensure that the new size has room for every live entry.
+ */
+static seg_err ord_rebuild(
+  seg_ordered *o,
+  const seg_hashtable_settings *settings,
+  uint64_t index_size
+) {
+  uint64_t start = seg_hashtable_clock_ns();
+  uint64_t usable = ord_usable_for(settings, index_size);
+  uint8_t width = ord_width_for(usable);
+
+  void *index = malloc(index_size * width);
+  if (index == NULL) {
+    return SEG_NOMEM("Unable to allocate hashtable index.");
+  }
+
+  /* Every width represents SEG_ORDERED_EMPTY with all bits set. */
+  memset(index, 0xff, index_size * width);
+
+  if (usable > o->usable) {
+    seg_bucket_entry *nentries = realloc(o->entries, sizeof(seg_bucket_entry) * usable);
+    if (nentries == NULL) {
+      free(index);
+      return SEG_NOMEM("Unable to expand hashtable entries.");
+    }
+    o->entries = nentries;
+  }
+
+  uint64_t live = 0;
+  for (uint64_t i = 0; i < o->used; i++) {
+    if (o->entries[i].key != &ord_deleted) {
+      o->entries[live++] = o->entries[i];
+    }
+  }
+
+  if (usable < o->usable) {
+    /* If shrinking in place fails, keep using the larger allocation. */
+    seg_bucket_entry *nentries = realloc(o->entries, sizeof(seg_bucket_entry) * usable);
+    if (nentries != NULL) {
+      o->entries = nentries;
+    }
+  }
+
+  free(o->index);
+  o->index = index;
+  o->index_size = index_size;
+  o->index_width = width;
+  o->usable = usable;
+  o->used = live;
+  o->count = live;
+
+  for (uint64_t i = 0; i < live; i++) {
+    uint64_t slot = ord_find_free_slot(o, o->entries[i].hashcode);
+    seg_ordered_index_set(o, slot, (int64_t) i);
+  }
+
+  o->counters.resizes++;
+  o->counters.resize_ns += seg_hashtable_clock_ns() - start;
+  return SEG_OK;
+}
+
+seg_err seg_ordered_init(seg_ordered *o, const seg_hashtable_settings *settings, uint64_t capacity)
+{
+  uint64_t index_size = ord_fit(settings, 0, capacity > 0 ? capacity - 1 : 0);
+  uint64_t usable = ord_usable_for(settings, index_size);
+  uint8_t width = ord_width_for(usable);
+
+  o->count = 0;
+  o->used = 0;
+  o->usable = usable;
+  o->index_size = index_size;
+  o->index_width = width;
+  o->initial_index_size = index_size;
+  memset(&o->counters, 0, sizeof(seg_hashtable_counters));
+
+  o->index = malloc(index_size * width);
+  if (o->index == NULL) {
+    return SEG_NOMEM("Unable to allocate hashtable index.");
+  }
+  memset(o->index, 0xff, index_size * width);
+
+  o->entries = malloc(sizeof(seg_bucket_entry) * usable);
+  if (o->entries == NULL) {
+    free(o->index);
+    return SEG_NOMEM("Unable to allocate hashtable entries.");
+  }
+
+  return SEG_OK;
+}
+
+seg_err seg_ordered_append(
+  seg_ordered *o,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  seg_bucket_entry **out
+) {
+  seg_err err;
+
+  if (o->used >= o->usable) {
+    /*
+     * The dense array is full. If at least half of it is still live, grow; otherwise, reclaiming
+     * the deleted entries makes enough room.
+     */
+    uint64_t index_size = o->index_size;
+    if (o->count + 1 > o->usable / 2) {
+      uint32_t factor = settings->table_growth_factor;
+      index_size *= factor < 2 ? 2 : factor;
+    }
+
+    err = ord_rebuild(o, settings, ord_fit(settings, index_size, o->count));
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
+
+  uint64_t slot = ord_find_free_slot(o, hashcode);
+  seg_bucket_entry *ent = &(o->entries[o->used]);
+
+  ent->hashcode = hashcode;
+  ent->key = key;
+  ent->value = NULL;
+
+  seg_ordered_index_set(o, slot, (int64_t) o->used);
+  o->used++;
+  o->count++;
+
+  *out = ent;
+  return SEG_OK;
+}
+
+seg_err seg_ordered_remove(seg_ordered *o, const seg_hashtable_settings *settings, int64_t slot)
+{
+  seg_bucket_entry *ent = seg_ordered_entry(o, slot);
+  ent->key = &ord_deleted;
+  ent->value = NULL;
+
+  seg_ordered_index_set(o, (uint64_t) slot, SEG_ORDERED_DUMMY);
+  o->count--;
+
+  uint32_t factor = settings->table_growth_factor;
+  if (settings->min_load <= 0 || factor < 2 || o->index_size <= o->initial_index_size) {
+    return SEG_OK;
+  }
+
+  float load = o->count / (float) o->index_size;
+  if (load < settings->min_load) {
+    uint64_t index_size = o->index_size / factor;
+    if (index_size < o->initial_index_size) {
+      index_size = o->initial_index_size;
+    }
+
+    return ord_rebuild(o, settings, ord_fit(settings, index_size, o->count));
+  }
+
+  return SEG_OK;
+}
+
+seg_err seg_ordered_resize(
+  seg_ordered *o,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity
+) {
+  return ord_rebuild(o, settings, ord_fit(settings, capacity, o->count));
+}
+
+seg_err seg_ordered_compact(seg_ordered *o, const seg_hashtable_settings *settings)
+{
+  if (o->used == o->count) {
+    /* Nothing has been deleted since the last rebuild. */
+    return SEG_OK;
+  }
+
+  return ord_rebuild(o, settings, ord_fit(settings, o->index_size, o->count));
+}
+
+/*
+ * Move a cursor forward from its current position to the nearest live entry.
+ */
+static void ord_seek(seg_ordered *o, seg_hashtable_cursor *cursor)
+{
+  while (cursor->position < o->used) {
+    seg_bucket_entry *ent = &(o->entries[cursor->position]);
+
+    if (ent->key != &ord_deleted) {
+      cursor->key = ent->key;
+      cursor->value = ent->value;
+      return;
+    }
+    cursor->position++;
+  }
+
+  cursor->done = true;
+}
+
+void seg_ordered_begin(seg_ordered *o, seg_hashtable_cursor *cursor)
+{
+  cursor->storage = NULL;
+  cursor->position = 0;
+  cursor->offset = 0;
+  cursor->key_length = 0;
+  cursor->done = false;
+
+  ord_seek(o, cursor);
+}
+
+void seg_ordered_next(seg_ordered *o, seg_hashtable_cursor *cursor)
+{
+  cursor->position++;
+  ord_seek(o, cursor);
+}
+
+/*
+ * Count the probe steps between the first index slot that `hashcode` selects and `slot`.
+ */
+static uint64_t ord_displacement(seg_ordered *o, uint32_t hashcode, uint64_t slot)
+{
+  uint64_t mask = o->index_size - 1;
+  uint64_t perturb = hashcode;
+  uint64_t at = hashcode & mask;
+  uint64_t steps = 0;
+
+  while (at != slot) {
+    perturb >>= SEG_ORDERED_PERTURB_SHIFT;
+    at = (at * 5 + perturb + 1) & mask;
+    steps++;
+  }
+  return steps;
+}
+
+void seg_ordered_stats(seg_ordered *o, seg_hashtable_stats *stats)
+{
+  memset(stats, 0, sizeof(seg_hashtable_stats));
+  stats->count = o->count;
+  stats->capacity = o->index_size;
+  stats->slots = o->index_size;
+  stats->counters = o->counters;
+  stats->bytes = o->index_size * o->index_width + sizeof(seg_bucket_entry) * o->usable;
+
+  for (uint64_t slot = 0; slot < o->index_size; slot++) {
+    int64_t ix = seg_ordered_index_get(o, slot);
+
+    if (ix == SEG_ORDERED_EMPTY) {
+      stats->empty_slots++;
+    } else if (ix == SEG_ORDERED_DUMMY) {
+      stats->tombstones++;
+    } else {
+      seg_hashtable_histogram_add(stats, ord_displacement(o, o->entries[ix].hashcode, slot));
+    }
+  }
+}
+
+void seg_ordered_free(seg_ordered *o)
+{
+  free(o->index);
+  free(o->entries);
+  o->index = NULL;
+  o->entries = NULL;
+}
@@ -0,0 +1,248 @@
+#ifndef ORDERED_H
+#define ORDERED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "errors.h"
+#include "ds/hashtable.h"
+#include "ds/buckets.h"
+
+/*
+ * Compact, insertion-ordered storage for the hashtables whose keys are opaque pointers.
+ *
+ * Entries are appended to a dense array in the order they're inserted. A separate, sparse index
+ * array maps each hash position to the offset of an entry within the dense array. Index elements
+ * are as narrow as the entry capacity allows: a table of a few entries needs only one byte per
+ * index slot. Iteration walks the dense array, so it visits entries in insertion order.
+ *
+ * Removing an entry marks it as deleted within the dense array and leaves a tombstone in the
+ * index. Both are reclaimed when the storage is rebuilt, which happens when the dense array fills,
+ * when the table shrinks, or on request.
+ *
+ * Rebuilds are always performed all at once: `incremental_resize_step` and the bucket settings
+ * have no effect.
+ */
+
+/* Index element values that don't refer to an entry. */
+#define SEG_ORDERED_EMPTY (-1)
+#define SEG_ORDERED_DUMMY (-2)
+
+/* Bits of the hashcode folded into each successive probe position. */
+#define SEG_ORDERED_PERTURB_SHIFT 5
+
+typedef struct {
+  /* Live entries. */
+  uint64_t count;
+
+  /* Entries appended to the dense array since it was last rebuilt, including deleted ones. */
+  uint64_t used;
+
+  /* Length of the dense array. Fixed by the index size and the maximum load. */
+  uint64_t usable;
+  seg_bucket_entry *entries;
+
+  /* Number of index elements, always a power of two, and the width of each in bytes. */
+  uint64_t index_size;
+  uint8_t index_width;
+  void *index;
+
+  uint64_t initial_index_size;
+  seg_hashtable_counters counters;
+} seg_ordered;
+
+/*
+ * Allocate storage with room for at least `capacity` entries before its first rebuild.
+ *
+ * SEG_NOMEM: If the allocation fails.
+ */
+seg_err seg_ordered_init(seg_ordered *o, const seg_hashtable_settings *settings, uint64_t capacity);
+
+/*
+ * Read or write an element of the sparse index.
+ */
+static inline int64_t seg_ordered_index_get(const seg_ordered *o, uint64_t slot)
+{
+  switch (o->index_width) {
+  case 1:
+    return ((const int8_t *) o->index)[slot];
+  case 2:
+    return ((const int16_t *) o->index)[slot];
+  case 4:
+    return ((const int32_t *) o->index)[slot];
+  default:
+    return ((const int64_t *) o->index)[slot];
+  }
+}
+
+static inline void seg_ordered_index_set(seg_ordered *o, uint64_t slot, int64_t ix)
+{
+  switch (o->index_width) {
+  case 1:
+    ((int8_t *) o->index)[slot] = (int8_t) ix;
+    break;
+  case 2:
+    ((int16_t *) o->index)[slot] = (int16_t) ix;
+    break;
+  case 4:
+    ((int32_t *) o->index)[slot] = (int32_t) ix;
+    break;
+  default:
+    ((int64_t *) o->index)[slot] = ix;
+    break;
+  }
+}
+
+/*
+ * Return the entry that an occupied index slot refers to.
+ */
+static inline seg_bucket_entry *seg_ordered_entry(seg_ordered *o, int64_t slot)
+{
+  return &(o->entries[seg_ordered_index_get(o, (uint64_t) slot)]);
+}
+
+/*
+ * Append a new entry to the dense array and index it, rebuilding the storage first if the dense
+ * array is full. The caller is responsible for verifying that `key` isn't already present.
+ *
+ * SEG_NOMEM: If a rebuild is necessary and its allocations fail.
+ */
+seg_err seg_ordered_append(
+  seg_ordered *o,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  seg_bucket_entry **out
+);
+
+/*
+ * Remove the entry referred to by an index slot located by a find function. The storage may
+ * shrink if its load falls below `min_load`, invalidating entry pointers.
+ *
+ * SEG_NOMEM: If shrinking fails.
+ */
+seg_err seg_ordered_remove(seg_ordered *o, const seg_hashtable_settings *settings, int64_t slot);
+
+/*
+ * Rebuild the storage with an index of at least `capacity` elements, or the smallest size that
+ * can hold every live entry, whichever is larger.
+ *
+ * SEG_NOMEM: If the allocations fail.
+ */
+seg_err seg_ordered_resize(
+  seg_ordered *o,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity
+);
+
+/*
+ * Squeeze deleted entries and tombstones out of the storage without changing its size.
+ *
+ * SEG_NOMEM: If the allocations fail.
+ */
+seg_err seg_ordered_compact(seg_ordered *o, const seg_hashtable_settings *settings);
+
+/*
+ * Position a cursor on the first live entry in insertion order, or mark it done if there are none.
+ */
+void seg_ordered_begin(seg_ordered *o, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next live entry in insertion order, or mark it done if there are no more.
+ */
+void seg_ordered_next(seg_ordered *o, seg_hashtable_cursor *cursor);
+
+/*
+ * Fill in the portions of `stats` that describe ordered storage.
+ */
+void seg_ordered_stats(seg_ordered *o, seg_hashtable_stats *stats);
+
+/*
+ * Release all storage.
+ */
+void seg_ordered_free(seg_ordered *o);
+
+/*
+ * Prefetch the index element that `hashcode` selects first.
+ */
+static inline void seg_ordered_prefetch(seg_ordered *o, uint32_t hashcode)
+{
+  uint64_t slot = hashcode & (o->index_size - 1);
+  SEG_BUCKETS_PREFETCH((const char *) o->index + slot * o->index_width);
+}
+
+/*
+ * Prefetch the entry that `hashcode`'s first index element refers to. Call this once the index
+ * element has had time to arrive from `seg_ordered_prefetch`.
+ */
+static inline void seg_ordered_prefetch_entry(seg_ordered *o, uint32_t hashcode)
+{
+  int64_t ix = seg_ordered_index_get(o, hashcode & (o->index_size - 1));
+  if (ix >= 0) {
+    SEG_BUCKETS_PREFETCH(&(o->entries[ix]));
+  }
+}
+
+/*
+ * Define a static function `NAME` that locates the index slot for `key` within ordered storage, or
+ * returns -1 if there is none. `EQUAL(stored, key, context)` must evaluate to true when a stored
+ * key matches the key being sought. Probes are perturbed by the upper bits of the hashcode, so that
+ * weak hash functions that only vary in their high bits don't collide into long runs. Each lookup
+ * is recorded in the storage's counters, along with the number of index elements it examined.
+ */
+#define SEG_ORDERED_DEFINE_FIND(NAME, CONTEXT_TYPE, EQUAL) \
+  static inline int64_t NAME( \
+    seg_ordered *o, \
+    uint32_t hashcode, \
+    const void *key, \
+    CONTEXT_TYPE context \
+  ) { \
+    uint64_t mask = o->index_size - 1; \
+    uint64_t perturb = hashcode; \
+    uint64_t slot = hashcode & mask; \
+    uint64_t probes = 0; \
+    (void) context; \
+    while (true) { \
+      int64_t ix = seg_ordered_index_get(o, slot); \
+      probes++; \
+      if (ix == SEG_ORDERED_EMPTY) { \
+        seg_hashtable_count_lookup(&o->counters, false, probes); \
+        return -1; \
+      } \
+      if (ix >= 0) { \
+        seg_bucket_entry *ent = &(o->entries[ix]); \
+        if (ent->hashcode == hashcode && EQUAL(ent->key, key, context)) { \
+          seg_hashtable_count_lookup(&o->counters, true, probes); \
+          return (int64_t) slot; \
+        } \
+      } \
+      perturb >>= SEG_ORDERED_PERTURB_SHIFT; \
+      slot = (slot * 5 + perturb + 1) & mask; \
+    } \
+  }
+
+/*
+ * Complete a find-or-create operation: report the entry at `found` if a find function defined by
+ * SEG_ORDERED_DEFINE_FIND located one, or append and count a new one otherwise.
+ */
+static inline seg_err seg_ordered_find_or_create(
+  seg_ordered *o,
+  const seg_hashtable_settings *settings,
+  uint32_t hashcode,
+  const void *key,
+  int64_t found,
+  seg_bucket_entry **ent,
+  bool *created
+) {
+  if (found >= 0) {
+    *ent = seg_ordered_entry(o, found);
+    *created = false;
+    return SEG_OK;
+  }
+
+  *created = true;
+  return seg_ordered_append(o, settings, hashcode, key, ent);
+}
+
+#endif
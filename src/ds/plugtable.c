@@ -4,148 +4,245 @@
 #include <stdio.h>
 
 #include "ds/plugtable.h"
-#include "ds/murmur.h"
-
-typedef struct {
-  uint32_t hashcode;
-  const void *key;
-  void *value;
-} pg_entry;
-
-typedef struct {
-  size_t length;
-  size_t capacity;
-  pg_entry *content;
-} pg_bucket;
+#include "ds/buckets.h"
+#include "ds/ordered.h"
+#include "ds/small.h"
 
 struct seg_plugtable {
-  uint64_t count;
-  uint64_t capacity;
   seg_plugtable_equal equalf;
   seg_plugtable_hash hashf;
+  seg_plugtable_layout layout;
   seg_hashtable_settings settings;
-  pg_bucket *buckets;
-};
 
-typedef struct {
-  seg_plugtable *table;
-  pg_bucket *nbuckets;
-  size_t ncapacity;
-} pg_resize_state;
+  /*
+   * Tables created with a capacity of zero keep their entries inline until they outgrow it, then
+   * move them into the storage that matches `layout`.
+   */
+  bool is_small;
+  union {
+    seg_buckets storage;
+    seg_ordered ordered;
+    seg_small small;
+  };
+};
 
 /* Internal utility methods. */
 
-seg_err pg_find_or_create_entry(
+#define PG_EQUAL(stored, key, table) ((*(table)->equalf)((stored), (key)))
+
+SEG_BUCKETS_DEFINE_FIND(pg_find, seg_plugtable *, PG_EQUAL)
+SEG_ORDERED_DEFINE_FIND(pg_find_ordered, seg_plugtable *, PG_EQUAL)
+SEG_SMALL_DEFINE_FIND(pg_find_small, seg_plugtable *, PG_EQUAL)
+
+static inline bool pg_is_ordered(seg_plugtable *table)
+{
+  return table->layout == SEG_PLUGTABLE_ORDERED;
+}
+
+/*
+ * Search for the entry of a key that's already been hashed. Return NULL if none is present.
+ */
+static inline seg_bucket_entry *pg_find_hashed(
   seg_plugtable *table,
-  pg_bucket *buckets,
-  uint64_t capacity,
   const void *key,
-  pg_entry **ent,
-  bool *created
+  uint32_t hashcode
 ) {
-  uint32_t hashcode = (*table->hashf)(key);
-  uint32_t bnum = hashcode % capacity;
-
-  pg_bucket *buck = &(buckets[bnum]);
-  pg_entry *e = NULL;
-  int bindex = 0;
-
-  if (buck->content == NULL) {
-    /* Create an empty bucket and return its first slot. */
-    buck->capacity = table->settings.init_bucket_capacity;
-    buck->length = 0;
-    buck->content = calloc(buck->capacity, sizeof(pg_entry));
-    if (buck->content == NULL) {
-      return SEG_NOMEM("Unable to allocate plugtable bucket");
-    }
+  if (table->is_small) {
+    return pg_find_small(&table->small, hashcode, key, table);
+  }
+
+  if (pg_is_ordered(table)) {
+    int64_t slot = pg_find_ordered(&table->ordered, hashcode, key, table);
+    return slot >= 0 ? seg_ordered_entry(&table->ordered, slot) : NULL;
+  }
+
+  return pg_find(&table->storage, hashcode, key, table);
+}
 
-    e = &(buck->content[0]);
+/*
+ * Move the entries of a small table into the storage that matches its layout, with room for
+ * `capacity` entries. Its inline storage is replaced.
+ */
+static seg_err pg_promote(seg_plugtable *table, uint64_t capacity)
+{
+  seg_err err;
+
+  if (pg_is_ordered(table)) {
+    err = seg_small_promote_ordered(&table->small, &table->settings, capacity, &table->ordered);
   } else {
-    /* Search for an item already present with this key. */
-    for (int i = 0; i < buck->length; i++) {
-      e = &(buck->content[i]);
-
-      if (
-        e->hashcode == hashcode && (*table->equalf)(e->key, key)
-      ) {
-        /* Found! Return this bucket and mark it as existing. */
-        *ent = e;
-        *created = false;
-        return SEG_OK;
-      }
-    }
+    err = seg_small_promote_buckets(&table->small, &table->settings, capacity, &table->storage);
+  }
 
-    /* Append and return a new entry at the bucket's end. */
-    bindex = buck->length;
+  if (err != SEG_OK) {
+    return err;
+  }
 
-    if (buck->length >= buck->capacity) {
-      /* Expand an existing bucket that has filled. */
-      buck->capacity = buck->capacity * table->settings.bucket_growth_factor;
-      buck->content = realloc(buck->content, buck->capacity);
+  table->is_small = false;
+  return SEG_OK;
+}
 
-      if (buck->content == NULL) {
-        return SEG_NOMEM("Unable to expand an existing plugtable bucket.");
-      }
+/*
+ * Advance any incremental resize that's in progress. Ordered storage always resizes all at once.
+ */
+static inline seg_err pg_migrate_step(seg_plugtable *table)
+{
+  if (table->is_small || pg_is_ordered(table)) {
+    return SEG_OK;
+  }
+
+  return seg_buckets_migrate_step(&table->storage, &table->settings);
+}
+
+/*
+ * A new entry has been created. Bucket storage may need to grow; ordered storage grows as it
+ * appends.
+ */
+static inline seg_err pg_trigger_dynamic_resize(seg_plugtable *table)
+{
+  if (table->is_small || pg_is_ordered(table)) {
+    return SEG_OK;
+  }
+
+  return seg_buckets_trigger_dynamic_resize(&table->storage, &table->settings);
+}
+
+static seg_err pg_find_or_create_entry(
+  seg_plugtable *table,
+  const void *key,
+  uint32_t hashcode,
+  seg_bucket_entry **ent,
+  bool *created
+) {
+  seg_err err;
 
-      memset(buck->content, 0, sizeof(pg_entry) * buck->capacity);
+  if (table->is_small) {
+    seg_bucket_entry *found = pg_find_small(&table->small, hashcode, key, table);
+    if (seg_small_find_or_create(&table->small, hashcode, key, found, ent, created)) {
+      return SEG_OK;
     }
 
-    e = &(buck->content[bindex]);
+    /* Full. Leave room for the same number of entries again before the storage grows. */
+    err = pg_promote(table, SEG_SMALL_CAPACITY * 2);
+    if (err != SEG_OK) {
+      return err;
+    }
   }
 
-  /* We either created or extended a bucket. Initialize the new entry. */
-  table->count++;
-  buck->length++;
+  if (pg_is_ordered(table)) {
+    int64_t found = pg_find_ordered(&table->ordered, hashcode, key, table);
 
-  e->hashcode = hashcode;
-  e->key = key;
+    return seg_ordered_find_or_create(
+      &table->ordered, &table->settings, hashcode, key, found, ent, created
+    );
+  }
 
-  *ent = e;
-  *created = true;
+  seg_bucket_entry *found = pg_find(&table->storage, hashcode, key, table);
 
-  return SEG_OK;
+  return seg_buckets_find_or_create(
+    &table->storage, &table->settings, hashcode, key, found, ent, created
+  );
 }
 
 /*
- * A new element has been added. Calculate the table's new load and trigger a capacity extension
- * if necessary.
+ * Store `value` at a key that's already been hashed. Assign the value it replaced to `out`.
  */
-seg_err pg_trigger_dynamic_resize(seg_plugtable *table)
-{
-  float load = table->count / (float) table->capacity;
-  if (load >= table->settings.max_load) {
-    return seg_plugtable_resize(table, table->capacity * table->settings.table_growth_factor);
-  }
-  return SEG_OK;
-}
+static seg_err pg_put_hashed(
+  seg_plugtable *table,
+  const void *key,
+  uint32_t hashcode,
+  void *value,
+  void **out
+) {
+  seg_err err;
 
-seg_err pg_resize_iter(const void *key, void *value, void *state)
-{
-  pg_resize_state *rs = (pg_resize_state*) state;
-  pg_entry *e;
+  seg_bucket_entry *ent;
   bool created;
+  void *result = NULL;
 
-  /* Add this entry to the new buckets structure. */
-  pg_find_or_create_entry(rs->table, rs->nbuckets, rs->ncapacity, key, &e, &created);
+  err = pg_migrate_step(table);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  err = pg_find_or_create_entry(table, key, hashcode, &ent, &created);
+  if (err != SEG_OK) {
+    return err;
+  }
 
   if (! created) {
-    return SEG_COLLISION("Unexpected collision during hash growth");
+    result = ent->value;
   }
 
-  e->value = value;
+  ent->value = value;
+
+  if (created) {
+    err = pg_trigger_dynamic_resize(table);
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
+
+  *out = result;
   return SEG_OK;
 }
 
+/*
+ * Hash up to SEG_BUCKETS_BATCH keys and prefetch the storage that they'll visit.
+ */
+static void pg_prefetch_batch(
+  seg_plugtable *table,
+  const void **keys,
+  size_t count,
+  uint32_t *hashcodes
+) {
+  if (table->is_small) {
+    /* Inline entries are already as close as they can be. */
+    for (size_t i = 0; i < count; i++) {
+      hashcodes[i] = (*table->hashf)(keys[i]);
+    }
+    return;
+  }
+
+  if (pg_is_ordered(table)) {
+    for (size_t i = 0; i < count; i++) {
+      hashcodes[i] = (*table->hashf)(keys[i]);
+      seg_ordered_prefetch(&table->ordered, hashcodes[i]);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      seg_ordered_prefetch_entry(&table->ordered, hashcodes[i]);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    hashcodes[i] = (*table->hashf)(keys[i]);
+    seg_buckets_prefetch(&table->storage, hashcodes[i]);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    seg_buckets_prefetch_entries(&table->storage, hashcodes[i]);
+  }
+}
+
 /* Public API. */
 
 uint64_t seg_plugtable_count(seg_plugtable *table)
 {
-  return table->count;
+  if (table->is_small) {
+    return table->small.count;
+  }
+
+  return pg_is_ordered(table) ? table->ordered.count : table->storage.count;
 }
 
 uint64_t seg_plugtable_capacity(seg_plugtable *table)
 {
-  return table->capacity;
+  if (table->is_small) {
+    return SEG_SMALL_CAPACITY;
+  }
+
+  return pg_is_ordered(table) ? table->ordered.index_size : table->storage.capacity;
 }
 
 seg_hashtable_settings *seg_plugtable_get_settings(seg_plugtable *table)
@@ -153,32 +250,66 @@ seg_hashtable_settings *seg_plugtable_get_settings(seg_plugtable *table)
   return &(table->settings);
 }
 
+void seg_plugtable_stats(seg_plugtable *table, seg_hashtable_stats *out)
+{
+  if (table->is_small) {
+    seg_small_stats(&table->small, out);
+  } else if (pg_is_ordered(table)) {
+    seg_ordered_stats(&table->ordered, out);
+  } else {
+    seg_buckets_stats(&table->storage, out);
+  }
+  out->bytes += sizeof(struct seg_plugtable);
+}
+
 seg_err seg_new_plugtable(
   uint64_t capacity,
   seg_plugtable_equal equalfunc,
   seg_plugtable_hash hashfunc,
   seg_plugtable **out
 ) {
+  return seg_new_plugtable_layout(capacity, SEG_PLUGTABLE_BUCKETS, equalfunc, hashfunc, out);
+}
+
+seg_err seg_new_plugtable_layout(
+  uint64_t capacity,
+  seg_plugtable_layout layout,
+  seg_plugtable_equal equalfunc,
+  seg_plugtable_hash hashfunc,
+  seg_plugtable **out
+) {
+  seg_err err;
+
   seg_plugtable *table = malloc(sizeof(struct seg_plugtable));
   if (table == NULL) {
     return SEG_NOMEM("Unable to allocate hashtable");
   }
 
-  table->capacity = capacity;
   table->equalf = equalfunc;
   table->hashf = hashfunc;
-  table->count = 0L;
+  table->layout = layout;
 
   table->settings.init_bucket_capacity = SEG_HT_INIT_BUCKET_CAPACITY;
   table->settings.bucket_growth_factor = SEG_HT_BUCKET_GROWTH_FACTOR;
   table->settings.max_load = SEG_HT_MAX_LOAD;
   table->settings.table_growth_factor = SEG_HT_TABLE_GROWTH_FACTOR;
+  table->settings.incremental_resize_step = SEG_HT_INCREMENTAL_RESIZE_STEP;
+  table->settings.min_load = SEG_HT_MIN_LOAD;
+
+  table->is_small = capacity == 0;
+  if (table->is_small) {
+    seg_small_init(&table->small);
+    err = SEG_OK;
+  } else if (pg_is_ordered(table)) {
+    err = seg_ordered_init(&table->ordered, &table->settings, capacity);
+  } else {
+    err = seg_buckets_init(&table->storage, capacity);
+  }
 
-  pg_bucket *buckets = calloc(capacity, sizeof(pg_bucket));
-  if (buckets == NULL) {
-    return SEG_NOMEM("Unable to allocate buckets for hashtable");
+  if (err != SEG_OK) {
+    free(table);
+    return err;
   }
-  table->buckets = buckets;
 
   *out = table;
   return SEG_OK;
@@ -186,72 +317,70 @@ seg_err seg_new_plugtable(
 
 seg_err seg_plugtable_resize(seg_plugtable *table, uint64_t capacity)
 {
-  seg_err err;
-
-  uint64_t orig_cap = table->capacity;
-  uint64_t orig_count = table->count;
-  if (orig_cap == capacity) {
-    return SEG_OK;
+  if (table->is_small) {
+    return capacity > 0 ? pg_promote(table, capacity) : SEG_OK;
   }
 
-  pg_bucket *nbuckets = calloc(capacity, sizeof(pg_bucket));
-
-  pg_resize_state state;
-  state.table = table;
-  state.nbuckets = nbuckets;
-  state.ncapacity = capacity;
-
-  err = seg_plugtable_each(table, pg_resize_iter, &state);
-  if (err != SEG_OK) {
-    return err;
+  if (pg_is_ordered(table)) {
+    return seg_ordered_resize(&table->ordered, &table->settings, capacity);
   }
 
-  free(table->buckets);
+  return seg_buckets_resize(&table->storage, &table->settings, capacity, false);
+}
 
-  table->capacity = capacity;
-  table->count = orig_count;
-  table->buckets = nbuckets;
+seg_err seg_plugtable_compact(seg_plugtable *table)
+{
+  if (! table->is_small && pg_is_ordered(table)) {
+    return seg_ordered_compact(&table->ordered, &table->settings);
+  }
 
+  /* Removing from bucket or inline storage leaves nothing behind to reclaim. */
   return SEG_OK;
 }
 
 seg_err seg_plugtable_put(seg_plugtable *table, const void *key, void *value, void **out)
 {
-  seg_err err;
-
-  pg_entry *ent;
-  bool created;
-  void *result = NULL;
+  return pg_put_hashed(table, key, (*table->hashf)(key), value, out);
+}
 
-  err = pg_find_or_create_entry(table, table->buckets, table->capacity, key, &ent, &created);
-  if (err != SEG_OK) {
-    return err;
-  }
+seg_err seg_plugtable_put_many(
+  seg_plugtable *table,
+  const void **keys,
+  void **values,
+  size_t count,
+  void **out
+) {
+  seg_err err;
+  uint32_t hashcodes[SEG_BUCKETS_BATCH];
 
-  if (! created) {
-    result = ent->value;
-  }
+  for (size_t base = 0; base < count; base += SEG_BUCKETS_BATCH) {
+    size_t batch = count - base < SEG_BUCKETS_BATCH ? count - base : SEG_BUCKETS_BATCH;
 
-  ent->value = value;
+    pg_prefetch_batch(table, keys + base, batch, hashcodes);
 
-  if (created) {
-    err = pg_trigger_dynamic_resize(table);
-    if (err != SEG_OK) {
-      return err;
+    for (size_t i = 0; i < batch; i++) {
+      err = pg_put_hashed(table, keys[base + i], hashcodes[i], values[base + i], &out[base + i]);
+      if (err != SEG_OK) {
+        return err;
+      }
     }
   }
 
-  *out = result;
   return SEG_OK;
 }
 
 seg_err seg_plugtable_putifabsent(seg_plugtable *table, const void *key, void *value, void **out) {
   seg_err err;
 
-  pg_entry *ent;
+  seg_bucket_entry *ent;
   bool created;
 
-  err = pg_find_or_create_entry(table, table->buckets, table->capacity, key, &ent, &created);
+  err = pg_migrate_step(table);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  err = pg_find_or_create_entry(table, key, (*table->hashf)(key), &ent, &created);
   if (err != SEG_OK) {
     return err;
   }
@@ -266,53 +395,117 @@ seg_err seg_plugtable_putifabsent(seg_plugtable *table, const void *key, void *v
     }
     *out = value;
   }
+
   return SEG_OK;
 }
 
-void *seg_plugtable_get(seg_plugtable *table, const void *key)
+seg_err seg_plugtable_remove(seg_plugtable *table, const void *key, void **out)
 {
+  seg_err err;
   uint32_t hashcode = (*table->hashf)(key);
-  uint32_t bnum = hashcode % table->capacity;
 
-  pg_bucket *buck = &(table->buckets[bnum]);
-  int bindex = 0;
+  if (table->is_small) {
+    seg_bucket_entry *ent = pg_find_small(&table->small, hashcode, key, table);
+    if (ent == NULL) {
+      /* Not present. */
+      *out = NULL;
+      return SEG_OK;
+    }
+
+    *out = ent->value;
+    seg_small_remove(&table->small, ent);
+    return SEG_OK;
+  }
+
+  if (pg_is_ordered(table)) {
+    int64_t slot = pg_find_ordered(&table->ordered, hashcode, key, table);
+    if (slot < 0) {
+      /* Not present. */
+      *out = NULL;
+      return SEG_OK;
+    }
+
+    *out = seg_ordered_entry(&table->ordered, slot)->value;
+    return seg_ordered_remove(&table->ordered, &table->settings, slot);
+  }
+
+  err = seg_buckets_migrate_step(&table->storage, &table->settings);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  seg_bucket_entry *ent = pg_find(&table->storage, hashcode, key, table);
+  if (ent == NULL) {
+    /* Not present. */
+    *out = NULL;
+    return SEG_OK;
+  }
+
+  *out = ent->value;
+  seg_buckets_remove(&table->storage, &table->settings, ent);
 
-  if(buck->content == NULL) {
-    /* Bucket empty. */
+  return seg_buckets_trigger_dynamic_shrink(&table->storage, &table->settings);
+}
+
+void *seg_plugtable_get(seg_plugtable *table, const void *key)
+{
+  seg_bucket_entry *ent = pg_find_hashed(table, key, (*table->hashf)(key));
+
+  if (ent == NULL) {
+    /* Not present. */
     return NULL;
   }
 
-  for (int i = 0; i < buck->length; i++) {
-    pg_entry *ent = &(buck->content[i]);
+  return ent->value;
+}
 
-    if (
-      ent->hashcode == hashcode && (*table->equalf)(ent->key, key)
-    ) {
-      /* Found it! */
-      return ent->value;
+void seg_plugtable_get_many(seg_plugtable *table, const void **keys, size_t count, void **out)
+{
+  uint32_t hashcodes[SEG_BUCKETS_BATCH];
+
+  for (size_t base = 0; base < count; base += SEG_BUCKETS_BATCH) {
+    size_t batch = count - base < SEG_BUCKETS_BATCH ? count - base : SEG_BUCKETS_BATCH;
+
+    pg_prefetch_batch(table, keys + base, batch, hashcodes);
+
+    for (size_t i = 0; i < batch; i++) {
+      seg_bucket_entry *ent = pg_find_hashed(table, keys[base + i], hashcodes[i]);
+      out[base + i] = ent != NULL ? ent->value : NULL;
     }
   }
+}
+
+void seg_plugtable_begin(seg_plugtable *table, seg_hashtable_cursor *cursor)
+{
+  if (table->is_small) {
+    seg_small_begin(&table->small, cursor);
+  } else if (pg_is_ordered(table)) {
+    seg_ordered_begin(&table->ordered, cursor);
+  } else {
+    seg_buckets_begin(&table->storage, cursor);
+  }
+}
 
-  /* Not present. */
-  return NULL;
+void seg_plugtable_next(seg_plugtable *table, seg_hashtable_cursor *cursor)
+{
+  if (table->is_small) {
+    seg_small_next(&table->small, cursor);
+  } else if (pg_is_ordered(table)) {
+    seg_ordered_next(&table->ordered, cursor);
+  } else {
+    seg_buckets_next(&table->storage, cursor);
+  }
 }
 
 seg_err seg_plugtable_each(seg_plugtable *table, seg_plugtable_iterator iter, void *state)
 {
   seg_err err;
+  seg_hashtable_cursor c;
 
-  for (int b = 0; b < table->capacity; b++) {
-    pg_bucket *buck = &(table->buckets[b]);
-
-    if (buck->content != NULL) {
-      for (int e = 0; e < buck->length; e++) {
-        pg_entry *ent = &(buck->content[e]);
-
-        err = (*iter)(ent->key, ent->value, state);
-        if (err != SEG_OK) {
-          return err;
-        }
-      }
+  for (seg_plugtable_begin(table, &c); ! seg_hashtable_done(&c); seg_plugtable_next(table, &c)) {
+    err = (*iter)(c.key, c.value, state);
+    if (err != SEG_OK) {
+      return err;
     }
   }
 
@@ -321,6 +514,13 @@ seg_err seg_plugtable_each(seg_plugtable *table, seg_plugtable_iterator iter, vo
 
 void seg_delete_plugtable(seg_plugtable *table)
 {
-  free(table->buckets);
+  /* Inline storage is freed along with the table. */
+  if (! table->is_small) {
+    if (pg_is_ordered(table)) {
+      seg_ordered_free(&table->ordered);
+    } else {
+      seg_buckets_free(&table->storage);
+    }
+  }
   free(table);
 }
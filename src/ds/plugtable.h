@@ -14,6 +14,22 @@
 struct seg_plugtable;
 typedef struct seg_plugtable seg_plugtable;
 
+/*
+ * Storage layouts available to a plugtable, chosen when it's created.
+ *
+ * SEG_PLUGTABLE_BUCKETS: Separately chained buckets. Supports incremental resizing. Iteration order
+ *   is unspecified.
+ * SEG_PLUGTABLE_ORDERED: A dense array of entries in insertion order, located through a compact
+ *   index of small integers. Far smaller than bucket storage for small tables, and iterates in
+ *   insertion order. Removed entries are reclaimed by rebuilding the storage, which happens
+ *   automatically as it fills or shrinks, or by `seg_plugtable_compact`. Resizes are never
+ *   incremental, and the bucket settings have no effect.
+ */
+typedef enum {
+  SEG_PLUGTABLE_BUCKETS,
+  SEG_PLUGTABLE_ORDERED
+} seg_plugtable_layout;
+
 /*
  * Signature of a function used to iterate over the key-value pairs within a ptrtable.
  */
@@ -30,7 +46,13 @@ typedef bool (*seg_plugtable_equal)(const void *left, const void *right);
 typedef uint32_t (*seg_plugtable_hash)(const void *key);
 
 /*
- * Allocate a new ptrtable with the specified initial capacity and equality and hash functions.
+ * Allocate a new ptrtable with the specified initial capacity and equality and hash functions. It
+ * uses SEG_PLUGTABLE_BUCKETS.
+ *
+ * A `capacity` of zero creates a small table, which holds up to SEG_SMALL_CAPACITY entries within
+ * its own allocation and finds them with a single scan of their hashcodes. It moves its entries
+ * into the storage of its layout when it overflows or is explicitly resized, and never moves them
+ * back. Small tables iterate in insertion order, whatever their layout.
  */
 seg_err seg_new_plugtable(
   uint64_t capacity,
@@ -39,6 +61,18 @@ seg_err seg_new_plugtable(
   seg_plugtable **out
 );
 
+/*
+ * Allocate a new plugtable with an explicit storage layout. For SEG_PLUGTABLE_ORDERED, `capacity`
+ * is the number of entries the table can hold before it first grows.
+ */
+seg_err seg_new_plugtable_layout(
+  uint64_t capacity,
+  seg_plugtable_layout layout,
+  seg_plugtable_equal equalfunc,
+  seg_plugtable_hash hashfunc,
+  seg_plugtable **out
+);
+
 /*
  * Return the number of items currently stored in a ptrtable.
  */
@@ -52,21 +86,49 @@ uint64_t seg_plugtable_capacity(seg_plugtable *table);
 /*
  * Retrieve the growth settings currently used by a ptrtable. The settings are read-write.
  */
-seg_hashtable_settings *seg_stringtable_get_settings(seg_plugtable *table);
+seg_hashtable_settings *seg_plugtable_get_settings(seg_plugtable *table);
+
+/*
+ * Take a snapshot of a plugtable's shape and usage. O(capacity).
+ */
+void seg_plugtable_stats(seg_plugtable *table, seg_hashtable_stats *out);
 
 /*
  * Resize a ptrtable's capacity. O(n). Invoked automatically during put operations if the table's
  * load increases beyond the threshold. Notice that `capacity` can be greater or less than the
  * current capacity.
+ *
+ * An explicit resize always completes before returning, including any incremental resize that was
+ * already in progress.
  */
 seg_err seg_plugtable_resize(seg_plugtable *table, uint64_t capacity);
 
+/*
+ * Reclaim the space held by removed entries. O(n) for SEG_PLUGTABLE_ORDERED tables that have had
+ * entries removed since they were last rebuilt; otherwise, does nothing.
+ */
+seg_err seg_plugtable_compact(seg_plugtable *table);
+
 /*
  * Add a new item to the ptrtable, expanding it if necessary. Return the value previously
  * assigned to `key` if one was present. Otherwise, return `NULL`.
  */
 seg_err seg_plugtable_put(seg_plugtable *table, const void *key, void *value, void **out);
 
+/*
+ * Store each of `count` values at the corresponding key, as though by `seg_plugtable_put`, and
+ * assign the value each replaced to the corresponding element of `out`. Keys are hashed and their
+ * buckets prefetched a batch at a time, so that cache misses overlap. If an error occurs, the keys
+ * before the one that failed have already been stored.
+ */
+seg_err seg_plugtable_put_many(
+  seg_plugtable *table,
+  const void **keys,
+  void **values,
+  size_t count,
+  void **out
+);
+
 /*
  * Add a new item to the stringtable if and only if `key` is currently unassigned. `out` will be
  * assigned to the existing item mapped to `key` if there was one, or the newly assigned `value`
@@ -79,15 +141,39 @@ seg_err seg_plugtable_putifabsent(
   void **out
 );
 
+/*
+ * Remove `key` from the plugtable. Assign to `out` the value that was mapped to `key`, or `NULL` if
+ * it wasn't present. The table may shrink if its load falls below its `min_load` setting.
+ */
+seg_err seg_plugtable_remove(seg_plugtable *table, const void *key, void **out);
+
 /*
  * Search for an existing value in the ptrtable at `key`. Return its value if it's
  * present, or NULL if not.
  */
 void *seg_plugtable_get(seg_plugtable *table, const void *key);
 
+/*
+ * Look up each of `count` keys, as though by `seg_plugtable_get`, and assign the results to the
+ * corresponding elements of `out`. Keys are hashed and their buckets prefetched a batch at a time,
+ * so that cache misses overlap.
+ */
+void seg_plugtable_get_many(seg_plugtable *table, const void **keys, size_t count, void **out);
+
+/*
+ * Position a cursor on the first key-value pair in the plugtable. See seg_hashtable_cursor.
+ */
+void seg_plugtable_begin(seg_plugtable *table, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next key-value pair in the plugtable.
+ */
+void seg_plugtable_next(seg_plugtable *table, seg_hashtable_cursor *cursor);
+
 /*
  * Iterate through each key-value pair in the ptrtable. `state` will be provided as-is to the
- * iterator function during each iteration.
+ * iterator function during each iteration. SEG_PLUGTABLE_ORDERED tables are iterated in insertion
+ * order. Replacing the value of an existing key doesn't change its position.
  */
 seg_err seg_plugtable_each(seg_plugtable *table, seg_plugtable_iterator iter, void *state);
 
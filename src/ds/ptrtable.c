@@ -3,155 +3,259 @@
 #include <string.h>
 #include <stdio.h>
 
-#include "ptrtable.h"
-#include "murmur.h"
-
-typedef struct {
-  uint32_t hashcode;
-  const void *key;
-  void *value;
-} pt_entry;
-
-typedef struct {
-  size_t length;
-  size_t capacity;
-  pt_entry *content;
-} pt_bucket;
+#include "ds/ptrtable.h"
+#include "ds/buckets.h"
+#include "ds/small.h"
 
 struct seg_ptrtable {
   uint32_t seed;
-  uint64_t count;
-  uint64_t capacity;
   size_t key_length;
+  seg_ptrtable_keys keys;
+  seg_hash_algorithm hash;
   seg_hashtable_settings settings;
-  pt_bucket *buckets;
-};
 
-typedef struct {
-  seg_ptrtable *table;
-  pt_bucket *nbuckets;
-  size_t ncapacity;
-} pt_resize_state;
+  /* Tables created with a capacity of zero keep their entries inline until they outgrow it. */
+  bool is_small;
+  union {
+    seg_buckets storage;
+    seg_small small;
+  };
+};
 
 /* Internal utility methods. */
 
-seg_err pt_find_or_create_entry(
-  seg_ptrtable *table,
-  pt_bucket *buckets,
-  uint64_t capacity,
-  const void *key,
-  pt_entry **ent,
-  bool *created
-) {
-  uint32_t hashcode = murmur3_32(key, (uint32_t) table->key_length, table->seed);
-  uint32_t bnum = hashcode % capacity;
-
-  pt_bucket *buck = &(buckets[bnum]);
-  pt_entry *e = NULL;
-  int bindex = 0;
-
-  if (buck->content == NULL) {
-    /* Create an empty bucket and return its first slot. */
-    buck->capacity = table->settings.init_bucket_capacity;
-    buck->length = 0;
-    buck->content = calloc(buck->capacity, sizeof(pt_entry));
+static inline uint64_t pt_load_word(const void *key)
+{
+  uint64_t word;
+  memcpy(&word, key, sizeof(uint64_t));
+  return word;
+}
 
-    if (buck->content == NULL) {
-      return SEG_NOMEM("Unable to allocate ptrtable bucket.");
-    }
+/*
+ * Multiply-shift hash of a single word. The high half of the product depends on every bit of the
+ * key, so aligned pointers with clear low bits still spread across buckets.
+ */
+static inline uint32_t pt_hash_word(uint64_t word, uint32_t seed)
+{
+  return (uint32_t) (((word ^ seed) * UINT64_C(0x9e3779b97f4a7c15)) >> 32);
+}
 
-    e = &(buck->content[0]);
-  } else {
-    /* Search for an item already present with this key. */
-    for (int i = 0; i < buck->length; i++) {
-      e = &(buck->content[i]);
-
-      if (
-        e->hashcode == hashcode && ! memcmp(e->key, key, table->key_length)
-      ) {
-        /* Found! Return this bucket and mark it as existing. */
-        *ent = e;
-        *created = false;
-        return SEG_OK;
-      }
-    }
+#define PT_BYTES_EQUAL(stored, key, key_length) (! memcmp((stored), (key), (key_length)))
+#define PT_WORD_EQUAL(stored, key, key_length) (pt_load_word(stored) == pt_load_word(key))
+#define PT_IDENTITY_EQUAL(stored, key, key_length) ((stored) == (key))
 
-    /* Append and return a new entry at the bucket's end. */
-    bindex = buck->length;
+SEG_BUCKETS_DEFINE_FIND(pt_find_bytes, size_t, PT_BYTES_EQUAL)
+SEG_BUCKETS_DEFINE_FIND(pt_find_word, size_t, PT_WORD_EQUAL)
+SEG_BUCKETS_DEFINE_FIND(pt_find_identity, size_t, PT_IDENTITY_EQUAL)
 
-    if (buck->length >= buck->capacity) {
-      /* Expand an existing bucket that has filled. */
-      buck->capacity = buck->capacity * table->settings.bucket_growth_factor;
-      buck->content = realloc(buck->content, buck->capacity);
+SEG_SMALL_DEFINE_FIND(pt_find_small_bytes, size_t, PT_BYTES_EQUAL)
+SEG_SMALL_DEFINE_FIND(pt_find_small_word, size_t, PT_WORD_EQUAL)
+SEG_SMALL_DEFINE_FIND(pt_find_small_identity, size_t, PT_IDENTITY_EQUAL)
 
-      if (buck->content == NULL) {
-        return SEG_NOMEM("Unable to expand ptrtable bucket.");
-      }
+/*
+ * Hash `key` with the table's key strategy.
+ */
+static inline uint32_t pt_hash(seg_ptrtable *table, const void *key)
+{
+  switch (table->keys) {
+  case SEG_PTRTABLE_KEYS_WORD:
+    return pt_hash_word(pt_load_word(key), table->seed);
+  case SEG_PTRTABLE_KEYS_IDENTITY:
+    return pt_hash_word((uint64_t) (uintptr_t) key, table->seed);
+  default:
+    return seg_hash(table->hash, key, table->key_length, table->seed);
+  }
+}
 
-      memset(buck->content, 0, sizeof(pt_entry) * buck->capacity);
+/*
+ * Search for the entry of a key that's already been hashed. Return NULL if none is present.
+ */
+static inline seg_bucket_entry *pt_find_hashed(
+  seg_ptrtable *table,
+  const void *key,
+  uint32_t hashcode
+) {
+  if (table->is_small) {
+    switch (table->keys) {
+    case SEG_PTRTABLE_KEYS_WORD:
+      return pt_find_small_word(&table->small, hashcode, key, table->key_length);
+    case SEG_PTRTABLE_KEYS_IDENTITY:
+      return pt_find_small_identity(&table->small, hashcode, key, table->key_length);
+    default:
+      return pt_find_small_bytes(&table->small, hashcode, key, table->key_length);
     }
+  }
 
-    e = &(buck->content[bindex]);
+  switch (table->keys) {
+  case SEG_PTRTABLE_KEYS_WORD:
+    return pt_find_word(&table->storage, hashcode, key, table->key_length);
+  case SEG_PTRTABLE_KEYS_IDENTITY:
+    return pt_find_identity(&table->storage, hashcode, key, table->key_length);
+  default:
+    return pt_find_bytes(&table->storage, hashcode, key, table->key_length);
   }
+}
 
-  /* We either created or extended a bucket. Initialize the new entry. */
-  table->count++;
-  buck->length++;
+/*
+ * Hash `key` with the table's key strategy and search for its entry. Return NULL if none is
+ * present. Either way, assign the computed hash to `hashcode`.
+ */
+static inline seg_bucket_entry *pt_find_entry(
+  seg_ptrtable *table,
+  const void *key,
+  uint32_t *hashcode
+) {
+  *hashcode = pt_hash(table, key);
+  return pt_find_hashed(table, key, *hashcode);
+}
 
-  e->hashcode = hashcode;
-  e->key = key;
+/*
+ * Move the entries of a small table into buckets. Its inline storage is replaced.
+ */
+static seg_err pt_promote(seg_ptrtable *table, uint64_t capacity)
+{
+  seg_err err;
 
-  *ent = e;
-  *created = true;
+  err = seg_small_promote_buckets(&table->small, &table->settings, capacity, &table->storage);
+  if (err != SEG_OK) {
+    return err;
+  }
 
+  table->is_small = false;
   return SEG_OK;
 }
 
 /*
- * A new element has been added. Calculate the table's new load and trigger a capacity extension
- * if necessary.
+ * Advance any incremental resize that's in progress. Small tables never have one.
  */
-seg_err pt_trigger_dynamic_resize(seg_ptrtable *table)
+static inline seg_err pt_migrate_step(seg_ptrtable *table)
 {
-  float load = table->count / (float) table->capacity;
-  if (load >= table->settings.max_load) {
-    return seg_ptrtable_resize(table, table->capacity * table->settings.table_growth_factor);
+  if (table->is_small) {
+    return SEG_OK;
   }
-  return SEG_OK;
+
+  return seg_buckets_migrate_step(&table->storage, &table->settings);
 }
 
-seg_err pt_resize_iter(const void *key, void *value, void *state)
+/*
+ * A new entry has been created. Buckets may need to grow; small tables are promoted as they fill.
+ */
+static inline seg_err pt_trigger_dynamic_resize(seg_ptrtable *table)
 {
+  if (table->is_small) {
+    return SEG_OK;
+  }
+
+  return seg_buckets_trigger_dynamic_resize(&table->storage, &table->settings);
+}
+
+static seg_err pt_find_or_create_entry(
+  seg_ptrtable *table,
+  const void *key,
+  uint32_t hashcode,
+  seg_bucket_entry **ent,
+  bool *created
+) {
+  seg_err err;
+  seg_bucket_entry *found = pt_find_hashed(table, key, hashcode);
+
+  if (table->is_small) {
+    if (seg_small_find_or_create(&table->small, hashcode, key, found, ent, created)) {
+      return SEG_OK;
+    }
+
+    /* Full. Leave room for the same number of entries again before the buckets grow. */
+    err = pt_promote(table, SEG_SMALL_CAPACITY * 2);
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
+
+  return seg_buckets_find_or_create(
+    &table->storage, &table->settings, hashcode, key, found, ent, created
+  );
+}
+
+/*
+ * Store `value` at a key that's already been hashed. Assign the value it replaced to `out`.
+ */
+static seg_err pt_put_hashed(
+  seg_ptrtable *table,
+  const void *key,
+  uint32_t hashcode,
+  void *value,
+  void **out
+) {
   seg_err err;
 
-  pt_resize_state *rs = (pt_resize_state*) state;
-  pt_entry *e;
+  seg_bucket_entry *ent;
   bool created;
+  void *result = NULL;
+
+  err = pt_migrate_step(table);
+  if (err != SEG_OK) {
+    return err;
+  }
 
-  /* Add this entry to the new buckets structure. */
-  err = pt_find_or_create_entry(rs->table, rs->nbuckets, rs->ncapacity, key, &e, &created);
+  err = pt_find_or_create_entry(table, key, hashcode, &ent, &created);
   if (err != SEG_OK) {
     return err;
   }
 
   if (! created) {
-    return SEG_COLLISION("Collision during expansion of ptrtable.");
+    result = ent->value;
   }
 
-  e->value = value;
+  ent->value = value;
+
+  if (created) {
+    err = pt_trigger_dynamic_resize(table);
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
+
+  *out = result;
   return SEG_OK;
 }
 
+/*
+ * Hash up to SEG_BUCKETS_BATCH keys and prefetch the buckets and entries that they'll visit.
+ */
+static void pt_prefetch_batch(
+  seg_ptrtable *table,
+  const void **keys,
+  size_t count,
+  uint32_t *hashcodes
+) {
+  if (table->is_small) {
+    /* Inline entries are already as close as they can be. */
+    for (size_t i = 0; i < count; i++) {
+      hashcodes[i] = pt_hash(table, keys[i]);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    hashcodes[i] = pt_hash(table, keys[i]);
+    seg_buckets_prefetch(&table->storage, hashcodes[i]);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    seg_buckets_prefetch_entries(&table->storage, hashcodes[i]);
+  }
+}
+
 /* Public API. */
 
 uint64_t seg_ptrtable_count(seg_ptrtable *table)
 {
-  return table->count;
+  return table->is_small ? table->small.count : table->storage.count;
 }
 
 uint64_t seg_ptrtable_capacity(seg_ptrtable *table)
 {
-  return table->capacity;
+  return table->is_small ? SEG_SMALL_CAPACITY : table->storage.capacity;
 }
 
 seg_hashtable_settings *seg_ptrtable_get_settings(seg_ptrtable *table)
@@ -159,103 +263,123 @@ seg_hashtable_settings *seg_ptrtable_get_settings(seg_ptrtable *table)
   return &(table->settings);
 }
 
+void seg_ptrtable_stats(seg_ptrtable *table, seg_hashtable_stats *out)
+{
+  if (table->is_small) {
+    seg_small_stats(&table->small, out);
+  } else {
+    seg_buckets_stats(&table->storage, out);
+  }
+  out->bytes += sizeof(struct seg_ptrtable);
+}
+
 seg_err seg_new_ptrtable(uint64_t capacity, uint64_t key_length, seg_ptrtable **out)
 {
+  seg_ptrtable_keys keys = SEG_PTRTABLE_KEYS_BYTES;
+  if (key_length == sizeof(uint64_t)) {
+    keys = SEG_PTRTABLE_KEYS_WORD;
+  }
+
+  return seg_new_ptrtable_keyed(capacity, key_length, keys, SEG_HASH_DEFAULT, out);
+}
+
+seg_err seg_new_ptrtable_keyed(
+  uint64_t capacity,
+  uint64_t key_length,
+  seg_ptrtable_keys keys,
+  seg_hash_algorithm hash,
+  seg_ptrtable **out
+) {
+  seg_err err;
+
+  if (keys == SEG_PTRTABLE_KEYS_WORD && key_length != sizeof(uint64_t)) {
+    return SEG_INVAL("Word-keyed ptrtables require 8-byte keys.");
+  }
+
   seg_ptrtable *table = malloc(sizeof(struct seg_ptrtable));
   if (table == NULL) {
     return SEG_NOMEM("Unable to allocate ptrtable.");
   }
 
-  table->capacity = capacity;
   table->key_length = key_length;
-  table->count = 0L;
+  table->keys = keys;
+  table->hash = hash;
   table->seed = (uint32_t) ((intptr_t) table) % UINT32_MAX;
 
   table->settings.init_bucket_capacity = SEG_HT_INIT_BUCKET_CAPACITY;
   table->settings.bucket_growth_factor = SEG_HT_BUCKET_GROWTH_FACTOR;
   table->settings.max_load = SEG_HT_MAX_LOAD;
   table->settings.table_growth_factor = SEG_HT_TABLE_GROWTH_FACTOR;
+  table->settings.incremental_resize_step = SEG_HT_INCREMENTAL_RESIZE_STEP;
+  table->settings.min_load = SEG_HT_MIN_LOAD;
 
-  pt_bucket *buckets = calloc(capacity, sizeof(pt_bucket));
-  if (buckets == NULL) {
-    return SEG_NOMEM("Unable to allocate ptrtable buckets.");
+  table->is_small = capacity == 0;
+  if (table->is_small) {
+    seg_small_init(&table->small);
+  } else {
+    err = seg_buckets_init(&table->storage, capacity);
+    if (err != SEG_OK) {
+      free(table);
+      return err;
+    }
   }
 
-  table->buckets = buckets;
   *out = table;
   return SEG_OK;
 }
 
 seg_err seg_ptrtable_resize(seg_ptrtable *table, uint64_t capacity)
 {
-  seg_err err;
-
-  uint64_t orig_cap = table->capacity;
-  uint64_t orig_count = table->count;
-  if (orig_cap == capacity) {
-    return SEG_OK;
-  }
-
-  pt_bucket *nbuckets = calloc(capacity, sizeof(pt_bucket));
-  if (nbuckets == NULL) {
-    return SEG_NOMEM("Unable to allocate resized ptrtable buckets.");
+  if (table->is_small) {
+    return capacity > 0 ? pt_promote(table, capacity) : SEG_OK;
   }
 
-  pt_resize_state state;
-  state.table = table;
-  state.nbuckets = nbuckets;
-  state.ncapacity = capacity;
-
-  err = seg_ptrtable_each(table, pt_resize_iter, &state);
-  if (err != SEG_OK) {
-    return err;
-  }
-
-  free(table->buckets);
-
-  table->capacity = capacity;
-  table->count = orig_count;
-  table->buckets = nbuckets;
-  return SEG_OK;
+  return seg_buckets_resize(&table->storage, &table->settings, capacity, false);
 }
 
 seg_err seg_ptrtable_put(seg_ptrtable *table, const void *key, void *value, void **out)
 {
-  seg_err err;
-
-  pt_entry *ent;
-  bool created;
-  void *result = NULL;
+  return pt_put_hashed(table, key, pt_hash(table, key), value, out);
+}
 
-  err = pt_find_or_create_entry(table, table->buckets, table->capacity, key, &ent, &created);
-  if (err != SEG_OK) {
-    return err;
-  }
+seg_err seg_ptrtable_put_many(
+  seg_ptrtable *table,
+  const void **keys,
+  void **values,
+  size_t count,
+  void **out
+) {
+  seg_err err;
+  uint32_t hashcodes[SEG_BUCKETS_BATCH];
 
-  if (! created) {
-    result = ent->value;
-  }
+  for (size_t base = 0; base < count; base += SEG_BUCKETS_BATCH) {
+    size_t batch = count - base < SEG_BUCKETS_BATCH ? count - base : SEG_BUCKETS_BATCH;
 
-  ent->value = value;
+    pt_prefetch_batch(table, keys + base, batch, hashcodes);
 
-  if (created) {
-    err = pt_trigger_dynamic_resize(table);
-    if (err != SEG_OK) {
-      return err;
+    for (size_t i = 0; i < batch; i++) {
+      err = pt_put_hashed(table, keys[base + i], hashcodes[i], values[base + i], &out[base + i]);
+      if (err != SEG_OK) {
+        return err;
+      }
     }
   }
 
-  *out = result;
   return SEG_OK;
 }
 
 seg_err seg_ptrtable_putifabsent(seg_ptrtable *table, const void *key, void *value, void **out) {
   seg_err err;
 
-  pt_entry *ent;
+  seg_bucket_entry *ent;
   bool created;
 
-  err = pt_find_or_create_entry(table, table->buckets, table->capacity, key, &ent, &created);
+  err = pt_migrate_step(table);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  err = pt_find_or_create_entry(table, key, pt_hash(table, key), &ent, &created);
   if (err != SEG_OK) {
     return err;
   }
@@ -274,50 +398,91 @@ seg_err seg_ptrtable_putifabsent(seg_ptrtable *table, const void *key, void *val
   return SEG_OK;
 }
 
-void *seg_ptrtable_get(seg_ptrtable *table, const void *key)
+seg_err seg_ptrtable_remove(seg_ptrtable *table, const void *key, void **out)
 {
-  uint32_t hashcode = murmur3_32(key, (uint32_t) table->key_length, table->seed);
-  uint32_t bnum = hashcode % table->capacity;
+  seg_err err;
+  uint32_t hashcode;
+
+  err = pt_migrate_step(table);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  seg_bucket_entry *ent = pt_find_entry(table, key, &hashcode);
+  if (ent == NULL) {
+    /* Not present. */
+    *out = NULL;
+    return SEG_OK;
+  }
+
+  *out = ent->value;
+
+  if (table->is_small) {
+    seg_small_remove(&table->small, ent);
+    return SEG_OK;
+  }
+
+  seg_buckets_remove(&table->storage, &table->settings, ent);
 
-  pt_bucket *buck = &(table->buckets[bnum]);
-  int bindex = 0;
+  return seg_buckets_trigger_dynamic_shrink(&table->storage, &table->settings);
+}
 
-  if(buck->content == NULL) {
-    /* Bucket empty. */
+void *seg_ptrtable_get(seg_ptrtable *table, const void *key)
+{
+  uint32_t hashcode;
+  seg_bucket_entry *ent = pt_find_entry(table, key, &hashcode);
+
+  if (ent == NULL) {
+    /* Not present. */
     return NULL;
   }
 
-  for (int i = 0; i < buck->length; i++) {
-    pt_entry *ent = &(buck->content[i]);
+  return ent->value;
+}
 
-    if (
-      ent->hashcode == hashcode && ! memcmp(ent->key, key, table->key_length)
-    ) {
-      /* Found it! */
-      return ent->value;
+void seg_ptrtable_get_many(seg_ptrtable *table, const void **keys, size_t count, void **out)
+{
+  uint32_t hashcodes[SEG_BUCKETS_BATCH];
+
+  for (size_t base = 0; base < count; base += SEG_BUCKETS_BATCH) {
+    size_t batch = count - base < SEG_BUCKETS_BATCH ? count - base : SEG_BUCKETS_BATCH;
+
+    pt_prefetch_batch(table, keys + base, batch, hashcodes);
+
+    for (size_t i = 0; i < batch; i++) {
+      seg_bucket_entry *ent = pt_find_hashed(table, keys[base + i], hashcodes[i]);
+      out[base + i] = ent != NULL ? ent->value : NULL;
     }
   }
+}
 
-  /* Not present. */
-  return NULL;
+void seg_ptrtable_begin(seg_ptrtable *table, seg_hashtable_cursor *cursor)
+{
+  if (table->is_small) {
+    seg_small_begin(&table->small, cursor);
+  } else {
+    seg_buckets_begin(&table->storage, cursor);
+  }
+}
+
+void seg_ptrtable_next(seg_ptrtable *table, seg_hashtable_cursor *cursor)
+{
+  if (table->is_small) {
+    seg_small_next(&table->small, cursor);
+  } else {
+    seg_buckets_next(&table->storage, cursor);
+  }
 }
 
 seg_err seg_ptrtable_each(seg_ptrtable *table, seg_ptrtable_iterator iter, void *state)
 {
   seg_err err;
+  seg_hashtable_cursor c;
 
-  for (int b = 0; b < table->capacity; b++) {
-    pt_bucket *buck = &(table->buckets[b]);
-
-    if (buck->content != NULL) {
-      for (int e = 0; e < buck->length; e++) {
-        pt_entry *ent = &(buck->content[e]);
-
-        err = (*iter)(ent->key, ent->value, state);
-        if (err != SEG_OK) {
-          return err;
-        }
-      }
+  for (seg_ptrtable_begin(table, &c); ! seg_hashtable_done(&c); seg_ptrtable_next(table, &c)) {
+    err = (*iter)(c.key, c.value, state);
+    if (err != SEG_OK) {
+      return err;
     }
   }
 
@@ -326,6 +491,8 @@ seg_err seg_ptrtable_each(seg_ptrtable *table, seg_ptrtable_iterator iter, void
 
 void seg_delete_ptrtable(seg_ptrtable *table)
 {
-  free(table->buckets);
+  if (! table->is_small) {
+    seg_buckets_free(&table->storage);
+  }
   free(table);
 }
@@ -6,6 +6,7 @@
 
 #include "errors.h"
 #include "ds/hashtable.h"
+#include "ds/hash.h"
 
 /*
  * Hashtable specialized for keys that are directly comparable and of uniform length. This is
@@ -15,16 +16,52 @@
 struct seg_ptrtable;
 typedef struct seg_ptrtable seg_ptrtable;
 
+/*
+ * Strategies used to hash and compare ptrtable keys. Each is compiled into its own specialized
+ * lookup path.
+ *
+ * SEG_PTRTABLE_KEYS_BYTES: Keys point to `key_length` bytes, which are hashed with the table's
+ *   hash algorithm and compared with memcmp.
+ * SEG_PTRTABLE_KEYS_WORD: Keys point to a single 64-bit word, which is hashed with a
+ *   multiply-shift and compared directly. `key_length` must be 8.
+ * SEG_PTRTABLE_KEYS_IDENTITY: The key pointers themselves are the keys and are never dereferenced.
+ *   `key_length` is ignored.
+ */
+typedef enum {
+  SEG_PTRTABLE_KEYS_BYTES,
+  SEG_PTRTABLE_KEYS_WORD,
+  SEG_PTRTABLE_KEYS_IDENTITY
+} seg_ptrtable_keys;
+
 /*
  * Signature of a function used to iterate over the key-value pairs within a ptrtable.
  */
 typedef seg_err (*seg_ptrtable_iterator)(const void *key, void *value, void *state);
 
 /*
- * Allocate a new ptrtable with the specified initial capacity and key size.
+ * Allocate a new ptrtable with the specified initial capacity and key size. 8-byte keys use
+ * SEG_PTRTABLE_KEYS_WORD; all other sizes use SEG_PTRTABLE_KEYS_BYTES with SEG_HASH_DEFAULT.
+ *
+ * A `capacity` of zero creates a small table, which holds up to SEG_SMALL_CAPACITY entries within
+ * its own allocation and finds them with a single scan of their hashcodes. It moves its entries
+ * into buckets when it overflows or is explicitly resized, and never moves them back.
  */
 seg_err seg_new_ptrtable(uint64_t capacity, uint64_t key_length, seg_ptrtable **out);
 
+/*
+ * Allocate a new ptrtable that hashes and compares its keys with an explicit strategy. `hash` is
+ * only used by SEG_PTRTABLE_KEYS_BYTES.
+ *
+ * SEG_INVAL: If `keys` is SEG_PTRTABLE_KEYS_WORD and `key_length` isn't 8.
+ */
+seg_err seg_new_ptrtable_keyed(
+  uint64_t capacity,
+  uint64_t key_length,
+  seg_ptrtable_keys keys,
+  seg_hash_algorithm hash,
+  seg_ptrtable **out
+);
+
 /*
  * Return the number of items currently stored in a ptrtable.
  */
@@ -38,12 +75,20 @@ uint64_t seg_ptrtable_capacity(seg_ptrtable *table);
 /*
  * Retrieve the growth settings currently used by a ptrtable. The settings are read-write.
  */
-seg_hashtable_settings *seg_stringtable_get_settings(seg_ptrtable *table);
+seg_hashtable_settings *seg_ptrtable_get_settings(seg_ptrtable *table);
+
+/*
+ * Take a snapshot of a ptrtable's shape and usage. O(capacity).
+ */
+void seg_ptrtable_stats(seg_ptrtable *table, seg_hashtable_stats *out);
 
 /*
  * Resize a ptrtable's capacity. O(n). Invoked automatically during put operations if the table's
  * load increases beyond the threshold. Notice that `capacity` can be greater or less than the
  * current capacity.
+ *
+ * An explicit resize always completes before returning, including any incremental resize that was
+ * already in progress.
  */
 seg_err seg_ptrtable_resize(seg_ptrtable *table, uint64_t capacity);
 
@@ -53,6 +98,20 @@ seg_err seg_ptrtable_resize(seg_ptrtable *table, uint64_t capacity);
  */
 seg_err seg_ptrtable_put(seg_ptrtable *table, const void *key, void *value, void **out);
 
+/*
+ * Store each of `count` values at the corresponding key, as though by `seg_ptrtable_put`, and
+ * assign the value each replaced to the corresponding element of `out`. Keys are hashed and their
+ * buckets prefetched a batch at a time, so that cache misses overlap. If an error occurs, the keys
+ * before the one that failed have already been stored.
+ */
+seg_err seg_ptrtable_put_many(
+  seg_ptrtable *table,
+  const void **keys,
+  void **values,
+  size_t count,
+  void **out
+);
+
 /*
  * Add a new item to the stringtable if and only if `key` is currently unassigned. Return the
  * existing item mapped to `key` if there was one, or the newly assigned `value` otherwise.
@@ -64,12 +123,35 @@ seg_err seg_ptrtable_putifabsent(
   void **out
 );
 
+/*
+ * Remove `key` from the ptrtable. Assign to `out` the value that was mapped to `key`, or `NULL` if
+ * it wasn't present. The table may shrink if its load falls below its `min_load` setting.
+ */
+seg_err seg_ptrtable_remove(seg_ptrtable *table, const void *key, void **out);
+
 /*
  * Search for an existing value in the ptrtable at `key`. Return the value or `NULL` if it's not
  * present.
  */
 void *seg_ptrtable_get(seg_ptrtable *table, const void *key);
 
+/*
+ * Look up each of `count` keys, as though by `seg_ptrtable_get`, and assign the results to the
+ * corresponding elements of `out`. Keys are hashed and their buckets prefetched a batch at a time,
+ * so that cache misses overlap.
+ */
+void seg_ptrtable_get_many(seg_ptrtable *table, const void **keys, size_t count, void **out);
+
+/*
+ * Position a cursor on the first key-value pair in the ptrtable. See seg_hashtable_cursor.
+ */
+void seg_ptrtable_begin(seg_ptrtable *table, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next key-value pair in the ptrtable.
+ */
+void seg_ptrtable_next(seg_ptrtable *table, seg_hashtable_cursor *cursor);
+
 /*
  * Iterate through each key-value pair in the ptrtable. `state` will be provided as-is to the
  * iterator function during each iteration.
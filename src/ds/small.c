@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "ds/small.h"
+
+void seg_small_init(seg_small *s)
+{
+  s->count = 0;
+  memset(s->hashcodes, 0, sizeof(s->hashcodes));
+  memset(&s->counters, 0, sizeof(seg_hashtable_counters));
+}
+
+seg_bucket_entry *seg_small_append(seg_small *s, uint32_t hashcode, const void *key)
+{
+  seg_bucket_entry *ent = &(s->entries[s->count]);
+
+  s->hashcodes[s->count] = hashcode;
+  ent->hashcode = hashcode;
+  ent->key = key;
+  ent->value = NULL;
+
+  s->count++;
+  return ent;
+}
+
+void seg_small_remove(seg_small *s, seg_bucket_entry *ent)
+{
+  size_t i = (size_t) (ent - s->entries);
+  size_t following = s->count - i - 1;
+
+  memmove(&(s->entries[i]), &(s->entries[i + 1]), sizeof(seg_bucket_entry) * following);
+  memmove(&(s->hashcodes[i]), &(s->hashcodes[i + 1]), sizeof(uint32_t) * following);
+  s->count--;
+}
+
+seg_err seg_small_promote_buckets(
+  seg_small *s,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  seg_buckets *out
+) {
+  seg_err err;
+  seg_buckets storage;
+  uint64_t start = seg_hashtable_clock_ns();
+
+  err = seg_buckets_init(&storage, capacity);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  for (uint32_t i = 0; i < s->count; i++) {
+    seg_bucket_entry *ent;
+
+    err = seg_buckets_append(&storage, settings, s->hashcodes[i], s->entries[i].key, &ent);
+    if (err != SEG_OK) {
+      seg_buckets_free(&storage);
+      return err;
+    }
+    ent->value = s->entries[i].value;
+  }
+
+  storage.count = s->count;
+  storage.counters = s->counters;
+  storage.counters.resizes++;
+  storage.counters.resize_ns += seg_hashtable_clock_ns() - start;
+
+  *out = storage;
+  return SEG_OK;
+}
+
+seg_err seg_small_promote_ordered(
+  seg_small *s,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  seg_ordered *out
+) {
+  seg_err err;
+  seg_ordered storage;
+  uint64_t start = seg_hashtable_clock_ns();
+
+  err = seg_ordered_init(&storage, settings, capacity);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  for (uint32_t i = 0; i < s->count; i++) {
+    seg_bucket_entry *ent;
+
+    err = seg_ordered_append(&storage, settings, s->hashcodes[i], s->entries[i].key, &ent);
+    if (err != SEG_OK) {
+      seg_ordered_free(&storage);
+      return err;
+    }
+    ent->value = s->entries[i].value;
+  }
+
+  storage.counters = s->counters;
+  storage.counters.resizes++;
+  storage.counters.resize_ns += seg_hashtable_clock_ns() - start;
+
+  *out = storage;
+  return SEG_OK;
+}
+
+/*
+ * Load the entry at a cursor's position, or mark it done if it's past the last one.
+ */
+static void small_seek(seg_small *s, seg_hashtable_cursor *cursor)
+{
+  if (cursor->position >= s->count) {
+    cursor->done = true;
+    return;
+  }
+
+  cursor->key = s->entries[cursor->position].key;
+  cursor->value = s->entries[cursor->position].value;
+}
+
+void seg_small_begin(seg_small *s, seg_hashtable_cursor *cursor)
+{
+  cursor->storage = NULL;
+  cursor->position = 0;
+  cursor->offset = 0;
+  cursor->key_length = 0;
+  cursor->done = false;
+
+  small_seek(s, cursor);
+}
+
+void seg_small_next(seg_small *s, seg_hashtable_cursor *cursor)
+{
+  cursor->position++;
+  small_seek(s, cursor);
+}
+
+void seg_small_stats(seg_small *s, seg_hashtable_stats *stats)
+{
+  memset(stats, 0, sizeof(seg_hashtable_stats));
+  stats->count = s->count;
+  stats->capacity = SEG_SMALL_CAPACITY;
+  stats->slots = SEG_SMALL_CAPACITY;
+  stats->empty_slots = SEG_SMALL_CAPACITY - s->count;
+  stats->counters = s->counters;
+
+  /* Every entry is found by the same single scan. */
+  for (uint32_t i = 0; i < s->count; i++) {
+    seg_hashtable_histogram_add(stats, 0);
+  }
+}
@@ -0,0 +1,192 @@
+#ifndef SMALL_H
+#define SMALL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "errors.h"
+#include "ds/hashtable.h"
+#include "ds/buckets.h"
+#include "ds/ordered.h"
+#include "ds/ctrlgroup.h"
+
+/*
+ * Inline storage for hashtables that hold only a handful of entries, embedded directly within the
+ * table that owns it so that small tables need no allocations beyond the table itself.
+ *
+ * Entries are kept in insertion order. Their hashcodes are duplicated into a separate array, which
+ * a lookup scans all at once; only the entries whose hashcodes match have their keys compared.
+ * Once the storage is full, the owning table is expected to move its entries into hashed storage.
+ */
+
+/* Entries that fit inline. The hashcode scan covers all of them at once. */
+#define SEG_SMALL_CAPACITY 8
+
+typedef struct {
+  uint32_t count;
+  uint32_t hashcodes[SEG_SMALL_CAPACITY];
+  seg_bucket_entry entries[SEG_SMALL_CAPACITY];
+
+  seg_hashtable_counters counters;
+} seg_small;
+
+/*
+ * Return a mask with one bit set for each of the first `count` hashcodes that equal `hashcode`.
+ */
+#if defined(__AVX2__)
+
+static inline seg_ctrlmask seg_small_match(const seg_small *s, uint32_t hashcode)
+{
+  __m256i hashes = _mm256_loadu_si256((const __m256i *) s->hashcodes);
+  __m256i eq = _mm256_cmpeq_epi32(hashes, _mm256_set1_epi32((int) hashcode));
+  seg_ctrlmask mask = (seg_ctrlmask) _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+  return mask & ((1u << s->count) - 1);
+}
+
+#elif defined(__SSE2__)
+
+static inline seg_ctrlmask seg_small_match(const seg_small *s, uint32_t hashcode)
+{
+  __m128i needle = _mm_set1_epi32((int) hashcode);
+  __m128i low = _mm_loadu_si128((const __m128i *) s->hashcodes);
+  __m128i high = _mm_loadu_si128((const __m128i *) (s->hashcodes + 4));
+  __m128 eqlow = _mm_castsi128_ps(_mm_cmpeq_epi32(low, needle));
+  __m128 eqhigh = _mm_castsi128_ps(_mm_cmpeq_epi32(high, needle));
+  seg_ctrlmask mask = (seg_ctrlmask) (_mm_movemask_ps(eqlow) | (_mm_movemask_ps(eqhigh) << 4));
+  return mask & ((1u << s->count) - 1);
+}
+
+#else
+
+static inline seg_ctrlmask seg_small_match(const seg_small *s, uint32_t hashcode)
+{
+  seg_ctrlmask mask = 0;
+  for (uint32_t i = 0; i < s->count; i++) {
+    if (s->hashcodes[i] == hashcode) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+}
+
+#endif
+
+/*
+ * Start with no entries.
+ */
+void seg_small_init(seg_small *s);
+
+/*
+ * True if another entry can't be appended.
+ */
+static inline bool seg_small_full(const seg_small *s)
+{
+  return s->count >= SEG_SMALL_CAPACITY;
+}
+
+/*
+ * Append a new entry. The caller is responsible for verifying that `key` isn't already present and
+ * that the storage isn't full.
+ */
+seg_bucket_entry *seg_small_append(seg_small *s, uint32_t hashcode, const void *key);
+
+/*
+ * Remove an entry located by a find function. The entries after it are shifted down to preserve
+ * insertion order, invalidating pointers to them.
+ */
+void seg_small_remove(seg_small *s, seg_bucket_entry *ent);
+
+/*
+ * Move every entry into newly initialized bucket or ordered storage with room for `capacity`
+ * entries, carrying the accumulated counters along. The move is counted as a resize. `out` may
+ * share memory with `s`: it's only written once every entry has been moved, and `s` is left
+ * untouched on failure.
+ *
+ * SEG_NOMEM: If the new storage can't be allocated.
+ */
+seg_err seg_small_promote_buckets(
+  seg_small *s,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  seg_buckets *out
+);
+
+seg_err seg_small_promote_ordered(
+  seg_small *s,
+  const seg_hashtable_settings *settings,
+  uint64_t capacity,
+  seg_ordered *out
+);
+
+/*
+ * Position a cursor on the first entry in insertion order, or mark it done if there are none.
+ */
+void seg_small_begin(seg_small *s, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next entry in insertion order, or mark it done if there are no more.
+ */
+void seg_small_next(seg_small *s, seg_hashtable_cursor *cursor);
+
+/*
+ * Fill in the portions of `stats` that describe inline storage. It owns no heap memory.
+ */
+void seg_small_stats(seg_small *s, seg_hashtable_stats *stats);
+
+/*
+ * Define a static function `NAME` that locates the entry for `key` within inline storage, or
+ * returns NULL if there is none. `EQUAL(stored, key, context)` must evaluate to true when a stored
+ * key matches the key being sought. Every lookup scans the hashcodes once, which is recorded in
+ * the storage's counters as a single probe.
+ */
+#define SEG_SMALL_DEFINE_FIND(NAME, CONTEXT_TYPE, EQUAL) \
+  static inline seg_bucket_entry *NAME( \
+    seg_small *s, \
+    uint32_t hashcode, \
+    const void *key, \
+    CONTEXT_TYPE context \
+  ) { \
+    seg_ctrlmask mask = seg_small_match(s, hashcode); \
+    (void) context; \
+    while (mask != 0) { \
+      seg_bucket_entry *ent = &(s->entries[seg_ctrlmask_first(mask)]); \
+      if (EQUAL(ent->key, key, context)) { \
+        seg_hashtable_count_lookup(&s->counters, true, 1); \
+        return ent; \
+      } \
+      mask = SEG_CTRLMASK_NEXT(mask); \
+    } \
+    seg_hashtable_count_lookup(&s->counters, false, 1); \
+    return NULL; \
+  }
+
+/*
+ * Complete a find-or-create operation: report `found` if a find function defined by
+ * SEG_SMALL_DEFINE_FIND located an existing entry, or append a new one otherwise. Return false
+ * without doing either if a new entry is needed but the storage is full.
+ */
+static inline bool seg_small_find_or_create(
+  seg_small *s,
+  uint32_t hashcode,
+  const void *key,
+  seg_bucket_entry *found,
+  seg_bucket_entry **ent,
+  bool *created
+) {
+  if (found != NULL) {
+    *ent = found;
+    *created = false;
+    return true;
+  }
+
+  if (seg_small_full(s)) {
+    return false;
+  }
+
+  *ent = seg_small_append(s, hashcode, key);
+  *created = true;
+  return true;
+}
+
+#endif
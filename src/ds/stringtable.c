@@ -6,107 +6,388 @@
 #include <stdio.h>
 
 #include "stringtable.h"
-#include "murmur.h"
+#include "ctrlgroup.h"
+#include "ds/hash.h"
+
+/*
+ * Stringtables are open-addressed. Slots are arranged in groups of SEG_CTRLGROUP_WIDTH, each
+ * described by a control byte within a parallel `ctrl` array. Probing visits whole groups at a
+ * time, comparing the seven-bit hash fragment in each control byte before touching any entries.
+ *
+ * Removing an entry leaves a tombstone (a deleted control byte) behind, unless its group still
+ * contains an empty slot: a group that has never filled can't have been passed over by any probe
+ * sequence, so the slot may safely become empty again. Tombstones count against the table's
+ * occupancy until the next rehash clears them.
+ *
+ * While an incremental resize is in progress, `previous` holds the slots being migrated away from.
+ * Migrated slots are marked as deleted so that probe sequences through `previous` stay intact.
+ *
+ * Keys are copied into an append-only arena owned by the table. Entries refer to their keys by
+ * offset, so the arena may be reallocated as it grows without invalidating them. The bytes of
+ * removed keys are reclaimed by compacting the arena once they outweigh the live keys.
+ */
 
 typedef struct {
   uint32_t hashcode;
-  const char *key;
-  size_t key_length;
+  uint32_t key_length;
+  uint64_t key_offset;
   void *value;
 } st_entry;
 
+/* Initial size of a table's key arena, in bytes, allocated when the first key is stored. */
+#define ST_ARENA_INIT_CAPACITY 256
+
 typedef struct {
-  size_t length;
-  size_t capacity;
-  st_entry *content;
-} st_bucket;
+  char *bytes;
+  uint64_t length;
+  uint64_t capacity;
+
+  /* Bytes within `length` that belong to removed keys. */
+  uint64_t garbage;
+} st_arena;
+
+typedef struct {
+  uint64_t slot_count;
+  uint64_t tombstones;
+  int8_t *ctrl;
+  st_entry *entries;
+} st_slots;
 
 struct seg_stringtable {
   uint32_t seed;
+  seg_hash_algorithm hash;
   uint64_t count;
   uint64_t capacity;
+  uint64_t initial_capacity;
   seg_hashtable_settings settings;
-  st_bucket *buckets;
+  st_slots slots;
+  st_slots previous;
+  uint64_t migrated;
+  st_arena keys;
+  seg_hashtable_counters counters;
 };
 
-typedef struct {
-  seg_stringtable *table;
-  st_bucket *nbuckets;
-  size_t ncapacity;
-} st_resize_state;
-
 /* Internal utility methods. */
 
-seg_err st_find_or_create_entry(
-  seg_stringtable *table,
-  st_bucket *buckets,
-  size_t capacity,
-  const char *key,
-  size_t key_length,
-  st_entry **ent,
-  bool *created
-) {
-  uint32_t hashcode = murmur3_32(key, (uint32_t) key_length, table->seed);
-  uint32_t bnum = hashcode % capacity;
+/*
+ * Compute the number of slots needed to hold a table of the given logical capacity with room to
+ * spare for at least `count` entries. Slot counts are powers of two and multiples of the group
+ * width, so that groups can be selected by masking.
+ */
+static uint64_t st_slot_count_for(uint64_t capacity, uint64_t count)
+{
+  uint64_t minimum = capacity;
+
+  /* Never let an open-addressed table fill past seven-eighths of its slots. */
+  uint64_t needed = count + (count / 7) + 1;
+  if (needed > minimum) {
+    minimum = needed;
+  }
+
+  uint64_t slot_count = SEG_CTRLGROUP_WIDTH;
+  while (slot_count < minimum) {
+    slot_count <<= 1;
+  }
+  return slot_count;
+}
+
+static seg_err st_slots_init(st_slots *slots, uint64_t slot_count)
+{
+  int8_t *ctrl = aligned_alloc(SEG_CTRLGROUP_WIDTH, slot_count);
+  if (ctrl == NULL) {
+    return SEG_NOMEM("Unable to allocate stringtable control bytes.");
+  }
+
+  st_entry *entries = malloc(sizeof(st_entry) * slot_count);
+  if (entries == NULL) {
+    free(ctrl);
+    return SEG_NOMEM("Unable to allocate stringtable entries.");
+  }
+
+  memset(ctrl, (uint8_t) SEG_CTRL_EMPTY, slot_count);
+
+  slots->slot_count = slot_count;
+  slots->tombstones = 0;
+  slots->ctrl = ctrl;
+  slots->entries = entries;
+  return SEG_OK;
+}
 
-  st_bucket *buck = &(buckets[bnum]);
-  st_entry *e = NULL;
-  int bindex = 0;
+static void st_slots_free(st_slots *slots)
+{
+  free(slots->ctrl);
+  free(slots->entries);
+}
 
-  if (buck->content == NULL) {
-    /* Create an empty bucket and return its first slot. */
-    buck->capacity = table->settings.init_bucket_capacity;
-    buck->length = 0;
-    buck->content = calloc(buck->capacity, sizeof(st_entry));
+/*
+ * Copy a key to the end of the key arena, growing it geometrically if it's full. Report the
+ * offset at which the key was stored.
+ */
+static seg_err st_arena_append(st_arena *arena, const char *key, size_t key_length, uint64_t *offset)
+{
+  if (arena->bytes == NULL || arena->length + key_length > arena->capacity) {
+    uint64_t ncapacity = arena->capacity > 0 ? arena->capacity * 2 : ST_ARENA_INIT_CAPACITY;
+    while (ncapacity < arena->length + key_length) {
+      ncapacity *= 2;
+    }
 
-    if (buck->content == NULL) {
-      return SEG_NOMEM("Unable to allocate stringtable bucket.");
+    char *nbytes = realloc(arena->bytes, ncapacity);
+    if (nbytes == NULL) {
+      return SEG_NOMEM("Unable to expand stringtable key arena.");
     }
 
-    e = &(buck->content[0]);
-  } else {
-    /* Search for an item already present with this key. */
-    for (int i = 0; i < buck->length; i++) {
-      e = &(buck->content[i]);
+    arena->bytes = nbytes;
+    arena->capacity = ncapacity;
+  }
+
+  memcpy(arena->bytes + arena->length, key, key_length);
+  *offset = arena->length;
+  arena->length += key_length;
+
+  return SEG_OK;
+}
+
+/*
+ * Locate the slot that holds `key`, or return -1 if it's not present. Groups are visited in
+ * triangular order, which reaches every group when the group count is a power of two. Add the
+ * number of groups visited to `probes`.
+ */
+static int64_t st_find_slot(
+  st_slots *slots,
+  const char *arena,
+  uint32_t hashcode,
+  const char *key,
+  size_t key_length,
+  uint64_t *probes
+) {
+  uint64_t group_mask = (slots->slot_count / SEG_CTRLGROUP_WIDTH) - 1;
+  uint64_t group = SEG_CTRL_H1(hashcode) & group_mask;
+  int8_t h2 = SEG_CTRL_H2(hashcode);
+
+  for (uint64_t stride = 1; stride <= group_mask + 1; stride++) {
+    const int8_t *ctrl = slots->ctrl + group * SEG_CTRLGROUP_WIDTH;
+    (*probes)++;
+
+    seg_ctrlmask match = seg_ctrlgroup_match(ctrl, h2);
+    while (match) {
+      uint64_t slot = group * SEG_CTRLGROUP_WIDTH + seg_ctrlmask_first(match);
+      st_entry *e = &(slots->entries[slot]);
 
       if (
         e->hashcode == hashcode && e->key_length == key_length &&
-        ! memcmp(e->key, key, key_length)
+        ! memcmp(arena + e->key_offset, key, key_length)
       ) {
-        /* Found! Return this bucket and mark it as existing. */
-        *ent = e;
-        *created = false;
-        return SEG_OK;
+        return (int64_t) slot;
       }
+
+      match = SEG_CTRLMASK_NEXT(match);
     }
 
-    /* Append and return a new entry at the bucket's end. */
-    bindex = buck->length;
+    if (seg_ctrlgroup_match_empty(ctrl)) {
+      /* An empty slot terminates the probe sequence. */
+      return -1;
+    }
 
-    if (buck->length >= buck->capacity) {
-      /* Expand an existing bucket that has filled. */
-      buck->capacity = buck->capacity * table->settings.bucket_growth_factor;
-      buck->content = realloc(buck->content, buck->capacity);
+    group = (group + stride) & group_mask;
+  }
 
-      if (buck->content == NULL) {
-        return SEG_NOMEM("Unable to expand stringtable bucket.");
-      }
+  return -1;
+}
 
-      memset(buck->content, 0, sizeof(st_entry) * buck->capacity);
+/*
+ * Locate the first available slot along `hashcode`'s probe sequence. The caller must already have
+ * verified that the key isn't present.
+ */
+static uint64_t st_find_available_slot(st_slots *slots, uint32_t hashcode)
+{
+  uint64_t group_mask = (slots->slot_count / SEG_CTRLGROUP_WIDTH) - 1;
+  uint64_t group = SEG_CTRL_H1(hashcode) & group_mask;
+
+  for (uint64_t stride = 1; ; stride++) {
+    seg_ctrlmask available = seg_ctrlgroup_match_available(slots->ctrl + group * SEG_CTRLGROUP_WIDTH);
+    if (available) {
+      return group * SEG_CTRLGROUP_WIDTH + seg_ctrlmask_first(available);
     }
 
-    e = &(buck->content[bindex]);
+    group = (group + stride) & group_mask;
   }
+}
 
-  /* We either created or extended a bucket. Initialize the new entry. */
-  table->count++;
-  buck->length++;
+static st_entry *st_fill_slot(
+  st_slots *slots,
+  uint32_t hashcode,
+  uint64_t key_offset,
+  uint32_t key_length
+) {
+  uint64_t slot = st_find_available_slot(slots, hashcode);
+  st_entry *e = &(slots->entries[slot]);
+
+  if (slots->ctrl[slot] == SEG_CTRL_DELETED) {
+    slots->tombstones--;
+  }
 
+  slots->ctrl[slot] = SEG_CTRL_H2(hashcode);
   e->hashcode = hashcode;
-  e->key = key;
+  e->key_offset = key_offset;
   e->key_length = key_length;
+  e->value = NULL;
+  return e;
+}
+
+/*
+ * Vacate a full slot. Leave a tombstone unless the slot's group has never been filled.
+ */
+static void st_clear_slot(st_slots *slots, uint64_t slot)
+{
+  const int8_t *group = slots->ctrl + (slot / SEG_CTRLGROUP_WIDTH) * SEG_CTRLGROUP_WIDTH;
+
+  if (seg_ctrlgroup_match_empty(group)) {
+    slots->ctrl[slot] = SEG_CTRL_EMPTY;
+  } else {
+    slots->ctrl[slot] = SEG_CTRL_DELETED;
+    slots->tombstones++;
+  }
+}
+
+static bool st_migrating(seg_stringtable *table)
+{
+  return table->previous.slot_count > 0;
+}
+
+/*
+ * Move up to `limit` slots' worth of entries from the previous slot array into the current one.
+ * Release the previous slots once they've been completely drained.
+ */
+static void st_migrate(seg_stringtable *table, uint64_t limit)
+{
+  st_slots *previous = &table->previous;
+  uint64_t end = table->migrated + limit;
+  if (end > previous->slot_count || limit == 0) {
+    end = previous->slot_count;
+  }
+
+  /* Hashcodes are cached in each entry, so entries can be moved without rehashing their keys. */
+  for (uint64_t i = table->migrated; i < end; i++) {
+    if (SEG_CTRL_ISFULL(previous->ctrl[i])) {
+      st_entry *e = &(previous->entries[i]);
+      st_entry *ne = st_fill_slot(&table->slots, e->hashcode, e->key_offset, e->key_length);
+      ne->value = e->value;
+
+      previous->ctrl[i] = SEG_CTRL_DELETED;
+      previous->tombstones++;
+    }
+  }
+  table->migrated = end;
+
+  if (table->migrated >= previous->slot_count) {
+    st_slots_free(previous);
+    previous->slot_count = 0;
+    table->migrated = 0;
+  }
+}
+
+/*
+ * Advance any incremental resize that's in progress. Called at the start of each mutating
+ * operation, before any entry pointers are handed out.
+ */
+static void st_migrate_step(seg_stringtable *table)
+{
+  if (st_migrating(table)) {
+    uint64_t start = seg_hashtable_clock_ns();
+    st_migrate(table, table->settings.incremental_resize_step);
+    table->counters.resize_ns += seg_hashtable_clock_ns() - start;
+  }
+}
+
+/*
+ * Replace the table's slots with a fresh array sized for `capacity`. If `incremental` is true,
+ * existing entries are left in place to be migrated by later operations; otherwise, they're all
+ * moved immediately.
+ */
+static seg_err st_begin_resize(seg_stringtable *table, uint64_t capacity, bool incremental)
+{
+  seg_err err;
+
+  /* Only one migration may be in flight at a time. Finish any that's already underway. */
+  if (st_migrating(table)) {
+    st_migrate(table, 0);
+  }
+
+  uint64_t slot_count = st_slot_count_for(capacity, table->count);
+  if (slot_count == table->slots.slot_count && table->slots.tombstones == 0) {
+    /* The existing slots are already the right size. */
+    table->capacity = capacity;
+    return SEG_OK;
+  }
+
+  st_slots nslots;
+  err = st_slots_init(&nslots, slot_count);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  table->previous = table->slots;
+  table->migrated = 0;
+  table->slots = nslots;
+  table->capacity = capacity;
+  table->counters.resizes++;
+
+  if (! incremental) {
+    uint64_t start = seg_hashtable_clock_ns();
+    st_migrate(table, 0);
+    table->counters.resize_ns += seg_hashtable_clock_ns() - start;
+  }
+
+  return SEG_OK;
+}
+
+static seg_err st_find_or_create_entry(
+  seg_stringtable *table,
+  const char *key,
+  size_t key_length,
+  st_entry **ent,
+  bool *created
+) {
+  seg_err err;
+
+  if (key_length > UINT32_MAX) {
+    return SEG_RANGE("Stringtable key is too long.");
+  }
+
+  uint32_t hashcode = seg_hash(table->hash, key, key_length, table->seed);
+  uint64_t probes = 0;
+
+  int64_t slot = st_find_slot(&table->slots, table->keys.bytes, hashcode, key, key_length, &probes);
+  if (slot >= 0) {
+    /* Found! Return this entry and mark it as existing. */
+    seg_hashtable_count_lookup(&table->counters, true, probes);
+    *ent = &(table->slots.entries[slot]);
+    *created = false;
+    return SEG_OK;
+  }
 
-  *ent = e;
+  if (st_migrating(table)) {
+    slot = st_find_slot(&table->previous, table->keys.bytes, hashcode, key, key_length, &probes);
+    if (slot >= 0) {
+      /* Found among the entries that haven't been migrated yet. */
+      seg_hashtable_count_lookup(&table->counters, true, probes);
+      *ent = &(table->previous.entries[slot]);
+      *created = false;
+      return SEG_OK;
+    }
+  }
+
+  seg_hashtable_count_lookup(&table->counters, false, probes);
+
+  uint64_t key_offset = 0;
+  err = st_arena_append(&table->keys, key, key_length, &key_offset);
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  table->count++;
+
+  *ent = st_fill_slot(&table->slots, hashcode, key_offset, (uint32_t) key_length);
   *created = true;
 
   return SEG_OK;
@@ -114,39 +395,132 @@ seg_err st_find_or_create_entry(
 
 /*
  * A new element has been added. Calculate the table's new load and trigger a capacity extension
- * if necessary.
+ * if necessary. Tombstones occupy slots as surely as live entries do, so a table that's crowded
+ * with them is rehashed at its current capacity instead.
  */
-seg_err st_trigger_dynamic_resize(seg_stringtable *table)
+static seg_err st_trigger_dynamic_resize(seg_stringtable *table)
 {
   float load = table->count / (float) table->capacity;
+  uint64_t occupied = table->count + table->slots.tombstones;
+  bool crowded = st_slot_count_for(0, occupied + 1) > table->slots.slot_count;
+  bool incremental = table->settings.incremental_resize_step > 0;
+
   if (load >= table->settings.max_load) {
-    return seg_stringtable_resize(table, table->capacity * table->settings.table_growth_factor);
+    uint64_t capacity = table->capacity * table->settings.table_growth_factor;
+
+    return st_begin_resize(table, capacity, incremental);
+  }
+
+  if (crowded) {
+    return st_begin_resize(table, table->capacity, incremental);
   }
+
   return SEG_OK;
 }
 
-seg_err st_resize_iter(const char *key, const uint64_t key_length, void *value, void *state)
+/*
+ * An element has been removed. If the table's load has fallen below `min_load`, shrink it, but
+ * never below the capacity it was created with.
+ */
+static seg_err st_trigger_dynamic_shrink(seg_stringtable *table)
 {
-  seg_err err;
+  uint32_t factor = table->settings.table_growth_factor;
 
-  st_resize_state *rs = (st_resize_state*) state;
-  st_entry *e;
-  bool created;
+  if (table->settings.min_load <= 0 || factor < 2 || table->capacity <= table->initial_capacity) {
+    return SEG_OK;
+  }
 
-  /* Add this entry to the new buckets structure. */
-  err = st_find_or_create_entry(rs->table, rs->nbuckets, rs->ncapacity, key, key_length, &e, &created);
-  if (err != SEG_OK) {
-    return err;
+  float load = table->count / (float) table->capacity;
+  if (load < table->settings.min_load) {
+    bool incremental = table->settings.incremental_resize_step > 0;
+    uint64_t capacity = table->capacity / factor;
+    if (capacity < table->initial_capacity) {
+      capacity = table->initial_capacity;
+    }
+
+    return st_begin_resize(table, capacity, incremental);
   }
 
-  if (! created) {
-    return SEG_COLLISION("Unexpected collision when resizing stringtable.");
+  return SEG_OK;
+}
+
+/*
+ * Copy the keys of every live entry into a fresh arena, sized to fit them, and release the old
+ * one. Entries within both the current and previous slots are updated to their new offsets.
+ */
+static seg_err st_arena_compact(seg_stringtable *table)
+{
+  st_arena *old = &table->keys;
+  uint64_t live = old->length - old->garbage;
+
+  st_arena fresh;
+  fresh.length = 0;
+  fresh.garbage = 0;
+  fresh.capacity = ST_ARENA_INIT_CAPACITY;
+  while (fresh.capacity < live * 2) {
+    fresh.capacity *= 2;
   }
 
-  e->value = value;
+  fresh.bytes = malloc(fresh.capacity);
+  if (fresh.bytes == NULL) {
+    return SEG_NOMEM("Unable to compact stringtable key arena.");
+  }
+
+  st_slots *all[] = { &table->previous, &table->slots };
+  for (int s = 0; s < 2; s++) {
+    st_slots *slots = all[s];
+
+    for (uint64_t i = 0; i < slots->slot_count; i++) {
+      if (SEG_CTRL_ISFULL(slots->ctrl[i])) {
+        st_entry *e = &(slots->entries[i]);
+
+        memcpy(fresh.bytes + fresh.length, old->bytes + e->key_offset, e->key_length);
+        e->key_offset = fresh.length;
+        fresh.length += e->key_length;
+      }
+    }
+  }
+
+  free(old->bytes);
+  *old = fresh;
   return SEG_OK;
 }
 
+/*
+ * Count the probe steps between the group that `hashcode` selects first and the group that holds
+ * `slot`.
+ */
+static uint64_t st_displacement(st_slots *slots, uint32_t hashcode, uint64_t slot)
+{
+  uint64_t group_mask = (slots->slot_count / SEG_CTRLGROUP_WIDTH) - 1;
+  uint64_t group = SEG_CTRL_H1(hashcode) & group_mask;
+  uint64_t target = slot / SEG_CTRLGROUP_WIDTH;
+  uint64_t stride = 1;
+
+  while (group != target && stride <= group_mask + 1) {
+    group = (group + stride) & group_mask;
+    stride++;
+  }
+
+  return stride - 1;
+}
+
+static void st_slots_stats(st_slots *slots, seg_hashtable_stats *stats)
+{
+  stats->slots += slots->slot_count;
+  stats->tombstones += slots->tombstones;
+  stats->bytes += (sizeof(int8_t) + sizeof(st_entry)) * slots->slot_count;
+
+  for (uint64_t i = 0; i < slots->slot_count; i++) {
+    if (SEG_CTRL_ISFULL(slots->ctrl[i])) {
+      st_entry *e = &(slots->entries[i]);
+      seg_hashtable_histogram_add(stats, st_displacement(slots, e->hashcode, i));
+    } else if (slots->ctrl[i] == SEG_CTRL_EMPTY) {
+      stats->empty_slots++;
+    }
+  }
+}
+
 /* Public API. */
 
 uint64_t seg_stringtable_count(seg_stringtable *table)
@@ -164,29 +538,66 @@ seg_hashtable_settings *seg_stringtable_get_settings(seg_stringtable *table)
   return &(table->settings);
 }
 
+void seg_stringtable_stats(seg_stringtable *table, seg_hashtable_stats *out)
+{
+  memset(out, 0, sizeof(seg_hashtable_stats));
+  out->count = table->count;
+  out->capacity = table->capacity;
+  out->counters = table->counters;
+  out->bytes = sizeof(struct seg_stringtable) + table->keys.capacity;
+
+  st_slots_stats(&table->slots, out);
+  if (st_migrating(table)) {
+    st_slots_stats(&table->previous, out);
+  }
+}
+
 seg_err seg_new_stringtable(uint64_t capacity, seg_stringtable **out)
 {
+  return seg_new_stringtable_hashed(capacity, SEG_HASH_DEFAULT, out);
+}
+
+seg_err seg_new_stringtable_hashed(
+  uint64_t capacity,
+  seg_hash_algorithm hash,
+  seg_stringtable **out
+) {
+  seg_err err;
+
   seg_stringtable *table = malloc(sizeof(struct seg_stringtable));
   if (table == NULL) {
     return SEG_NOMEM("Unable to allocate stringtable.");
   }
 
   table->capacity = capacity;
+  table->initial_capacity = capacity;
   table->count = 0L;
   table->seed = (uint32_t) ((intptr_t) table) % UINT32_MAX;
+  table->hash = hash;
 
   table->settings.init_bucket_capacity = SEG_HT_INIT_BUCKET_CAPACITY;
   table->settings.bucket_growth_factor = SEG_HT_BUCKET_GROWTH_FACTOR;
   table->settings.max_load = SEG_HT_MAX_LOAD;
   table->settings.table_growth_factor = SEG_HT_TABLE_GROWTH_FACTOR;
+  table->settings.incremental_resize_step = SEG_HT_INCREMENTAL_RESIZE_STEP;
+  table->settings.min_load = SEG_HT_MIN_LOAD;
 
-  st_bucket *buckets = calloc(capacity, sizeof(st_bucket));
+  table->previous.slot_count = 0;
+  table->previous.tombstones = 0;
+  table->migrated = 0;
 
-  if (buckets == NULL) {
-    return SEG_NOMEM("Unable to allocate buckets for stringtable.");
+  table->keys.bytes = NULL;
+  table->keys.length = 0;
+  table->keys.capacity = 0;
+  table->keys.garbage = 0;
+  memset(&table->counters, 0, sizeof(seg_hashtable_counters));
+
+  err = st_slots_init(&table->slots, st_slot_count_for(capacity, 0));
+  if (err != SEG_OK) {
+    free(table);
+    return err;
   }
 
-  table->buckets = buckets;
   *out = table;
 
   return SEG_OK;
@@ -194,36 +605,11 @@ seg_err seg_new_stringtable(uint64_t capacity, seg_stringtable **out)
 
 seg_err seg_stringtable_resize(seg_stringtable *table, uint64_t capacity)
 {
-  seg_err err;
-
-  uint64_t orig_cap = table->capacity;
-  uint64_t orig_count = table->count;
-  if (orig_cap == capacity) {
+  if (table->capacity == capacity && ! st_migrating(table)) {
     return SEG_OK;
   }
 
-  st_bucket *nbuckets = calloc(capacity, sizeof(st_bucket));
-  if (nbuckets == NULL) {
-    return SEG_NOMEM("Unable to allocate new buckets to resize stringtable.");
-  }
-
-  st_resize_state state;
-  state.table = table;
-  state.nbuckets = nbuckets;
-  state.ncapacity = capacity;
-
-  err = seg_stringtable_each(table, st_resize_iter, &state);
-  if (err != SEG_OK) {
-    return err;
-  }
-
-  free(table->buckets);
-
-  table->capacity = capacity;
-  table->count = orig_count;
-  table->buckets = nbuckets;
-
-  return SEG_OK;
+  return st_begin_resize(table, capacity, false);
 }
 
 seg_err seg_stringtable_put(seg_stringtable *table, const char *key, size_t key_length, void *value, void **out)
@@ -234,7 +620,9 @@ seg_err seg_stringtable_put(seg_stringtable *table, const char *key, size_t key_
   bool created;
   void *result = NULL;
 
-  err = st_find_or_create_entry(table, table->buckets, table->capacity, key, key_length, &ent, &created);
+  st_migrate_step(table);
+
+  err = st_find_or_create_entry(table, key, key_length, &ent, &created);
   if (err != SEG_OK) {
     return err;
   }
@@ -267,7 +655,9 @@ seg_err seg_stringtable_putifabsent(
   st_entry *ent;
   bool created;
 
-  err = st_find_or_create_entry(table, table->buckets, table->capacity, key, key_length, &ent, &created);
+  st_migrate_step(table);
+
+  err = st_find_or_create_entry(table, key, key_length, &ent, &created);
   if (err != SEG_OK) {
     return err;
   }
@@ -289,49 +679,143 @@ seg_err seg_stringtable_putifabsent(
 
 void *seg_stringtable_get(seg_stringtable *table, const char *key, size_t key_length)
 {
-  uint32_t hashcode = murmur3_32(key, (uint32_t) key_length, table->seed);
-  uint32_t bnum = hashcode % table->capacity;
-
-  st_bucket *buck = &(table->buckets[bnum]);
-  int bindex = 0;
+  uint32_t hashcode = seg_hash(table->hash, key, key_length, table->seed);
+  uint64_t probes = 0;
 
-  if(buck->content == NULL) {
-    /* Bucket empty. */
-    return NULL;
+  int64_t slot = st_find_slot(&table->slots, table->keys.bytes, hashcode, key, key_length, &probes);
+  if (slot >= 0) {
+    seg_hashtable_count_lookup(&table->counters, true, probes);
+    return table->slots.entries[slot].value;
   }
 
-  for (int i = 0; i < buck->length; i++) {
-    st_entry *ent = &(buck->content[i]);
-
-    if (
-      ent->hashcode == hashcode && ent->key_length == key_length &&
-      ! memcmp(ent->key, key, key_length)
-    ) {
-      /* Found it! */
-      return ent->value;
+  if (st_migrating(table)) {
+    slot = st_find_slot(&table->previous, table->keys.bytes, hashcode, key, key_length, &probes);
+    if (slot >= 0) {
+      seg_hashtable_count_lookup(&table->counters, true, probes);
+      return table->previous.entries[slot].value;
     }
   }
 
   /* Not present. */
+  seg_hashtable_count_lookup(&table->counters, false, probes);
   return NULL;
 }
 
-seg_err seg_stringtable_each(seg_stringtable *table, seg_stringtable_iterator iter, void *state)
-{
+seg_err seg_stringtable_remove(
+  seg_stringtable *table,
+  const char *key,
+  size_t key_length,
+  void **out
+) {
   seg_err err;
+  st_slots *slots = &table->slots;
+
+  st_migrate_step(table);
+
+  uint32_t hashcode = seg_hash(table->hash, key, key_length, table->seed);
+  uint64_t probes = 0;
+
+  int64_t slot = st_find_slot(slots, table->keys.bytes, hashcode, key, key_length, &probes);
+  if (slot < 0 && st_migrating(table)) {
+    slots = &table->previous;
+    slot = st_find_slot(slots, table->keys.bytes, hashcode, key, key_length, &probes);
+  }
+
+  seg_hashtable_count_lookup(&table->counters, slot >= 0, probes);
+
+  if (slot < 0) {
+    /* Not present. */
+    *out = NULL;
+    return SEG_OK;
+  }
+
+  st_entry *e = &(slots->entries[slot]);
+  *out = e->value;
+
+  st_clear_slot(slots, (uint64_t) slot);
+  table->count--;
+  table->keys.garbage += e->key_length;
 
-  for (int b = 0; b < table->capacity; b++) {
-    st_bucket *buck = &(table->buckets[b]);
+  uint64_t garbage = table->keys.garbage;
+  if (garbage > ST_ARENA_INIT_CAPACITY && garbage > table->keys.length - garbage) {
+    err = st_arena_compact(table);
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
 
-    if (buck->content != NULL) {
-      for (int e = 0; e < buck->length; e++) {
-        st_entry *ent = &(buck->content[e]);
+  return st_trigger_dynamic_shrink(table);
+}
+
+/*
+ * Move a cursor forward from its current position to the nearest full slot, a group of control
+ * bytes at a time. Slots that haven't been migrated yet are visited before the current ones.
+ */
+static void st_seek(seg_stringtable *table, seg_hashtable_cursor *cursor)
+{
+  while (true) {
+    st_slots *slots = cursor->storage;
 
-        err = (*iter)(ent->key, ent->key_length, ent->value, state);
-        if (err != SEG_OK) {
-          return err;
-        }
+    while (cursor->position < slots->slot_count) {
+      uint64_t group = cursor->position & ~(uint64_t) (SEG_CTRLGROUP_WIDTH - 1);
+      seg_ctrlmask full = seg_ctrlgroup_match_full(slots->ctrl + group);
+
+      /* Ignore the slots in this group that precede the cursor. */
+      full &= ~(seg_ctrlmask) 0 << (cursor->position - group);
+
+      if (full != 0) {
+        cursor->position = group + seg_ctrlmask_first(full);
+
+        st_entry *ent = &(slots->entries[cursor->position]);
+        cursor->key = table->keys.bytes + ent->key_offset;
+        cursor->key_length = ent->key_length;
+        cursor->value = ent->value;
+        return;
       }
+
+      cursor->position = group + SEG_CTRLGROUP_WIDTH;
+    }
+
+    if (slots == &table->slots) {
+      cursor->done = true;
+      return;
+    }
+
+    cursor->storage = &table->slots;
+    cursor->position = 0;
+  }
+}
+
+void seg_stringtable_begin(seg_stringtable *table, seg_hashtable_cursor *cursor)
+{
+  /* Migrated slots are marked as deleted. */
+  cursor->storage = st_migrating(table) ? &table->previous : &table->slots;
+  cursor->position = 0;
+  cursor->offset = 0;
+  cursor->done = false;
+
+  st_seek(table, cursor);
+}
+
+void seg_stringtable_next(seg_stringtable *table, seg_hashtable_cursor *cursor)
+{
+  cursor->position++;
+  st_seek(table, cursor);
+}
+
+seg_err seg_stringtable_each(seg_stringtable *table, seg_stringtable_iterator iter, void *state)
+{
+  seg_err err;
+  seg_hashtable_cursor c;
+
+  for (
+    seg_stringtable_begin(table, &c);
+    ! seg_hashtable_done(&c);
+    seg_stringtable_next(table, &c)
+  ) {
+    err = (*iter)(c.key, c.key_length, c.value, state);
+    if (err != SEG_OK) {
+      return err;
     }
   }
 
@@ -340,6 +824,10 @@ seg_err seg_stringtable_each(seg_stringtable *table, seg_stringtable_iterator it
 
 void seg_delete_stringtable(seg_stringtable *table)
 {
-  free(table->buckets);
+  if (st_migrating(table)) {
+    st_slots_free(&table->previous);
+  }
+  st_slots_free(&table->slots);
+  free(table->keys.bytes);
   free(table);
 }
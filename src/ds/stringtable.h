@@ -6,11 +6,15 @@
 
 #include "errors.h"
 #include "ds/hashtable.h"
+#include "ds/hash.h"
 
 /*
  * Hashtable specialized for keys that are directly comparable, variable-sized, contiguous chunks
  * of memory. This is most useful for tables keyed with strings, including internal tables like
  * the symbol table.
+ *
+ * Stringtables are open-addressed, so the bucket settings within seg_hashtable_settings have no
+ * effect on them.
  */
 struct seg_stringtable;
 typedef struct seg_stringtable seg_stringtable;
@@ -26,10 +30,20 @@ typedef seg_err (*seg_stringtable_iterator)(
 );
 
 /*
- * Allocate a new stringtable with the specified initial capacity.
+ * Allocate a new stringtable with the specified initial capacity. Keys are hashed with
+ * SEG_HASH_DEFAULT.
  */
 seg_err seg_new_stringtable(uint64_t capacity, seg_stringtable **out);
 
+/*
+ * Allocate a new stringtable that hashes its keys with a specific algorithm.
+ */
+seg_err seg_new_stringtable_hashed(
+  uint64_t capacity,
+  seg_hash_algorithm hash,
+  seg_stringtable **out
+);
+
 /*
  * Return the number of items currently stored in a stringtable.
  */
@@ -45,16 +59,30 @@ uint64_t seg_stringtable_capacity(seg_stringtable *table);
  */
 seg_hashtable_settings *seg_stringtable_get_settings(seg_stringtable *table);
 
+/*
+ * Take a snapshot of a stringtable's shape and usage. Probe lengths are measured in slot groups.
+ * O(capacity).
+ */
+void seg_stringtable_stats(seg_stringtable *table, seg_hashtable_stats *out);
+
 /*
  * Resize a stringtable's capacity. O(n). Invoked automatically during put operations if the table's
  * load increases beyond the threshold. Notice that `capacity` can be greater or less than the
  * current capacity.
+ *
+ * An explicit resize always completes before returning, including any incremental resize that was
+ * already in progress.
  */
 seg_err seg_stringtable_resize(seg_stringtable *table, uint64_t capacity);
 
 /*
  * Add a new item to the stringtable, expanding it if necessary. Return the value previously
  * assigned to `key` if one was present. Otherwise, return `NULL`.
+ *
+ * New keys are copied into storage owned by the table, so the caller's buffer may be released as
+ * soon as this returns.
+ *
+ * SEG_RANGE: If `key_length` doesn't fit within 32 bits.
  */
 seg_err seg_stringtable_put(
   seg_stringtable *table,
@@ -66,7 +94,8 @@ seg_err seg_stringtable_put(
 
 /*
  * Add a new item to the stringtable if and only if `key` is currently unassigned. Return the
- * existing item mapped to `key` if there was one, or the newly assigned `value` otherwise.
+ * existing item mapped to `key` if there was one, or the newly assigned `value` otherwise. As with
+ * `seg_stringtable_put`, new keys are copied.
  */
 seg_err seg_stringtable_putifabsent(
   seg_stringtable *table,
@@ -76,15 +105,40 @@ seg_err seg_stringtable_putifabsent(
   void **out
 );
 
+/*
+ * Remove `key` from the stringtable. Assign to `out` the value that was mapped to `key`, or `NULL`
+ * if it wasn't present. The table may shrink if its load falls below its `min_load` setting.
+ */
+seg_err seg_stringtable_remove(
+  seg_stringtable *table,
+  const char *key,
+  size_t key_length,
+  void **out
+);
+
 /*
  * Search for an existing value in the hashtable at `key`. Return the value or
  * `NULL` if it's not present.
  */
 void *seg_stringtable_get(seg_stringtable *table, const char *key, size_t key_length);
 
+/*
+ * Position a cursor on the first key-value pair in the hashtable. See seg_hashtable_cursor. The
+ * cursor's `key` points to `key_length` bytes within the table's own storage, which are only valid
+ * until the table is next modified.
+ */
+void seg_stringtable_begin(seg_stringtable *table, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next key-value pair in the hashtable. Empty slots are skipped a group
+ * at a time.
+ */
+void seg_stringtable_next(seg_stringtable *table, seg_hashtable_cursor *cursor);
+
 /*
  * Iterate through each key-value pair in the hashtable. `state` will be provided as-is to the
- * iterator function during each iteration.
+ * iterator function during each iteration. Keys point into the table's own storage, and are only
+ * valid until the table is next modified.
  */
 seg_err seg_stringtable_each(seg_stringtable *table, seg_stringtable_iterator iter, void *state);
 
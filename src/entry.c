@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <unistd.h>
@@ -13,8 +14,29 @@
 #include "lexer.h"
 #include "debug/ast_printer.h"
 #include "debug/symbol_printer.h"
+#include "debug/memory_printer.h"
 #include "runtime/runtime.h"
 
+/*
+ * Print an error's message, after a printf-style context and followed by any detail attached to it.
+ */
+static void print_err(seg_err err, const char *context, ...)
+{
+  const char *detail = seg_err_detail(err);
+  va_list args;
+
+  fputs("segment: ", stderr);
+  va_start(args, context);
+  vfprintf(stderr, context, args);
+  va_end(args);
+
+  if (detail != NULL) {
+    fprintf(stderr, ": %s (%s)\n", err->message, detail);
+  } else {
+    fprintf(stderr, ": %s\n", err->message);
+  }
+}
+
 /*
  * Print a usage statement and exit with an exit code.
  */
@@ -23,11 +45,13 @@ static void print_usage(FILE *dest, int code, const char *progname)
   fprintf(
     dest,
     "Usage: %s [--debug lexer|ast|symbol] [--phase lexer|ast] [--verbose|-v] "
-    "file ...\n",
+    "[--symbol-image PATH] file ...\n",
     progname);
   fprintf(dest, "\n  --debug PHASE  Produce debugging output for the specified phase.\n");
   fprintf(dest, "  --phase PHASE  Execute only up to the specified phase.\n");
-  fprintf(dest, "  --verbose      Output banners and statistics.\n");
+  fprintf(dest, "  --verbose      Output banners, statistics, memory usage and collections.\n");
+  fprintf(dest, "  --symbol-image PATH\n");
+  fprintf(dest, "                 Load interned symbols from PATH, and save them there on exit.\n");
   fprintf(dest, "  file           Interpret each file in sequence.\n");
   exit(code);
 }
@@ -48,6 +72,7 @@ static void process_options(int argc, char **argv, seg_options *opts)
     {"phase", required_argument, NULL, 'p'},
     {"verbose", no_argument, NULL, 'v'},
     {"help", no_argument, NULL, 'h'},
+    {"symbol-image", required_argument, NULL, 's'},
     {0, 0, 0, 0}
   };
 
@@ -55,6 +80,7 @@ static void process_options(int argc, char **argv, seg_options *opts)
   opts->src_paths = NULL;
   opts->src_count = 0;
   opts->verbose = 0;
+  opts->symbol_image = NULL;
 
   opts->lexer_debug = 0;
 
@@ -64,7 +90,7 @@ static void process_options(int argc, char **argv, seg_options *opts)
   opts->symbol_debug = 0;
 
   while (c != -1) {
-    c = getopt_long(argc, argv, "d:p:hv", long_options, &option_index);
+    c = getopt_long(argc, argv, "d:p:hvs:", long_options, &option_index);
 
     switch (c) {
       case 'd':
@@ -97,6 +123,9 @@ static void process_options(int argc, char **argv, seg_options *opts)
       case 'v':
         opts->verbose = 1;
         break;
+      case 's':
+        opts->symbol_image = optarg;
+        break;
       case '?':
         print_usage(stderr, 1, argv[0]);
         break;
@@ -139,10 +168,15 @@ static int process_file(seg_runtime *r, const char *path, seg_options *opts)
     exit(1);
   }
 
-  void *content = mmap(NULL, (size_t) istat.st_size, PROT_READ, MAP_PRIVATE, ifd, 0);
-  if (content == MAP_FAILED) {
-    perror("unable to memory-map input file");
-    exit(1);
+  /* mmap() refuses zero-length mappings, so an empty file is parsed from an empty buffer. */
+  char empty = '\0';
+  void *content = &empty;
+  if (istat.st_size > 0) {
+    content = mmap(NULL, (size_t) istat.st_size, PROT_READ, MAP_PRIVATE, ifd, 0);
+    if (content == MAP_FAILED) {
+      perror("unable to memory-map input file");
+      exit(1);
+    }
   }
 
   seg_program *program = seg_parse(r, (char*) content, istat.st_size, opts);
@@ -176,6 +210,12 @@ static int process_file(seg_runtime *r, const char *path, seg_options *opts)
     seg_print_symboltable(program->symboltable);
   }
 
+  /* Interned symbols own copies of their names, so the source can be released once parsed. */
+  if (istat.st_size > 0) {
+    munmap(content, (size_t) istat.st_size);
+  }
+  close(ifd);
+
   return 0;
 }
 
@@ -194,6 +234,15 @@ int main(int argc, char **argv)
 
   process_options(argc, argv, &opts);
 
+  /* A missing image isn't an error: it's written once this run has interned some symbols. */
+  seg_symboltable *symboltable = seg_runtime_symboltable(runtime);
+  if (opts.symbol_image != NULL && access(opts.symbol_image, F_OK) == 0) {
+    err = seg_symboltable_load_image(symboltable, opts.symbol_image);
+    if (err != SEG_OK) {
+      print_err(err, "Ignoring symbol image <%s>", opts.symbol_image);
+    }
+  }
+
   for (int i = 0; i < opts.src_count; i++) {
     res = process_file(runtime, opts.src_paths[i], &opts);
     if (res) {
@@ -202,6 +251,20 @@ int main(int argc, char **argv)
     }
   }
 
+  if (opts.verbose) {
+    putchar('\n');
+    seg_print_memory(runtime);
+    putchar('\n');
+    seg_print_collections(runtime);
+  }
+
+  if (opts.symbol_image != NULL) {
+    err = seg_symboltable_write_image(symboltable, opts.symbol_image);
+    if (err != SEG_OK) {
+      print_err(err, "Unable to save symbol image <%s>", opts.symbol_image);
+    }
+  }
+
   seg_delete_runtime(runtime);
   return 0;
 }
@@ -1,16 +1,30 @@
+#include <stdio.h>
+#include <stdarg.h>
+
 #include "errors.h"
 
-struct __seg_err __seg_err_nomem = {
-  .code = SEG_CODE_NOMEM,
-  .message = "Out of memory"
-};
+/* Room for a path and a reason, which is as much detail as any error carries. */
+#define DETAIL_LENGTH 512
 
-seg_err __seg_create_err(seg_err_code code, const char *msg) {
-  seg_err err = malloc(sizeof(seg_err));
-  if (err == NULL) {
-    return &__seg_err_nomem;
-  }
-  err->code = code;
-  err->message = msg;
+static _Thread_local seg_err detailed_err;
+static _Thread_local char detail[DETAIL_LENGTH];
+
+seg_err seg_err_with_detail(seg_err err, const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(detail, sizeof(detail), format, args);
+  va_end(args);
+
+  detailed_err = err;
   return err;
 }
+
+const char *seg_err_detail(seg_err err)
+{
+  if (err == NULL || err != detailed_err) {
+    return NULL;
+  }
+  return detail;
+}
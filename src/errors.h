@@ -25,20 +25,42 @@ typedef enum {
 
 } seg_err_code;
 
-typedef struct __seg_err {
+/*
+ * Errors are descriptors with static storage, one for each site that can fail, so returning one
+ * never allocates and they needn't be freed. Two failures compare equal if and only if they came
+ * from the same site.
+ */
+typedef const struct __seg_err {
   seg_err_code code;
   const char *message;
 } *seg_err;
 
 #define SEG_OK NULL
 
-seg_err __seg_create_err(seg_err_code code, const char *msg);
+/*
+ * Attach printf-style detail to an error that's about to be returned, such as the path of a file
+ * that couldn't be opened. Descriptors are shared by every failure at their site, so the detail is
+ * kept aside for the calling thread until it attaches another. Returns `err`.
+ */
+seg_err seg_err_with_detail(seg_err err, const char *format, ...);
+
+/*
+ * Return the detail most recently attached to `err` on the calling thread, or NULL if the thread
+ * has attached detail to a different error since.
+ */
+const char *seg_err_detail(seg_err err);
 
 #define __STRINGIZE_DETAIL(x) #x
 #define __STRINGIZE(x) __STRINGIZE_DETAIL(x)
 
 #define __PREFIX(msg) (__FILE__ "@L" __STRINGIZE(__LINE__) ": " msg)
 
+/* Evaluates to the address of a descriptor that's private to the site that expands it. */
+#define __SEG_ERR(code, msg) (__extension__ ({ \
+    static const struct __seg_err __seg_site_err = { (code), __PREFIX(msg) }; \
+    &__seg_site_err; \
+  }))
+
 #define SEG_TRY(expr) \
   do { \
     err = (expr); \
@@ -47,11 +69,11 @@ seg_err __seg_create_err(seg_err_code code, const char *msg);
     } \
   } while(0)
 
-#define SEG_NOMEM(msg) __seg_create_err(SEG_CODE_NOMEM, __PREFIX("NOMEM " msg))
-#define SEG_RANGE(msg) __seg_create_err(SEG_CODE_RANGE, __PREFIX("RANGE " msg))
-#define SEG_TYPE(msg) __seg_create_err(SEG_CODE_TYPE, __PREFIX("TYPE " msg))
-#define SEG_INVAL(msg) __seg_create_err(SEG_CODE_INVAL, __PREFIX("INVAL " msg))
-#define SEG_COLLISION(msg) __seg_create_err(SEG_CODE_COLLISION, __PREFIX("COLLISION " msg))
-#define SEG_NOTYET(msg) __seg_create_err(SEG_CODE_NOTYET, __PREFIX("NOTYET " msg))
+#define SEG_NOMEM(msg) __SEG_ERR(SEG_CODE_NOMEM, "NOMEM " msg)
+#define SEG_RANGE(msg) __SEG_ERR(SEG_CODE_RANGE, "RANGE " msg)
+#define SEG_TYPE(msg) __SEG_ERR(SEG_CODE_TYPE, "TYPE " msg)
+#define SEG_INVAL(msg) __SEG_ERR(SEG_CODE_INVAL, "INVAL " msg)
+#define SEG_COLLISION(msg) __SEG_ERR(SEG_CODE_COLLISION, "COLLISION " msg)
+#define SEG_NOTYET(msg) __SEG_ERR(SEG_CODE_NOTYET, "NOTYET " msg)
 
 #endif
@@ -96,7 +96,16 @@ expr (OUT) ::= INTEGER (L).
   OUT->child.integer.value = value;
 }
 
-expr ::= FLOAT.
+expr (OUT) ::= FLOAT (L).
+{
+  double value = seg_token_as_float(L);
+  seg_delete_token(L);
+
+  OUT = malloc(sizeof(seg_expr_node));
+  OUT->child_kind = SEG_FLOAT;
+  OUT->child.floating.value = value;
+}
+
 expr ::= TRUE.
 expr ::= FALSE.
 
@@ -235,6 +244,8 @@ expr (OUT) ::= IDENTIFIER (V).
     OUT->child.methodcall.receiver = seg_implicit_self(state);
     OUT->child.methodcall.args = NULL;
   }
+
+  free((char*) name);
 }
 
 expr (OUT) ::= block (IN). { OUT = IN; }
@@ -297,6 +308,8 @@ parameter (OUT) ::= IDENTIFIER (ID).
   OUT = malloc(sizeof(seg_parameter_list));
   INTERN(&OUT->parameter, name, length);
   OUT->next = NULL;
+
+  free(name);
 }
 
 parameter ::= IDENTIFIER ASSIGNMENT expr.
@@ -85,7 +85,7 @@ static void report(const char *name, const char *ts, const char *te, seg_options
     comment;
 
     integer => { CAPTURE(INTEGER); };
-    float => { EMPTY(FLOAT); };
+    float => { CAPTURE(FLOAT); };
     true => { EMPTY(TRUE); };
     false => { EMPTY(FALSE); };
 
@@ -214,9 +214,16 @@ seg_program *seg_parse(seg_runtime *r, char *content, off_t length, seg_options
   }
 
   ParseFree(parser, free);
+  free(stack);
 
   seg_program *program = malloc(sizeof(seg_program));
   program->ast = state.root;
   program->symboltable = state.symboltable;
+
+  /* Programs live as long as the runtime that parsed them. */
+  uint64_t nodes, bytes;
+  seg_ast_memory(program->ast, &nodes, &bytes);
+  _seg_runtime_allocated(r, SEG_MEMORY_AST, nodes + 1, bytes + sizeof(seg_program));
+
   return program;
 }
@@ -0,0 +1,700 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "model/integer.h"
+#include "model/layout.h"
+#include "runtime/runtime.h"
+
+/*
+ * An immediate integer, read as a 64-bit word, is its value shifted left by eight above this tag:
+ * the immediate bit, the integer kind and a zero length. Arithmetic on two of them can be done on
+ * the words directly, and a result overflows the immediate range exactly when the word arithmetic
+ * overflows 64 bits.
+ */
+#define INT_TAG ((int64_t) (SEG_IMM_INTEGER << 1 | 1))
+#define INT_TAG_MASK ((int64_t) 0xff)
+#define INT_SHIFT 8
+
+/* Multiply by splitting operands in half once both have at least this many limbs. */
+#define KARATSUBA_THRESHOLD 32
+
+/* Results of up to this many limbs are computed on the stack. */
+#define INLINE_LIMBS 8
+
+/* The largest power of ten in a limb, used to format integers nineteen digits at a time. */
+#define DECIMAL_CHUNK UINT64_C(10000000000000000000)
+#define DECIMAL_CHUNK_DIGITS 19
+
+typedef unsigned __int128 dlimb;
+
+static int64_t _word(seg_object o)
+{
+  int64_t word;
+  memcpy(&word, &o, sizeof(word));
+  return word;
+}
+
+static seg_object _from_word(int64_t word)
+{
+  seg_object o;
+  memcpy(&o, &word, sizeof(o));
+  return o;
+}
+
+static seg_object _immediate(int64_t value)
+{
+  return _from_word((int64_t) ((uint64_t) value << INT_SHIFT) | INT_TAG);
+}
+
+static bool _both_immediate(int64_t wa, int64_t wb)
+{
+  return (((wa ^ INT_TAG) | (wb ^ INT_TAG)) & INT_TAG_MASK) == 0;
+}
+
+// MAGNITUDES //////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Unsigned arithmetic on arrays of limbs, least significant first. Inputs may carry leading zero
+ * limbs; outputs are sized for the largest possible result and normalized by the caller.
+ */
+
+static size_t mag_normalize(const uint64_t *a, size_t n)
+{
+  while (n > 0 && a[n - 1] == 0) {
+    n--;
+  }
+  return n;
+}
+
+static int mag_compare(const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
+{
+  an = mag_normalize(a, an);
+  bn = mag_normalize(b, bn);
+
+  if (an != bn) {
+    return an < bn ? -1 : 1;
+  }
+  for (size_t i = an; i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/* r[0 .. rn) += a[0 .. an), where an <= rn. Returns the carry out of r. */
+static uint64_t mag_add_into(uint64_t *r, size_t rn, const uint64_t *a, size_t an)
+{
+  uint64_t carry = 0;
+  size_t i = 0;
+
+  for (; i < an; i++) {
+    dlimb s = (dlimb) r[i] + a[i] + carry;
+    r[i] = (uint64_t) s;
+    carry = (uint64_t) (s >> 64);
+  }
+  for (; carry != 0 && i < rn; i++) {
+    carry = ++r[i] == 0;
+  }
+  return carry;
+}
+
+/* r[0 .. rn) -= a[0 .. an), where an <= rn. Returns the borrow out of r. */
+static uint64_t mag_sub_from(uint64_t *r, size_t rn, const uint64_t *a, size_t an)
+{
+  uint64_t borrow = 0;
+  size_t i = 0;
+
+  for (; i < an; i++) {
+    uint64_t sub = a[i] + borrow;
+    uint64_t next = sub < borrow || r[i] < sub;
+    r[i] -= sub;
+    borrow = next;
+  }
+  for (; borrow != 0 && i < rn; i++) {
+    borrow = r[i]-- == 0;
+  }
+  return borrow;
+}
+
+/* r[0 .. an + 1) = a + b, where bn <= an. */
+static void mag_add(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
+{
+  memcpy(r, a, an * sizeof(uint64_t));
+  r[an] = mag_add_into(r, an, b, bn);
+}
+
+/* r[0 .. an) = a - b, where b <= a. */
+static void mag_sub(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
+{
+  memcpy(r, a, an * sizeof(uint64_t));
+  mag_sub_from(r, an, b, bn);
+}
+
+/* r[0 .. an + bn) = a * b. */
+static void mag_mul_schoolbook(
+  uint64_t *r,
+  const uint64_t *a,
+  size_t an,
+  const uint64_t *b,
+  size_t bn
+) {
+  memset(r, 0, (an + bn) * sizeof(uint64_t));
+
+  for (size_t i = 0; i < bn; i++) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < an; j++) {
+      dlimb t = (dlimb) a[j] * b[i] + r[i + j] + carry;
+      r[i + j] = (uint64_t) t;
+      carry = (uint64_t) (t >> 64);
+    }
+    r[i + an] = carry;
+  }
+}
+
+/*
+ * r[0 .. an + bn) = a * b. Large operands are split at half of the longer one, a = a1 B^h + a0, so
+ * that when b is split the same way, a * b = z2 B^2h + z1 B^h + z0 takes three half-sized products:
+ * z0 = a0 b0, z2 = a1 b1, and z1 = (a0 + a1)(b0 + b1) - z0 - z2. When b is too short to split, a's
+ * halves are multiplied by b separately.
+ */
+static seg_err mag_mul(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
+{
+  seg_err err;
+
+  if (an < bn) {
+    const uint64_t *swap = a;
+    a = b;
+    b = swap;
+
+    size_t swap_n = an;
+    an = bn;
+    bn = swap_n;
+  }
+
+  if (bn < KARATSUBA_THRESHOLD) {
+    mag_mul_schoolbook(r, a, an, b, bn);
+    return SEG_OK;
+  }
+
+  size_t h = (an + 1) / 2;
+
+  if (bn <= h) {
+    uint64_t *high = malloc((an - h + bn) * sizeof(uint64_t));
+    if (high == NULL) {
+      return SEG_NOMEM("Unable to allocate scratch space for a product.");
+    }
+
+    err = mag_mul(r, a, h, b, bn);
+    if (err == SEG_OK) {
+      err = mag_mul(high, a + h, an - h, b, bn);
+    }
+    if (err == SEG_OK) {
+      memset(r + h + bn, 0, (an - h) * sizeof(uint64_t));
+      mag_add_into(r + h, an + bn - h, high, an - h + bn);
+    }
+
+    free(high);
+    return err;
+  }
+
+  // The sums of halves, then their product.
+  uint64_t *scratch = malloc((4 * h + 4) * sizeof(uint64_t));
+  if (scratch == NULL) {
+    return SEG_NOMEM("Unable to allocate scratch space for a product.");
+  }
+  uint64_t *sa = scratch;
+  uint64_t *sb = sa + h + 1;
+  uint64_t *z1 = sb + h + 1;
+
+  mag_add(sa, a, h, a + h, an - h);
+  mag_add(sb, b, h, b + h, bn - h);
+
+  err = mag_mul(r, a, h, b, h);
+  if (err == SEG_OK) {
+    err = mag_mul(r + 2 * h, a + h, an - h, b + h, bn - h);
+  }
+  if (err == SEG_OK) {
+    err = mag_mul(z1, sa, h + 1, sb, h + 1);
+  }
+  if (err == SEG_OK) {
+    mag_sub_from(z1, 2 * h + 2, r, 2 * h);
+    mag_sub_from(z1, 2 * h + 2, r + 2 * h, an + bn - 2 * h);
+
+    // Whatever of z1 lies beyond the end of the product is zero.
+    size_t z1n = an + bn - h < 2 * h + 2 ? an + bn - h : 2 * h + 2;
+    mag_add_into(r + h, an + bn - h, z1, z1n);
+  }
+
+  free(scratch);
+  return err;
+}
+
+/*
+ * q[0 .. an - bn + 1) = a / b and rem[0 .. bn) = a % b, where an >= bn and b's most significant
+ * limb isn't zero. This is Knuth's Algorithm D: each quotient limb is estimated from the leading
+ * limbs, after shifting both operands so that b's top bit is set, and is off by at most two.
+ */
+static seg_err mag_divmod(
+  uint64_t *q,
+  uint64_t *rem,
+  const uint64_t *a,
+  size_t an,
+  const uint64_t *b,
+  size_t bn
+) {
+  if (bn == 1) {
+    dlimb partial = 0;
+    for (size_t i = an; i-- > 0;) {
+      partial = (partial << 64) | a[i];
+      q[i] = (uint64_t) (partial / b[0]);
+      partial %= b[0];
+    }
+    rem[0] = (uint64_t) partial;
+    return SEG_OK;
+  }
+
+  uint64_t *un = malloc((an + 1 + bn) * sizeof(uint64_t));
+  if (un == NULL) {
+    return SEG_NOMEM("Unable to allocate scratch space for a quotient.");
+  }
+  uint64_t *vn = un + an + 1;
+
+  int s = __builtin_clzll(b[bn - 1]);
+  for (size_t i = bn - 1; i > 0; i--) {
+    vn[i] = (b[i] << s) | (s == 0 ? 0 : b[i - 1] >> (64 - s));
+  }
+  vn[0] = b[0] << s;
+
+  un[an] = s == 0 ? 0 : a[an - 1] >> (64 - s);
+  for (size_t i = an - 1; i > 0; i--) {
+    un[i] = (a[i] << s) | (s == 0 ? 0 : a[i - 1] >> (64 - s));
+  }
+  un[0] = a[0] << s;
+
+  for (size_t j = an - bn + 1; j-- > 0;) {
+    dlimb numerator = ((dlimb) un[j + bn] << 64) | un[j + bn - 1];
+    dlimb qhat = numerator / vn[bn - 1];
+    dlimb rhat = numerator % vn[bn - 1];
+
+    while ((qhat >> 64) != 0 || qhat * vn[bn - 2] > ((rhat << 64) | un[j + bn - 2])) {
+      qhat--;
+      rhat += vn[bn - 1];
+      if ((rhat >> 64) != 0) {
+        break;
+      }
+    }
+
+    // Subtract qhat * vn from the current window of un.
+    uint64_t carry = 0;
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < bn; i++) {
+      dlimb p = qhat * vn[i] + carry;
+      carry = (uint64_t) (p >> 64);
+
+      uint64_t sub = (uint64_t) p + borrow;
+      uint64_t next = sub < borrow || un[i + j] < sub;
+      un[i + j] -= sub;
+      borrow = next;
+    }
+    bool negative = un[j + bn] < carry || un[j + bn] - carry < borrow;
+    un[j + bn] = un[j + bn] - carry - borrow;
+
+    // The estimate was one too large. Add a divisor back.
+    q[j] = (uint64_t) qhat;
+    if (negative) {
+      q[j]--;
+      un[j + bn] += mag_add_into(un + j, bn, vn, bn);
+    }
+  }
+
+  for (size_t i = 0; i < bn; i++) {
+    rem[i] = (un[i] >> s) | (s == 0 ? 0 : un[i + 1] << (64 - s));
+  }
+
+  free(un);
+  return SEG_OK;
+}
+
+// OPERANDS AND RESULTS ////////////////////////////////////////////////////////////////////////////
+
+/*
+ * An integer's sign and magnitude, wherever it's stored. An immediate's magnitude is kept in
+ * `small`, so operands must not be copied once they're read.
+ */
+typedef struct {
+  const uint64_t *limbs;
+  size_t n;
+  bool negative;
+  uint64_t small;
+} operand;
+
+static seg_err _operand(seg_runtime *r, seg_object o, operand *out)
+{
+  if (o.bits.immediate) {
+    if (o.bits.kind != SEG_IMM_INTEGER) {
+      return SEG_TYPE("Object was not an integer");
+    }
+
+    int64_t value = o.bits.body;
+    out->negative = value < 0;
+    out->small = value < 0 ? -(uint64_t) value : (uint64_t) value;
+    out->limbs = &out->small;
+    out->n = value != 0;
+    return SEG_OK;
+  }
+
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+  if (!SEG_SAME(o.pointer->klass, boots->integer_class)) {
+    return SEG_TYPE("Object was not an integer");
+  }
+
+  seg_object_bigint *big = (seg_object_bigint *) o.pointer;
+  out->limbs = big->limbs;
+  out->n = SEG_BIGINT_LIMBS(big->length);
+  out->negative = big->negative != 0;
+  return SEG_OK;
+}
+
+/* Space for a result's limbs: on the stack if it's small, or allocated if it isn't. */
+typedef struct {
+  uint64_t *limbs;
+  uint64_t inline_limbs[INLINE_LIMBS];
+} scratch;
+
+static seg_err _scratch(scratch *s, size_t n)
+{
+  if (n <= INLINE_LIMBS) {
+    s->limbs = s->inline_limbs;
+    return SEG_OK;
+  }
+
+  s->limbs = malloc(n * sizeof(uint64_t));
+  if (s->limbs == NULL) {
+    return SEG_NOMEM("Unable to allocate scratch space for an integer.");
+  }
+  return SEG_OK;
+}
+
+static void _scratch_free(scratch *s)
+{
+  if (s->limbs != s->inline_limbs) {
+    free(s->limbs);
+  }
+}
+
+/* Return an integer as an immediate if it fits, or allocate it if it doesn't. */
+static seg_err _result(
+  seg_runtime *r,
+  const uint64_t *limbs,
+  size_t n,
+  bool negative,
+  seg_object *out
+) {
+  n = mag_normalize(limbs, n);
+
+  if (n == 0) {
+    *out = _immediate(0);
+    return SEG_OK;
+  }
+
+  if (n == 1) {
+    if (!negative && limbs[0] <= (uint64_t) SEG_INTEGER_MAX) {
+      *out = _immediate((int64_t) limbs[0]);
+      return SEG_OK;
+    }
+    if (negative && limbs[0] <= (uint64_t) SEG_INTEGER_MAX + 1) {
+      *out = _immediate(-(int64_t) (limbs[0] - 1) - 1);
+      return SEG_OK;
+    }
+  }
+
+  seg_err err;
+  seg_object_bigint *big;
+  SEG_TRY(seg_runtime_allocate(
+    r, SEG_MEMORY_BUFFERS, SEG_ALLOC_YOUNG, sizeof(seg_object_bigint) + n * sizeof(uint64_t),
+    (void **) &big
+  ));
+
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+  big->common.klass = boots->integer_class;
+  big->length = sizeof(uint64_t) + n * sizeof(uint64_t);
+  big->negative = negative;
+  memcpy(big->limbs, limbs, n * sizeof(uint64_t));
+
+  out->pointer = (seg_object_common *) big;
+  return SEG_OK;
+}
+
+seg_err _seg_integer_box(seg_runtime *r, int64_t value, seg_object *out)
+{
+  uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+  return _result(r, &magnitude, 1, value < 0, out);
+}
+
+// ARITHMETIC //////////////////////////////////////////////////////////////////////////////////////
+
+static seg_err _add(seg_runtime *r, seg_object a, seg_object b, bool subtract, seg_object *out)
+{
+  seg_err err;
+  operand x, y;
+  SEG_TRY(_operand(r, a, &x));
+  SEG_TRY(_operand(r, b, &y));
+
+  bool y_negative = y.negative != subtract;
+  size_t n = (x.n > y.n ? x.n : y.n) + 1;
+
+  scratch t;
+  SEG_TRY(_scratch(&t, n));
+
+  bool negative;
+  if (x.negative == y_negative) {
+    negative = x.negative;
+    if (x.n >= y.n) {
+      mag_add(t.limbs, x.limbs, x.n, y.limbs, y.n);
+    } else {
+      mag_add(t.limbs, y.limbs, y.n, x.limbs, x.n);
+    }
+  } else if (mag_compare(x.limbs, x.n, y.limbs, y.n) >= 0) {
+    negative = x.negative;
+    mag_sub(t.limbs, x.limbs, x.n, y.limbs, y.n);
+    n = x.n;
+  } else {
+    negative = y_negative;
+    mag_sub(t.limbs, y.limbs, y.n, x.limbs, x.n);
+    n = y.n;
+  }
+
+  err = _result(r, t.limbs, n, negative, out);
+  _scratch_free(&t);
+  return err;
+}
+
+seg_err seg_integer_add(seg_runtime *r, seg_object a, seg_object b, seg_object *out)
+{
+  int64_t wa = _word(a), wb = _word(b), sum;
+
+  if (_both_immediate(wa, wb) && !__builtin_add_overflow(wa, wb - INT_TAG, &sum)) {
+    *out = _from_word(sum);
+    return SEG_OK;
+  }
+
+  return _add(r, a, b, false, out);
+}
+
+seg_err seg_integer_sub(seg_runtime *r, seg_object a, seg_object b, seg_object *out)
+{
+  int64_t wa = _word(a), wb = _word(b), difference;
+
+  if (_both_immediate(wa, wb) && !__builtin_sub_overflow(wa, wb - INT_TAG, &difference)) {
+    *out = _from_word(difference);
+    return SEG_OK;
+  }
+
+  return _add(r, a, b, true, out);
+}
+
+seg_err seg_integer_mul(seg_runtime *r, seg_object a, seg_object b, seg_object *out)
+{
+  seg_err err;
+  int64_t wa = _word(a), wb = _word(b), product;
+
+  if (_both_immediate(wa, wb) && !__builtin_mul_overflow(wa - INT_TAG, b.bits.body, &product)) {
+    *out = _from_word(product | INT_TAG);
+    return SEG_OK;
+  }
+
+  operand x, y;
+  SEG_TRY(_operand(r, a, &x));
+  SEG_TRY(_operand(r, b, &y));
+
+  scratch t;
+  SEG_TRY(_scratch(&t, x.n + y.n));
+
+  err = mag_mul(t.limbs, x.limbs, x.n, y.limbs, y.n);
+  if (err == SEG_OK) {
+    err = _result(r, t.limbs, x.n + y.n, x.negative != y.negative, out);
+  }
+
+  _scratch_free(&t);
+  return err;
+}
+
+seg_err seg_integer_divmod(
+  seg_runtime *r,
+  seg_object a,
+  seg_object b,
+  seg_object *quotient,
+  seg_object *remainder
+) {
+  seg_err err;
+  int64_t wa = _word(a), wb = _word(b);
+
+  if (_both_immediate(wa, wb) && b.bits.body != 0) {
+    int64_t x = a.bits.body, y = b.bits.body;
+    int64_t q = x / y, m = x % y;
+
+    if (m != 0 && (m ^ y) < 0) {
+      q--;
+      m += y;
+    }
+
+    // Only SEG_INTEGER_MIN / -1 leaves the immediate range.
+    if (q <= SEG_INTEGER_MAX) {
+      if (quotient != NULL) {
+        *quotient = _immediate(q);
+      }
+      if (remainder != NULL) {
+        *remainder = _immediate(m);
+      }
+      return SEG_OK;
+    }
+  }
+
+  operand x, y;
+  SEG_TRY(_operand(r, a, &x));
+  SEG_TRY(_operand(r, b, &y));
+
+  if (y.n == 0) {
+    return SEG_RANGE("Integer division by zero.");
+  }
+
+  size_t qn = x.n >= y.n ? x.n - y.n + 1 : 1;
+  scratch q, m;
+  SEG_TRY(_scratch(&q, qn + 1));
+  err = _scratch(&m, y.n);
+  if (err != SEG_OK) {
+    _scratch_free(&q);
+    return err;
+  }
+
+  memset(q.limbs, 0, (qn + 1) * sizeof(uint64_t));
+  if (x.n >= y.n) {
+    err = mag_divmod(q.limbs, m.limbs, x.limbs, x.n, y.limbs, y.n);
+  } else {
+    memset(m.limbs, 0, y.n * sizeof(uint64_t));
+    memcpy(m.limbs, x.limbs, x.n * sizeof(uint64_t));
+  }
+
+  // Round a negative quotient down rather than toward zero: |q| + 1, and |b| - |m|.
+  bool negative = x.negative != y.negative;
+  if (err == SEG_OK && negative && mag_normalize(m.limbs, y.n) != 0) {
+    uint64_t one = 1;
+    mag_add_into(q.limbs, qn + 1, &one, 1);
+
+    mag_sub_from(m.limbs, y.n, y.limbs, y.n);
+    for (size_t i = 0; i < y.n; i++) {
+      m.limbs[i] = ~m.limbs[i];
+    }
+    mag_add_into(m.limbs, y.n, &one, 1);
+  }
+
+  if (err == SEG_OK && quotient != NULL) {
+    err = _result(r, q.limbs, qn + 1, negative, quotient);
+  }
+  if (err == SEG_OK && remainder != NULL) {
+    err = _result(r, m.limbs, y.n, y.negative, remainder);
+  }
+
+  _scratch_free(&q);
+  _scratch_free(&m);
+  return err;
+}
+
+seg_err seg_integer_compare(seg_runtime *r, seg_object a, seg_object b, int *out)
+{
+  seg_err err;
+  int64_t wa = _word(a), wb = _word(b);
+
+  if (_both_immediate(wa, wb)) {
+    *out = (wa > wb) - (wa < wb);
+    return SEG_OK;
+  }
+
+  operand x, y;
+  SEG_TRY(_operand(r, a, &x));
+  SEG_TRY(_operand(r, b, &y));
+
+  if (x.negative != y.negative) {
+    *out = x.negative ? -1 : 1;
+  } else {
+    int magnitude = mag_compare(x.limbs, x.n, y.limbs, y.n);
+    *out = x.negative ? -magnitude : magnitude;
+  }
+  return SEG_OK;
+}
+
+// CONVERSION //////////////////////////////////////////////////////////////////////////////////////
+
+seg_err seg_integer_to_int64(seg_runtime *r, seg_object integer, int64_t *out)
+{
+  seg_err err;
+  operand x;
+  SEG_TRY(_operand(r, integer, &x));
+
+  if (x.n == 0) {
+    *out = 0;
+    return SEG_OK;
+  }
+
+  if (x.n == 1 && !x.negative && x.limbs[0] <= (uint64_t) INT64_MAX) {
+    *out = (int64_t) x.limbs[0];
+    return SEG_OK;
+  }
+  if (x.n == 1 && x.negative && x.limbs[0] <= (uint64_t) INT64_MAX + 1) {
+    *out = -(int64_t) (x.limbs[0] - 1) - 1;
+    return SEG_OK;
+  }
+
+  return SEG_RANGE("Integer out of 64-bit range.");
+}
+
+seg_err seg_integer_string(seg_runtime *r, seg_object integer, seg_object *out)
+{
+  seg_err err;
+  operand x;
+  SEG_TRY(_operand(r, integer, &x));
+
+  // Each limb holds fewer than twenty digits. Allow for a sign, and for zero.
+  size_t capacity = x.n * 20 + 2;
+  char *digits = malloc(capacity);
+  uint64_t *work = malloc((x.n + 1) * sizeof(uint64_t));
+  if (digits == NULL || work == NULL) {
+    free(digits);
+    free(work);
+    return SEG_NOMEM("Unable to allocate space to format an integer.");
+  }
+
+  // Divide by 10^19 repeatedly, writing digits backward from the end.
+  memcpy(work, x.limbs, x.n * sizeof(uint64_t));
+  size_t n = x.n;
+  char *cursor = digits + capacity;
+
+  do {
+    dlimb partial = 0;
+    for (size_t i = n; i-- > 0;) {
+      partial = (partial << 64) | work[i];
+      work[i] = (uint64_t) (partial / DECIMAL_CHUNK);
+      partial %= DECIMAL_CHUNK;
+    }
+    n = mag_normalize(work, n);
+
+    uint64_t chunk = (uint64_t) partial;
+    for (int i = 0; i < DECIMAL_CHUNK_DIGITS && (n > 0 || chunk > 0 || i == 0); i++) {
+      *--cursor = (char) ('0' + chunk % 10);
+      chunk /= 10;
+    }
+  } while (n > 0);
+
+  if (x.negative) {
+    *--cursor = '-';
+  }
+
+  err = seg_string(r, cursor, (uint64_t) (digits + capacity - cursor), out);
+
+  free(digits);
+  free(work);
+  return err;
+}
@@ -0,0 +1,71 @@
+#ifndef INTEGER_H
+#define INTEGER_H
+
+#include <stdint.h>
+
+#include "errors.h"
+#include "model/object.h"
+
+/*
+ * Integer arithmetic of arbitrary precision. Integers from SEG_INTEGER_MIN to SEG_INTEGER_MAX are
+ * immediates, and arithmetic on them never allocates unless its result leaves that range. Results
+ * that do are promoted to heap-allocated integers, and results that fit again are returned as
+ * immediates, so each integer has exactly one representation.
+ *
+ * Every operation fails with SEG_TYPE if an operand isn't an integer, and with SEG_NOMEM if a large
+ * result, or the scratch space used to compute it, can't be allocated.
+ */
+
+/*
+ * Compute a + b.
+ */
+seg_err seg_integer_add(seg_runtime *r, seg_object a, seg_object b, seg_object *out);
+
+/*
+ * Compute a - b.
+ */
+seg_err seg_integer_sub(seg_runtime *r, seg_object a, seg_object b, seg_object *out);
+
+/*
+ * Compute a * b.
+ */
+seg_err seg_integer_mul(seg_runtime *r, seg_object a, seg_object b, seg_object *out);
+
+/*
+ * Divide a by b, rounding the quotient toward negative infinity, so that the remainder is zero or
+ * has the sign of b. Either output may be NULL.
+ *
+ * SEG_RANGE: If b is zero.
+ */
+seg_err seg_integer_divmod(
+  seg_runtime *r,
+  seg_object a,
+  seg_object b,
+  seg_object *quotient,
+  seg_object *remainder
+);
+
+/*
+ * Compare two integers, setting `out` to a negative number, zero, or a positive number as a is less
+ * than, equal to, or greater than b.
+ */
+seg_err seg_integer_compare(seg_runtime *r, seg_object a, seg_object b, int *out);
+
+/*
+ * Access the value of any integer that fits in 64 bits.
+ *
+ * SEG_RANGE: If the integer is too large.
+ */
+seg_err seg_integer_to_int64(seg_runtime *r, seg_object integer, int64_t *out);
+
+/*
+ * Format an integer in decimal, as a String.
+ */
+seg_err seg_integer_string(seg_runtime *r, seg_object integer, seg_object *out);
+
+/*
+ * Allocate a heap integer for a value outside of the immediate range, for seg_integer().
+ */
+seg_err _seg_integer_box(seg_runtime *r, int64_t value, seg_object *out);
+
+#endif
@@ -21,12 +21,12 @@ seg_err seg_class(seg_runtime *r, const char *name, seg_storage storage, seg_obj
 
   // Ensure that the class object has enough slots for its own instance variables, then populate
   // them.
-  SEG_TRY(seg_slotted_grow(out, (uint64_t) SEG_CLASS_SLOTCOUNT));
+  SEG_TRY(seg_slotted_grow(r, out, (uint64_t) SEG_CLASS_SLOTCOUNT));
 
-  SEG_TRY(seg_slot_atput(*out, (uint64_t) SEG_CLASS_SLOT_NAME, o_name));
-  SEG_TRY(seg_slot_atput(*out, (uint64_t) SEG_CLASS_SLOT_STORAGE, o_storage));
-  SEG_TRY(seg_slot_atput(*out, (uint64_t) SEG_CLASS_SLOT_LENGTH, o_length));
-  SEG_TRY(seg_slot_atput(*out, (uint64_t) SEG_CLASS_SLOT_IVARS, boots->none_instance));
+  SEG_TRY(seg_slot_atput(r, *out, (uint64_t) SEG_CLASS_SLOT_NAME, o_name));
+  SEG_TRY(seg_slot_atput(r, *out, (uint64_t) SEG_CLASS_SLOT_STORAGE, o_storage));
+  SEG_TRY(seg_slot_atput(r, *out, (uint64_t) SEG_CLASS_SLOT_LENGTH, o_length));
+  SEG_TRY(seg_slot_atput(r, *out, (uint64_t) SEG_CLASS_SLOT_IVARS, boots->none_instance));
 
   return SEG_OK;
 }
@@ -43,7 +43,7 @@ seg_err seg_class_ivars(seg_runtime *r, seg_object klass, int64_t count, ...)
 
   seg_object ivar_array;
   SEG_TRY(seg_slotted(r, boots->array_class, &ivar_array));
-  SEG_TRY(seg_slotted_grow(&ivar_array, count));
+  SEG_TRY(seg_slotted_grow(r, &ivar_array, count));
 
   va_start(args, count);
 
@@ -57,7 +57,7 @@ seg_err seg_class_ivars(seg_runtime *r, seg_object klass, int64_t count, ...)
       return err;
     }
 
-    SEG_TRY(seg_slot_atput(ivar_array, i, ivarsym));
+    SEG_TRY(seg_slot_atput(r, ivar_array, i, ivarsym));
     if (err != SEG_OK) {
       va_end(args);
       return err;
@@ -68,8 +68,8 @@ seg_err seg_class_ivars(seg_runtime *r, seg_object klass, int64_t count, ...)
 
   seg_object slot_count;
   SEG_TRY(seg_integer(r, count, &slot_count));
-  SEG_TRY(seg_slot_atput(klass, SEG_CLASS_SLOT_LENGTH, slot_count));
-  SEG_TRY(seg_slot_atput(klass, SEG_CLASS_SLOT_IVARS, ivar_array));
+  SEG_TRY(seg_slot_atput(r, klass, SEG_CLASS_SLOT_LENGTH, slot_count));
+  SEG_TRY(seg_slot_atput(r, klass, SEG_CLASS_SLOT_IVARS, ivar_array));
 
   return SEG_OK;
 }
@@ -0,0 +1,81 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+
+#include "model/object.h"
+
+/*
+ * The layouts of heap objects. Only the object model and the collector, which copies and traces
+ * objects, should look inside them; everything else goes through the accessors in object.h.
+ */
+
+/*
+ * The kinds of immediate. Every odd kind is a float: the kind's low bit, together with the
+ * immediate bit, tags the other 62 bits of the object as float bits. The remaining kinds are even.
+ */
+typedef enum {
+  SEG_IMM_FLOAT = 1,
+  SEG_IMM_INTEGER = 2,
+  SEG_IMM_STRING = 4,
+  SEG_IMM_SYMBOL = 6
+} seg_imm_kinds;
+
+/*
+ * Storage shared by all heap-allocated (non-immediate) seg_object values.
+ */
+struct seg_object_common {
+
+  /*
+  * All objects contain at least a pointer to the Class object that instantiated them. The Class
+  * class containers a pointer to itself.
+  */
+  seg_object klass;
+
+};
+
+/*
+ * Buffers (to include strings of various encodings and symbols) store their content as an opaque
+ * sequence of bytes.
+ */
+typedef struct {
+  seg_object_common common;
+  uint64_t length;
+  char bytes[];
+} seg_object_buffer;
+
+/*
+ * Non-immediate symbols carry their symbol ID after their bytes, at the next four-byte boundary.
+ */
+#define SEG_SYMBOL_ID_OFFSET(length) (((length) + 3) & ~((uint64_t) 3))
+
+/*
+ * Most instances are slotted objects. Slotted objects contain references to one or more other
+ * objects, indexed by instance variable name or by numeric offset.
+ */
+typedef struct {
+  seg_object_common common;
+  uint64_t length;
+  seg_object slots[];
+} seg_object_slotted;
+
+/*
+ * Integers too large to be immediates are buffers of 64-bit limbs, least significant first, after a
+ * sign word. The most significant limb is never zero, and a value that fits in an immediate is
+ * never stored this way. `length` counts the bytes of the sign and the limbs, as for any buffer.
+ */
+typedef struct {
+  seg_object_common common;
+  uint64_t length;
+  uint64_t negative;
+  uint64_t limbs[];
+} seg_object_bigint;
+
+#define SEG_BIGINT_LIMBS(length) (((length) - sizeof(uint64_t)) / sizeof(uint64_t))
+
+_Static_assert(
+  sizeof(seg_object_bigint) == sizeof(seg_object_buffer) + sizeof(uint64_t),
+  "Big integers must be sized like buffers."
+);
+
+#endif
@@ -5,62 +5,27 @@
 
 #include "errors.h"
 #include "model/object.h"
+#include "model/layout.h"
 #include "model/klass.h"
+#include "model/integer.h"
 #include "runtime/runtime.h"
+#include "runtime/gc.h"
 #include "runtime/symboltable.h"
 
-typedef enum {
-  SEG_IMM_INTEGER = 1,
-  SEG_IMM_FLOAT = 2,
-  SEG_IMM_STRING = 3,
-  SEG_IMM_SYMBOL = 4
-} seg_imm_kinds;
-
-/*
- * Storage shared by all heap-allocated (non-immediate) seg_object values.
- */
-struct seg_object_common {
-
-  /*
-  * All objects contain at least a pointer to the Class object that instantiated them. The Class
-  * class containers a pointer to itself.
-  */
-  seg_object klass;
-
-};
-
-/*
- * Buffers (to include strings of various encodings and symbols) store their content as an opaque
- * sequence of bytes.
- */
-typedef struct {
-  seg_object_common common;
-  uint64_t length;
-  char bytes[];
-} seg_object_buffer;
-
-/*
- * Most instances are slotted objects. Slotted objects contain references to one or more other
- * objects, indexed by instance variable name or by numeric offset.
- */
-typedef struct {
-  seg_object_common common;
-  uint64_t length;
-  seg_object slots[];
-} seg_object_slotted;
-
 seg_err seg_object_class(seg_runtime *r, seg_object instance, seg_object *out)
 {
   if (instance.bits.immediate) {
     const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
 
+    if (instance.bits.kind & SEG_IMM_FLOAT) {
+      *out = boots->float_class;
+      return SEG_OK;
+    }
+
     switch (instance.bits.kind) {
     case SEG_IMM_INTEGER:
       *out = boots->integer_class;
       break;
-    case SEG_IMM_FLOAT:
-      *out = boots->float_class;
-      break;
     case SEG_IMM_STRING:
       *out = boots->string_class;
       break;
@@ -112,8 +77,8 @@ seg_object seg_object_frompointer(void *p)
 
 seg_err seg_integer(seg_runtime *r, int64_t value, seg_object *out)
 {
-  if (value <= SEG_INTEGER_MIN || value >= SEG_INTEGER_MAX) {
-    return SEG_RANGE("Integer out of immediate range.");
+  if (value < SEG_INTEGER_MIN || value > SEG_INTEGER_MAX) {
+    return _seg_integer_box(r, value, out);
   }
 
   out->bits.immediate = 1;
@@ -137,13 +102,32 @@ seg_err seg_integer_value(seg_object object, int64_t *out)
 
 // SEG_BUFFER //////////////////////////////////////////////////////////////////////////////////////
 
+static size_t _buffer_size(uint64_t length, bool is_string)
+{
+  if (is_string) {
+    return sizeof(seg_object_buffer) + length;
+  }
+  return sizeof(seg_object_buffer) + SEG_SYMBOL_ID_OFFSET(length) + sizeof(uint32_t);
+}
+
+/*
+ * Strings are young. Symbols are interned from any thread and freed one by one when the symbol
+ * table sweeps them, so they're pinned.
+ */
+static seg_alloc_placement _buffer_placement(bool is_string)
+{
+  return is_string ? SEG_ALLOC_YOUNG : SEG_ALLOC_PINNED;
+}
+
 static seg_err _buffer(seg_runtime *r, const char *str, uint64_t length, bool is_string, seg_object *out) {
   if (length > SEG_STR_IMMLEN) {
     // Allocate a non-immediate string object.
-    seg_object_buffer *s = malloc(sizeof(seg_object_buffer) + length);
-    if (s == NULL) {
-      return SEG_NOMEM("Unable to allocate a buffer.");
-    }
+    seg_err err;
+    seg_object_buffer *s;
+    SEG_TRY(seg_runtime_allocate(
+      r, SEG_MEMORY_BUFFERS, _buffer_placement(is_string), _buffer_size(length, is_string),
+      (void **) &s
+    ));
 
     const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
     if (is_string) {
@@ -155,6 +139,9 @@ static seg_err _buffer(seg_runtime *r, const char *str, uint64_t length, bool is
     memcpy(s->bytes, str, length);
 
     out->pointer = (seg_object_common*) s;
+    if (! is_string) {
+      seg_symbol_set_id(*out, SEG_NO_SYMBOL_ID);
+    }
 
     return SEG_OK;
   }
@@ -196,6 +183,60 @@ seg_err seg_symbol(seg_runtime *r, const char *str, uint64_t length, seg_object
   return _buffer(r, str, length, false, out);
 }
 
+void seg_delete_symbol(seg_runtime *r, seg_object symbol)
+{
+  seg_object_buffer *s = (seg_object_buffer *) symbol.pointer;
+
+  seg_runtime_release(
+    r, SEG_MEMORY_BUFFERS, _buffer_placement(false), s, _buffer_size(s->length, false)
+  );
+}
+
+uint64_t seg_symbol_footprint(uint64_t length)
+{
+  uint64_t size = sizeof(seg_object_buffer) + SEG_SYMBOL_ID_OFFSET(length) + sizeof(uint32_t);
+  return (size + 7) & ~((uint64_t) 7);
+}
+
+void seg_symbol_write(void *at, const char *str, uint64_t length)
+{
+  seg_object_buffer *s = at;
+
+  memset(s, 0, seg_symbol_footprint(length));
+  s->length = length;
+  memcpy(s->bytes, str, length);
+
+  seg_object o = SEG_FROMPOINTER(s);
+  seg_symbol_set_id(o, SEG_NO_SYMBOL_ID);
+}
+
+seg_object seg_symbol_adopt(seg_runtime *r, void *at)
+{
+  seg_object_buffer *s = at;
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  s->common.klass = boots->symbol_class;
+
+  seg_object o = SEG_FROMPOINTER(s);
+  return o;
+}
+
+uint32_t seg_symbol_id(seg_object symbol)
+{
+  seg_object_buffer *casted = (seg_object_buffer *) symbol.pointer;
+  uint32_t id;
+
+  memcpy(&id, casted->bytes + SEG_SYMBOL_ID_OFFSET(casted->length), sizeof(uint32_t));
+  return id;
+}
+
+void seg_symbol_set_id(seg_object symbol, uint32_t id)
+{
+  seg_object_buffer *casted = (seg_object_buffer *) symbol.pointer;
+
+  memcpy(casted->bytes + SEG_SYMBOL_ID_OFFSET(casted->length), &id, sizeof(uint32_t));
+}
+
 seg_err seg_buffer_contents(seg_object *buffer, char **out, uint64_t *length)
 {
   if (buffer->bits.immediate) {
@@ -218,28 +259,144 @@ seg_err seg_buffer_contents(seg_object *buffer, char **out, uint64_t *length)
   return SEG_OK;
 }
 
-// SEG_SLOTTED /////////////////////////////////////////////////////////////////////////////////////
+// SEG_FLOAT ///////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * An immediate float keeps a double's sign and all 52 bits of its mantissa, but only nine bits of
+ * its exponent: the two bits below the exponent's top bit must both be its complement. That covers
+ * every magnitude from 2^-255 up to 2^257. The double's bits are rotated left by three, moving its
+ * sign and the exponent's top two bits to the bottom, and then those two are replaced by the tag.
+ *
+ * Zero doesn't fit, so it takes the representation of the one value that's excluded from the range
+ * instead: exactly 2^-255, which is rare enough to be allocated along with the rest.
+ */
+#define FLOAT_TAG ((uint64_t) 0x3)
+#define FLOAT_EXCLUDED ((uint64_t) 0x3000000000000000)
+#define FLOAT_ZERO ((uint64_t) 0x8000000000000003)
+
+static uint64_t _double_bits(double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static seg_object _float_immediate(uint64_t word)
+{
+  seg_object o;
+  memcpy(&o, &word, sizeof(o));
+  return o;
+}
+
+_Static_assert(sizeof(seg_object) == sizeof(uint64_t), "Immediate floats must fill an object.");
+
+bool seg_float_is_immediate(double value)
+{
+  uint64_t bits = _double_bits(value);
+  uint64_t top = (bits >> 60) & 0x7;
+
+  return bits == 0 || ((top == 0x3 || top == 0x4) && bits != FLOAT_EXCLUDED);
+}
+
+seg_err seg_float(seg_runtime *r, double value, seg_object *out)
+{
+  uint64_t bits = _double_bits(value);
+
+  if (bits == 0) {
+    *out = _float_immediate(FLOAT_ZERO);
+    return SEG_OK;
+  }
+
+  if (seg_float_is_immediate(value)) {
+    uint64_t rotated = (bits << 3) | (bits >> 61);
+    *out = _float_immediate((rotated & ~FLOAT_TAG) | FLOAT_TAG);
+    return SEG_OK;
+  }
+
+  // Infinities, NaNs, negative zero, and extreme magnitudes are boxed.
+  seg_err err;
+  seg_object_buffer *b;
+  SEG_TRY(seg_runtime_allocate(
+    r, SEG_MEMORY_BUFFERS, SEG_ALLOC_YOUNG, _buffer_size(sizeof(double), true), (void **) &b
+  ));
 
-static seg_err _slotted_alloc(uint64_t length, seg_object_slotted **out)
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+  b->common.klass = boots->float_class;
+  b->length = sizeof(double);
+  memcpy(b->bytes, &value, sizeof(double));
+
+  out->pointer = (seg_object_common*) b;
+  return SEG_OK;
+}
+
+seg_err seg_float_value(seg_runtime *r, seg_object object, double *out)
 {
-  *out = malloc(sizeof(seg_object_slotted) + (length * sizeof(seg_object)));
-  if (*out == NULL) {
-    return SEG_NOMEM("Unable to allocate a slotted object.");
+  if (object.bits.immediate && (object.bits.kind & SEG_IMM_FLOAT)) {
+    uint64_t word;
+    memcpy(&word, &object, sizeof(word));
+
+    if (word == FLOAT_ZERO) {
+      *out = 0.0;
+      return SEG_OK;
+    }
+
+    // The top bit now holds the lowest of the exponent's top three bits, which determines the
+    // other two.
+    uint64_t rotated = (2 - (word >> 63)) | (word & ~FLOAT_TAG);
+    uint64_t bits = (rotated >> 3) | (rotated << 61);
+    memcpy(out, &bits, sizeof(double));
+    return SEG_OK;
   }
+
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+  if (object.bits.immediate || !SEG_SAME(object.pointer->klass, boots->float_class)) {
+    return SEG_TYPE("Object was not a float");
+  }
+
+  memcpy(out, ((seg_object_buffer *) object.pointer)->bytes, sizeof(double));
   return SEG_OK;
 }
 
+// SEG_SLOTTED /////////////////////////////////////////////////////////////////////////////////////
+
+static size_t _slotted_size(uint64_t length)
+{
+  return sizeof(seg_object_slotted) + (length * sizeof(seg_object));
+}
+
+/*
+ * Classes are long-lived, and every instance refers to one, so they're allocated directly in the
+ * old generation. That way no object's class is ever moved out from under it.
+ */
+static seg_alloc_placement _slotted_placement(seg_runtime *r, seg_object klass)
+{
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  return SEG_SAME(klass, boots->class_class) ? SEG_ALLOC_OLD : SEG_ALLOC_YOUNG;
+}
+
+static seg_err _slotted_alloc(
+  seg_runtime *r,
+  seg_alloc_placement placement,
+  uint64_t length,
+  seg_object_slotted **out
+) {
+  return seg_runtime_allocate(
+    r, SEG_MEMORY_SLOTTED, placement, _slotted_size(length), (void **) out
+  );
+}
+
 static void _slotted_init_header(seg_object_slotted *object, seg_object klass, uint64_t length)
 {
   object->common.klass.pointer = klass.pointer;
   object->length = length;
 }
 
-static void _slotted_init_slots(seg_runtime *r, seg_object_slotted *object)
+static void _slotted_init_slots(seg_runtime *r, seg_object_slotted *object, uint64_t from)
 {
   const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
 
-  for (uint64_t i = 0; i < object->length; i++) {
+  for (uint64_t i = from; i < object->length; i++) {
     object->slots[i] = boots->none_instance;
   }
 }
@@ -270,12 +427,20 @@ seg_err seg_slotted(seg_runtime *r, seg_object klass, seg_object *out)
   SEG_TRY(seg_integer_value(length_slot, &length_value));
 
   seg_object_slotted *result;
-  SEG_TRY(_slotted_alloc(length_value, &result));
+  SEG_TRY(_slotted_alloc(r, _slotted_placement(r, klass), length_value, &result));
   _slotted_init_header(result, klass, length_value);
-  _slotted_init_slots(r, result);
+  _slotted_init_slots(r, result, 0);
 
   out->pointer = (seg_object_common*) result;
 
+  // Every slot now holds the same object, so one barrier covers them all.
+  err = seg_gc_write_barrier(seg_runtime_gc(r), *out, boots->none_instance);
+  if (err != SEG_OK) {
+    seg_runtime_release(r, SEG_MEMORY_SLOTTED, _slotted_placement(r, klass), result,
+      _slotted_size(result->length));
+    return err;
+  }
+
   return SEG_OK;
 }
 
@@ -286,7 +451,7 @@ seg_err seg_slotted_length(seg_object slotted, uint64_t *out)
   return SEG_OK;
 }
 
-seg_err seg_slotted_grow(seg_object *slotted, uint64_t length)
+seg_err seg_slotted_grow(seg_runtime *r, seg_object *slotted, uint64_t length)
 {
   seg_err err;
   seg_object_slotted *casted = (seg_object_slotted*) slotted->pointer;
@@ -295,13 +460,26 @@ seg_err seg_slotted_grow(seg_object *slotted, uint64_t length)
     return SEG_OK;
   }
 
+  seg_alloc_placement placement = _slotted_placement(r, casted->common.klass);
+
   seg_object_slotted *bigger;
-  SEG_TRY(_slotted_alloc(length, &bigger));
+  SEG_TRY(_slotted_alloc(r, placement, length, &bigger));
   _slotted_init_header(bigger, casted->common.klass, length);
-  memcpy(bigger->slots, casted->slots, (size_t) casted->length);
+  memcpy(bigger->slots, casted->slots, (size_t) casted->length * sizeof(seg_object));
+
+  // The collector traces every slot, so the new ones can't be left uninitialized.
+  _slotted_init_slots(r, bigger, casted->length);
+
+  // The copied slots may refer to young objects that the collector must now find from here.
+  seg_object result = { .pointer = (seg_object_common*) bigger };
+  err = seg_gc_write_barrier_bulk(seg_runtime_gc(r), result);
+  if (err != SEG_OK) {
+    seg_runtime_release(r, SEG_MEMORY_SLOTTED, placement, bigger, _slotted_size(length));
+    return err;
+  }
 
   slotted->pointer = (seg_object_common*) bigger;
-  free(casted);
+  seg_runtime_release(r, SEG_MEMORY_SLOTTED, placement, casted, _slotted_size(casted->length));
 
   return SEG_OK;
 }
@@ -319,14 +497,19 @@ seg_err seg_slot_at(seg_object slotted, uint64_t index, seg_object *out)
   return SEG_OK;
 }
 
-seg_err seg_slot_atput(seg_object slotted, uint64_t index, seg_object value)
+seg_err seg_slot_atput(seg_runtime *r, seg_object slotted, uint64_t index, seg_object value)
 {
+  seg_err err;
   seg_object_slotted *casted = (seg_object_slotted*) slotted.pointer;
 
   if (index >= casted->length) {
     return SEG_RANGE("Attempt to mutate invalid slot index");
   }
 
+  if (!SEG_IS_IMMEDIATE(value)) {
+    SEG_TRY(seg_gc_write_barrier(seg_runtime_gc(r), slotted, value));
+  }
+
   casted->slots[index] = value;
 
   return SEG_OK;
@@ -339,13 +522,8 @@ seg_err _seg_bootstrap_runtime(seg_runtime *runtime, seg_bootstrap_objects *boot
   seg_err err;
   seg_symboltable *symtable = seg_runtime_symboltable(runtime);
 
-  // Prepopulate the symbol table with symbols that we're going to use as names later.
-  seg_object sym_name, sym_storage, sym_length, sym_ivars;
-  SEG_TRY(seg_symboltable_cintern(symtable, "name", &sym_name));
-  SEG_TRY(seg_symboltable_cintern(symtable, "storage", &sym_storage));
-  SEG_TRY(seg_symboltable_cintern(symtable, "preferred_length", &sym_length));
-  SEG_TRY(seg_symboltable_cintern(symtable, "instance_variables", &sym_ivars));
-
+  // Symbols that we're going to use as names later are either immediates or well-known symbols
+  // that the symbol table created along with itself, so they needn't be interned here.
   seg_object sym_name_class;
   SEG_TRY(seg_symboltable_cintern(symtable, "Class", &sym_name_class));
 
@@ -361,13 +539,13 @@ seg_err _seg_bootstrap_runtime(seg_runtime *runtime, seg_bootstrap_objects *boot
   seg_object class_class;
   seg_object_slotted *class_class_internal;
 
-  SEG_TRY(_slotted_alloc(SEG_CLASS_SLOTCOUNT, &class_class_internal));
+  SEG_TRY(_slotted_alloc(runtime, SEG_ALLOC_OLD, SEG_CLASS_SLOTCOUNT, &class_class_internal));
   class_class.pointer = (seg_object_common*) class_class_internal;
   _slotted_init_header(class_class_internal, class_class, SEG_CLASS_SLOTCOUNT);
 
-  SEG_TRY(seg_slot_atput(class_class, (uint64_t) SEG_CLASS_SLOT_NAME, sym_name_class));
-  SEG_TRY(seg_slot_atput(class_class, (uint64_t) SEG_CLASS_SLOT_STORAGE, slotted_storage));
-  SEG_TRY(seg_slot_atput(class_class, (uint64_t) SEG_CLASS_SLOT_LENGTH, preferred_length));
+  SEG_TRY(seg_slot_atput(runtime, class_class, (uint64_t) SEG_CLASS_SLOT_NAME, sym_name_class));
+  SEG_TRY(seg_slot_atput(runtime, class_class, (uint64_t) SEG_CLASS_SLOT_STORAGE, slotted_storage));
+  SEG_TRY(seg_slot_atput(runtime, class_class, (uint64_t) SEG_CLASS_SLOT_LENGTH, preferred_length));
 
   bootstrap->class_class = class_class;
 
@@ -378,16 +556,54 @@ seg_err _seg_bootstrap_runtime(seg_runtime *runtime, seg_bootstrap_objects *boot
   SEG_TRY(seg_slotted(runtime, bootstrap->array_class, &empty_array_0));
   SEG_TRY(seg_slotted(runtime, bootstrap->array_class, &empty_array_1));
 
-  SEG_TRY(seg_slot_atput(bootstrap->class_class, (uint64_t) SEG_CLASS_SLOT_IVARS, empty_array_0));
-  SEG_TRY(seg_slot_atput(bootstrap->array_class, (uint64_t) SEG_CLASS_SLOT_IVARS, empty_array_1));
+  SEG_TRY(seg_slot_atput(
+    runtime, bootstrap->class_class, (uint64_t) SEG_CLASS_SLOT_IVARS, empty_array_0
+  ));
+  SEG_TRY(seg_slot_atput(
+    runtime, bootstrap->array_class, (uint64_t) SEG_CLASS_SLOT_IVARS, empty_array_1
+  ));
 
   // Initialize the rest of the well-known class objects.
-  SEG_TRY(seg_class(runtime, "Integer", SEG_STORAGE_IMMEDIATE, &bootstrap->integer_class));
-  SEG_TRY(seg_class(runtime, "Float", SEG_STORAGE_IMMEDIATE, &bootstrap->float_class));
+  SEG_TRY(seg_class(runtime, "Integer", SEG_STORAGE_BUFFER, &bootstrap->integer_class));
+  SEG_TRY(seg_class(runtime, "Float", SEG_STORAGE_BUFFER, &bootstrap->float_class));
   SEG_TRY(seg_class(runtime, "String", SEG_STORAGE_BUFFER, &bootstrap->string_class));
   SEG_TRY(seg_class(runtime, "Symbol", SEG_STORAGE_BUFFER, &bootstrap->symbol_class));
   SEG_TRY(seg_class(runtime, "Array", SEG_STORAGE_SLOTTED, &bootstrap->array_class));
   SEG_TRY(seg_class(runtime, "Block", SEG_STORAGE_BUFFER, &bootstrap->block_class));
 
+  // The well-known symbols were created along with the symbol table, before the Symbol class
+  // existed, so they're given it now.
+  for (int i = 0; i < SEG_WELLKNOWN_COUNT; i++) {
+    seg_object symbol = seg_symboltable_wellknown(symtable, (seg_wellknown_id) i);
+    symbol.pointer->klass = bootstrap->symbol_class;
+  }
+
   return SEG_OK;
 }
+
+// COLLECTION //////////////////////////////////////////////////////////////////////////////////////
+
+seg_err _seg_object_layout(
+  seg_runtime *r,
+  seg_object_common *o,
+  seg_storage *storage,
+  size_t *size
+) {
+  seg_err err;
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  SEG_TRY(seg_class_storage(o->klass, storage));
+
+  switch (*storage) {
+  case SEG_STORAGE_BUFFER: {
+    bool is_string = ! SEG_SAME(o->klass, boots->symbol_class);
+    *size = _buffer_size(((seg_object_buffer *) o)->length, is_string);
+    return SEG_OK;
+  }
+  case SEG_STORAGE_SLOTTED:
+    *size = _slotted_size(((seg_object_slotted *) o)->length);
+    return SEG_OK;
+  default:
+    return SEG_INVAL("Heap object with immediate storage.");
+  }
+}
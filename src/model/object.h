@@ -2,6 +2,7 @@
 #define OBJECT_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 #include "errors.h"
@@ -22,9 +23,9 @@ typedef union {
   /* Immediate value storage. */
   struct {
     /*
-    * Because malloc() aligns the memory it allocates (on 64-bit systems, generally on four-byte
-    * boundaries), it will never return an odd pointer. This means that we can use the least
-    * significant bit as a flag for immediates.
+    * Because seg_runtime_allocate() aligns every object it allocates on eight-byte boundaries,
+    * whether it's carved from the nursery or returned by malloc(), it will never return an odd
+    * pointer. This means that we can use the least significant bit as a flag for immediates.
     */
     unsigned immediate: 1;
 
@@ -92,29 +93,51 @@ seg_err seg_object_storage(seg_object o, seg_storage *out);
 seg_object seg_object_frompointer(void *p);
 
 /*
- * Allocate a new integer object.
+ * Construct an integer. Values from SEG_INTEGER_MIN to SEG_INTEGER_MAX are immediates; larger ones
+ * are allocated on the heap. See model/integer.h for arithmetic.
  *
- * SEG_RANGE: If value uses more than 56 bits.
+ * SEG_NOMEM: If a value outside the immediate range can't be allocated.
  */
 seg_err seg_integer(seg_runtime *r, int64_t value, seg_object *out);
 
 /*
- * The maximum value that can legally be stored within an immediate integer.
+ * The maximum value that can be stored within an immediate integer's 56 bits.
  */
-#define SEG_INTEGER_MAX ((int64_t) 0x00ffffffffffffff)
+#define SEG_INTEGER_MAX ((int64_t) 0x007fffffffffffff)
 
 /*
- * The minimum value that can legally be stored within an immediate integer.
+ * The minimum value that can be stored within an immediate integer.
  */
-#define SEG_INTEGER_MIN ((int64_t) 0xffe0000000000000)
+#define SEG_INTEGER_MIN (-SEG_INTEGER_MAX - 1)
 
 /*
- * Access the value of an immediate integer.
+ * Access the value of an immediate integer. Use seg_integer_to_int64() to accept any integer.
  *
  * SEG_TYPE: If object is not an immediate integer.
  */
 seg_err seg_integer_value(seg_object object, int64_t *out);
 
+/*
+ * Construct a float. Positive zero, and every value with a magnitude above 2^-255 and below 2^257,
+ * is returned as an immediate without allocating. Anything else, such as an infinity, a NaN, or
+ * negative zero, is allocated on the heap.
+ *
+ * SEG_NOMEM: If a value that isn't immediate can't be allocated.
+ */
+seg_err seg_float(seg_runtime *r, double value, seg_object *out);
+
+/*
+ * Return true if seg_float() would return value as an immediate, without allocating.
+ */
+bool seg_float_is_immediate(double value);
+
+/*
+ * Access the value of a float, immediate or not.
+ *
+ * SEG_TYPE: If object is not a float.
+ */
+seg_err seg_float_value(seg_runtime *r, seg_object object, double *out);
+
 /*
  * Allocate a new string object. If it's seven bytes or less in length, return an immediate string
  * instead.
@@ -150,6 +173,47 @@ seg_err seg_cstring(seg_runtime *r, const char *str, seg_object *out);
  */
 seg_err seg_symbol(seg_runtime *r, const char *str, uint64_t length, seg_object *out);
 
+/*
+ * Free a non-immediate symbol allocated by seg_symbol(). Only the symboltable should call this, for
+ * symbols that it's discarding.
+ */
+void seg_delete_symbol(seg_runtime *r, seg_object symbol);
+
+/*
+ * Return the number of bytes that a non-immediate symbol with a `length`-byte name occupies,
+ * rounded up to a multiple of eight so that symbols can be laid out back to back.
+ */
+uint64_t seg_symbol_footprint(uint64_t length);
+
+/*
+ * Lay out a non-immediate symbol in the `seg_symbol_footprint(length)` bytes at `at`, which must be
+ * eight-byte aligned, instead of allocating it. The symbol contains no pointers, so its bytes may
+ * be written to a file and mapped back in at any address. It has no class until it's adopted.
+ */
+void seg_symbol_write(void *at, const char *str, uint64_t length);
+
+/*
+ * Give a symbol laid out by seg_symbol_write the runtime's Symbol class, and return it.
+ */
+seg_object seg_symbol_adopt(seg_runtime *r, void *at);
+
+/*
+ * The ID carried by a non-immediate symbol that no symboltable has assigned one.
+ */
+#define SEG_NO_SYMBOL_ID UINT32_MAX
+
+/*
+ * Access the ID stored within a non-immediate symbol. Use seg_symboltable_id() instead, which also
+ * assigns IDs to immediate symbols.
+ */
+uint32_t seg_symbol_id(seg_object symbol);
+
+/*
+ * Record the ID that a symboltable has assigned to a non-immediate symbol. Only the symboltable
+ * should call this, before the symbol is published.
+ */
+void seg_symbol_set_id(seg_object symbol, uint32_t id);
+
 /*
  * Access a symbol or string's contents and length.
  *
@@ -179,7 +243,7 @@ seg_err seg_slotted_length(seg_object instance, uint64_t *out);
  * SEG_TYPE: If instance is not a slotted object.
  * SEG_NOMEM: If the allocation fails.
  */
-seg_err seg_slotted_grow(seg_object *instance, uint64_t length);
+seg_err seg_slotted_grow(seg_runtime *r, seg_object *instance, uint64_t length);
 
 /*
  * Access a slot within a slotted object at a specific index.
@@ -190,12 +254,14 @@ seg_err seg_slotted_grow(seg_object *instance, uint64_t length);
 seg_err seg_slot_at(seg_object slotted, uint64_t index, seg_object *out);
 
 /*
- * Set a slot within a slotted object at a specific index.
+ * Set a slot within a slotted object at a specific index. Stores pass through the collector's write
+ * barrier, so that it can find old objects that refer to young ones.
  *
  * SEG_TYPE: If slotted is not actually a slotted object.
  * SEG_RANGE: If the index is beyond the object's current ivar capacity.
+ * SEG_NOMEM: If the collector can't remember the store. The slot is left unchanged.
  */
-seg_err seg_slot_atput(seg_object slotted, uint64_t index, seg_object value);
+seg_err seg_slot_atput(seg_runtime *r, seg_object slotted, uint64_t index, seg_object value);
 
 #define SEG_NO_IVAR UINT64_MAX
 
@@ -208,4 +274,17 @@ typedef struct seg_bootstrap_objects seg_bootstrap_objects;
  */
 seg_err _seg_bootstrap_runtime(seg_runtime *runtime, seg_bootstrap_objects *bootstrap);
 
+/*
+ * Report the storage that a heap object's class specifies, and the number of bytes the object
+ * occupies, so that the collector can copy it. Only the collector should call this.
+ *
+ * SEG_INVAL: If the object's class doesn't describe heap storage.
+ */
+seg_err _seg_object_layout(
+  seg_runtime *r,
+  seg_object_common *o,
+  seg_storage *storage,
+  size_t *size
+);
+
 #endif
@@ -11,6 +11,8 @@ typedef struct {
 
   int verbose;
 
+  const char *symbol_image;
+
   const char **src_paths;
   int src_count;
 } seg_options;
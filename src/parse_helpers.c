@@ -108,6 +108,8 @@ seg_expr_node *seg_parse_binop(
   seg_expr_node *out = malloc(sizeof(seg_expr_node));
   out->child_kind = SEG_METHODCALL;
   seg_symboltable_intern(state->symboltable, selname, length, &out->child.methodcall.selector);
+  free(selname);
+
   out->child.methodcall.receiver = lhs;
   out->child.methodcall.args = seg_parse_arg(state, rhs, NULL);
   return out;
@@ -134,6 +136,8 @@ seg_expr_node *seg_parse_methodcall(
   seg_expr_node *out = malloc(sizeof(seg_expr_node));
   out->child_kind = SEG_METHODCALL;
   seg_symboltable_intern(state->symboltable, selname, length, &out->child.methodcall.selector);
+  free(selname);
+
   out->child.methodcall.receiver = receiver;
   out->child.methodcall.args = args;
   return out;
@@ -194,8 +198,10 @@ seg_arg_list *seg_parse_arg(seg_parser_state *state, seg_expr_node *value, seg_t
     size_t length;
 
     kwname = seg_token_without(keyword, 0, 1, &length);
+    seg_delete_token(keyword);
 
     seg_symboltable_intern(state->symboltable, kwname, length, &arg->keyword);
+    free(kwname);
   } else {
     arg->keyword.pointer = NULL;
   }
@@ -0,0 +1,634 @@
+/* clock_gettime() is POSIX, not C11. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "ds/ptrtable.h"
+#include "model/layout.h"
+#include "runtime/gc.h"
+#include "runtime/nursery.h"
+#include "runtime/symboltable.h"
+
+/*
+ * The old generation is a doubly linked list of individually allocated objects, each preceded by a
+ * header. Young objects are copied into it the first time they survive a minor collection, and
+ * stay where they are until a major collection finds them unreachable.
+ */
+typedef struct gc_old_header {
+  struct gc_old_header *prev;
+  struct gc_old_header *next;
+
+  /* The bytes requested for the object that follows, and its seg_memory_kind. */
+  uint64_t size;
+  uint32_t kind;
+
+  /* Set while a major collection has found the object reachable. */
+  bool marked;
+
+  /* Set while the object is on the remembered stack. */
+  bool remembered;
+} gc_old_header;
+
+_Static_assert(
+  sizeof(gc_old_header) % SEG_NURSERY_ALIGN == 0,
+  "Old object headers must keep their objects aligned."
+);
+
+/* Collect the nursery at a safepoint once this much of it is used. */
+#define GC_MINOR_THRESHOLD (SEG_NURSERY_SIZE / 2)
+
+/* Collect the old generation once it has grown to this many bytes, at least. */
+#define GC_MAJOR_MINIMUM ((uint64_t) 8 * 1024 * 1024)
+
+/*
+ * A young object that has been copied out of the nursery has its class replaced by its new
+ * address, tagged with the low bit. No class is ever tagged, because classes are heap objects.
+ */
+#define GC_FORWARDED ((uintptr_t) 1)
+
+/* A growable stack of pointers, for roots and for objects waiting to be scanned. */
+typedef struct {
+  void **items;
+  uint64_t count;
+  uint64_t capacity;
+} gc_stack;
+
+struct seg_gc {
+  seg_runtime *runtime;
+  seg_bootstrap_objects *bootstraps;
+
+  seg_nursery nursery;
+
+  /* The old generation, most recently allocated first. */
+  gc_old_header *old;
+  uint64_t old_objects;
+  uint64_t old_bytes;
+
+  /* Locations registered with seg_gc_push_root(). */
+  gc_stack roots;
+
+  /*
+   * Old objects that may refer to young ones, found by the write barrier. A minor collection scans
+   * these instead of the whole old generation.
+   */
+  gc_stack remembered;
+
+  /* Promoted objects whose slots haven't been scanned yet, or marked objects during a major. */
+  gc_stack gray;
+
+  /* Collections that allocation has requested, and the old generation size that requests one. */
+  bool minor_requested;
+  bool major_requested;
+  uint64_t major_threshold;
+
+  /*
+   * Live young objects and their bytes, by seg_memory_kind. Only the thread that owns the nursery
+   * writes these, so they're updated without a locked instruction.
+   */
+  _Atomic uint64_t young_allocations[SEG_MEMORY_KINDS];
+  _Atomic uint64_t young_bytes[SEG_MEMORY_KINDS];
+
+  seg_gc_stats stats;
+};
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/* Add to a counter that only one thread writes. */
+static void add_owned(_Atomic uint64_t *counter, uint64_t delta)
+{
+  uint64_t current = atomic_load_explicit(counter, memory_order_relaxed);
+  atomic_store_explicit(counter, current + delta, memory_order_relaxed);
+}
+
+static seg_err stack_push(gc_stack *stack, void *item)
+{
+  if (stack->count == stack->capacity) {
+    uint64_t capacity = stack->capacity == 0 ? 64 : stack->capacity * 2;
+    void **items = realloc(stack->items, sizeof(void *) * capacity);
+    if (items == NULL) {
+      return SEG_NOMEM("Unable to grow a collector stack.");
+    }
+
+    stack->items = items;
+    stack->capacity = capacity;
+  }
+
+  stack->items[stack->count++] = item;
+  return SEG_OK;
+}
+
+static gc_old_header *header_of(void *object)
+{
+  return (gc_old_header *) object - 1;
+}
+
+seg_err seg_new_gc(seg_runtime *runtime, seg_bootstrap_objects *roots, seg_gc **out)
+{
+  seg_gc *gc = calloc(1, sizeof(seg_gc));
+  if (gc == NULL) {
+    return SEG_NOMEM("Unable to allocate the collector.");
+  }
+
+  gc->runtime = runtime;
+  gc->bootstraps = roots;
+  gc->major_threshold = GC_MAJOR_MINIMUM;
+  seg_nursery_init(&gc->nursery);
+
+  for (int k = 0; k < SEG_MEMORY_KINDS; k++) {
+    atomic_init(&gc->young_allocations[k], 0);
+    atomic_init(&gc->young_bytes[k], 0);
+  }
+
+  *out = gc;
+  return SEG_OK;
+}
+
+// ALLOCATION //////////////////////////////////////////////////////////////////////////////////////
+
+static seg_err old_allocate(seg_gc *gc, seg_memory_kind kind, size_t size, void **out)
+{
+  gc_old_header *header = malloc(sizeof(gc_old_header) + size);
+  if (header == NULL) {
+    return SEG_NOMEM("Unable to allocate an old object.");
+  }
+
+  header->prev = NULL;
+  header->next = gc->old;
+  header->size = size;
+  header->kind = (uint32_t) kind;
+  header->marked = false;
+  header->remembered = false;
+
+  if (gc->old != NULL) {
+    gc->old->prev = header;
+  }
+  gc->old = header;
+
+  gc->old_objects++;
+  gc->old_bytes += size;
+  if (gc->old_bytes >= gc->major_threshold) {
+    gc->major_requested = true;
+  }
+
+  _seg_runtime_allocated(gc->runtime, kind, 1, size);
+  _seg_runtime_allocated(gc->runtime, SEG_MEMORY_DIRECT, 1, size);
+
+  *out = header + 1;
+  return SEG_OK;
+}
+
+static void old_free(seg_gc *gc, gc_old_header *header)
+{
+  if (header->remembered) {
+    gc_stack *stack = &gc->remembered;
+    for (uint64_t i = 0; i < stack->count; i++) {
+      if (stack->items[i] == header + 1) {
+        stack->items[i] = stack->items[--stack->count];
+        break;
+      }
+    }
+  }
+
+  if (header->prev != NULL) {
+    header->prev->next = header->next;
+  } else {
+    gc->old = header->next;
+  }
+  if (header->next != NULL) {
+    header->next->prev = header->prev;
+  }
+
+  gc->old_objects--;
+  gc->old_bytes -= header->size;
+
+  _seg_runtime_released(gc->runtime, (seg_memory_kind) header->kind, 1, header->size);
+  _seg_runtime_released(gc->runtime, SEG_MEMORY_DIRECT, 1, header->size);
+  free(header);
+}
+
+seg_err seg_gc_allocate(
+  seg_gc *gc,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  size_t size,
+  void **out
+) {
+  if (placement == SEG_ALLOC_PINNED) {
+    void *object = malloc(size);
+    if (object == NULL) {
+      return SEG_NOMEM("Unable to allocate an object.");
+    }
+
+    _seg_runtime_allocated(gc->runtime, kind, 1, size);
+    _seg_runtime_allocated(gc->runtime, SEG_MEMORY_DIRECT, 1, size);
+    *out = object;
+    return SEG_OK;
+  }
+
+  if (placement == SEG_ALLOC_YOUNG && size <= SEG_NURSERY_MAX_OBJECT) {
+    void *object = seg_nursery_allocate(&gc->nursery, size);
+    if (object != NULL) {
+      add_owned(&gc->young_allocations[kind], 1);
+      add_owned(&gc->young_bytes[kind], size);
+      *out = object;
+      return SEG_OK;
+    }
+
+    /* The nursery is full. Tenure this object, and empty the nursery at the next safepoint. */
+    gc->minor_requested = true;
+  }
+
+  return old_allocate(gc, kind, size, out);
+}
+
+void seg_gc_release(
+  seg_gc *gc,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  void *object,
+  size_t size
+) {
+  if (placement == SEG_ALLOC_PINNED) {
+    _seg_runtime_released(gc->runtime, kind, 1, size);
+    _seg_runtime_released(gc->runtime, SEG_MEMORY_DIRECT, 1, size);
+    free(object);
+    return;
+  }
+
+  if (seg_nursery_contains(&gc->nursery, object)) {
+    /* Its memory is reclaimed when the nursery is emptied. */
+    add_owned(&gc->young_allocations[kind], -(uint64_t) 1);
+    add_owned(&gc->young_bytes[kind], -(uint64_t) size);
+    return;
+  }
+
+  old_free(gc, header_of(object));
+}
+
+// ROOTS ///////////////////////////////////////////////////////////////////////////////////////////
+
+seg_err seg_gc_push_root(seg_gc *gc, seg_object *root)
+{
+  return stack_push(&gc->roots, root);
+}
+
+void seg_gc_pop_roots(seg_gc *gc, uint64_t count)
+{
+  gc->roots.count -= count;
+}
+
+/* The bootstrap objects, as an array of roots. */
+static seg_object *bootstrap_roots(seg_gc *gc, uint64_t *count)
+{
+  *count = sizeof(seg_bootstrap_objects) / sizeof(seg_object);
+  return (seg_object *) gc->bootstraps;
+}
+
+_Static_assert(
+  sizeof(seg_bootstrap_objects) % sizeof(seg_object) == 0,
+  "The bootstrap objects must be scannable as an array of roots."
+);
+
+// WRITE BARRIER ///////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Each old object is its own card: it's remembered at most once between minor collections, however
+ * many of its slots are written.
+ */
+static seg_err remember(seg_gc *gc, void *object)
+{
+  gc_old_header *header = header_of(object);
+  if (header->remembered) {
+    return SEG_OK;
+  }
+
+  seg_err err = stack_push(&gc->remembered, object);
+  if (err == SEG_OK) {
+    header->remembered = true;
+  }
+  return err;
+}
+
+seg_err seg_gc_write_barrier(seg_gc *gc, seg_object object, seg_object value)
+{
+  if (
+    SEG_IS_IMMEDIATE(value) ||
+    ! seg_nursery_contains(&gc->nursery, value.pointer) ||
+    seg_nursery_contains(&gc->nursery, object.pointer)
+  ) {
+    return SEG_OK;
+  }
+
+  return remember(gc, object.pointer);
+}
+
+seg_err seg_gc_write_barrier_bulk(seg_gc *gc, seg_object object)
+{
+  if (seg_nursery_contains(&gc->nursery, object.pointer)) {
+    return SEG_OK;
+  }
+
+  return remember(gc, object.pointer);
+}
+
+// MINOR COLLECTION ////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * If `slot` refers to a young object, copy it into the old generation unless that's already
+ * happened, and refer to the copy instead.
+ */
+static seg_err evacuate(seg_gc *gc, seg_object *slot)
+{
+  seg_err err;
+  seg_object_common *o = slot->pointer;
+
+  if (SEG_IS_IMMEDIATE(*slot) || ! seg_nursery_contains(&gc->nursery, o)) {
+    return SEG_OK;
+  }
+
+  uintptr_t klass = (uintptr_t) o->klass.pointer;
+  if (klass & GC_FORWARDED) {
+    slot->pointer = (seg_object_common *) (klass & ~GC_FORWARDED);
+    return SEG_OK;
+  }
+
+  seg_storage storage;
+  size_t size;
+  SEG_TRY(_seg_object_layout(gc->runtime, o, &storage, &size));
+
+  seg_memory_kind kind = storage == SEG_STORAGE_SLOTTED ? SEG_MEMORY_SLOTTED : SEG_MEMORY_BUFFERS;
+  void *copy;
+  SEG_TRY(old_allocate(gc, kind, size, &copy));
+  memcpy(copy, o, size);
+
+  o->klass.pointer = (seg_object_common *) ((uintptr_t) copy | GC_FORWARDED);
+  slot->pointer = copy;
+  gc->stats.bytes_promoted += size;
+
+  /* Buffers don't refer to anything but their class, which is already old. */
+  if (storage == SEG_STORAGE_SLOTTED) {
+    SEG_TRY(stack_push(&gc->gray, copy));
+  }
+  return SEG_OK;
+}
+
+static seg_err evacuate_slots(seg_gc *gc, seg_object_common *o)
+{
+  seg_err err;
+  seg_object_slotted *slotted = (seg_object_slotted *) o;
+
+  for (uint64_t i = 0; i < slotted->length; i++) {
+    SEG_TRY(evacuate(gc, &slotted->slots[i]));
+  }
+  return SEG_OK;
+}
+
+static seg_err minor(seg_gc *gc)
+{
+  seg_err err;
+  uint64_t count;
+
+  seg_object *bootstraps = bootstrap_roots(gc, &count);
+  for (uint64_t i = 0; i < count; i++) {
+    SEG_TRY(evacuate(gc, &bootstraps[i]));
+  }
+
+  for (uint64_t i = 0; i < gc->roots.count; i++) {
+    SEG_TRY(evacuate(gc, (seg_object *) gc->roots.items[i]));
+  }
+
+  /*
+   * Only old objects that the write barrier has seen given a young reference can hold one. Objects
+   * promoted by this collection are scanned from the gray stack instead.
+   */
+  while (gc->remembered.count > 0) {
+    seg_object_common *o = gc->remembered.items[gc->remembered.count - 1];
+
+    SEG_TRY(evacuate_slots(gc, o));
+    header_of(o)->remembered = false;
+    gc->remembered.count--;
+    gc->stats.remembered_objects++;
+  }
+
+  while (gc->gray.count > 0) {
+    SEG_TRY(evacuate_slots(gc, gc->gray.items[--gc->gray.count]));
+  }
+
+  seg_nursery_reset(&gc->nursery);
+  gc->minor_requested = false;
+
+  for (int k = 0; k < SEG_MEMORY_KINDS; k++) {
+    atomic_store_explicit(&gc->young_allocations[k], 0, memory_order_relaxed);
+    atomic_store_explicit(&gc->young_bytes[k], 0, memory_order_relaxed);
+  }
+
+  return SEG_OK;
+}
+
+// MAJOR COLLECTION ////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  seg_gc *gc;
+
+  /* Reachable symbols, which are pinned rather than old, by identity. */
+  seg_ptrtable *symbols;
+} gc_marker;
+
+static seg_err mark(gc_marker *m, seg_object o)
+{
+  if (SEG_IS_IMMEDIATE(o) || o.pointer == NULL) {
+    return SEG_OK;
+  }
+
+  if (SEG_SAME(o.pointer->klass, m->gc->bootstraps->symbol_class)) {
+    void *previous;
+    return seg_ptrtable_put(m->symbols, o.pointer, o.pointer, &previous);
+  }
+
+  gc_old_header *header = header_of(o.pointer);
+  if (header->marked) {
+    return SEG_OK;
+  }
+
+  header->marked = true;
+  return stack_push(&m->gc->gray, o.pointer);
+}
+
+static seg_err mark_reachable(gc_marker *m)
+{
+  seg_err err;
+  seg_gc *gc = m->gc;
+  uint64_t count;
+
+  seg_object *bootstraps = bootstrap_roots(gc, &count);
+  for (uint64_t i = 0; i < count; i++) {
+    SEG_TRY(mark(m, bootstraps[i]));
+  }
+
+  for (uint64_t i = 0; i < gc->roots.count; i++) {
+    SEG_TRY(mark(m, *(seg_object *) gc->roots.items[i]));
+  }
+
+  while (gc->gray.count > 0) {
+    seg_object_common *o = gc->gray.items[--gc->gray.count];
+
+    SEG_TRY(mark(m, o->klass));
+
+    if (header_of(o)->kind == SEG_MEMORY_SLOTTED) {
+      seg_object_slotted *slotted = (seg_object_slotted *) o;
+      for (uint64_t i = 0; i < slotted->length; i++) {
+        SEG_TRY(mark(m, slotted->slots[i]));
+      }
+    }
+  }
+
+  return SEG_OK;
+}
+
+static bool symbol_is_live(seg_object symbol, void *state)
+{
+  return seg_ptrtable_get((seg_ptrtable *) state, symbol.pointer) != NULL;
+}
+
+static seg_err major(seg_gc *gc)
+{
+  seg_err err;
+  gc_marker m = { .gc = gc };
+
+  /* With the nursery empty, every object is old or pinned. */
+  SEG_TRY(minor(gc));
+
+  SEG_TRY(seg_new_ptrtable_keyed(
+    1024, 0, SEG_PTRTABLE_KEYS_IDENTITY, SEG_HASH_DEFAULT, &m.symbols
+  ));
+
+  err = mark_reachable(&m);
+
+  /* Free whatever wasn't marked, or, if marking failed, only clear the marks. */
+  gc_old_header *h = gc->old;
+  while (h != NULL) {
+    gc_old_header *next = h->next;
+
+    if (h->marked) {
+      h->marked = false;
+    } else if (err == SEG_OK) {
+      gc->stats.objects_reclaimed++;
+      gc->stats.bytes_reclaimed += h->size;
+      old_free(gc, h);
+    }
+
+    h = next;
+  }
+
+  if (err != SEG_OK) {
+    gc->gray.count = 0;
+    seg_delete_ptrtable(m.symbols);
+    return err;
+  }
+
+  uint64_t reclaimed;
+  seg_symboltable *table = seg_runtime_symboltable(gc->runtime);
+  err = seg_symboltable_sweep(table, &symbol_is_live, m.symbols, &reclaimed);
+  seg_delete_ptrtable(m.symbols);
+  SEG_TRY(err);
+
+  gc->stats.symbols_reclaimed += reclaimed;
+
+  gc->major_requested = false;
+  gc->major_threshold = gc->old_bytes * 2;
+  if (gc->major_threshold < GC_MAJOR_MINIMUM) {
+    gc->major_threshold = GC_MAJOR_MINIMUM;
+  }
+
+  return SEG_OK;
+}
+
+// COLLECTION //////////////////////////////////////////////////////////////////////////////////////
+
+seg_err seg_gc_collect(seg_gc *gc, seg_gc_kind kind)
+{
+  seg_err err;
+  uint64_t start = now_ns();
+
+  if (kind == SEG_GC_MAJOR) {
+    err = major(gc);
+  } else {
+    err = minor(gc);
+  }
+
+  uint64_t pause = now_ns() - start;
+  if (kind == SEG_GC_MAJOR) {
+    gc->stats.major_collections++;
+    gc->stats.major_pause_ns += pause;
+  } else {
+    gc->stats.minor_collections++;
+    gc->stats.minor_pause_ns += pause;
+  }
+  if (pause > gc->stats.max_pause_ns) {
+    gc->stats.max_pause_ns = pause;
+  }
+
+  return err;
+}
+
+seg_err seg_gc_safepoint(seg_gc *gc)
+{
+  if (gc->major_requested) {
+    return seg_gc_collect(gc, SEG_GC_MAJOR);
+  }
+
+  /*
+   * Empty the nursery before it's full, so that objects allocated before the next safepoint are
+   * unlikely to overflow it into the old generation.
+   */
+  if (gc->minor_requested || seg_nursery_used(&gc->nursery) >= GC_MINOR_THRESHOLD) {
+    return seg_gc_collect(gc, SEG_GC_MINOR);
+  }
+  return SEG_OK;
+}
+
+void seg_gc_statistics(seg_gc *gc, seg_gc_stats *out)
+{
+  *out = gc->stats;
+  out->young_capacity = seg_nursery_bytes(&gc->nursery);
+  out->young_bytes = seg_nursery_used(&gc->nursery);
+  out->old_objects = gc->old_objects;
+  out->old_bytes = gc->old_bytes;
+}
+
+void _seg_gc_young_tally(seg_gc *gc, seg_memory_kind kind, seg_memory_tally *out)
+{
+  out->count = atomic_load_explicit(&gc->young_allocations[kind], memory_order_relaxed);
+  out->bytes = atomic_load_explicit(&gc->young_bytes[kind], memory_order_relaxed);
+}
+
+uint64_t _seg_gc_overhead(seg_gc *gc)
+{
+  uint64_t stacks = gc->roots.capacity + gc->remembered.capacity + gc->gray.capacity;
+
+  return sizeof(seg_gc) + sizeof(void *) * stacks + sizeof(gc_old_header) * gc->old_objects;
+}
+
+void seg_delete_gc(seg_gc *gc)
+{
+  gc_old_header *h = gc->old;
+  while (h != NULL) {
+    gc_old_header *next = h->next;
+    free(h);
+    h = next;
+  }
+
+  seg_nursery_free(&gc->nursery);
+  free(gc->roots.items);
+  free(gc->remembered.items);
+  free(gc->gray.items);
+  free(gc);
+}
@@ -0,0 +1,177 @@
+#ifndef GC_H
+#define GC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "errors.h"
+#include "model/object.h"
+#include "runtime/runtime.h"
+
+/*
+ * A generational garbage collector. Objects are allocated young, in the nursery. A minor
+ * collection copies the young objects that are still reachable into the old generation and empties
+ * the nursery; a major collection also frees the old objects, and the weak symbols, that are no
+ * longer reachable.
+ *
+ * Collections only happen when they're asked for: by seg_gc_collect(), or by seg_gc_safepoint()
+ * once allocation has half filled the nursery or grown the old generation enough. Allocation never
+ * collects, so C code may hold objects in locals freely between safepoints. At a safepoint, every
+ * object must be reachable from a root: the runtime's bootstrap objects, the locations registered
+ * with seg_gc_push_root() by interpreter frames, or, for symbols, the symbol table.
+ *
+ * Classes are allocated directly in the old generation, so an object's class is never moved. Old
+ * objects aren't moved either. Only young objects are, and a minor collection rewrites every root
+ * and every reference from the old generation that points to one. To find those references without
+ * scanning the whole old generation, every store of an object into a slot must pass through the
+ * write barrier: seg_slot_atput() does, and code that writes slots in bulk calls
+ * seg_gc_write_barrier_bulk() afterward.
+ *
+ * Only the thread that owns the runtime may allocate young or old objects, or collect. Pinned
+ * objects may be allocated and released from any thread.
+ */
+typedef struct seg_gc seg_gc;
+
+typedef enum {
+  /* Promote every reachable young object into the old generation, then empty the nursery. */
+  SEG_GC_MINOR,
+
+  /* Perform a minor collection, then free unreachable old objects and weak symbols. */
+  SEG_GC_MAJOR
+} seg_gc_kind;
+
+/*
+ * Counters describing a collector's work so far, and the current size of its heap.
+ */
+typedef struct {
+  uint64_t minor_collections;
+  uint64_t major_collections;
+
+  /* Nanoseconds spent in each kind of collection, and in the longest single one. */
+  uint64_t minor_pause_ns;
+  uint64_t major_pause_ns;
+  uint64_t max_pause_ns;
+
+  /* Old objects scanned by minor collections because the write barrier remembered them. */
+  uint64_t remembered_objects;
+
+  /* Bytes copied from the nursery into the old generation. */
+  uint64_t bytes_promoted;
+
+  /* Old objects and weak symbols freed by major collections, and their bytes. */
+  uint64_t objects_reclaimed;
+  uint64_t bytes_reclaimed;
+  uint64_t symbols_reclaimed;
+
+  /* The size of the nursery, and the bytes allocated from it since it was last emptied. */
+  uint64_t young_capacity;
+  uint64_t young_bytes;
+
+  /* Objects in the old generation and their bytes, including any garbage not yet collected. */
+  uint64_t old_objects;
+  uint64_t old_bytes;
+} seg_gc_stats;
+
+/*
+ * Create the collector for a runtime, before anything allocates from it. `roots` is updated in
+ * place when a collection moves a bootstrap object; it may be populated after the collector exists.
+ *
+ * SEG_NOMEM: If the collector can't be allocated.
+ */
+seg_err seg_new_gc(seg_runtime *runtime, seg_bootstrap_objects *roots, seg_gc **out);
+
+/*
+ * Allocate an object for seg_runtime_allocate(). Young objects that don't fit in the nursery are
+ * placed in the old generation, and a minor collection is requested.
+ *
+ * SEG_NOMEM: If the allocation fails.
+ */
+seg_err seg_gc_allocate(
+  seg_gc *gc,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  size_t size,
+  void **out
+);
+
+/*
+ * Release an object for seg_runtime_release().
+ */
+void seg_gc_release(
+  seg_gc *gc,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  void *object,
+  size_t size
+);
+
+/*
+ * Register a location that holds an object, such as a local variable in an interpreter frame, as a
+ * root. The collector keeps the object alive and updates the location when the object is moved.
+ * Roots are a stack: release them in the reverse order with seg_gc_pop_roots().
+ *
+ * SEG_NOMEM: If the root stack can't grow.
+ */
+seg_err seg_gc_push_root(seg_gc *gc, seg_object *root);
+
+/*
+ * Unregister the `count` most recently registered roots.
+ */
+void seg_gc_pop_roots(seg_gc *gc, uint64_t count);
+
+/*
+ * Record that `value` has been, or is about to be, stored into a slot of `object`. If that makes an
+ * old object refer to a young one, the next minor collection scans the old object's slots.
+ *
+ * SEG_NOMEM: If the remembered set can't grow. The store must not be made.
+ */
+seg_err seg_gc_write_barrier(seg_gc *gc, seg_object object, seg_object value);
+
+/*
+ * Record that any of the slots of `object` may have been written, as by copying them all at once.
+ *
+ * SEG_NOMEM: As for seg_gc_write_barrier().
+ */
+seg_err seg_gc_write_barrier_bulk(seg_gc *gc, seg_object object);
+
+/*
+ * Collect garbage now.
+ *
+ * SEG_NOMEM: If a surviving young object can't be promoted, or if a major collection can't allocate
+ *   its mark stack. A failed minor collection may have moved some objects but not updated every
+ *   reference to them, so the runtime must only be deleted afterwards.
+ */
+seg_err seg_gc_collect(seg_gc *gc, seg_gc_kind kind);
+
+/*
+ * Collect garbage if the nursery is half full, or if allocation has requested a collection since
+ * the last one. Interpreters should call this regularly, at points where every live object is
+ * reachable from a root.
+ *
+ * SEG_NOMEM: As for seg_gc_collect().
+ */
+seg_err seg_gc_safepoint(seg_gc *gc);
+
+/*
+ * Report the collector's work so far and the current size of its heap.
+ */
+void seg_gc_statistics(seg_gc *gc, seg_gc_stats *out);
+
+/*
+ * Report the live young objects of a kind of memory and their bytes, for seg_runtime_memory().
+ */
+void _seg_gc_young_tally(seg_gc *gc, seg_memory_kind kind, seg_memory_tally *out);
+
+/*
+ * Return the bytes held by the collector's own bookkeeping, not counting any objects.
+ */
+uint64_t _seg_gc_overhead(seg_gc *gc);
+
+/*
+ * Free every object in the nursery and the old generation, and the collector itself. Pinned
+ * objects must be released by their owners first.
+ */
+void seg_delete_gc(seg_gc *gc);
+
+#endif
@@ -0,0 +1,53 @@
+#include <stdlib.h>
+
+#include "runtime/nursery.h"
+
+_Static_assert(
+  SEG_NURSERY_SIZE % SEG_NURSERY_ALIGN == 0,
+  "The nursery must end on an aligned boundary."
+);
+
+void seg_nursery_init(seg_nursery *n)
+{
+  n->top = NULL;
+  n->limit = NULL;
+  n->base = NULL;
+}
+
+void *seg_nursery_refill(seg_nursery *n, size_t size)
+{
+  if (n->base != NULL) {
+    return NULL;
+  }
+
+  /* malloc() aligns its allocations at least as strictly as the nursery does. */
+  n->base = malloc(SEG_NURSERY_SIZE);
+  if (n->base == NULL) {
+    return NULL;
+  }
+
+  n->top = n->base + size;
+  n->limit = n->base + SEG_NURSERY_SIZE;
+  return n->base;
+}
+
+uint64_t seg_nursery_used(const seg_nursery *n)
+{
+  return (uint64_t) (n->top - n->base);
+}
+
+uint64_t seg_nursery_bytes(const seg_nursery *n)
+{
+  return n->base == NULL ? 0 : SEG_NURSERY_SIZE;
+}
+
+void seg_nursery_reset(seg_nursery *n)
+{
+  n->top = n->base;
+}
+
+void seg_nursery_free(seg_nursery *n)
+{
+  free(n->base);
+  seg_nursery_init(n);
+}
@@ -0,0 +1,97 @@
+#ifndef NURSERY_H
+#define NURSERY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * The young generation: one contiguous region that objects are carved from by bumping a pointer,
+ * so that allocating one costs a comparison and an addition rather than a call into malloc.
+ * Individual objects are never freed. Once the collector has moved every surviving object out, the
+ * whole region is reset at once.
+ *
+ * A nursery isn't thread-safe. Only the thread that owns it may allocate from it.
+ */
+
+/* Bytes in the region that objects are carved from. */
+#define SEG_NURSERY_SIZE ((size_t) 4 * 1024 * 1024)
+
+/*
+ * Objects larger than this aren't worth copying out of the nursery when they survive. Callers
+ * should allocate them in the old generation instead.
+ */
+#define SEG_NURSERY_MAX_OBJECT ((size_t) 16 * 1024)
+
+/*
+ * Alignment of every allocation: enough for any field of an object, and enough to keep the
+ * immediate tag bit clear in a pointer to one.
+ */
+#define SEG_NURSERY_ALIGN ((size_t) 8)
+
+typedef struct {
+  /* The next free byte, and the end of the region. */
+  char *top;
+  char *limit;
+
+  /* The start of the region, or NULL before the first object is allocated. */
+  char *base;
+} seg_nursery;
+
+/*
+ * Initialize an empty nursery. Its region is allocated along with its first object.
+ */
+void seg_nursery_init(seg_nursery *n);
+
+/*
+ * Allocate `size` bytes, already aligned, when they don't fit after `top`. Returns NULL if the
+ * region can't be allocated, or if it's full. Use seg_nursery_allocate() instead.
+ */
+void *seg_nursery_refill(seg_nursery *n, size_t size);
+
+/*
+ * Allocate `size` bytes, which must be no more than SEG_NURSERY_MAX_OBJECT. Returns NULL if the
+ * nursery is full and must be collected.
+ */
+static inline void *seg_nursery_allocate(seg_nursery *n, size_t size)
+{
+  size = (size + SEG_NURSERY_ALIGN - 1) & ~(SEG_NURSERY_ALIGN - 1);
+
+  if ((uintptr_t) n->limit - (uintptr_t) n->top < size) {
+    return seg_nursery_refill(n, size);
+  }
+
+  void *p = n->top;
+  n->top += size;
+  return p;
+}
+
+/*
+ * Return true if `p` points into the nursery.
+ */
+static inline bool seg_nursery_contains(const seg_nursery *n, const void *p)
+{
+  return (uintptr_t) p - (uintptr_t) n->base < (uintptr_t) n->limit - (uintptr_t) n->base;
+}
+
+/*
+ * Return the number of bytes allocated since the nursery was last reset.
+ */
+uint64_t seg_nursery_used(const seg_nursery *n);
+
+/*
+ * Return the number of bytes held in the nursery's region.
+ */
+uint64_t seg_nursery_bytes(const seg_nursery *n);
+
+/*
+ * Discard every object in the nursery, so that its region can be allocated from again.
+ */
+void seg_nursery_reset(seg_nursery *n);
+
+/*
+ * Release the nursery's region, and every object within it.
+ */
+void seg_nursery_free(seg_nursery *n);
+
+#endif
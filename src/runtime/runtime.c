@@ -1,11 +1,19 @@
 #include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
 
 #include "runtime/runtime.h"
+#include "runtime/gc.h"
 #include "model/object.h"
 
 struct seg_runtime {
   seg_symboltable *symboltable;
   seg_bootstrap_objects bootstrap;
+  seg_gc *gc;
+
+  /* Live allocations and their bytes, by seg_memory_kind. Updated from any thread. */
+  _Atomic uint64_t allocations[SEG_MEMORY_KINDS];
+  _Atomic uint64_t allocated_bytes[SEG_MEMORY_KINDS];
 };
 
 seg_err seg_new_runtime(seg_runtime **out)
@@ -17,6 +25,18 @@ seg_err seg_new_runtime(seg_runtime **out)
     return SEG_NOMEM("Unable to allocate runtime.");
   }
 
+  /* The symbol table allocates symbols as it's created, so the heap must be ready first. */
+  for (int k = 0; k < SEG_MEMORY_KINDS; k++) {
+    atomic_init(&r->allocations[k], 0);
+    atomic_init(&r->allocated_bytes[k], 0);
+  }
+  memset(&r->bootstrap, 0, sizeof(seg_bootstrap_objects));
+
+  err = seg_new_gc(r, &r->bootstrap, &r->gc);
+  if (err != SEG_OK) {
+    return err;
+  }
+
   /* Initialize the symbol table. */
   err = seg_new_symboltable(r, &r->symboltable);
   if (err != SEG_OK) {
@@ -43,8 +63,93 @@ const seg_bootstrap_objects *seg_runtime_bootstraps(seg_runtime *runtime)
   return &(runtime->bootstrap);
 }
 
+seg_gc *seg_runtime_gc(seg_runtime *runtime)
+{
+  return runtime->gc;
+}
+
+static void tally(seg_runtime *runtime, seg_memory_kind kind, seg_memory_tally *out)
+{
+  seg_memory_tally young;
+  _seg_gc_young_tally(runtime->gc, kind, &young);
+
+  out->count = atomic_load_explicit(&runtime->allocations[kind], memory_order_relaxed) +
+    young.count;
+  out->bytes = atomic_load_explicit(&runtime->allocated_bytes[kind], memory_order_relaxed) +
+    young.bytes;
+}
+
+void seg_runtime_memory(seg_runtime *runtime, seg_memory_usage *out)
+{
+  seg_hashtable_stats stats;
+
+  out->runtime.count = 1;
+  out->runtime.bytes = sizeof(struct seg_runtime) + _seg_gc_overhead(runtime->gc);
+
+  seg_symboltable_stats(runtime->symboltable, &stats);
+  out->symboltable.count = stats.count;
+  out->symboltable.bytes = stats.bytes;
+
+  out->images.count = seg_symboltable_image_count(runtime->symboltable);
+  out->images.bytes = seg_symboltable_image_bytes(runtime->symboltable);
+
+  tally(runtime, SEG_MEMORY_BUFFERS, &out->buffers);
+  tally(runtime, SEG_MEMORY_SLOTTED, &out->slotted);
+  tally(runtime, SEG_MEMORY_AST, &out->ast);
+
+  seg_gc_stats gc_stats;
+  seg_gc_statistics(runtime->gc, &gc_stats);
+  out->nursery.count = gc_stats.young_capacity > 0 ? 1 : 0;
+  out->nursery.bytes = gc_stats.young_capacity;
+  tally(runtime, SEG_MEMORY_DIRECT, &out->direct);
+
+  out->total_bytes = out->runtime.bytes + out->symboltable.bytes + out->images.bytes +
+    out->nursery.bytes + out->direct.bytes + out->ast.bytes;
+}
+
+seg_err seg_runtime_allocate(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  size_t size,
+  void **out
+) {
+  return seg_gc_allocate(runtime->gc, kind, placement, size, out);
+}
+
+void seg_runtime_release(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  void *object,
+  size_t size
+) {
+  seg_gc_release(runtime->gc, kind, placement, object, size);
+}
+
+void _seg_runtime_allocated(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  uint64_t count,
+  uint64_t bytes
+) {
+  atomic_fetch_add_explicit(&runtime->allocations[kind], count, memory_order_relaxed);
+  atomic_fetch_add_explicit(&runtime->allocated_bytes[kind], bytes, memory_order_relaxed);
+}
+
+void _seg_runtime_released(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  uint64_t count,
+  uint64_t bytes
+) {
+  atomic_fetch_sub_explicit(&runtime->allocations[kind], count, memory_order_relaxed);
+  atomic_fetch_sub_explicit(&runtime->allocated_bytes[kind], bytes, memory_order_relaxed);
+}
+
 void seg_delete_runtime(seg_runtime *runtime)
 {
   seg_delete_symboltable(runtime->symboltable);
+  seg_delete_gc(runtime->gc);
   free(runtime);
 }
@@ -11,6 +11,10 @@
 struct seg_runtime;
 typedef struct seg_runtime seg_runtime;
 
+/* Forward declaration of the collector, which a runtime owns. See gc.h. */
+struct seg_gc;
+typedef struct seg_gc seg_gc;
+
 /*
  * Special objects instantiated runtime initialization that used often enough by the interpreter
  * to justify special access.
@@ -32,6 +36,80 @@ struct seg_bootstrap_objects {
 };
 typedef struct seg_bootstrap_objects seg_bootstrap_objects;
 
+/*
+ * Kinds of memory that a runtime's subsystems allocate on its behalf, and report to it as they go.
+ */
+typedef enum {
+  SEG_MEMORY_BUFFERS,
+  SEG_MEMORY_SLOTTED,
+  SEG_MEMORY_AST,
+
+  /* Old and pinned objects, allocated individually rather than in the nursery. */
+  SEG_MEMORY_DIRECT,
+
+  SEG_MEMORY_KINDS
+} seg_memory_kind;
+
+/*
+ * Where seg_runtime_allocate() places an object.
+ */
+typedef enum {
+  /*
+   * In the nursery, by bumping a pointer, unless the object is too large or the nursery is full.
+   * Young objects that survive a minor collection are moved into the old generation.
+   */
+  SEG_ALLOC_YOUNG,
+
+  /* Directly in the old generation, for objects expected to live long, such as classes. */
+  SEG_ALLOC_OLD,
+
+  /*
+   * Individually, with malloc, so that the object can be freed on its own with
+   * seg_runtime_release(). For objects that are discarded one by one, such as interned symbols.
+   */
+  SEG_ALLOC_PINNED
+} seg_alloc_placement;
+
+/*
+ * A number of live allocations, and the bytes requested for them. Allocator overhead per
+ * allocation isn't included.
+ */
+typedef struct {
+  uint64_t count;
+  uint64_t bytes;
+} seg_memory_tally;
+
+/*
+ * A snapshot of the memory that a runtime is holding, by subsystem.
+ */
+typedef struct {
+  /* The runtime structure itself. */
+  seg_memory_tally runtime;
+
+  /* Symbol table indexes, ID registry and lookaside tables, counting the table's symbols. */
+  seg_memory_tally symboltable;
+
+  /* Symbol images mapped by the symbol table, counting their symbols. */
+  seg_memory_tally images;
+
+  /* Live heap objects, wherever they're allocated: strings and symbols, and slotted instances. */
+  seg_memory_tally buffers;
+  seg_memory_tally slotted;
+
+  /* Where heap objects live: the nursery, and objects allocated individually. */
+  seg_memory_tally nursery;
+  seg_memory_tally direct;
+
+  /* Parsed programs, counting their nodes. */
+  seg_memory_tally ast;
+
+  /*
+   * Bytes held by the runtime, its symbol table and images, the nursery, individually allocated
+   * objects and parsed programs. Buffers and slotted instances are counted where they live.
+   */
+  uint64_t total_bytes;
+} seg_memory_usage;
+
 /*
  * Initialize the runtime, bootstrapping it with initial objects such as the Class class.
  */
@@ -47,6 +125,64 @@ seg_symboltable *seg_runtime_symboltable(seg_runtime *runtime);
  */
 const seg_bootstrap_objects *seg_runtime_bootstraps(seg_runtime *runtime);
 
+/*
+ * Access the garbage collector that manages a runtime's heap.
+ */
+seg_gc *seg_runtime_gc(seg_runtime *runtime);
+
+/*
+ * Allocate `size` bytes for a heap object of a kind of memory. Every object is aligned to at least
+ * eight bytes, so the tag bit of a seg_object that points to it is clear. Young and old objects may
+ * only be allocated by the thread that runs the interpreter; pinned objects may be allocated and
+ * released from any thread. Allocating never collects garbage, but the collector traces slotted
+ * objects, so they must be initialized before the next safepoint.
+ *
+ * SEG_NOMEM: If the allocation fails.
+ */
+seg_err seg_runtime_allocate(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  size_t size,
+  void **out
+);
+
+/*
+ * Release an object before the collector finds it unreachable, when nothing else can refer to it.
+ * Pinned and old objects are freed; objects in the nursery are only uncounted, because their memory
+ * is reclaimed when the nursery is emptied.
+ */
+void seg_runtime_release(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  seg_alloc_placement placement,
+  void *object,
+  size_t size
+);
+
+/*
+ * Take a snapshot of the memory held by each of a runtime's subsystems. The snapshot may be taken
+ * while other threads allocate, but then it isn't atomic across subsystems.
+ */
+void seg_runtime_memory(seg_runtime *runtime, seg_memory_usage *out);
+
+/*
+ * Record that `count` allocations totalling `bytes` of a kind of memory have been made or released
+ * on a runtime's behalf. Only the subsystems that allocate that memory should call these.
+ */
+void _seg_runtime_allocated(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  uint64_t count,
+  uint64_t bytes
+);
+void _seg_runtime_released(
+  seg_runtime *runtime,
+  seg_memory_kind kind,
+  uint64_t count,
+  uint64_t bytes
+);
+
 /*
  * Dispose of a runtime acquired from seg_new_runtime().
  */
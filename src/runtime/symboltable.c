@@ -1,14 +1,535 @@
+/* pthread_rwlock_t is POSIX, not C11. */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
-#include "ds/stringtable.h"
+#include "ds/hash.h"
+#include "ds/ptrtable.h"
 #include "runtime/symboltable.h"
+#include "runtime/wellknown_table.h"
+
+/*
+ * Non-immediate symbols are stored in an open-addressed, linearly probed index whose slots are
+ * only ever filled, never cleared. That lets lookups proceed without taking any locks: a reader
+ * acquires the current index, probes it, and compares symbol names directly.
+ *
+ * Inserting threads claim an empty slot with a compare-and-swap. Two threads racing to intern the
+ * same name walk the same probe sequence, so whichever loses the CAS finds the winner's symbol in
+ * that slot and adopts it. Each name therefore has exactly one canonical symbol.
+ *
+ * A slot's hashcode is written after its symbol is published. Readers treat a zero hashcode as
+ * "not yet known" and fall back to comparing the name.
+ *
+ * Inserters share `resize_lock`; growing the index takes it exclusively, copies every symbol into
+ * a larger index and publishes that. Readers are never blocked. They may still be probing a
+ * replaced index, which is complete as of the moment it was replaced, so replaced indexes are
+ * retired rather than freed until the table itself is deleted. Their total size is bounded by the
+ * size of the final index.
+ *
+ * Lookup counters are shared by every thread, so updating them on each lookup would serialize
+ * otherwise independent readers. They're only maintained when SEG_SYMTABLE_STATS is set.
+ *
+ * The symbols listed in wellknown.def are allocated when the table is created and never enter the
+ * index. Their names are checked first, through a perfect hash generated at build time that only
+ * reads a few bytes of each name, so interning one never computes a full hash or probes the index.
+ *
+ * Each symbol is numbered with an ID that's reserved before the symbol competes to be published
+ * and recorded in the symbol itself, so the ID is visible wherever the symbol is. A candidate that
+ * loses the race abandons its ID. IDs map back to symbols through a registry of chunks that double
+ * in size, which grows without moving entries and so without blocking readers. Immediate symbols
+ * aren't allocated or indexed, so they're only numbered when their ID is first asked for, through
+ * a ptrtable guarded by `immediate_lock`.
+ *
+ * Symbols minted from runtime data are interned weakly, and every other symbol is permanent. Each
+ * slot records the lifetime of its symbol once it's published. Interning a weak symbol's name
+ * permanently promotes it, under `resize_lock` so that the promotion can't be lost by a concurrent
+ * resize. A sweep takes the lock exclusively and rebuilds the index without the weak symbols that
+ * the collector found unreachable. Sweeps free the symbols they reclaim, along with the indexes
+ * that earlier resizes retired, so they may only run while no other thread is using the table.
+ *
+ * A symbol image is a file holding permanent symbols that are mapped in, rather than interned one
+ * at a time, when a table is created. It contains a header, a linearly probed index of slots that
+ * each pair a hashcode with the file offset of a symbol, and an arena of symbols laid out by
+ * seg_symbol_write. Nothing in it is a pointer, so it may be mapped at any address. Loading it
+ * gives each symbol its class and ID, then makes the mapping read-only. The table adopts the
+ * image's hash algorithm and seed, so a name is hashed once to probe both the image and the index,
+ * and symbols that the image lacks overflow into the index as usual.
+ */
+
+#define SYM_IMAGE_MAGIC "SEGSYMS"
+#define SYM_IMAGE_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t hash;
+  uint32_t seed;
+  uint32_t pointer_size;
+  uint64_t file_length;
+  uint64_t symbol_count;
+  uint64_t slot_count;
+  uint64_t slots_offset;
+  uint64_t arena_offset;
+} sym_image_header;
+
+typedef struct {
+  uint32_t hashcode;
+  /* File offset of the symbol, or zero if the slot is empty. */
+  uint32_t offset;
+} sym_image_slot;
+
+typedef struct {
+  char *mapping;
+  size_t mapping_length;
+  uint64_t symbol_count;
+  uint64_t slot_count;
+  const sym_image_slot *slots;
+} sym_image;
+
+/* IDs held by the first registry chunk. Chunk `k` holds SYM_CHUNK_BASE * 2^k IDs. */
+#define SYM_CHUNK_BASE 64
+
+/* Enough chunks to hold every 32-bit ID. */
+#define SYM_CHUNKS 27
+
+typedef _Atomic(seg_object_common *) sym_id_entry;
+
+typedef enum {
+  /* The symbol has been published, but its publisher hasn't recorded its lifetime yet. */
+  SYM_PUBLISHING = 0,
+  SYM_WEAK,
+  SYM_PERMANENT
+} sym_lifetime;
+
+typedef struct {
+  _Atomic(seg_object_common *) symbol;
+  _Atomic uint32_t hashcode;
+  _Atomic uint32_t lifetime;
+} sym_slot;
+
+typedef struct sym_index {
+  uint64_t slot_count;
+  struct sym_index *retired_next;
+  sym_slot slots[];
+} sym_index;
 
 struct seg_symboltable {
   seg_runtime *runtime;
-  seg_stringtable *storage;
+  uint32_t seed;
+  seg_hash_algorithm hash;
+  seg_hashtable_settings settings;
+
+  _Atomic(sym_index *) index;
+  _Atomic uint64_t count;
+
+  pthread_rwlock_t resize_lock;
+  sym_index *retired;
+
+  /* Read-only once the table has been created. */
+  seg_object_common *wellknown[SEG_WELLKNOWN_COUNT];
+
+  /* Read-only once loaded, or NULL if no image has been loaded. */
+  sym_image *image;
+
+  _Atomic uint64_t next_id;
+  _Atomic(sym_id_entry *) id_chunks[SYM_CHUNKS];
+
+  pthread_mutex_t immediate_lock;
+  /* Maps immediate symbols to one more than their IDs. Created when it's first needed. */
+  seg_ptrtable *immediate_ids;
+
+  bool track_lookups;
+  _Atomic uint64_t hits;
+  _Atomic uint64_t hit_probes;
+  _Atomic uint64_t misses;
+  _Atomic uint64_t miss_probes;
+
+  /* Weak symbols, counted before they're published. */
+  _Atomic uint64_t weak_count;
+
+  /* Guarded by `resize_lock`. */
+  uint64_t resizes;
+  uint64_t resize_ns;
+  uint64_t reclaimed;
+  uint64_t sweeps;
 };
 
+/* Internal utility methods. */
+
+#define SEG_WELLKNOWN(ID, NAME) NAME,
+static const char *sym_wellknown_names[SEG_WELLKNOWN_COUNT] = {
+#include "runtime/wellknown.def"
+};
+#undef SEG_WELLKNOWN
+
+#define SEG_WELLKNOWN(ID, NAME) sizeof(NAME) - 1,
+static const uint64_t sym_wellknown_lengths[SEG_WELLKNOWN_COUNT] = {
+#include "runtime/wellknown.def"
+};
+#undef SEG_WELLKNOWN
+
+/*
+ * Find the registry chunk that holds `id`, and its position within that chunk.
+ */
+static void sym_id_locate(uint32_t id, unsigned *chunk, uint64_t *offset)
+{
+  uint64_t n = (uint64_t) id / SYM_CHUNK_BASE + 1;
+  unsigned k = 63 - (unsigned) __builtin_clzll(n);
+
+  *chunk = k;
+  *offset = (uint64_t) id - SYM_CHUNK_BASE * ((1ull << k) - 1);
+}
+
+/*
+ * Claim the next unused ID, allocating the registry chunk that will hold it if necessary.
+ *
+ * SEG_NOMEM: If the chunk can't be allocated.
+ * SEG_RANGE: If every 32-bit ID has been used.
+ */
+static seg_err sym_id_reserve(seg_symboltable *table, uint32_t *out)
+{
+  uint64_t id = atomic_fetch_add_explicit(&table->next_id, 1, memory_order_relaxed);
+  if (id >= SEG_NO_SYMBOL_ID) {
+    return SEG_RANGE("Every symbol ID has been assigned.");
+  }
+
+  unsigned k;
+  uint64_t offset;
+  sym_id_locate((uint32_t) id, &k, &offset);
+
+  if (atomic_load_explicit(&table->id_chunks[k], memory_order_acquire) == NULL) {
+    uint64_t length = (uint64_t) SYM_CHUNK_BASE << k;
+    sym_id_entry *chunk = malloc(sizeof(sym_id_entry) * length);
+    if (chunk == NULL) {
+      return SEG_NOMEM("Unable to allocate symbol IDs.");
+    }
+
+    for (uint64_t i = 0; i < length; i++) {
+      atomic_init(&chunk[i], NULL);
+    }
+
+    sym_id_entry *expected = NULL;
+    if (! atomic_compare_exchange_strong_explicit(
+      &table->id_chunks[k], &expected, chunk, memory_order_acq_rel, memory_order_acquire
+    )) {
+      /* Another thread allocated this chunk first. */
+      free(chunk);
+    }
+  }
+
+  *out = (uint32_t) id;
+  return SEG_OK;
+}
+
+/*
+ * Record the symbol that a reserved ID belongs to.
+ */
+static void sym_id_publish(seg_symboltable *table, uint32_t id, seg_object_common *symbol)
+{
+  unsigned k;
+  uint64_t offset;
+  sym_id_locate(id, &k, &offset);
+
+  sym_id_entry *chunk = atomic_load_explicit(&table->id_chunks[k], memory_order_acquire);
+  atomic_store_explicit(&chunk[offset], symbol, memory_order_release);
+}
+
+/*
+ * Return the preallocated symbol with the given name, or NULL if the name isn't well-known.
+ * `length` must be greater than SEG_STR_IMMLEN.
+ */
+static seg_object_common *sym_wellknown(
+  seg_symboltable *table,
+  const char *name,
+  uint64_t length
+) {
+  uint32_t h = seg_wellknown_hash(name, length, SEG_WELLKNOWN_MULTIPLIER, SEG_WELLKNOWN_SHIFT);
+  int8_t id = seg_wellknown_slots[h];
+
+  if (id < 0 || sym_wellknown_lengths[id] != length) {
+    return NULL;
+  }
+  if (memcmp(sym_wellknown_names[id], name, length) != 0) {
+    return NULL;
+  }
+
+  return table->wellknown[id];
+}
+
+static seg_err sym_index_new(uint64_t capacity, sym_index **out)
+{
+  uint64_t slot_count = 16;
+  while (slot_count < capacity) {
+    slot_count <<= 1;
+  }
+
+  sym_index *index = malloc(sizeof(sym_index) + sizeof(sym_slot) * slot_count);
+  if (index == NULL) {
+    return SEG_NOMEM("Unable to allocate symboltable index.");
+  }
+
+  index->slot_count = slot_count;
+  index->retired_next = NULL;
+  for (uint64_t i = 0; i < slot_count; i++) {
+    atomic_init(&index->slots[i].symbol, NULL);
+    atomic_init(&index->slots[i].hashcode, 0);
+    atomic_init(&index->slots[i].lifetime, SYM_PUBLISHING);
+  }
+
+  *out = index;
+  return SEG_OK;
+}
+
+/*
+ * Number of symbols an index may hold before it must grow. Linear probing needs at least one empty
+ * slot to terminate and degrades sharply as the index fills, so the configured load is clamped.
+ */
+static uint64_t sym_index_limit(seg_symboltable *table, sym_index *index)
+{
+  float max_load = table->settings.max_load;
+  if (max_load > 0.9f) {
+    max_load = 0.9f;
+  } else if (max_load < 0.1f) {
+    max_load = 0.1f;
+  }
+
+  return (uint64_t) (index->slot_count * max_load);
+}
+
+static bool sym_matches(seg_object_common *symbol, const char *name, uint64_t length)
+{
+  seg_object o = SEG_FROMPOINTER(symbol);
+  char *contents;
+  uint64_t contents_length;
+
+  seg_buffer_contents(&o, &contents, &contents_length);
+  return contents_length == length && ! memcmp(contents, name, length);
+}
+
+/*
+ * Probe `index` for the slot holding a symbol with the given name. Return NULL if there isn't one.
+ * Report the number of slots visited in `probes`.
+ */
+static sym_slot *sym_find(
+  sym_index *index,
+  uint32_t hashcode,
+  const char *name,
+  uint64_t length,
+  uint64_t *probes
+) {
+  uint64_t mask = index->slot_count - 1;
+  *probes = 0;
+
+  for (uint64_t i = hashcode & mask; ; i = (i + 1) & mask) {
+    sym_slot *slot = &(index->slots[i]);
+    seg_object_common *symbol = atomic_load_explicit(&slot->symbol, memory_order_acquire);
+    (*probes)++;
+
+    if (symbol == NULL) {
+      return NULL;
+    }
+
+    uint32_t slot_hashcode = atomic_load_explicit(&slot->hashcode, memory_order_acquire);
+    if ((slot_hashcode == 0 || slot_hashcode == hashcode) && sym_matches(symbol, name, length)) {
+      return slot;
+    }
+  }
+}
+
+/*
+ * Find a symbol's slot in the current index, and record the lookup if the table is tracking them.
+ */
+static sym_slot *sym_lookup(
+  seg_symboltable *table,
+  uint32_t hashcode,
+  const char *name,
+  uint64_t length
+) {
+  uint64_t probes;
+  sym_index *index = atomic_load_explicit(&table->index, memory_order_acquire);
+  sym_slot *slot = sym_find(index, hashcode, name, length, &probes);
+
+  if (table->track_lookups) {
+    if (slot != NULL) {
+      atomic_fetch_add_explicit(&table->hits, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&table->hit_probes, probes, memory_order_relaxed);
+    } else {
+      atomic_fetch_add_explicit(&table->misses, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&table->miss_probes, probes, memory_order_relaxed);
+    }
+  }
+
+  return slot;
+}
+
+/*
+ * Place `symbol` into the first empty slot along its probe sequence, or return the slot of an
+ * existing symbol with the same name if one is found first. The caller must hold `resize_lock` for
+ * reading and must already have reserved room for the symbol in the count.
+ */
+static sym_slot *sym_claim(
+  sym_index *index,
+  uint32_t hashcode,
+  const char *name,
+  uint64_t length,
+  seg_object_common *symbol
+) {
+  uint64_t mask = index->slot_count - 1;
+
+  for (uint64_t i = hashcode & mask; ; i = (i + 1) & mask) {
+    sym_slot *slot = &(index->slots[i]);
+    seg_object_common *existing = atomic_load_explicit(&slot->symbol, memory_order_acquire);
+
+    if (existing == NULL) {
+      if (atomic_compare_exchange_strong_explicit(
+        &slot->symbol, &existing, symbol, memory_order_acq_rel, memory_order_acquire
+      )) {
+        atomic_store_explicit(&slot->hashcode, hashcode, memory_order_release);
+        return slot;
+      }
+
+      /* Another thread claimed this slot first. `existing` now holds its symbol. */
+    }
+
+    uint32_t slot_hashcode = atomic_load_explicit(&slot->hashcode, memory_order_acquire);
+    if ((slot_hashcode == 0 || slot_hashcode == hashcode) && sym_matches(existing, name, length)) {
+      return slot;
+    }
+  }
+}
+
+/*
+ * Whether a symbol lives in the mapped symbol image, rather than having been allocated.
+ */
+static bool sym_image_contains(seg_symboltable *table, seg_object_common *symbol)
+{
+  sym_image *image = table->image;
+  char *at = (char *) symbol;
+
+  return image != NULL && at >= image->mapping && at < image->mapping + image->mapping_length;
+}
+
+/*
+ * Probe the symbol image for a symbol with the given name. Return NULL if there isn't one, or if
+ * there's no image.
+ */
+static seg_object_common *sym_image_find(
+  seg_symboltable *table,
+  uint32_t hashcode,
+  const char *name,
+  uint64_t length
+) {
+  sym_image *image = table->image;
+  if (image == NULL) {
+    return NULL;
+  }
+
+  uint64_t mask = image->slot_count - 1;
+  for (uint64_t i = hashcode & mask; ; i = (i + 1) & mask) {
+    const sym_image_slot *slot = &(image->slots[i]);
+
+    if (slot->offset == 0) {
+      return NULL;
+    }
+
+    seg_object_common *symbol = (seg_object_common *) (image->mapping + slot->offset);
+    if (slot->hashcode == hashcode && sym_matches(symbol, name, length)) {
+      return symbol;
+    }
+  }
+}
+
+/*
+ * Make the symbol in `slot` permanent, whether it's weak or still being published. The caller must
+ * hold `resize_lock` for reading.
+ */
+static void sym_promote(seg_symboltable *table, sym_slot *slot)
+{
+  uint32_t lifetime = atomic_load_explicit(&slot->lifetime, memory_order_acquire);
+
+  while (lifetime != SYM_PERMANENT) {
+    if (atomic_compare_exchange_weak_explicit(
+      &slot->lifetime, &lifetime, SYM_PERMANENT, memory_order_acq_rel, memory_order_acquire
+    )) {
+      if (lifetime == SYM_WEAK) {
+        atomic_fetch_sub_explicit(&table->weak_count, 1, memory_order_relaxed);
+      }
+      return;
+    }
+  }
+}
+
+/*
+ * Replace `seen` with an index that's `table_growth_factor` times larger, unless another thread
+ * has already done so. Must be called without holding `resize_lock`.
+ */
+static seg_err sym_grow(seg_symboltable *table, sym_index *seen)
+{
+  seg_err err = SEG_OK;
+
+  pthread_rwlock_wrlock(&table->resize_lock);
+
+  sym_index *current = atomic_load_explicit(&table->index, memory_order_relaxed);
+  if (current == seen) {
+    uint64_t start = seg_hashtable_clock_ns();
+    uint32_t factor = table->settings.table_growth_factor;
+    if (factor < 2) {
+      factor = 2;
+    }
+
+    sym_index *grown;
+    err = sym_index_new(current->slot_count * factor, &grown);
+    if (err == SEG_OK) {
+      /* No inserters are active, so every published slot's hashcode has been written. */
+      uint64_t mask = grown->slot_count - 1;
+
+      for (uint64_t i = 0; i < current->slot_count; i++) {
+        sym_slot *slot = &(current->slots[i]);
+        seg_object_common *symbol = atomic_load_explicit(&slot->symbol, memory_order_relaxed);
+        if (symbol == NULL) {
+          continue;
+        }
+
+        uint32_t hashcode = atomic_load_explicit(&slot->hashcode, memory_order_relaxed);
+        uint64_t j = hashcode & mask;
+        while (atomic_load_explicit(&grown->slots[j].symbol, memory_order_relaxed) != NULL) {
+          j = (j + 1) & mask;
+        }
+
+        atomic_store_explicit(&grown->slots[j].symbol, symbol, memory_order_relaxed);
+        atomic_store_explicit(&grown->slots[j].hashcode, hashcode, memory_order_relaxed);
+        atomic_store_explicit(
+          &grown->slots[j].lifetime,
+          atomic_load_explicit(&slot->lifetime, memory_order_relaxed),
+          memory_order_relaxed
+        );
+      }
+
+      atomic_store_explicit(&table->index, grown, memory_order_release);
+
+      current->retired_next = table->retired;
+      table->retired = current;
+      table->resizes++;
+    }
+
+    table->resize_ns += seg_hashtable_clock_ns() - start;
+  }
+
+  pthread_rwlock_unlock(&table->resize_lock);
+  return err;
+}
+
+/* Public API. */
+
 seg_err seg_new_symboltable(seg_runtime *r, seg_symboltable **out)
 {
   seg_err err;
@@ -24,13 +545,18 @@ seg_err seg_new_symboltable(seg_runtime *r, seg_symboltable **out)
   uint32_t bucket_growth_factor = SEG_SYMTABLE_BUCKET_GROWTH;
   float max_load = SEG_SYMTABLE_MAX_LOAD;
   uint32_t table_growth_factor = SEG_SYMTABLE_GROWTH;
+  seg_hash_algorithm hash = SEG_HASH_DEFAULT;
 
   const char *capacity_str = getenv("SEG_SYMTABLE_INIT_CAP");
   if (capacity_str != NULL) {
     capacity = strtoul(capacity_str, &end, 10);
   }
 
-  const char *bucketcap_str = getenv("SEG_SYMTABLE_GROWTH");
+  if (capacity == 0) {
+    capacity = 1;
+  }
+
+  const char *bucketcap_str = getenv("SEG_SYMTABLE_BUCKET_CAP");
   if (bucketcap_str != NULL) {
     init_bucket_capacity = (uint32_t) strtoul(bucketcap_str, &end, 10);
   }
@@ -50,27 +576,113 @@ seg_err seg_new_symboltable(seg_runtime *r, seg_symboltable **out)
     table_growth_factor = (uint32_t) strtoul(growth_str, &end, 10);
   }
 
-  seg_stringtable *storage;
-  err = seg_new_stringtable(capacity, &storage);
+  const char *stats_str = getenv("SEG_SYMTABLE_STATS");
+  bool track_lookups = stats_str != NULL && *stats_str != '\0' && strcmp(stats_str, "0") != 0;
+
+  const char *hash_str = getenv("SEG_SYMTABLE_HASH");
+  if (hash_str != NULL && ! seg_hash_parse(hash_str, &hash)) {
+    free(table);
+    return SEG_INVAL("SEG_SYMTABLE_HASH must be one of murmur3, wide or crc32c.");
+  }
+
+  sym_index *index;
+  err = sym_index_new(capacity, &index);
   if (err != SEG_OK) {
+    free(table);
     return err;
   }
 
-  seg_hashtable_settings *settings = seg_stringtable_get_settings(storage);
-  settings->init_bucket_capacity = init_bucket_capacity;
-  settings->bucket_growth_factor = bucket_growth_factor;
-  settings->max_load = max_load;
-  settings->table_growth_factor = table_growth_factor;
+  if (pthread_rwlock_init(&table->resize_lock, NULL) != 0) {
+    free(index);
+    free(table);
+    return SEG_NOMEM("Unable to initialize symboltable lock.");
+  }
+
+  if (pthread_mutex_init(&table->immediate_lock, NULL) != 0) {
+    pthread_rwlock_destroy(&table->resize_lock);
+    free(index);
+    free(table);
+    return SEG_NOMEM("Unable to initialize symboltable lock.");
+  }
 
+  atomic_init(&table->next_id, 0);
+  for (int k = 0; k < SYM_CHUNKS; k++) {
+    atomic_init(&table->id_chunks[k], NULL);
+  }
+  table->immediate_ids = NULL;
+  table->image = NULL;
+
+  /* Well-known symbols are numbered first, so each one's seg_wellknown_id is also its ID. */
   table->runtime = r;
-  table->storage = storage;
+  for (int i = 0; i < SEG_WELLKNOWN_COUNT; i++) {
+    seg_object symbol;
+    uint32_t id;
+
+    err = seg_symbol(r, sym_wellknown_names[i], sym_wellknown_lengths[i], &symbol);
+    if (err == SEG_OK) {
+      err = sym_id_reserve(table, &id);
+      if (err != SEG_OK) {
+        seg_delete_symbol(r, symbol);
+      }
+    }
+
+    if (err != SEG_OK) {
+      for (int j = 0; j < i; j++) {
+        seg_object o = SEG_FROMPOINTER(table->wellknown[j]);
+        seg_delete_symbol(r, o);
+      }
+      free(atomic_load_explicit(&table->id_chunks[0], memory_order_relaxed));
+      pthread_mutex_destroy(&table->immediate_lock);
+      pthread_rwlock_destroy(&table->resize_lock);
+      free(index);
+      free(table);
+      return err;
+    }
+
+    seg_symbol_set_id(symbol, id);
+    sym_id_publish(table, id, SEG_TOPOINTER(symbol));
+    table->wellknown[i] = SEG_TOPOINTER(symbol);
+  }
+
+  table->seed = (uint32_t) ((intptr_t) table) % UINT32_MAX;
+  table->hash = hash;
+  table->retired = NULL;
+  atomic_init(&table->index, index);
+  atomic_init(&table->count, 0);
+
+  table->track_lookups = track_lookups;
+  atomic_init(&table->hits, 0);
+  atomic_init(&table->hit_probes, 0);
+  atomic_init(&table->misses, 0);
+  atomic_init(&table->miss_probes, 0);
+  table->resizes = 0;
+  table->resize_ns = 0;
+  atomic_init(&table->weak_count, 0);
+  table->reclaimed = 0;
+  table->sweeps = 0;
+
+  table->settings.init_bucket_capacity = init_bucket_capacity;
+  table->settings.bucket_growth_factor = bucket_growth_factor;
+  table->settings.max_load = max_load;
+  table->settings.table_growth_factor = table_growth_factor;
+  table->settings.incremental_resize_step = 0;
+  table->settings.min_load = 0;
 
   *out = table;
   return SEG_OK;
 }
 
-seg_err seg_symboltable_intern(seg_symboltable *table, const char *name, uint64_t length, seg_object *out)
-{
+/*
+ * Intern a symbol that's either permanent or weak. Interning a weak symbol's name permanently
+ * promotes it.
+ */
+static seg_err sym_intern(
+  seg_symboltable *table,
+  const char *name,
+  uint64_t length,
+  sym_lifetime lifetime,
+  seg_object *out
+) {
   seg_err err;
   seg_object created;
 
@@ -86,28 +698,132 @@ seg_err seg_symboltable_intern(seg_symboltable *table, const char *name, uint64_
     return SEG_OK;
   }
 
-  seg_object existing = SEG_FROMPOINTER(seg_stringtable_get(table->storage, name, length));
+  seg_object_common *existing = sym_wellknown(table, name, length);
+  if (existing != NULL) {
+    out->pointer = existing;
+    return SEG_OK;
+  }
+
+  uint32_t hashcode = seg_hash(table->hash, name, length, table->seed);
+
+  existing = sym_image_find(table, hashcode, name, length);
+  if (existing != NULL) {
+    out->pointer = existing;
+    return SEG_OK;
+  }
+
+  /* Fast path: the symbol already exists. No locks are taken unless it must be promoted. */
+  sym_slot *slot = sym_lookup(table, hashcode, name, length);
+  if (slot != NULL) {
+    existing = atomic_load_explicit(&slot->symbol, memory_order_acquire);
+
+    if (
+      lifetime == SYM_PERMANENT &&
+      atomic_load_explicit(&slot->lifetime, memory_order_acquire) != SYM_PERMANENT
+    ) {
+      uint64_t probes;
+
+      /* Find the symbol again in case a resize copied it to a new index. */
+      pthread_rwlock_rdlock(&table->resize_lock);
+      sym_index *current = atomic_load_explicit(&table->index, memory_order_acquire);
+      sym_promote(table, sym_find(current, hashcode, name, length, &probes));
+      pthread_rwlock_unlock(&table->resize_lock);
+    }
 
-  if (!SEG_SAME(existing, SEG_NO_SYMBOL)) {
-    *out = existing;
+    out->pointer = existing;
     return SEG_OK;
   }
 
+  /* Allocate and number a candidate symbol before competing to publish it. */
   err = seg_symbol(table->runtime, name, length, &created);
   if (err != SEG_OK) {
     return err;
   }
 
-  void *prior;
-  err = seg_stringtable_put(table->storage, name, length, SEG_TOPOINTER(created), &prior);
+  uint32_t id;
+  err = sym_id_reserve(table, &id);
   if (err != SEG_OK) {
+    seg_delete_symbol(table->runtime, created);
     return err;
   }
+  seg_symbol_set_id(created, id);
 
-  *out = created;
+  sym_index *index;
+  while (true) {
+    pthread_rwlock_rdlock(&table->resize_lock);
+    index = atomic_load_explicit(&table->index, memory_order_acquire);
+
+    /* Reserve room for the candidate before claiming a slot, so the index can never fill. */
+    uint64_t reserved = atomic_fetch_add_explicit(&table->count, 1, memory_order_relaxed) + 1;
+    if (reserved <= sym_index_limit(table, index)) {
+      break;
+    }
+
+    atomic_fetch_sub_explicit(&table->count, 1, memory_order_relaxed);
+    pthread_rwlock_unlock(&table->resize_lock);
+
+    err = sym_grow(table, index);
+    if (err != SEG_OK) {
+      seg_delete_symbol(table->runtime, created);
+      return err;
+    }
+  }
+
+  /* Count a weak candidate before publishing it, so that a promotion can't precede its count. */
+  if (lifetime == SYM_WEAK) {
+    atomic_fetch_add_explicit(&table->weak_count, 1, memory_order_relaxed);
+  }
+
+  slot = sym_claim(index, hashcode, name, length, SEG_TOPOINTER(created));
+  seg_object_common *canonical = atomic_load_explicit(&slot->symbol, memory_order_acquire);
+  bool counted = lifetime == SYM_WEAK;
+
+  if (canonical == SEG_TOPOINTER(created)) {
+    sym_id_publish(table, id, canonical);
+
+    /* A concurrent permanent intern may already have promoted the new symbol. */
+    uint32_t publishing = SYM_PUBLISHING;
+    if (atomic_compare_exchange_strong_explicit(
+      &slot->lifetime, &publishing, lifetime, memory_order_acq_rel, memory_order_acquire
+    )) {
+      counted = false;
+    }
+  } else {
+    /* Another thread published this name first. */
+    atomic_fetch_sub_explicit(&table->count, 1, memory_order_relaxed);
+    if (lifetime == SYM_PERMANENT) {
+      sym_promote(table, slot);
+    }
+  }
+
+  if (counted) {
+    atomic_fetch_sub_explicit(&table->weak_count, 1, memory_order_relaxed);
+  }
+
+  pthread_rwlock_unlock(&table->resize_lock);
+
+  if (canonical != SEG_TOPOINTER(created)) {
+    seg_delete_symbol(table->runtime, created);
+  }
+
+  out->pointer = canonical;
   return SEG_OK;
 }
 
+seg_err seg_symboltable_intern(seg_symboltable *table, const char *name, uint64_t length, seg_object *out)
+{
+  return sym_intern(table, name, length, SYM_PERMANENT, out);
+}
+
+seg_err seg_symboltable_intern_weak(
+  seg_symboltable *table,
+  const char *name,
+  uint64_t length,
+  seg_object *out
+) {
+  return sym_intern(table, name, length, SYM_WEAK, out);
+}
+
 seg_err seg_symboltable_cintern(seg_symboltable *table, const char *name, seg_object *out)
 {
   return seg_symboltable_intern(table, name, strlen(name), out);
@@ -128,49 +844,764 @@ seg_object seg_symboltable_get(seg_symboltable *table, const char *name, uint64_
     return created;
   }
 
-  seg_object o = SEG_FROMPOINTER(seg_stringtable_get(table->storage, name, length));
+  seg_object_common *wellknown = sym_wellknown(table, name, length);
+  if (wellknown != NULL) {
+    seg_object o = SEG_FROMPOINTER(wellknown);
+    return o;
+  }
+
+  uint32_t hashcode = seg_hash(table->hash, name, length, table->seed);
+
+  seg_object_common *imaged = sym_image_find(table, hashcode, name, length);
+  if (imaged != NULL) {
+    seg_object o = SEG_FROMPOINTER(imaged);
+    return o;
+  }
+
+  sym_slot *slot = sym_lookup(table, hashcode, name, length);
+  if (slot == NULL) {
+    return SEG_NO_SYMBOL;
+  }
+
+  seg_object o = SEG_FROMPOINTER(atomic_load_explicit(&slot->symbol, memory_order_acquire));
+  return o;
+}
+
+seg_err seg_symboltable_id(seg_symboltable *table, seg_object symbol, uint32_t *out)
+{
+  seg_err err = SEG_OK;
+
+  if (! SEG_IS_IMMEDIATE(symbol)) {
+    uint32_t id = seg_symbol_id(symbol);
+    if (id == SEG_NO_SYMBOL_ID) {
+      return SEG_INVAL("Symbol was not interned by a symboltable.");
+    }
+
+    *out = id;
+    return SEG_OK;
+  }
+
+  pthread_mutex_lock(&table->immediate_lock);
+
+  if (table->immediate_ids == NULL) {
+    err = seg_new_ptrtable_keyed(
+      0, 0, SEG_PTRTABLE_KEYS_IDENTITY, SEG_HASH_DEFAULT, &table->immediate_ids
+    );
+  }
+
+  if (err == SEG_OK) {
+    uintptr_t stored = (uintptr_t) seg_ptrtable_get(table->immediate_ids, SEG_TOPOINTER(symbol));
+
+    if (stored == 0) {
+      uint32_t id;
+      void *previous;
+
+      err = sym_id_reserve(table, &id);
+      if (err == SEG_OK) {
+        stored = (uintptr_t) id + 1;
+        err = seg_ptrtable_put(
+          table->immediate_ids, SEG_TOPOINTER(symbol), (void *) stored, &previous
+        );
+      }
+      if (err == SEG_OK) {
+        sym_id_publish(table, id, SEG_TOPOINTER(symbol));
+      }
+    }
+
+    if (err == SEG_OK) {
+      *out = (uint32_t) (stored - 1);
+    }
+  }
+
+  pthread_mutex_unlock(&table->immediate_lock);
+  return err;
+}
+
+seg_object seg_symboltable_symbol(seg_symboltable *table, uint32_t id)
+{
+  if (id >= atomic_load_explicit(&table->next_id, memory_order_acquire)) {
+    return SEG_NO_SYMBOL;
+  }
+
+  unsigned k;
+  uint64_t offset;
+  sym_id_locate(id, &k, &offset);
+
+  sym_id_entry *chunk = atomic_load_explicit(&table->id_chunks[k], memory_order_acquire);
+  if (chunk == NULL) {
+    return SEG_NO_SYMBOL;
+  }
+
+  seg_object o = SEG_FROMPOINTER(atomic_load_explicit(&chunk[offset], memory_order_acquire));
+  return o;
+}
+
+uint32_t seg_symboltable_id_limit(seg_symboltable *table)
+{
+  uint64_t next = atomic_load_explicit(&table->next_id, memory_order_acquire);
+  return next < SEG_NO_SYMBOL_ID ? (uint32_t) next : SEG_NO_SYMBOL_ID;
+}
+
+seg_object seg_symboltable_wellknown(seg_symboltable *table, seg_wellknown_id id)
+{
+  seg_object o = SEG_FROMPOINTER(table->wellknown[id]);
   return o;
 }
 
 uint64_t seg_symboltable_count(seg_symboltable *table)
 {
-  return seg_stringtable_count(table->storage);
+  return atomic_load_explicit(&table->count, memory_order_relaxed);
 }
 
 uint64_t seg_symboltable_capacity(seg_symboltable *table)
 {
-  return seg_stringtable_capacity(table->storage);
+  return atomic_load_explicit(&table->index, memory_order_acquire)->slot_count;
 }
 
 seg_hashtable_settings *seg_symboltable_get_settings(seg_symboltable *table)
 {
-  return seg_stringtable_get_settings(table->storage);
+  return &(table->settings);
 }
 
-typedef struct {
-  void *outer_state;
-  seg_symboltable_iterator iter;
-} symboliter_state;
+void seg_symboltable_stats(seg_symboltable *table, seg_hashtable_stats *out)
+{
+  memset(out, 0, sizeof(seg_hashtable_stats));
+
+  /* Hold off resizes, so that the index and the resize counters are consistent. */
+  pthread_rwlock_rdlock(&table->resize_lock);
+
+  sym_index *index = atomic_load_explicit(&table->index, memory_order_acquire);
+  uint64_t mask = index->slot_count - 1;
+
+  out->count = atomic_load_explicit(&table->count, memory_order_relaxed);
+  out->capacity = index->slot_count;
+  out->slots = index->slot_count;
+  out->bytes = sizeof(struct seg_symboltable);
+
+  for (uint64_t i = 0; i < index->slot_count; i++) {
+    sym_slot *slot = &(index->slots[i]);
+
+    if (atomic_load_explicit(&slot->symbol, memory_order_acquire) == NULL) {
+      out->empty_slots++;
+    } else {
+      uint32_t hashcode = atomic_load_explicit(&slot->hashcode, memory_order_acquire);
+      seg_hashtable_histogram_add(out, (i - (hashcode & mask)) & mask);
+    }
+  }
+
+  out->bytes += sizeof(sym_index) + sizeof(sym_slot) * index->slot_count;
+  for (int k = 0; k < SYM_CHUNKS; k++) {
+    if (atomic_load_explicit(&table->id_chunks[k], memory_order_acquire) != NULL) {
+      out->bytes += sizeof(sym_id_entry) * ((uint64_t) SYM_CHUNK_BASE << k);
+    }
+  }
+  for (sym_index *retired = table->retired; retired != NULL; retired = retired->retired_next) {
+    out->bytes += sizeof(sym_index) + sizeof(sym_slot) * retired->slot_count;
+  }
+
+  pthread_mutex_lock(&table->immediate_lock);
+  if (table->immediate_ids != NULL) {
+    seg_hashtable_stats ids;
+    seg_ptrtable_stats(table->immediate_ids, &ids);
+    out->bytes += ids.bytes;
+  }
+  pthread_mutex_unlock(&table->immediate_lock);
+
+  out->counters.hits = atomic_load_explicit(&table->hits, memory_order_relaxed);
+  out->counters.hit_probes = atomic_load_explicit(&table->hit_probes, memory_order_relaxed);
+  out->counters.misses = atomic_load_explicit(&table->misses, memory_order_relaxed);
+  out->counters.miss_probes = atomic_load_explicit(&table->miss_probes, memory_order_relaxed);
+  out->counters.resizes = table->resizes;
+  out->counters.resize_ns = table->resize_ns;
+
+  pthread_rwlock_unlock(&table->resize_lock);
+}
+
+/*
+ * Walk the symbols in an image's arena, checking that each lies within the file, and set the bit in
+ * `starts` for each eight-byte word of the arena where one begins.
+ */
+static seg_err sym_image_validate_arena(
+  char *mapping,
+  size_t length,
+  uint64_t *starts,
+  uint64_t *arena_end
+) {
+  sym_image_header *header = (sym_image_header *) mapping;
+  uint64_t offset = header->arena_offset;
+
+  for (uint64_t i = 0; i < header->symbol_count; i++) {
+    if (offset > length || length - offset < seg_symbol_footprint(0)) {
+      return SEG_INVAL("Symbol image arena is out of bounds.");
+    }
+
+    seg_object symbol = SEG_FROMPOINTER((mapping + offset));
+    char *contents;
+    uint64_t contents_length;
+    seg_buffer_contents(&symbol, &contents, &contents_length);
+
+    if (
+      SEG_STR_WILLBEIMM(contents_length) ||
+      contents_length > length ||
+      seg_symbol_footprint(contents_length) > length - offset
+    ) {
+      return SEG_INVAL("Symbol image arena is out of bounds.");
+    }
+
+    uint64_t mark = (offset - header->arena_offset) / 8;
+    starts[mark / 64] |= UINT64_C(1) << (mark % 64);
+    offset += seg_symbol_footprint(contents_length);
+  }
+
+  *arena_end = offset;
+  return SEG_OK;
+}
+
+/*
+ * Check that every occupied slot in an image's index points at the start of a symbol in its arena.
+ */
+static seg_err sym_image_validate_slots(char *mapping, const uint64_t *starts, uint64_t arena_end)
+{
+  sym_image_header *header = (sym_image_header *) mapping;
+  const sym_image_slot *slots = (const sym_image_slot *) (mapping + header->slots_offset);
+
+  for (uint64_t i = 0; i < header->slot_count; i++) {
+    uint64_t slot_offset = slots[i].offset;
+    if (slot_offset == 0) {
+      continue;
+    }
+
+    if (slot_offset < header->arena_offset || slot_offset >= arena_end || slot_offset % 8 != 0) {
+      return SEG_INVAL("Symbol image index is out of bounds.");
+    }
+
+    uint64_t mark = (slot_offset - header->arena_offset) / 8;
+    if ((starts[mark / 64] & (UINT64_C(1) << (mark % 64))) == 0) {
+      return SEG_INVAL("Symbol image index doesn't point at a symbol.");
+    }
+  }
+
+  return SEG_OK;
+}
+
+/*
+ * Check that a mapped symbol image is well-formed enough to be used safely: that it was written for
+ * this kind of machine, and that every offset within it stays within the file.
+ */
+static seg_err sym_image_validate(char *mapping, size_t length)
+{
+  sym_image_header *header = (sym_image_header *) mapping;
+
+  if (memcmp(header->magic, SYM_IMAGE_MAGIC, sizeof(header->magic)) != 0) {
+    return SEG_INVAL("File is not a symbol image.");
+  }
+
+  if (header->version != SYM_IMAGE_VERSION || header->pointer_size != sizeof(void *)) {
+    return SEG_INVAL("Symbol image was written by an incompatible build.");
+  }
+
+  if (header->hash > SEG_HASH_CRC32C) {
+    return SEG_INVAL("Symbol image uses an unknown hash algorithm.");
+  }
+
+  if (header->file_length != length) {
+    return SEG_INVAL("Symbol image is truncated.");
+  }
+
+  uint64_t slot_count = header->slot_count;
+  if (
+    slot_count == 0 ||
+    (slot_count & (slot_count - 1)) != 0 ||
+    slot_count <= header->symbol_count
+  ) {
+    return SEG_INVAL("Symbol image index is malformed.");
+  }
+
+  if (
+    header->slots_offset % sizeof(sym_image_slot) != 0 ||
+    header->slots_offset > length ||
+    slot_count > (length - header->slots_offset) / sizeof(sym_image_slot) ||
+    header->arena_offset % 8 != 0 ||
+    header->arena_offset > length
+  ) {
+    return SEG_INVAL("Symbol image sections are out of bounds.");
+  }
+
+  /*
+   * Every symbol, whether reached through the arena or the index, must lie within the file. The
+   * arena walk marks where each symbol starts, one bit per eight bytes, and index slots may only
+   * point at those marks.
+   */
+  uint64_t *starts = calloc((length - header->arena_offset) / 8 / 64 + 1, sizeof(uint64_t));
+  if (starts == NULL) {
+    return SEG_NOMEM("Unable to allocate space to validate a symbol image.");
+  }
+
+  uint64_t arena_end;
+  seg_err err = sym_image_validate_arena(mapping, length, starts, &arena_end);
+  if (err == SEG_OK) {
+    err = sym_image_validate_slots(mapping, starts, arena_end);
+  }
+
+  free(starts);
+  return err;
+}
+
+seg_err seg_symboltable_load_image(seg_symboltable *table, const char *path)
+{
+  seg_err err;
+  struct stat info;
+
+  if (table->image != NULL) {
+    return SEG_INVAL("A symbol image has already been loaded.");
+  }
+
+  if (atomic_load_explicit(&table->count, memory_order_relaxed) != 0) {
+    return SEG_INVAL("Symbol images must be loaded before any symbols are interned.");
+  }
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return seg_err_with_detail(
+      SEG_INVAL("Unable to open symbol image."), "%s: %s", path, strerror(errno)
+    );
+  }
+
+  if (fstat(fd, &info) == -1 || (size_t) info.st_size < sizeof(sym_image_header)) {
+    close(fd);
+    return SEG_INVAL("Symbol image is truncated.");
+  }
+
+  /* Mapped privately, so that symbols can be given their classes without modifying the file. */
+  size_t length = (size_t) info.st_size;
+  char *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return SEG_NOMEM("Unable to map symbol image.");
+  }
+
+  err = sym_image_validate(mapping, length);
+  if (err != SEG_OK) {
+    munmap(mapping, length);
+    return err;
+  }
+
+  sym_image *image = malloc(sizeof(sym_image));
+  if (image == NULL) {
+    munmap(mapping, length);
+    return SEG_NOMEM("Unable to allocate symbol image.");
+  }
+
+  sym_image_header *header = (sym_image_header *) mapping;
+  uint64_t offset = header->arena_offset;
+  uint32_t first_id = seg_symboltable_id_limit(table);
+
+  for (uint64_t i = 0; i < header->symbol_count; i++) {
+    seg_object symbol = seg_symbol_adopt(table->runtime, mapping + offset);
+    char *contents;
+    uint64_t contents_length;
+    uint32_t id;
+
+    err = sym_id_reserve(table, &id);
+    if (err != SEG_OK) {
+      for (uint32_t published = first_id; published < id; published++) {
+        sym_id_publish(table, published, NULL);
+      }
+      free(image);
+      munmap(mapping, length);
+      return err;
+    }
+
+    seg_symbol_set_id(symbol, id);
+    sym_id_publish(table, id, SEG_TOPOINTER(symbol));
+
+    seg_buffer_contents(&symbol, &contents, &contents_length);
+    offset += seg_symbol_footprint(contents_length);
+  }
+
+  mprotect(mapping, length, PROT_READ);
+
+  image->mapping = mapping;
+  image->mapping_length = length;
+  image->symbol_count = header->symbol_count;
+  image->slot_count = header->slot_count;
+  image->slots = (const sym_image_slot *) (mapping + header->slots_offset);
+
+  table->hash = (seg_hash_algorithm) header->hash;
+  table->seed = header->seed;
+  table->image = image;
+  return SEG_OK;
+}
+
+seg_err seg_symboltable_write_image(seg_symboltable *table, const char *path)
+{
+  seg_err err = SEG_OK;
+
+  pthread_rwlock_rdlock(&table->resize_lock);
+
+  sym_index *index = atomic_load_explicit(&table->index, memory_order_acquire);
+  uint64_t image_count = table->image != NULL ? table->image->symbol_count : 0;
+  uint64_t capacity = image_count + index->slot_count;
 
-static seg_err symboliter(const char *key, const uint64_t key_length, void *value, void *state)
+  seg_object_common **symbols = malloc(sizeof(seg_object_common *) * capacity);
+  if (symbols == NULL) {
+    pthread_rwlock_unlock(&table->resize_lock);
+    return SEG_NOMEM("Unable to allocate symbol image.");
+  }
+
+  /* Gather every permanent symbol: those already in an image, then those in the index. */
+  uint64_t symbol_count = 0;
+  uint64_t arena_length = 0;
+
+  if (table->image != NULL) {
+    sym_image_header *header = (sym_image_header *) table->image->mapping;
+    uint64_t offset = header->arena_offset;
+
+    for (uint64_t i = 0; i < image_count; i++) {
+      seg_object symbol = SEG_FROMPOINTER((table->image->mapping + offset));
+      char *contents;
+      uint64_t contents_length;
+
+      seg_buffer_contents(&symbol, &contents, &contents_length);
+      symbols[symbol_count++] = SEG_TOPOINTER(symbol);
+      arena_length += seg_symbol_footprint(contents_length);
+      offset += seg_symbol_footprint(contents_length);
+    }
+  }
+
+  for (uint64_t i = 0; i < index->slot_count; i++) {
+    sym_slot *slot = &(index->slots[i]);
+    seg_object_common *symbol = atomic_load_explicit(&slot->symbol, memory_order_acquire);
+
+    if (
+      symbol != NULL &&
+      atomic_load_explicit(&slot->lifetime, memory_order_acquire) == SYM_PERMANENT
+    ) {
+      seg_object o = SEG_FROMPOINTER(symbol);
+      char *contents;
+      uint64_t contents_length;
+
+      seg_buffer_contents(&o, &contents, &contents_length);
+      symbols[symbol_count++] = symbol;
+      arena_length += seg_symbol_footprint(contents_length);
+    }
+  }
+
+  /* Keep the image's index at most half full, so that probes stay short. */
+  uint64_t slot_count = 16;
+  while (slot_count < symbol_count * 2) {
+    slot_count <<= 1;
+  }
+
+  uint64_t slots_offset = sizeof(sym_image_header);
+  uint64_t arena_offset = slots_offset + sizeof(sym_image_slot) * slot_count;
+  uint64_t file_length = arena_offset + arena_length;
+
+  char *buffer = NULL;
+  if (file_length > UINT32_MAX) {
+    err = SEG_RANGE("Symbol image would be larger than 4GB.");
+  } else {
+    buffer = calloc(1, file_length);
+    if (buffer == NULL) {
+      err = SEG_NOMEM("Unable to allocate symbol image.");
+    }
+  }
+
+  if (err == SEG_OK) {
+    sym_image_header *header = (sym_image_header *) buffer;
+    memcpy(header->magic, SYM_IMAGE_MAGIC, sizeof(header->magic));
+    header->version = SYM_IMAGE_VERSION;
+    header->hash = (uint32_t) table->hash;
+    header->seed = table->seed;
+    header->pointer_size = sizeof(void *);
+    header->file_length = file_length;
+    header->symbol_count = symbol_count;
+    header->slot_count = slot_count;
+    header->slots_offset = slots_offset;
+    header->arena_offset = arena_offset;
+
+    sym_image_slot *slots = (sym_image_slot *) (buffer + slots_offset);
+    uint64_t mask = slot_count - 1;
+    uint64_t offset = arena_offset;
+
+    for (uint64_t i = 0; i < symbol_count; i++) {
+      seg_object symbol = SEG_FROMPOINTER(symbols[i]);
+      char *contents;
+      uint64_t contents_length;
+
+      seg_buffer_contents(&symbol, &contents, &contents_length);
+      seg_symbol_write(buffer + offset, contents, contents_length);
+
+      uint32_t hashcode = seg_hash(table->hash, contents, contents_length, table->seed);
+      uint64_t j = hashcode & mask;
+      while (slots[j].offset != 0) {
+        j = (j + 1) & mask;
+      }
+      slots[j].hashcode = hashcode;
+      slots[j].offset = (uint32_t) offset;
+
+      offset += seg_symbol_footprint(contents_length);
+    }
+  }
+
+  pthread_rwlock_unlock(&table->resize_lock);
+  free(symbols);
+
+  if (err != SEG_OK) {
+    return err;
+  }
+
+  /*
+   * Write a new file and rename it into place, rather than overwriting the image in place: this
+   * process or others may have the existing image mapped.
+   */
+  size_t path_length = strlen(path);
+  char *temporary = malloc(path_length + sizeof(".tmp"));
+  if (temporary == NULL) {
+    free(buffer);
+    return SEG_NOMEM("Unable to allocate symbol image path.");
+  }
+  memcpy(temporary, path, path_length);
+  memcpy(temporary + path_length, ".tmp", sizeof(".tmp"));
+
+  FILE *file = fopen(temporary, "wb");
+  if (file == NULL) {
+    err = seg_err_with_detail(
+      SEG_INVAL("Unable to create symbol image."), "%s: %s", temporary, strerror(errno)
+    );
+  } else {
+    size_t written = fwrite(buffer, 1, file_length, file);
+    if (fclose(file) != 0 || written != file_length) {
+      err = SEG_INVAL("Unable to write symbol image.");
+    } else if (rename(temporary, path) != 0) {
+      err = seg_err_with_detail(
+        SEG_INVAL("Unable to replace symbol image."), "%s: %s", path, strerror(errno)
+      );
+    }
+
+    if (err != SEG_OK) {
+      remove(temporary);
+    }
+  }
+
+  free(temporary);
+  free(buffer);
+  return err;
+}
+
+uint64_t seg_symboltable_image_count(seg_symboltable *table)
+{
+  return table->image != NULL ? table->image->symbol_count : 0;
+}
+
+uint64_t seg_symboltable_image_bytes(seg_symboltable *table)
+{
+  return table->image != NULL ? sizeof(sym_image) + table->image->mapping_length : 0;
+}
+
+seg_err seg_symboltable_sweep(
+  seg_symboltable *table,
+  seg_symboltable_liveness is_live,
+  void *state,
+  uint64_t *reclaimed
+) {
+  seg_err err = SEG_OK;
+  uint64_t dead = 0;
+
+  pthread_rwlock_wrlock(&table->resize_lock);
+
+  sym_index *current = atomic_load_explicit(&table->index, memory_order_relaxed);
+
+  if (atomic_load_explicit(&table->weak_count, memory_order_relaxed) > 0) {
+    sym_index *swept;
+    err = sym_index_new(current->slot_count, &swept);
+
+    if (err == SEG_OK) {
+      uint64_t mask = swept->slot_count - 1;
+
+      for (uint64_t i = 0; i < current->slot_count; i++) {
+        sym_slot *slot = &(current->slots[i]);
+        seg_object_common *symbol = atomic_load_explicit(&slot->symbol, memory_order_relaxed);
+        if (symbol == NULL) {
+          continue;
+        }
+
+        seg_object o = SEG_FROMPOINTER(symbol);
+        uint32_t lifetime = atomic_load_explicit(&slot->lifetime, memory_order_relaxed);
+        if (lifetime == SYM_WEAK && ! (*is_live)(o, state)) {
+          sym_id_publish(table, seg_symbol_id(o), NULL);
+          seg_delete_symbol(table->runtime, o);
+          dead++;
+          continue;
+        }
+
+        uint32_t hashcode = atomic_load_explicit(&slot->hashcode, memory_order_relaxed);
+        uint64_t j = hashcode & mask;
+        while (atomic_load_explicit(&swept->slots[j].symbol, memory_order_relaxed) != NULL) {
+          j = (j + 1) & mask;
+        }
+
+        atomic_store_explicit(&swept->slots[j].symbol, symbol, memory_order_relaxed);
+        atomic_store_explicit(&swept->slots[j].hashcode, hashcode, memory_order_relaxed);
+        atomic_store_explicit(&swept->slots[j].lifetime, lifetime, memory_order_relaxed);
+      }
+
+      /* No other thread is using the table, so replaced indexes can be freed immediately. */
+      atomic_store_explicit(&table->index, swept, memory_order_release);
+      free(current);
+
+      while (table->retired != NULL) {
+        sym_index *next = table->retired->retired_next;
+        free(table->retired);
+        table->retired = next;
+      }
+
+      atomic_fetch_sub_explicit(&table->count, dead, memory_order_relaxed);
+      atomic_fetch_sub_explicit(&table->weak_count, dead, memory_order_relaxed);
+      table->reclaimed += dead;
+    }
+  }
+
+  if (err == SEG_OK) {
+    table->sweeps++;
+  }
+
+  pthread_rwlock_unlock(&table->resize_lock);
+
+  if (reclaimed != NULL) {
+    *reclaimed = dead;
+  }
+  return err;
+}
+
+void seg_symboltable_reclamation_stats(seg_symboltable *table, seg_symboltable_reclamation *out)
+{
+  pthread_rwlock_rdlock(&table->resize_lock);
+
+  uint64_t count = atomic_load_explicit(&table->count, memory_order_relaxed);
+  uint64_t weak = atomic_load_explicit(&table->weak_count, memory_order_relaxed);
+
+  /* Concurrent interns may have counted a weak candidate that hasn't been published yet. */
+  if (weak > count) {
+    weak = count;
+  }
+
+  out->permanent = count - weak;
+  out->weak = weak;
+  out->reclaimed = table->reclaimed;
+  out->sweeps = table->sweeps;
+
+  pthread_rwlock_unlock(&table->resize_lock);
+}
+
+/*
+ * Move a cursor forward from its current position to the nearest claimed slot.
+ */
+static void sym_seek(seg_hashtable_cursor *cursor)
+{
+  sym_index *index = cursor->storage;
+
+  while (cursor->position < index->slot_count) {
+    sym_slot *slot = &(index->slots[cursor->position]);
+    seg_object_common *symbol = atomic_load_explicit(&slot->symbol, memory_order_acquire);
+
+    if (symbol != NULL) {
+      cursor->value = symbol;
+      return;
+    }
+    cursor->position++;
+  }
+
+  cursor->done = true;
+}
+
+void seg_symboltable_begin(seg_symboltable *table, seg_hashtable_cursor *cursor)
 {
-  symboliter_state *casted = (symboliter_state*) state;
-  seg_object o = SEG_FROMPOINTER(value);
+  /* Indexes retired by a resize live as long as the table, so this one stays valid. */
+  cursor->storage = atomic_load_explicit(&table->index, memory_order_acquire);
+  cursor->position = 0;
+  cursor->offset = 0;
+  cursor->key = NULL;
+  cursor->key_length = 0;
+  cursor->done = false;
 
-  return casted->iter(o, casted->outer_state);
+  sym_seek(cursor);
+}
+
+void seg_symboltable_next(seg_symboltable *table, seg_hashtable_cursor *cursor)
+{
+  cursor->position++;
+  sym_seek(cursor);
+}
+
+seg_object seg_symboltable_cursor_symbol(seg_hashtable_cursor *cursor)
+{
+  seg_object o = SEG_FROMPOINTER(cursor->value);
+  return o;
 }
 
 seg_err seg_symboltable_each(seg_symboltable *table, seg_symboltable_iterator iter, void *state)
 {
-  symboliter_state symbolstate;
-  symbolstate.outer_state = state;
-  symbolstate.iter = iter;
+  seg_err err;
+  seg_hashtable_cursor c;
 
-  return seg_stringtable_each(table->storage, symboliter, &symbolstate);
+  for (
+    seg_symboltable_begin(table, &c);
+    ! seg_hashtable_done(&c);
+    seg_symboltable_next(table, &c)
+  ) {
+    err = (*iter)(seg_symboltable_cursor_symbol(&c), state);
+    if (err != SEG_OK) {
+      return err;
+    }
+  }
+
+  return SEG_OK;
 }
 
 void seg_delete_symboltable(seg_symboltable *table)
 {
-  seg_delete_stringtable(table->storage);
+  sym_index *retired = table->retired;
+  while (retired != NULL) {
+    sym_index *next = retired->retired_next;
+    free(retired);
+    retired = next;
+  }
+
+  for (int i = 0; i < SEG_WELLKNOWN_COUNT; i++) {
+    seg_object o = SEG_FROMPOINTER(table->wellknown[i]);
+    seg_delete_symbol(table->runtime, o);
+  }
+
+  /* Retired indexes only share symbols with the current one, which owns every interned symbol. */
+  sym_index *current = atomic_load_explicit(&table->index, memory_order_relaxed);
+  for (uint64_t i = 0; i < current->slot_count; i++) {
+    seg_object_common *symbol = atomic_load_explicit(
+      &current->slots[i].symbol, memory_order_relaxed
+    );
+    if (symbol == NULL || sym_image_contains(table, symbol)) {
+      continue;
+    }
+
+    seg_object o = SEG_FROMPOINTER(symbol);
+    seg_delete_symbol(table->runtime, o);
+  }
+
+  for (int k = 0; k < SYM_CHUNKS; k++) {
+    free(atomic_load_explicit(&table->id_chunks[k], memory_order_relaxed));
+  }
+
+  if (table->immediate_ids != NULL) {
+    seg_delete_ptrtable(table->immediate_ids);
+  }
+  pthread_mutex_destroy(&table->immediate_lock);
+
+  if (table->image != NULL) {
+    munmap(table->image->mapping, table->image->mapping_length);
+    free(table->image);
+  }
+
+  free(current);
+  pthread_rwlock_destroy(&table->resize_lock);
   free(table);
 }
@@ -6,7 +6,13 @@
 #include "errors.h"
 #include "model/object.h"
 #include "ds/hashtable.h"
+#include "runtime/wellknown.h"
 
+/*
+ * The symboltable may be shared among threads. Lookups, including the lookup that precedes each
+ * intern, never block and take no locks. Concurrent interns of the same name all return the same
+ * symbol. Interns only wait on one another while the table grows.
+ */
 struct seg_symboltable;
 typedef struct seg_symboltable seg_symboltable;
 
@@ -15,12 +21,40 @@ typedef struct seg_symboltable seg_symboltable;
  */
 typedef seg_err (*seg_symboltable_iterator)(seg_object symbol, void *state);
 
+/*
+ * Signature of a function that reports whether a weak symbol is still reachable during a sweep.
+ */
+typedef bool (*seg_symboltable_liveness)(seg_object symbol, void *state);
+
+/*
+ * Counts of the symboltable's non-immediate symbols by lifetime, not including well-known symbols.
+ */
+typedef struct {
+  /* Live symbols that will never be reclaimed. */
+  uint64_t permanent;
+
+  /* Live symbols that a sweep may reclaim. */
+  uint64_t weak;
+
+  /* Weak symbols reclaimed by all sweeps so far. */
+  uint64_t reclaimed;
+
+  /* Sweeps that have completed. */
+  uint64_t sweeps;
+} seg_symboltable_reclamation;
+
 /*
  * Default growth characteristics of the symbol table. Each of these may be overridden by the
  * environment variable of the same name, or controlled at runtime through the Symboltable object.
+ *
+ * The initial capacity is deliberately small: the table grows geometrically as symbols are
+ * interned, so short-lived processes don't pay to allocate slots that they'll never touch.
+ *
+ * The symboltable is open-addressed, so the bucket settings are recorded but have no effect.
+ * Maximum loads above 0.9 are treated as 0.9.
  */
 
-#define SEG_SYMTABLE_CAP 1048576
+#define SEG_SYMTABLE_CAP 64
 #define SEG_SYMTABLE_GROWTH 2
 #define SEG_SYMTABLE_BUCKET_CAP 4
 #define SEG_SYMTABLE_BUCKET_GROWTH 2
@@ -28,7 +62,7 @@ typedef seg_err (*seg_symboltable_iterator)(seg_object symbol, void *state);
 
 /*
  * Allocate a new symboltable for the interpreter. Read initial storage settings for the table from
- * the process' environment.
+ * the process' environment. Set SEG_SYMTABLE_STATS=1 to count lookups for seg_symboltable_stats.
  *
  * SEG_NOMEM: If the allocation fails.
  */
@@ -36,13 +70,29 @@ seg_err seg_new_symboltable(seg_runtime *r, seg_symboltable **out);
 
 /*
  * Insert a new entry into the symboltable if it's not already present. Return the newly created
- * symbol or the previously existing one.
+ * symbol or the previously existing one. Symbols interned this way are permanent: this is how the
+ * parser and the runtime intern names that appear in source.
  *
  * SEG_NOMEM: If the allocation of a new symbol fails.
  * SEG_RANGE: If the symbol length is greater than seg_symbol() permits.
  */
 seg_err seg_symboltable_intern(seg_symboltable *table, const char *name, uint64_t length, seg_object *out);
 
+/*
+ * Intern a symbol weakly, as for a name computed by a running program. A weak symbol is reclaimed
+ * by the first sweep that finds it unreachable, after which interning the same name creates a new
+ * symbol with a new ID. Interning a weak symbol's name with `seg_symboltable_intern` makes it
+ * permanent.
+ *
+ * SEG_NOMEM: If the allocation of a new symbol fails.
+ */
+seg_err seg_symboltable_intern_weak(
+  seg_symboltable *table,
+  const char *name,
+  uint64_t length,
+  seg_object *out
+);
+
 /*
  * Convenience function to intern a symbol from a C-style NULL-terminated string.
  */
@@ -56,7 +106,42 @@ seg_object seg_symboltable_get(seg_symboltable *table, const char *name, uint64_
 #define SEG_NO_SYMBOL SEG_NULL
 
 /*
- * Return the number of non-immediate symbols currently stored in the symboltable.
+ * Find the ID of an interned symbol. IDs are 32-bit integers, numbered from zero in the order that
+ * symbols were interned, so they can index arrays sized by seg_symboltable_id_limit(). A symbol's
+ * ID never changes. IDs are dense, except that one is abandoned whenever threads race to intern
+ * the same new name.
+ *
+ * Finding a non-immediate symbol's ID reads it from the symbol and never blocks. An immediate
+ * symbol is numbered the first time its ID is asked for, and looking it up takes a lock, so callers
+ * that dispatch on immediate selectors should find their IDs once and keep them.
+ *
+ * SEG_INVAL: If `symbol` is a non-immediate symbol that wasn't interned by a symboltable.
+ * SEG_NOMEM: If an immediate symbol can't be numbered.
+ * SEG_RANGE: If every 32-bit ID has already been assigned.
+ */
+seg_err seg_symboltable_id(seg_symboltable *table, seg_object symbol, uint32_t *out);
+
+/*
+ * Return the symbol with the given ID, or SEG_NO_SYMBOL if no symbol has it. A symbol interned by
+ * one thread can be found by its ID in any thread once that intern has returned.
+ */
+seg_object seg_symboltable_symbol(seg_symboltable *table, uint32_t id);
+
+/*
+ * Return one more than the largest ID assigned so far.
+ */
+uint32_t seg_symboltable_id_limit(seg_symboltable *table);
+
+/*
+ * Access one of the symbols listed in wellknown.def without looking up its name. Well-known
+ * symbols are created along with the symboltable. Like immediates, they're always present, but
+ * they aren't included in its count, stats or cursors.
+ */
+seg_object seg_symboltable_wellknown(seg_symboltable *table, seg_wellknown_id id);
+
+/*
+ * Return the number of non-immediate symbols currently stored in the symboltable, not counting
+ * well-known symbols.
  */
 uint64_t seg_symboltable_count(seg_symboltable *table);
 
@@ -70,6 +155,89 @@ uint64_t seg_symboltable_capacity(seg_symboltable *table);
 */
 seg_hashtable_settings *seg_symboltable_get_settings(seg_symboltable *table);
 
+/*
+ * Take a snapshot of the symboltable's shape and usage. Probe lengths are measured in slots.
+ * Lookup counters remain zero unless the SEG_SYMTABLE_STATS environment variable was set when the
+ * symboltable was created. Retired indexes are included in the byte count, but symbols themselves
+ * are not. O(capacity).
+ */
+void seg_symboltable_stats(seg_symboltable *table, seg_hashtable_stats *out);
+
+/*
+ * Position a cursor on the first interned symbol. See seg_hashtable_cursor. Unlike other tables,
+ * the symboltable may be modified while a cursor is in use: the cursor walks the slots that were
+ * current when it began, so it may miss symbols interned after that, but it never visits a symbol
+ * twice.
+ */
+void seg_symboltable_begin(seg_symboltable *table, seg_hashtable_cursor *cursor);
+
+/*
+ * Advance a cursor to the next interned symbol.
+ */
+void seg_symboltable_next(seg_symboltable *table, seg_hashtable_cursor *cursor);
+
+/*
+ * Return the symbol at a cursor's position.
+ */
+seg_object seg_symboltable_cursor_symbol(seg_hashtable_cursor *cursor);
+
+/*
+ * Reclaim every weak symbol for which `is_live` returns false, freeing it and releasing its ID.
+ * `state` is passed through to `is_live`, which is only consulted for weak symbols. Report the
+ * number of symbols reclaimed in `reclaimed`, if it isn't NULL.
+ *
+ * Sweeping frees memory that lock-free readers could otherwise be using, so it must only be called
+ * while no other thread is using the symboltable, as during a stop-the-world collection. Cursors
+ * begun before a sweep must not be advanced after it.
+ *
+ * SEG_NOMEM: If the rebuilt index can't be allocated. No symbols are reclaimed.
+ */
+seg_err seg_symboltable_sweep(
+  seg_symboltable *table,
+  seg_symboltable_liveness is_live,
+  void *state,
+  uint64_t *reclaimed
+);
+
+/*
+ * Count the live symbols by lifetime, along with the symbols reclaimed by sweeps.
+ */
+void seg_symboltable_reclamation_stats(seg_symboltable *table, seg_symboltable_reclamation *out);
+
+/*
+ * Map the permanent symbols stored in a symbol image into the table, so that they're found without
+ * being interned. The table adopts the hash algorithm and seed that the image was written with, and
+ * symbols that the image doesn't contain are interned as usual. Like well-known symbols, imaged
+ * symbols aren't included in the table's count, stats or cursors. Images must be loaded after the
+ * runtime is bootstrapped, so that the Symbol class exists, but before the table is shared between
+ * threads or any non-immediate symbols are interned.
+ *
+ * SEG_INVAL: If the image can't be read or is malformed, if an image has already been loaded, or
+ *   if symbols have already been interned.
+ * SEG_NOMEM: If the image can't be mapped, or its symbols can't be numbered.
+ */
+seg_err seg_symboltable_load_image(seg_symboltable *table, const char *path);
+
+/*
+ * Write every permanent symbol in the table, including those loaded from an image, to a symbol
+ * image at `path`. The file is replaced atomically, so an image may be rewritten while it's loaded.
+ *
+ * SEG_INVAL: If the file can't be written.
+ * SEG_NOMEM: If the image can't be assembled in memory.
+ * SEG_RANGE: If the image would be larger than 4GB.
+ */
+seg_err seg_symboltable_write_image(seg_symboltable *table, const char *path);
+
+/*
+ * Return the number of symbols mapped in from a symbol image.
+ */
+uint64_t seg_symboltable_image_count(seg_symboltable *table);
+
+/*
+ * Return the number of bytes mapped for a symbol image, or zero if none has been loaded.
+ */
+uint64_t seg_symboltable_image_bytes(seg_symboltable *table);
+
 /*
 * Iterate through each interned symbol. `state` will be provided as-is to the
 * iterator function during each iteration.
@@ -0,0 +1,38 @@
+#ifndef WELLKNOWN_H
+#define WELLKNOWN_H
+
+#include <stdint.h>
+
+/*
+ * Identifiers of the symbols listed in wellknown.def. Every symboltable preallocates these, and
+ * finds them by name through a perfect hash instead of its dynamic index. Each identifier is also
+ * its symbol's ID, as reported by seg_symboltable_id().
+ */
+
+#define SEG_WELLKNOWN(ID, NAME) ID,
+typedef enum {
+#include "runtime/wellknown.def"
+  SEG_WELLKNOWN_COUNT
+} seg_wellknown_id;
+#undef SEG_WELLKNOWN
+
+/*
+ * Hash a name that's longer than an immediate into the well-known slot table. Only the length and
+ * three bytes are mixed in, so this costs far less than a full hash of the name. `multiplier` and
+ * `shift` are chosen by tools/wellknown.c so that no two well-known names collide.
+ */
+static inline uint32_t seg_wellknown_hash(
+  const char *name,
+  uint64_t length,
+  uint32_t multiplier,
+  unsigned shift
+) {
+  uint32_t key = (uint32_t) (uint8_t) name[0] |
+    (uint32_t) (uint8_t) name[length / 2] << 8 |
+    (uint32_t) (uint8_t) name[length - 1] << 16 |
+    (uint32_t) length << 24;
+
+  return (key * multiplier) >> shift;
+}
+
+#endif
@@ -0,0 +1,12 @@
+/* Generated by tools/wellknown.c from src/runtime/wellknown.def. Do not edit. */
+
+#define SEG_WELLKNOWN_MULTIPLIER 0x2b1f4d63u
+#define SEG_WELLKNOWN_SHIFT 30
+#define SEG_WELLKNOWN_SLOTS 4
+
+static const int8_t seg_wellknown_slots[SEG_WELLKNOWN_SLOTS] = {
+  SEG_WK_STRINGCONV,
+  SEG_WK_STRINGINTERN,
+  SEG_WK_PREFERRED_LENGTH,
+  SEG_WK_INSTANCE_VARIABLES,
+};
@@ -1,5 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 
@@ -66,6 +68,70 @@ long seg_token_as_integer(seg_token *tok)
   return v;
 }
 
+/* Powers of ten that a double represents exactly. */
+static const double exact_powers_of_ten[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define EXACT_POWERS (sizeof(exact_powers_of_ten) / sizeof(exact_powers_of_ten[0]))
+
+double seg_token_as_float(seg_token *tok)
+{
+  const char *p = tok->start;
+  const char *end = tok->start + tok->length;
+  bool negative = false;
+
+  if (p < end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    p++;
+  }
+
+  uint64_t mantissa = 0;
+  int significant = 0;
+  size_t scale = 0;
+  bool fraction = false;
+
+  for (; p < end; p++) {
+    if (*p == '.') {
+      fraction = true;
+      continue;
+    }
+
+    if (mantissa != 0 || *p != '0') {
+      significant++;
+    }
+    if (significant <= 19) {
+      mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+    }
+    if (fraction) {
+      scale++;
+    }
+  }
+
+  // When both the digits and the power of ten are exact doubles, a single division rounds
+  // correctly. Literals are nearly always this short.
+  if (significant <= 19 && mantissa <= (UINT64_C(1) << 53) && scale < EXACT_POWERS) {
+    double v = (double) mantissa / exact_powers_of_ten[scale];
+    return negative ? -v : v;
+  }
+
+  // Otherwise, strtod() needs a terminated copy. The lexer accepts nothing it would read
+  // differently.
+  char *copy = malloc(tok->length + 1);
+  memcpy(copy, tok->start, tok->length);
+  copy[tok->length] = '\0';
+
+  errno = 0;
+  double v = strtod(copy, NULL);
+  if (errno) {
+    perror("Unable to parse token as float");
+  }
+
+  free(copy);
+  return v;
+}
+
 void seg_delete_token(seg_token *tok)
 {
   free(tok);
@@ -44,6 +44,11 @@ char *seg_token_without(seg_token *tok, size_t initial, size_t final, size_t *le
  */
 long seg_token_as_integer(seg_token *tok);
 
+/*
+ * Interpret this token as a float, rounded to the nearest double.
+ */
+double seg_token_as_float(seg_token *tok);
+
 /*
  * Destroy a token allocated by seg_new_token.
  */
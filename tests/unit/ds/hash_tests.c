@@ -0,0 +1,85 @@
+#include <CUnit/CUnit.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unit.h"
+#include "ds/hash.h"
+#include "ds/murmur.h"
+
+static void test_murmur3(void)
+{
+  /* Reference values from the canonical MurmurHash3_x86_32. */
+  CU_ASSERT_EQUAL(murmur3_32("", 0, 0), 0);
+  CU_ASSERT_EQUAL(murmur3_32("hello", 5, 0), 0x248bfa47);
+  CU_ASSERT_EQUAL(
+    murmur3_32("The quick brown fox jumps over the lazy dog", 43, 0x9747b28c),
+    0x2fa826cd
+  );
+
+  /* Unaligned keys hash the same as aligned ones. */
+  char buffer[16] = "xhello";
+  CU_ASSERT_EQUAL(murmur3_32(buffer + 1, 5, 0), 0x248bfa47);
+}
+
+static void test_crc32c(void)
+{
+  /* The standard CRC32C check value. */
+  CU_ASSERT_EQUAL(seg_hash_crc32c("123456789", 9, 0), 0xe3069283);
+  CU_ASSERT_EQUAL(seg_hash_crc32c("", 0, 0), 0);
+
+  /* Words and trailing bytes are combined identically. */
+  const char *text = "The quick brown fox jumps over the lazy dog";
+  uint32_t whole = seg_hash_crc32c(text, 43, 0);
+  CU_ASSERT_EQUAL(whole, 0x22620404);
+}
+
+static void test_wide(void)
+{
+  char key[128];
+  for (size_t i = 0; i < sizeof(key); i++) {
+    key[i] = (char) (i * 7);
+  }
+
+  /* Every key length is deterministic, seed-sensitive, and sensitive to its final byte. */
+  for (size_t length = 0; length <= sizeof(key); length++) {
+    uint64_t h0 = seg_hash_wide(key, length, 1);
+    CU_ASSERT_EQUAL(seg_hash_wide(key, length, 1), h0);
+    CU_ASSERT_NOT_EQUAL(seg_hash_wide(key, length, 2), h0);
+
+    if (length > 0) {
+      key[length - 1] ^= 1;
+      CU_ASSERT_NOT_EQUAL(seg_hash_wide(key, length, 1), h0);
+      key[length - 1] ^= 1;
+
+      /* Distinct lengths over the same bytes produce distinct hashes. */
+      CU_ASSERT_NOT_EQUAL(seg_hash_wide(key, length - 1, 1), h0);
+    }
+  }
+}
+
+static void test_names(void)
+{
+  seg_hash_algorithm algorithm;
+
+  for (int i = SEG_HASH_MURMUR3; i <= SEG_HASH_CRC32C; i++) {
+    CU_ASSERT_TRUE(seg_hash_parse(seg_hash_name((seg_hash_algorithm) i), &algorithm));
+    CU_ASSERT_EQUAL(algorithm, i);
+  }
+
+  CU_ASSERT_FALSE(seg_hash_parse("md5", &algorithm));
+}
+
+CU_pSuite initialize_hash_suite(void)
+{
+  CU_pSuite pSuite = CU_add_suite("hash", NULL, NULL);
+  if (pSuite == NULL) {
+    return NULL;
+  }
+
+  ADD_TEST(test_murmur3);
+  ADD_TEST(test_crc32c);
+  ADD_TEST(test_wide);
+  ADD_TEST(test_names);
+
+  return pSuite;
+}
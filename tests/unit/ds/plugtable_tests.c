@@ -5,6 +5,7 @@
 
 #include "unit.h"
 #include "ds/plugtable.h"
+#include "ds/small.h"
 
 typedef struct {
   int32_t aaa;
@@ -220,6 +221,412 @@ static void test_resize(void)
   seg_delete_plugtable(table);
 }
 
+static seg_err counting_iterator(const void *k, void *value, void *state)
+{
+  int *count = (int *) state;
+  (*count)++;
+  return SEG_OK;
+}
+
+static void test_incremental_resize(void)
+{
+  seg_err err;
+  void *out;
+  key keys[500];
+
+  seg_plugtable *table;
+  err = seg_new_plugtable(4L, equals0, hash0, &table);
+  SEG_ASSERT_OK(err);
+
+  seg_plugtable_get_settings(table)->incremental_resize_step = 1;
+
+  for (int i = 0; i < 500; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = -i;
+
+    err = seg_plugtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+
+    /* Every entry remains reachable while buckets are migrated. */
+    for (int j = 0; j <= i; j++) {
+      CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[j]), &keys[j]);
+    }
+  }
+
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 500);
+
+  int visited = 0;
+  err = seg_plugtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, 500);
+
+  err = seg_plugtable_resize(table, 2000L);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_plugtable_capacity(table), 2000);
+  CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[123]), &keys[123]);
+
+  seg_delete_plugtable(table);
+}
+
+static void test_remove(void)
+{
+  seg_err err;
+  void *out;
+  key keys[1000];
+
+  seg_plugtable *table;
+  err = seg_new_plugtable(16L, equals0, hash0, &table);
+  SEG_ASSERT_OK(err);
+
+  seg_plugtable_get_settings(table)->incremental_resize_step = 2;
+
+  for (int i = 0; i < 1000; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+
+    err = seg_plugtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  uint64_t grown = seg_plugtable_capacity(table);
+  CU_ASSERT(grown > 16);
+
+  /* Removing an absent key does nothing. */
+  key absent = {5000, 5000};
+  err = seg_plugtable_remove(table, &absent, &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_NULL(out);
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 1000);
+
+  /* Remove all but every hundredth key. The table shrinks as it empties. */
+  for (int i = 0; i < 1000; i++) {
+    if (i % 100 == 0) {
+      continue;
+    }
+
+    err = seg_plugtable_remove(table, &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_EQUAL(out, &keys[i]);
+  }
+
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 10);
+  CU_ASSERT(seg_plugtable_capacity(table) < grown);
+  CU_ASSERT(seg_plugtable_capacity(table) >= 16);
+
+  for (int i = 0; i < 1000; i++) {
+    void *expected = i % 100 == 0 ? &keys[i] : NULL;
+    CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[i]), expected);
+  }
+
+  int visited = 0;
+  err = seg_plugtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, 10);
+
+  /* Removed keys may be stored again. */
+  err = seg_plugtable_putifabsent(table, &keys[1], "again", &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_STRING_EQUAL(out, "again");
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 11);
+
+  seg_delete_plugtable(table);
+}
+
+static void test_many(void)
+{
+  seg_err err;
+  key keys[100];
+  const void *keyptrs[101];
+  void *values[100];
+  void *out[101];
+
+  seg_plugtable *table;
+  err = seg_new_plugtable(4L, equals0, hash0, &table);
+  SEG_ASSERT_OK(err);
+
+  for (int i = 0; i < 100; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+    keyptrs[i] = &keys[i];
+    values[i] = &keys[i];
+  }
+
+  /* A count that isn't a multiple of the batch size. The table resizes partway through. */
+  err = seg_plugtable_put_many(table, keyptrs, values, 37, out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 37);
+  for (int i = 0; i < 37; i++) {
+    CU_ASSERT_PTR_NULL(out[i]);
+  }
+
+  /* Replacing existing keys reports the values they held. */
+  err = seg_plugtable_put_many(table, keyptrs, values, 100, out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 100);
+  for (int i = 0; i < 100; i++) {
+    void *expected = i < 37 ? &keys[i] : NULL;
+    CU_ASSERT_PTR_EQUAL(out[i], expected);
+  }
+
+  key absent = {5000, 5000};
+  keyptrs[100] = &absent;
+
+  seg_plugtable_get_many(table, keyptrs, 101, out);
+  for (int i = 0; i < 100; i++) {
+    CU_ASSERT_PTR_EQUAL(out[i], &keys[i]);
+    CU_ASSERT_PTR_EQUAL(out[i], seg_plugtable_get(table, &keys[i]));
+  }
+  CU_ASSERT_PTR_NULL(out[100]);
+
+  seg_delete_plugtable(table);
+}
+
+typedef struct {
+  int32_t expected[100];
+  int visited;
+  bool in_order;
+} order_state;
+
+static seg_err order_iterator(const void *k, void *value, void *state)
+{
+  key *thekey = (key *) k;
+  order_state *s = (order_state *) state;
+
+  if (s->visited >= 100 || s->expected[s->visited] != thekey->aaa || value != k) {
+    s->in_order = false;
+  }
+  s->visited++;
+  return SEG_OK;
+}
+
+static void test_ordered(void)
+{
+  seg_err err;
+  void *out;
+  key keys[100];
+  order_state state;
+
+  seg_plugtable *table;
+  err = seg_new_plugtable_layout(4L, SEG_PLUGTABLE_ORDERED, equals0, hash0, &table);
+  SEG_ASSERT_OK(err);
+
+  /* Insert in a scrambled order, growing the table several times. */
+  for (int i = 0; i < 100; i++) {
+    int n = (i * 37) % 100;
+    keys[n].aaa = n;
+    keys[n].bbb = n;
+    state.expected[i] = n;
+
+    err = seg_plugtable_put(table, &keys[n], &keys[n], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+  }
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 100);
+
+  /* Replacing a value doesn't move its key. */
+  err = seg_plugtable_put(table, &keys[37], &keys[37], &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_EQUAL(out, &keys[37]);
+
+  state.visited = 0;
+  state.in_order = true;
+  err = seg_plugtable_each(table, &order_iterator, &state);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(state.visited, 100);
+  CU_ASSERT(state.in_order);
+
+  /* Remove every other key in insertion order, then put the first back. It moves to the end. */
+  int expected = 0;
+  for (int i = 0; i < 100; i++) {
+    int n = (i * 37) % 100;
+    if (i % 2 == 0) {
+      err = seg_plugtable_remove(table, &keys[n], &out);
+      SEG_ASSERT_OK(err);
+      CU_ASSERT_PTR_EQUAL(out, &keys[n]);
+    } else {
+      state.expected[expected++] = n;
+    }
+  }
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 50);
+  CU_ASSERT_PTR_NULL(seg_plugtable_get(table, &keys[0]));
+
+  err = seg_plugtable_putifabsent(table, &keys[0], &keys[0], &out);
+  SEG_ASSERT_OK(err);
+  state.expected[expected++] = 0;
+
+  state.visited = 0;
+  state.in_order = true;
+  err = seg_plugtable_each(table, &order_iterator, &state);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(state.visited, 51);
+  CU_ASSERT(state.in_order);
+
+  /* Compaction clears tombstones without disturbing the order. */
+  err = seg_plugtable_compact(table);
+  SEG_ASSERT_OK(err);
+
+  seg_hashtable_stats stats;
+  seg_plugtable_stats(table, &stats);
+  CU_ASSERT_EQUAL(stats.count, 51);
+  CU_ASSERT_EQUAL(stats.tombstones, 0);
+  CU_ASSERT_EQUAL(stats.slots - stats.empty_slots, 51);
+
+  state.visited = 0;
+  state.in_order = true;
+  err = seg_plugtable_each(table, &order_iterator, &state);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(state.visited, 51);
+  CU_ASSERT(state.in_order);
+
+  for (int i = 0; i < expected; i++) {
+    int n = state.expected[i];
+    CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[n]), &keys[n]);
+  }
+
+  seg_delete_plugtable(table);
+}
+
+static void test_ordered_large(void)
+{
+  seg_err err;
+  void *out;
+  static key keys[40000];
+
+  seg_plugtable *table;
+  err = seg_new_plugtable_layout(2L, SEG_PLUGTABLE_ORDERED, equals0, hash0, &table);
+  SEG_ASSERT_OK(err);
+
+  /* Enough entries to widen the index through one, two and four byte elements. */
+  for (int i = 0; i < 40000; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+
+    err = seg_plugtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  for (int i = 0; i < 40000; i++) {
+    CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[i]), &keys[i]);
+  }
+  uint64_t grown = seg_plugtable_capacity(table);
+
+  /* Shrinks as it empties. */
+  for (int i = 10; i < 40000; i++) {
+    err = seg_plugtable_remove(table, &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_EQUAL(out, &keys[i]);
+  }
+
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 10);
+  CU_ASSERT(seg_plugtable_capacity(table) < grown);
+
+  const void *keyptrs[11];
+  void *values[11];
+  for (int i = 0; i < 11; i++) {
+    keyptrs[i] = &keys[i];
+  }
+  seg_plugtable_get_many(table, keyptrs, 11, values);
+  for (int i = 0; i < 10; i++) {
+    CU_ASSERT_PTR_EQUAL(values[i], &keys[i]);
+  }
+  CU_ASSERT_PTR_NULL(values[10]);
+
+  seg_delete_plugtable(table);
+}
+
+/* Collide every even key with every other, so that inline lookups see several matching hashes. */
+static uint32_t hash_parity(const void *k)
+{
+  key *casted = (key*) k;
+
+  return (uint32_t) casted->aaa % 2;
+}
+
+static void test_small(void)
+{
+  seg_err err;
+  void *out;
+  key keys[40];
+  order_state state;
+
+  seg_plugtable *table;
+  err = seg_new_plugtable_layout(0L, SEG_PLUGTABLE_ORDERED, equals0, hash_parity, &table);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_plugtable_capacity(table), SEG_SMALL_CAPACITY);
+
+  for (int i = 0; i < 40; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+  }
+
+  for (int i = 0; i < SEG_SMALL_CAPACITY; i++) {
+    err = seg_plugtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+  }
+
+  for (int i = 0; i < SEG_SMALL_CAPACITY; i++) {
+    CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[i]), &keys[i]);
+  }
+  CU_ASSERT_PTR_NULL(seg_plugtable_get(table, &keys[SEG_SMALL_CAPACITY]));
+
+  /* Full, but still inline. */
+  seg_hashtable_stats stats;
+  seg_plugtable_stats(table, &stats);
+  CU_ASSERT_EQUAL(stats.count, SEG_SMALL_CAPACITY);
+  CU_ASSERT_EQUAL(stats.capacity, SEG_SMALL_CAPACITY);
+  CU_ASSERT_EQUAL(stats.counters.resizes, 0);
+
+  /* Removing from the middle keeps the others in order. */
+  err = seg_plugtable_remove(table, &keys[2], &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_EQUAL(out, &keys[2]);
+  CU_ASSERT_PTR_NULL(seg_plugtable_get(table, &keys[2]));
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), SEG_SMALL_CAPACITY - 1);
+
+  err = seg_plugtable_putifabsent(table, &keys[2], &keys[2], &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_EQUAL(out, &keys[2]);
+
+  /* Overflowing moves every entry into ordered storage without disturbing the order. */
+  for (int i = SEG_SMALL_CAPACITY; i < 40; i++) {
+    err = seg_plugtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+  }
+  CU_ASSERT_EQUAL(seg_plugtable_count(table), 40);
+  CU_ASSERT(seg_plugtable_capacity(table) > SEG_SMALL_CAPACITY);
+
+  int expected = 0;
+  for (int i = 0; i < 40; i++) {
+    if (i != 2) {
+      state.expected[expected++] = i;
+    }
+    if (i == SEG_SMALL_CAPACITY - 1) {
+      state.expected[expected++] = 2;
+    }
+  }
+
+  state.visited = 0;
+  state.in_order = true;
+  err = seg_plugtable_each(table, &order_iterator, &state);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(state.visited, 40);
+  CU_ASSERT(state.in_order);
+
+  /* Lookups made while the table was small still count. */
+  seg_plugtable_stats(table, &stats);
+  CU_ASSERT(stats.counters.resizes >= 1);
+  CU_ASSERT(stats.counters.hits >= SEG_SMALL_CAPACITY);
+
+  for (int i = 0; i < 40; i++) {
+    CU_ASSERT_PTR_EQUAL(seg_plugtable_get(table, &keys[i]), &keys[i]);
+  }
+
+  seg_delete_plugtable(table);
+}
+
 CU_pSuite initialize_plugtable_suite(void)
 {
   CU_pSuite pSuite = CU_add_suite("plugtable", NULL, NULL);
@@ -231,6 +638,12 @@ CU_pSuite initialize_plugtable_suite(void)
   ADD_TEST(test_putifabsent);
   ADD_TEST(test_each);
   ADD_TEST(test_resize);
+  ADD_TEST(test_incremental_resize);
+  ADD_TEST(test_remove);
+  ADD_TEST(test_many);
+  ADD_TEST(test_ordered);
+  ADD_TEST(test_ordered_large);
+  ADD_TEST(test_small);
 
   return pSuite;
 }
@@ -4,6 +4,7 @@
 
 #include "unit.h"
 #include "ds/ptrtable.h"
+#include "ds/small.h"
 
 typedef struct {
   int32_t aaa;
@@ -207,6 +208,478 @@ static void test_resize(void)
   seg_delete_ptrtable(table);
 }
 
+static seg_err counting_iterator(const void *k, void *value, void *state)
+{
+  int *count = (int *) state;
+  (*count)++;
+  return SEG_OK;
+}
+
+static void test_incremental_resize(void)
+{
+  seg_err err;
+  void *out;
+  key keys[500];
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(4L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+
+  seg_ptrtable_get_settings(table)->incremental_resize_step = 1;
+
+  for (int i = 0; i < 500; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = -i;
+
+    err = seg_ptrtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+
+    /* Every entry remains reachable while buckets are migrated. */
+    for (int j = 0; j <= i; j++) {
+      CU_ASSERT_PTR_EQUAL(seg_ptrtable_get(table, &keys[j]), &keys[j]);
+    }
+  }
+
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 500);
+
+  int visited = 0;
+  err = seg_ptrtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, 500);
+
+  err = seg_ptrtable_resize(table, 2000L);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_capacity(table), 2000);
+  CU_ASSERT_PTR_EQUAL(seg_ptrtable_get(table, &keys[123]), &keys[123]);
+
+  seg_delete_ptrtable(table);
+}
+
+static void test_migration_failure(void)
+{
+  seg_err err;
+  void *out;
+  key keys[500];
+  int seen[500] = { 0 };
+  seg_hashtable_stats stats;
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(4L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+
+  /* Long buckets make it likely that a bucket's entries are bound for several others. */
+  seg_ptrtable_get_settings(table)->incremental_resize_step = 1;
+  seg_ptrtable_get_settings(table)->max_load = 4;
+
+  /*
+   * Stop inserting shortly after a resize begins, once some of the new buckets have been filled
+   * but most of the old ones have yet to be migrated.
+   */
+  int n = 0;
+  int after_resize = -1;
+  uint64_t resizes = 0;
+  while (n < 500 && after_resize != 0) {
+    keys[n].aaa = n;
+    keys[n].bbb = n;
+
+    err = seg_ptrtable_put(table, &keys[n], &seen[n], &out);
+    SEG_ASSERT_OK(err);
+    n++;
+
+    seg_ptrtable_stats(table, &stats);
+    if (after_resize > 0) {
+      after_resize--;
+    } else if (stats.counters.resizes > resizes && n >= 100) {
+      after_resize = (int) (stats.capacity / 4);
+    }
+    resizes = stats.counters.resizes;
+  }
+
+  /*
+   * Try to migrate each remaining bucket while no allocation can succeed, then let it finish. A
+   * bucket whose entries are bound for a mix of existing and missing buckets fails partway through.
+   */
+  key absent = {5000, 5000};
+  int failures = 0;
+  for (int i = 0; i < 256; i++) {
+    seg_test_fail_allocations(true);
+    if (seg_ptrtable_remove(table, &absent, &out) != SEG_OK) {
+      failures++;
+    }
+    seg_test_fail_allocations(false);
+
+    err = seg_ptrtable_remove(table, &absent, &out);
+    SEG_ASSERT_OK(err);
+  }
+  CU_ASSERT(failures > 0);
+
+  /* Retrying finishes the migration without moving any entry twice. */
+  err = seg_ptrtable_resize(table, seg_ptrtable_capacity(table));
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), (uint64_t) n);
+
+  seg_hashtable_cursor c;
+  for (seg_ptrtable_begin(table, &c); ! seg_hashtable_done(&c); seg_ptrtable_next(table, &c)) {
+    (*(int *) c.value)++;
+  }
+  for (int i = 0; i < n; i++) {
+    CU_ASSERT_EQUAL(seen[i], 1);
+  }
+
+  /* Removed keys stay removed. */
+  for (int i = 0; i < n; i++) {
+    err = seg_ptrtable_remove(table, &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_EQUAL(out, &seen[i]);
+    CU_ASSERT_PTR_NULL(seg_ptrtable_get(table, &keys[i]));
+  }
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 0);
+
+  seg_delete_ptrtable(table);
+}
+
+static void test_key_strategies(void)
+{
+  seg_err err;
+  void *out;
+
+  seg_ptrtable *bytes;
+  err = seg_new_ptrtable_keyed(
+    10L, sizeof(key), SEG_PTRTABLE_KEYS_BYTES, SEG_HASH_MURMUR3, &bytes
+  );
+  SEG_ASSERT_OK(err);
+
+  seg_ptrtable *identity;
+  err = seg_new_ptrtable_keyed(
+    10L, 0L, SEG_PTRTABLE_KEYS_IDENTITY, SEG_HASH_DEFAULT, &identity
+  );
+  SEG_ASSERT_OK(err);
+
+  key k0 = {12, 34};
+  key k1 = {12, 34};
+
+  err = seg_ptrtable_put(bytes, &k0, "bytes", &out);
+  SEG_ASSERT_OK(err);
+  err = seg_ptrtable_put(identity, &k0, "identity", &out);
+  SEG_ASSERT_OK(err);
+
+  /* Byte-keyed tables compare key contents. Identity-keyed tables compare addresses. */
+  CU_ASSERT_STRING_EQUAL(seg_ptrtable_get(bytes, &k1), "bytes");
+  CU_ASSERT_STRING_EQUAL(seg_ptrtable_get(identity, &k0), "identity");
+  CU_ASSERT_PTR_NULL(seg_ptrtable_get(identity, &k1));
+
+  seg_delete_ptrtable(bytes);
+  seg_delete_ptrtable(identity);
+
+  seg_ptrtable *invalid;
+  err = seg_new_ptrtable_keyed(10L, 4L, SEG_PTRTABLE_KEYS_WORD, SEG_HASH_DEFAULT, &invalid);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_INVAL);
+}
+
+static void test_remove(void)
+{
+  seg_err err;
+  void *out;
+  key keys[1000];
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(16L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+
+  seg_ptrtable_get_settings(table)->incremental_resize_step = 2;
+
+  for (int i = 0; i < 1000; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+
+    err = seg_ptrtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  uint64_t grown = seg_ptrtable_capacity(table);
+  CU_ASSERT(grown > 16);
+
+  /* Removing an absent key does nothing. */
+  key absent = {5000, 5000};
+  err = seg_ptrtable_remove(table, &absent, &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_NULL(out);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 1000);
+
+  /* Remove all but every hundredth key. The table shrinks as it empties. */
+  for (int i = 0; i < 1000; i++) {
+    if (i % 100 == 0) {
+      continue;
+    }
+
+    err = seg_ptrtable_remove(table, &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_EQUAL(out, &keys[i]);
+  }
+
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 10);
+  CU_ASSERT(seg_ptrtable_capacity(table) < grown);
+  CU_ASSERT(seg_ptrtable_capacity(table) >= 16);
+
+  for (int i = 0; i < 1000; i++) {
+    void *expected = i % 100 == 0 ? &keys[i] : NULL;
+    CU_ASSERT_PTR_EQUAL(seg_ptrtable_get(table, &keys[i]), expected);
+  }
+
+  int visited = 0;
+  err = seg_ptrtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, 10);
+
+  /* Removed keys may be stored again. */
+  err = seg_ptrtable_putifabsent(table, &keys[1], "again", &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_STRING_EQUAL(out, "again");
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 11);
+
+  seg_delete_ptrtable(table);
+}
+
+static void test_stats(void)
+{
+  seg_err err;
+  void *out;
+  key keys[100];
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(16L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+
+  for (int i = 0; i < 100; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+
+    err = seg_ptrtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  for (int i = 0; i < 100; i++) {
+    CU_ASSERT_PTR_EQUAL(seg_ptrtable_get(table, &keys[i]), &keys[i]);
+  }
+
+  key absent = {5000, 5000};
+  CU_ASSERT_PTR_NULL(seg_ptrtable_get(table, &absent));
+
+  seg_hashtable_stats stats;
+  seg_ptrtable_stats(table, &stats);
+
+  CU_ASSERT_EQUAL(stats.count, 100);
+  CU_ASSERT_EQUAL(stats.capacity, seg_ptrtable_capacity(table));
+  CU_ASSERT_EQUAL(stats.slots, stats.capacity);
+  CU_ASSERT(stats.bytes > stats.slots * sizeof(void *));
+
+  /* Every bucket is accounted for, and their lengths sum to the count. */
+  uint64_t buckets = 0, entries = 0;
+  for (int i = 0; i < SEG_HT_HISTOGRAM_BINS; i++) {
+    buckets += stats.histogram[i];
+    entries += stats.histogram[i] * i;
+  }
+  CU_ASSERT_EQUAL(buckets, stats.slots);
+  CU_ASSERT_EQUAL(stats.histogram[0], stats.empty_slots);
+  CU_ASSERT(entries <= 100);
+  CU_ASSERT(stats.max_length >= 1);
+
+  /* Each put looked its key up first: 100 misses during insertion, then 100 hits and one miss. */
+  CU_ASSERT_EQUAL(stats.counters.hits, 100);
+  CU_ASSERT_EQUAL(stats.counters.misses, 101);
+  CU_ASSERT(stats.counters.hit_probes >= 100);
+  CU_ASSERT(stats.counters.resizes >= 1);
+
+  seg_delete_ptrtable(table);
+}
+
+static void test_many(void)
+{
+  seg_err err;
+  key keys[100];
+  const void *keyptrs[101];
+  void *values[100];
+  void *out[101];
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(4L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+
+  for (int i = 0; i < 100; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+    keyptrs[i] = &keys[i];
+    values[i] = &keys[i];
+  }
+
+  /* A count that isn't a multiple of the batch size. The table resizes partway through. */
+  err = seg_ptrtable_put_many(table, keyptrs, values, 37, out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 37);
+  for (int i = 0; i < 37; i++) {
+    CU_ASSERT_PTR_NULL(out[i]);
+  }
+
+  /* Replacing existing keys reports the values they held. */
+  err = seg_ptrtable_put_many(table, keyptrs, values, 100, out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 100);
+  for (int i = 0; i < 100; i++) {
+    void *expected = i < 37 ? &keys[i] : NULL;
+    CU_ASSERT_PTR_EQUAL(out[i], expected);
+  }
+
+  key absent = {5000, 5000};
+  keyptrs[100] = &absent;
+
+  seg_ptrtable_get_many(table, keyptrs, 101, out);
+  for (int i = 0; i < 100; i++) {
+    CU_ASSERT_PTR_EQUAL(out[i], &keys[i]);
+    CU_ASSERT_PTR_EQUAL(out[i], seg_ptrtable_get(table, &keys[i]));
+  }
+  CU_ASSERT_PTR_NULL(out[100]);
+
+  seg_delete_ptrtable(table);
+}
+
+static void test_small(void)
+{
+  seg_err err;
+  void *out;
+  key keys[100];
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(0L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_capacity(table), SEG_SMALL_CAPACITY);
+
+  for (int i = 0; i < 100; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = -i;
+  }
+
+  for (int i = 0; i < SEG_SMALL_CAPACITY; i++) {
+    err = seg_ptrtable_put(table, &keys[i], &keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+  }
+
+  /* Keys are compared by content, not by address. */
+  key copy = keys[3];
+  CU_ASSERT_PTR_EQUAL(seg_ptrtable_get(table, &copy), &keys[3]);
+  CU_ASSERT_PTR_NULL(seg_ptrtable_get(table, &keys[SEG_SMALL_CAPACITY]));
+
+  err = seg_ptrtable_put(table, &copy, "replaced", &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_EQUAL(out, &keys[3]);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), SEG_SMALL_CAPACITY);
+
+  err = seg_ptrtable_remove(table, &keys[0], &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_EQUAL(out, &keys[0]);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), SEG_SMALL_CAPACITY - 1);
+
+  int visited = 0;
+  err = seg_ptrtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, SEG_SMALL_CAPACITY - 1);
+
+  /* Still inline: it owns nothing beyond itself. */
+  seg_hashtable_stats small_stats;
+  seg_ptrtable_stats(table, &small_stats);
+  CU_ASSERT_EQUAL(small_stats.capacity, SEG_SMALL_CAPACITY);
+  CU_ASSERT_EQUAL(small_stats.empty_slots, 1);
+
+  /* Overflowing promotes it to buckets. */
+  const void *keyptrs[100];
+  void *values[100];
+  void *outs[100];
+  for (int i = 0; i < 100; i++) {
+    keyptrs[i] = &keys[i];
+    values[i] = &keys[i];
+  }
+
+  err = seg_ptrtable_put_many(table, keyptrs, values, 100, outs);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_count(table), 100);
+  CU_ASSERT_STRING_EQUAL(outs[3], "replaced");
+  CU_ASSERT(seg_ptrtable_capacity(table) > SEG_SMALL_CAPACITY);
+
+  seg_ptrtable_get_many(table, keyptrs, 100, outs);
+  for (int i = 0; i < 100; i++) {
+    CU_ASSERT_PTR_EQUAL(outs[i], &keys[i]);
+  }
+
+  seg_hashtable_stats stats;
+  seg_ptrtable_stats(table, &stats);
+  CU_ASSERT(stats.counters.resizes >= 1);
+  CU_ASSERT(stats.counters.hits > small_stats.counters.hits);
+  CU_ASSERT(stats.bytes > small_stats.bytes);
+
+  seg_delete_ptrtable(table);
+
+  /* An explicit resize promotes a small table too. */
+  err = seg_new_ptrtable_keyed(0L, 0L, SEG_PTRTABLE_KEYS_IDENTITY, SEG_HASH_DEFAULT, &table);
+  SEG_ASSERT_OK(err);
+
+  err = seg_ptrtable_put(table, &keys[0], &keys[1], &out);
+  SEG_ASSERT_OK(err);
+
+  err = seg_ptrtable_resize(table, 50L);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_ptrtable_capacity(table), 50);
+  CU_ASSERT_PTR_EQUAL(seg_ptrtable_get(table, &keys[0]), &keys[1]);
+  CU_ASSERT_PTR_NULL(seg_ptrtable_get(table, &copy));
+
+  seg_delete_ptrtable(table);
+}
+
+static void test_cursor(void)
+{
+  seg_err err;
+  void *out;
+  key keys[200];
+  int seen[200] = { 0 };
+
+  seg_ptrtable *table;
+  err = seg_new_ptrtable(4L, sizeof(key), &table);
+  SEG_ASSERT_OK(err);
+
+  seg_hashtable_cursor c;
+  seg_ptrtable_begin(table, &c);
+  CU_ASSERT_TRUE(seg_hashtable_done(&c));
+
+  /* Leave a migration in progress. */
+  seg_ptrtable_get_settings(table)->incremental_resize_step = 1;
+
+  for (int i = 0; i < 200; i++) {
+    keys[i].aaa = i;
+    keys[i].bbb = i;
+
+    err = seg_ptrtable_put(table, &keys[i], &seen[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  int visited = 0;
+  for (seg_ptrtable_begin(table, &c); ! seg_hashtable_done(&c); seg_ptrtable_next(table, &c)) {
+    int *mark = c.value;
+    const key *k = c.key;
+
+    CU_ASSERT_EQUAL(k->aaa, (int) (mark - seen));
+    (*mark)++;
+    visited++;
+  }
+  CU_ASSERT_EQUAL(visited, 200);
+
+  for (int i = 0; i < 200; i++) {
+    CU_ASSERT_EQUAL(seen[i], 1);
+  }
+
+  seg_delete_ptrtable(table);
+}
+
 CU_pSuite initialize_ptrtable_suite(void)
 {
   CU_pSuite pSuite = CU_add_suite("ptrtable", NULL, NULL);
@@ -218,6 +691,14 @@ CU_pSuite initialize_ptrtable_suite(void)
   ADD_TEST(test_putifabsent);
   ADD_TEST(test_each);
   ADD_TEST(test_resize);
+  ADD_TEST(test_incremental_resize);
+  ADD_TEST(test_migration_failure);
+  ADD_TEST(test_remove);
+  ADD_TEST(test_key_strategies);
+  ADD_TEST(test_stats);
+  ADD_TEST(test_many);
+  ADD_TEST(test_small);
+  ADD_TEST(test_cursor);
 
   return pSuite;
 }
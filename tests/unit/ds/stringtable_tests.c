@@ -193,6 +193,317 @@ static void test_resize(void)
   seg_delete_stringtable(table);
 }
 
+static void test_owned_keys(void)
+{
+  seg_err err;
+  void *out;
+  char buffer[16];
+
+  seg_stringtable *table;
+  err = seg_new_stringtable(10L, &table);
+  SEG_ASSERT_OK(err);
+
+  strcpy(buffer, "transient");
+  err = seg_stringtable_put(table, buffer, strlen(buffer), "value", &out);
+  SEG_ASSERT_OK(err);
+
+  /* The table doesn't retain the caller's buffer. */
+  memset(buffer, 'x', sizeof(buffer));
+
+  void *found = seg_stringtable_get(table, "transient", 9);
+  CU_ASSERT_PTR_NOT_NULL(found);
+  CU_ASSERT_STRING_EQUAL(found, "value");
+
+  seg_delete_stringtable(table);
+}
+
+static void check_many(seg_hash_algorithm hash)
+{
+  seg_err err;
+  void *out;
+  char keys[2000][16];
+
+  seg_stringtable *table;
+  err = seg_new_stringtable_hashed(4L, hash, &table);
+  SEG_ASSERT_OK(err);
+
+  for (int i = 0; i < 2000; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+
+    err = seg_stringtable_put(table, keys[i], strlen(keys[i]), keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+  }
+
+  CU_ASSERT_EQUAL(seg_stringtable_count(table), 2000);
+
+  for (int i = 0; i < 2000; i++) {
+    void *found = seg_stringtable_get(table, keys[i], strlen(keys[i]));
+    CU_ASSERT_PTR_EQUAL(found, keys[i]);
+  }
+
+  CU_ASSERT_PTR_NULL(seg_stringtable_get(table, "key2000", 7));
+  CU_ASSERT_PTR_NULL(seg_stringtable_get(table, "key", 3));
+
+  seg_delete_stringtable(table);
+}
+
+static void test_many(void)
+{
+  check_many(SEG_HASH_MURMUR3);
+  check_many(SEG_HASH_WIDE);
+  check_many(SEG_HASH_CRC32C);
+}
+
+static seg_err counting_iterator(const char *key, const uint64_t key_length, void *value, void *state)
+{
+  int *count = (int *) state;
+  (*count)++;
+  return SEG_OK;
+}
+
+static void test_incremental_resize(void)
+{
+  seg_err err;
+  void *out;
+  char keys[500][16];
+
+  seg_stringtable *table;
+  err = seg_new_stringtable(4L, &table);
+  SEG_ASSERT_OK(err);
+
+  seg_stringtable_get_settings(table)->incremental_resize_step = 1;
+
+  for (int i = 0; i < 500; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+
+    err = seg_stringtable_put(table, keys[i], strlen(keys[i]), keys[i], &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+
+    /* Every entry remains reachable while slots are migrated. */
+    for (int j = 0; j <= i; j++) {
+      CU_ASSERT_PTR_EQUAL(seg_stringtable_get(table, keys[j], strlen(keys[j])), keys[j]);
+    }
+  }
+
+  CU_ASSERT_EQUAL(seg_stringtable_count(table), 500);
+
+  int visited = 0;
+  err = seg_stringtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, 500);
+
+  err = seg_stringtable_resize(table, 2000L);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_stringtable_capacity(table), 2000);
+  CU_ASSERT_PTR_EQUAL(seg_stringtable_get(table, keys[123], strlen(keys[123])), keys[123]);
+
+  seg_delete_stringtable(table);
+}
+
+static void test_remove(void)
+{
+  seg_err err;
+  void *out;
+  char keys[1000][16];
+
+  seg_stringtable *table;
+  err = seg_new_stringtable(16L, &table);
+  SEG_ASSERT_OK(err);
+
+  seg_stringtable_get_settings(table)->incremental_resize_step = 2;
+
+  for (int i = 0; i < 1000; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+
+    err = seg_stringtable_put(table, keys[i], strlen(keys[i]), keys[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  uint64_t grown = seg_stringtable_capacity(table);
+
+  /* Removing an absent key does nothing. */
+  err = seg_stringtable_remove(table, "nope", 4, &out);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_PTR_NULL(out);
+  CU_ASSERT_EQUAL(seg_stringtable_count(table), 1000);
+
+  /* Remove all but every hundredth key. The table shrinks as it empties. */
+  for (int i = 0; i < 1000; i++) {
+    if (i % 100 == 0) {
+      continue;
+    }
+
+    err = seg_stringtable_remove(table, keys[i], strlen(keys[i]), &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_EQUAL(out, keys[i]);
+  }
+
+  CU_ASSERT_EQUAL(seg_stringtable_count(table), 10);
+  CU_ASSERT(seg_stringtable_capacity(table) < grown);
+  CU_ASSERT(seg_stringtable_capacity(table) >= 16);
+
+  for (int i = 0; i < 1000; i++) {
+    void *expected = i % 100 == 0 ? keys[i] : NULL;
+    CU_ASSERT_PTR_EQUAL(seg_stringtable_get(table, keys[i], strlen(keys[i])), expected);
+  }
+
+  int visited = 0;
+  err = seg_stringtable_each(table, &counting_iterator, &visited);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(visited, 10);
+
+  seg_delete_stringtable(table);
+}
+
+static void test_churn(void)
+{
+  seg_err err;
+  void *out;
+  char live[64][24];
+
+  seg_stringtable *table;
+  err = seg_new_stringtable(16L, &table);
+  SEG_ASSERT_OK(err);
+
+  for (int i = 0; i < 64; i++) {
+    snprintf(live[i], sizeof(live[i]), "churn%d", i);
+    err = seg_stringtable_put(table, live[i], strlen(live[i]), live[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  uint64_t steady = seg_stringtable_capacity(table);
+
+  /* Replace each live key with a new one, many times over. Tombstones must not accumulate. */
+  for (int i = 64; i < 20000; i++) {
+    char *slot = live[i % 64];
+
+    err = seg_stringtable_remove(table, slot, strlen(slot), &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_EQUAL(out, slot);
+
+    snprintf(slot, sizeof(live[0]), "churn%d", i);
+    err = seg_stringtable_put(table, slot, strlen(slot), slot, &out);
+    SEG_ASSERT_OK(err);
+    CU_ASSERT_PTR_NULL(out);
+  }
+
+  CU_ASSERT_EQUAL(seg_stringtable_count(table), 64);
+  CU_ASSERT_EQUAL(seg_stringtable_capacity(table), steady);
+
+  for (int i = 0; i < 64; i++) {
+    CU_ASSERT_PTR_EQUAL(seg_stringtable_get(table, live[i], strlen(live[i])), live[i]);
+  }
+  CU_ASSERT_PTR_NULL(seg_stringtable_get(table, "churn0", 6));
+
+  seg_delete_stringtable(table);
+}
+
+static void test_stats(void)
+{
+  seg_err err;
+  void *out;
+  char keys[100][8];
+
+  seg_stringtable *table;
+  err = seg_new_stringtable(16L, &table);
+  SEG_ASSERT_OK(err);
+
+  for (int i = 0; i < 100; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+
+    err = seg_stringtable_put(table, keys[i], strlen(keys[i]), keys[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  for (int i = 0; i < 100; i++) {
+    CU_ASSERT_PTR_EQUAL(seg_stringtable_get(table, keys[i], strlen(keys[i])), keys[i]);
+  }
+  CU_ASSERT_PTR_NULL(seg_stringtable_get(table, "absent", 6));
+
+  err = seg_stringtable_remove(table, keys[0], strlen(keys[0]), &out);
+  SEG_ASSERT_OK(err);
+
+  seg_hashtable_stats stats;
+  seg_stringtable_stats(table, &stats);
+
+  CU_ASSERT_EQUAL(stats.count, 99);
+  CU_ASSERT_EQUAL(stats.capacity, seg_stringtable_capacity(table));
+  CU_ASSERT(stats.slots >= 99);
+  CU_ASSERT_EQUAL(stats.slots - stats.empty_slots - stats.tombstones, 99);
+
+  /* Every live entry appears in the probe length histogram exactly once. */
+  uint64_t entries = 0;
+  for (int i = 0; i < SEG_HT_HISTOGRAM_BINS; i++) {
+    entries += stats.histogram[i];
+  }
+  CU_ASSERT_EQUAL(entries, 99);
+
+  /* 100 misses while inserting, 100 hits and a miss from gets, and a hit from the remove. */
+  CU_ASSERT_EQUAL(stats.counters.hits, 101);
+  CU_ASSERT_EQUAL(stats.counters.misses, 101);
+  CU_ASSERT(stats.counters.hit_probes >= 101);
+  CU_ASSERT(stats.counters.resizes >= 1);
+  CU_ASSERT(stats.bytes > stats.slots);
+
+  seg_delete_stringtable(table);
+}
+
+static void test_cursor(void)
+{
+  seg_err err;
+  void *out;
+  char keys[300][10];
+  bool seen[300] = { false };
+
+  seg_stringtable *table;
+  err = seg_new_stringtable(4L, &table);
+  SEG_ASSERT_OK(err);
+
+  /* Stop partway through a migration, so that the cursor walks both slot arrays. */
+  seg_stringtable_get_settings(table)->incremental_resize_step = 1;
+
+  for (int i = 0; i < 300; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+
+    err = seg_stringtable_put(table, keys[i], strlen(keys[i]), &seen[i], &out);
+    SEG_ASSERT_OK(err);
+  }
+
+  int visited = 0;
+  seg_hashtable_cursor c;
+  seg_stringtable_begin(table, &c);
+  for (; ! seg_hashtable_done(&c); seg_stringtable_next(table, &c)) {
+    bool *mark = c.value;
+
+    CU_ASSERT_FALSE(*mark);
+    *mark = true;
+
+    int i = (int) (mark - seen);
+    CU_ASSERT_EQUAL(c.key_length, strlen(keys[i]));
+    CU_ASSERT_NSTRING_EQUAL(c.key, keys[i], c.key_length);
+    visited++;
+  }
+  CU_ASSERT_EQUAL(visited, 300);
+
+  /* Cursors may be abandoned early. */
+  seg_stringtable_begin(table, &c);
+  CU_ASSERT_FALSE(seg_hashtable_done(&c));
+  seg_stringtable_next(table, &c);
+  CU_ASSERT_FALSE(seg_hashtable_done(&c));
+
+  seg_delete_stringtable(table);
+
+  err = seg_new_stringtable(100L, &table);
+  SEG_ASSERT_OK(err);
+
+  seg_stringtable_begin(table, &c);
+  CU_ASSERT_TRUE(seg_hashtable_done(&c));
+
+  seg_delete_stringtable(table);
+}
+
 CU_pSuite initialize_stringtable_suite(void)
 {
   CU_pSuite pSuite = CU_add_suite("stringtable", NULL, NULL);
@@ -204,6 +515,13 @@ CU_pSuite initialize_stringtable_suite(void)
   ADD_TEST(test_putifabsent);
   ADD_TEST(test_each);
   ADD_TEST(test_resize);
+  ADD_TEST(test_owned_keys);
+  ADD_TEST(test_many);
+  ADD_TEST(test_incremental_resize);
+  ADD_TEST(test_remove);
+  ADD_TEST(test_churn);
+  ADD_TEST(test_stats);
+  ADD_TEST(test_cursor);
 
   return pSuite;
 }
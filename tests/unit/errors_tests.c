@@ -0,0 +1,182 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <CUnit/CUnit.h>
+
+#include "unit.h"
+#include "errors.h"
+#include "model/object.h"
+#include "model/integer.h"
+#include "runtime/runtime.h"
+#include "runtime/symboltable.h"
+
+/*
+ * Count and fail allocations. The test suite is linked with `-Wl,--wrap` for malloc, calloc and
+ * realloc, which sends every call to them from segment's own objects here, and makes
+ * `__real_malloc` and friends the allocator itself. Only malloc is counted: nothing on an error
+ * path uses the others. Any of them can be made to fail.
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+static atomic_bool counting;
+static atomic_uint_fast64_t allocations;
+static atomic_bool failing;
+
+void *__wrap_malloc(size_t size)
+{
+  if (atomic_load_explicit(&failing, memory_order_relaxed)) {
+    return NULL;
+  }
+  if (atomic_load_explicit(&counting, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  }
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  if (atomic_load_explicit(&failing, memory_order_relaxed)) {
+    return NULL;
+  }
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+  if (atomic_load_explicit(&failing, memory_order_relaxed)) {
+    return NULL;
+  }
+  return __real_realloc(pointer, size);
+}
+
+void seg_test_fail_allocations(bool fail)
+{
+  atomic_store(&failing, fail);
+}
+
+static void start_counting(void)
+{
+  atomic_store(&allocations, 0);
+  atomic_store(&counting, true);
+}
+
+static uint64_t stop_counting(void)
+{
+  atomic_store(&counting, false);
+  return atomic_load(&allocations);
+}
+
+static seg_err fail_range(void)
+{
+  return SEG_RANGE("First site.");
+}
+
+static seg_err fail_range_elsewhere(void)
+{
+  return SEG_RANGE("Second site.");
+}
+
+static void test_descriptors(void)
+{
+  /* Each site has one descriptor, which every failure there returns. */
+  seg_err first = fail_range();
+  CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+  CU_ASSERT_PTR_EQUAL(fail_range(), first);
+  CU_ASSERT_EQUAL(first->code, SEG_CODE_RANGE);
+  CU_ASSERT_PTR_NOT_NULL(strstr(first->message, "errors_tests.c@L"));
+  CU_ASSERT_PTR_NOT_NULL(strstr(first->message, "RANGE First site."));
+
+  seg_err second = fail_range_elsewhere();
+  CU_ASSERT_PTR_NOT_EQUAL(second, first);
+  CU_ASSERT_EQUAL(second->code, SEG_CODE_RANGE);
+
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_object zero, one, two;
+  SEG_ASSERT_TRY(seg_integer(r, 0, &zero));
+  SEG_ASSERT_TRY(seg_integer(r, 1, &one));
+  SEG_ASSERT_TRY(seg_integer(r, 2, &two));
+
+  seg_err err = seg_integer_divmod(r, one, zero, NULL, NULL);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_PTR_EQUAL(seg_integer_divmod(r, two, zero, NULL, NULL), err);
+
+  seg_delete_runtime(r);
+}
+
+static void test_detail(void)
+{
+  seg_err first = fail_range();
+  seg_err second = fail_range_elsewhere();
+
+  CU_ASSERT_PTR_NULL(seg_err_detail(SEG_OK));
+
+  CU_ASSERT_PTR_EQUAL(seg_err_with_detail(first, "%s %d", "detail", 42), first);
+  CU_ASSERT_STRING_EQUAL(seg_err_detail(first), "detail 42");
+  CU_ASSERT_PTR_NULL(seg_err_detail(second));
+
+  /* Detail attached to another error replaces it. */
+  seg_err_with_detail(second, "other");
+  CU_ASSERT_PTR_NULL(seg_err_detail(first));
+  CU_ASSERT_STRING_EQUAL(seg_err_detail(second), "other");
+}
+
+static void test_failures_allocate_nothing(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  seg_object integer, zero, huge, symbol, loose, out;
+  int64_t value;
+  char *contents;
+  uint64_t length;
+  uint32_t id;
+  SEG_ASSERT_TRY(seg_integer(r, 7, &integer));
+  SEG_ASSERT_TRY(seg_integer(r, 0, &zero));
+  SEG_ASSERT_TRY(seg_integer(r, INT64_MAX, &huge));
+  SEG_ASSERT_TRY(seg_integer_add(r, huge, huge, &huge));
+  SEG_ASSERT_TRY(seg_symboltable_cintern(table, "sym", &symbol));
+  SEG_ASSERT_TRY(seg_symbol(r, "not_interned", 12, &loose));
+
+  /* Prove that the counter sees allocations at all. */
+  start_counting();
+  seg_object allocated;
+  SEG_ASSERT_TRY(seg_symbol(r, "counted_symbol", 14, &allocated));
+  CU_ASSERT_EQUAL(stop_counting(), 1);
+  seg_delete_symbol(r, allocated);
+
+  start_counting();
+  for (int i = 0; i < 1000; i++) {
+    CU_ASSERT_EQUAL(seg_integer_to_int64(r, huge, &value)->code, SEG_CODE_RANGE);
+    CU_ASSERT_EQUAL(seg_integer_divmod(r, huge, zero, &out, NULL)->code, SEG_CODE_RANGE);
+    CU_ASSERT_EQUAL(seg_integer_add(r, integer, symbol, &out)->code, SEG_CODE_TYPE);
+    CU_ASSERT_EQUAL(seg_integer_value(symbol, &value)->code, SEG_CODE_TYPE);
+    CU_ASSERT_EQUAL(seg_buffer_contents(&integer, &contents, &length)->code, SEG_CODE_TYPE);
+    CU_ASSERT_EQUAL(seg_slot_at(boots->class_class, 1000, &out)->code, SEG_CODE_RANGE);
+    CU_ASSERT_EQUAL(seg_symboltable_id(table, loose, &id)->code, SEG_CODE_INVAL);
+  }
+  CU_ASSERT_EQUAL(stop_counting(), 0);
+
+  seg_delete_symbol(r, loose);
+  seg_delete_runtime(r);
+}
+
+CU_pSuite initialize_errors_suite(void)
+{
+  CU_pSuite pSuite = CU_add_suite("errors", NULL, NULL);
+  if (pSuite == NULL) {
+    return NULL;
+  }
+
+  ADD_TEST(test_descriptors);
+  ADD_TEST(test_detail);
+  ADD_TEST(test_failures_allocate_nothing);
+
+  return pSuite;
+}
@@ -0,0 +1,306 @@
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unit.h"
+#include "errors.h"
+#include "model/object.h"
+#include "model/integer.h"
+#include "runtime/runtime.h"
+#include "runtime/gc.h"
+
+static void assert_decimal(seg_runtime *r, seg_object integer, const char *expected)
+{
+  seg_object string;
+  char *contents;
+  uint64_t length;
+
+  SEG_ASSERT_TRY(seg_integer_string(r, integer, &string));
+  SEG_ASSERT_TRY(seg_buffer_contents(&string, &contents, &length));
+  CU_ASSERT_EQUAL(length, strlen(expected));
+  CU_ASSERT_EQUAL(strncmp(contents, expected, length), 0);
+}
+
+static void assert_equal(seg_runtime *r, seg_object a, seg_object b)
+{
+  int comparison;
+
+  SEG_ASSERT_TRY(seg_integer_compare(r, a, b, &comparison));
+  CU_ASSERT_EQUAL(comparison, 0);
+}
+
+static void format_int128(__int128 value, char *out)
+{
+  char digits[48];
+  int n = 0;
+  unsigned __int128 magnitude = value < 0 ? -(unsigned __int128) value : (unsigned __int128) value;
+
+  do {
+    digits[n++] = (char) ('0' + (int) (magnitude % 10));
+    magnitude /= 10;
+  } while (magnitude > 0);
+
+  if (value < 0) {
+    *out++ = '-';
+  }
+  while (n > 0) {
+    *out++ = digits[--n];
+  }
+  *out = '\0';
+}
+
+static void assert_int128(seg_runtime *r, seg_object integer, __int128 expected)
+{
+  char decimal[48];
+
+  format_int128(expected, decimal);
+  assert_decimal(r, integer, decimal);
+}
+
+static void test_immediate_arithmetic(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_object a, b, out, q, m;
+  SEG_ASSERT_TRY(seg_integer(r, -7, &a));
+  SEG_ASSERT_TRY(seg_integer(r, 2, &b));
+
+  seg_memory_usage before;
+  seg_runtime_memory(r, &before);
+
+  int64_t v;
+  SEG_ASSERT_TRY(seg_integer_add(r, a, b, &out));
+  SEG_ASSERT_TRY(seg_integer_value(out, &v));
+  CU_ASSERT_EQUAL(v, -5);
+
+  SEG_ASSERT_TRY(seg_integer_sub(r, a, b, &out));
+  SEG_ASSERT_TRY(seg_integer_value(out, &v));
+  CU_ASSERT_EQUAL(v, -9);
+
+  SEG_ASSERT_TRY(seg_integer_mul(r, a, b, &out));
+  SEG_ASSERT_TRY(seg_integer_value(out, &v));
+  CU_ASSERT_EQUAL(v, -14);
+
+  /* Quotients round toward negative infinity, and remainders take the divisor's sign. */
+  SEG_ASSERT_TRY(seg_integer_divmod(r, a, b, &q, &m));
+  SEG_ASSERT_TRY(seg_integer_value(q, &v));
+  CU_ASSERT_EQUAL(v, -4);
+  SEG_ASSERT_TRY(seg_integer_value(m, &v));
+  CU_ASSERT_EQUAL(v, 1);
+
+  SEG_ASSERT_TRY(seg_integer(r, 7, &a));
+  SEG_ASSERT_TRY(seg_integer(r, -2, &b));
+  SEG_ASSERT_TRY(seg_integer_divmod(r, a, b, &q, &m));
+  SEG_ASSERT_TRY(seg_integer_value(q, &v));
+  CU_ASSERT_EQUAL(v, -4);
+  SEG_ASSERT_TRY(seg_integer_value(m, &v));
+  CU_ASSERT_EQUAL(v, -1);
+
+  int comparison;
+  SEG_ASSERT_TRY(seg_integer_compare(r, a, b, &comparison));
+  CU_ASSERT(comparison > 0);
+
+  /* None of that allocated. */
+  seg_memory_usage after;
+  seg_runtime_memory(r, &after);
+  CU_ASSERT_EQUAL(after.buffers.count, before.buffers.count);
+
+  seg_delete_runtime(r);
+}
+
+static void test_promotion(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_object max, min, one, minus_one, out, q;
+  SEG_ASSERT_TRY(seg_integer(r, SEG_INTEGER_MAX, &max));
+  SEG_ASSERT_TRY(seg_integer(r, SEG_INTEGER_MIN, &min));
+  SEG_ASSERT_TRY(seg_integer(r, 1, &one));
+  SEG_ASSERT_TRY(seg_integer(r, -1, &minus_one));
+
+  /* Overflowing the immediate range promotes, and coming back demotes. */
+  SEG_ASSERT_TRY(seg_integer_add(r, max, one, &out));
+  CU_ASSERT_FALSE(SEG_IS_IMMEDIATE(out));
+  assert_decimal(r, out, "36028797018963968");
+
+  SEG_ASSERT_TRY(seg_integer_sub(r, out, one, &out));
+  CU_ASSERT(SEG_IS_IMMEDIATE(out));
+  SEG_ASSERT_SAME(out, max);
+
+  SEG_ASSERT_TRY(seg_integer_sub(r, min, one, &out));
+  CU_ASSERT_FALSE(SEG_IS_IMMEDIATE(out));
+  assert_decimal(r, out, "-36028797018963969");
+
+  SEG_ASSERT_TRY(seg_integer_mul(r, min, minus_one, &out));
+  CU_ASSERT_FALSE(SEG_IS_IMMEDIATE(out));
+  assert_decimal(r, out, "36028797018963968");
+
+  SEG_ASSERT_TRY(seg_integer_divmod(r, min, minus_one, &q, NULL));
+  assert_equal(r, q, out);
+
+  /* Products overflow 64 bits, too. */
+  SEG_ASSERT_TRY(seg_integer(r, (int64_t) 1 << 40, &out));
+  SEG_ASSERT_TRY(seg_integer_mul(r, out, out, &out));
+  assert_decimal(r, out, "1208925819614629174706176");
+
+  int64_t v;
+  seg_err err = seg_integer_to_int64(r, out, &v);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_RANGE);
+
+  seg_delete_runtime(r);
+}
+
+static void test_reference(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  srand(42);
+
+  /* Check operands of every width up to 64 bits against 128-bit arithmetic. */
+  for (int i = 0; i < 2000; i++) {
+    int64_t x = (int64_t) (((uint64_t) rand() << 62) ^ ((uint64_t) rand() << 31) ^ rand());
+    int64_t y = (int64_t) (((uint64_t) rand() << 62) ^ ((uint64_t) rand() << 31) ^ rand());
+    x >>= rand() % 64;
+    y >>= rand() % 64;
+    if (y == 0) {
+      y = 3;
+    }
+
+    seg_object a, b, out, q, m;
+    SEG_ASSERT_TRY(seg_integer(r, x, &a));
+    SEG_ASSERT_TRY(seg_integer(r, y, &b));
+
+    SEG_ASSERT_TRY(seg_integer_add(r, a, b, &out));
+    assert_int128(r, out, (__int128) x + y);
+
+    SEG_ASSERT_TRY(seg_integer_sub(r, a, b, &out));
+    assert_int128(r, out, (__int128) x - y);
+
+    SEG_ASSERT_TRY(seg_integer_mul(r, a, b, &out));
+    assert_int128(r, out, (__int128) x * y);
+
+    __int128 expected_q = (__int128) x / y, expected_m = (__int128) x % y;
+    if (expected_m != 0 && (expected_m < 0) != (y < 0)) {
+      expected_q--;
+      expected_m += y;
+    }
+    SEG_ASSERT_TRY(seg_integer_divmod(r, a, b, &q, &m));
+    assert_int128(r, q, expected_q);
+    assert_int128(r, m, expected_m);
+
+    int comparison;
+    SEG_ASSERT_TRY(seg_integer_compare(r, a, b, &comparison));
+    CU_ASSERT_EQUAL(comparison, (x > y) - (x < y));
+
+    SEG_ASSERT_TRY(seg_gc_safepoint(seg_runtime_gc(r)));
+  }
+
+  seg_delete_runtime(r);
+}
+
+static void power(seg_runtime *r, int64_t base, int exponent, seg_object *out)
+{
+  seg_object b;
+  SEG_ASSERT_TRY(seg_integer(r, base, &b));
+  SEG_ASSERT_TRY(seg_integer(r, 1, out));
+
+  for (int i = 0; i < exponent; i++) {
+    SEG_ASSERT_TRY(seg_integer_mul(r, *out, b, out));
+  }
+}
+
+static void test_large(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_object n, one, out, q, m;
+  SEG_ASSERT_TRY(seg_integer(r, 1, &one));
+
+  SEG_ASSERT_TRY(seg_integer(r, 1, &out));
+  for (int i = 2; i <= 30; i++) {
+    SEG_ASSERT_TRY(seg_integer(r, i, &n));
+    SEG_ASSERT_TRY(seg_integer_mul(r, out, n, &out));
+  }
+  assert_decimal(r, out, "265252859812191058636308480000000");
+
+  power(r, 2, 200, &out);
+  assert_decimal(r, out, "1606938044258990275541962092341162602522202993782792835301376");
+
+  power(r, -3, 3, &out);
+  assert_decimal(r, out, "-27");
+
+  /* Operands this long are multiplied by Karatsuba's method, balanced or not. */
+  seg_object a, b, square, product, left, right;
+  power(r, 3, 4000, &a);
+  power(r, -5, 1001, &b);
+
+  SEG_ASSERT_TRY(seg_integer_mul(r, a, a, &square));
+  SEG_ASSERT_TRY(seg_integer_add(r, a, one, &left));
+  SEG_ASSERT_TRY(seg_integer_sub(r, a, one, &right));
+  SEG_ASSERT_TRY(seg_integer_mul(r, left, right, &product));
+  SEG_ASSERT_TRY(seg_integer_add(r, product, one, &product));
+  assert_equal(r, product, square);
+
+  SEG_ASSERT_TRY(seg_integer_divmod(r, square, a, &q, &m));
+  assert_equal(r, q, a);
+  assert_decimal(r, m, "0");
+
+  SEG_ASSERT_TRY(seg_integer_mul(r, a, b, &product));
+  SEG_ASSERT_TRY(seg_integer_add(r, product, a, &product));
+  SEG_ASSERT_TRY(seg_integer_sub(r, product, one, &product));
+  SEG_ASSERT_TRY(seg_integer_divmod(r, product, b, &q, &m));
+  SEG_ASSERT_TRY(seg_integer_mul(r, q, b, &out));
+  SEG_ASSERT_TRY(seg_integer_add(r, out, m, &out));
+  assert_equal(r, out, product);
+
+  /* The remainder has the divisor's sign, and is smaller. */
+  int comparison;
+  SEG_ASSERT_TRY(seg_integer_compare(r, m, b, &comparison));
+  CU_ASSERT(comparison > 0);
+  SEG_ASSERT_TRY(seg_integer(r, 0, &n));
+  SEG_ASSERT_TRY(seg_integer_compare(r, m, n, &comparison));
+  CU_ASSERT(comparison <= 0);
+
+  seg_delete_runtime(r);
+}
+
+static void test_types(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_object integer, zero, floating, out;
+  SEG_ASSERT_TRY(seg_integer(r, 10, &integer));
+  SEG_ASSERT_TRY(seg_integer(r, 0, &zero));
+  SEG_ASSERT_TRY(seg_float(r, 1.5, &floating));
+
+  seg_err err = seg_integer_add(r, integer, floating, &out);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_TYPE);
+
+  err = seg_integer_divmod(r, integer, zero, &out, &out);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_RANGE);
+
+  seg_delete_runtime(r);
+}
+
+CU_pSuite initialize_integer_suite(void)
+{
+  CU_pSuite pSuite = CU_add_suite("integer", NULL, NULL);
+  if (pSuite == NULL) {
+    return NULL;
+  }
+
+  ADD_TEST(test_immediate_arithmetic);
+  ADD_TEST(test_promotion);
+  ADD_TEST(test_reference);
+  ADD_TEST(test_large);
+  ADD_TEST(test_types);
+
+  return pSuite;
+}
@@ -5,6 +5,7 @@
 #include "errors.h"
 #include "model/object.h"
 #include "model/klass.h"
+#include "model/integer.h"
 #include "runtime/runtime.h"
 
 static void test_immediate_integer(void)
@@ -32,9 +33,98 @@ static void test_immediate_integer(void)
   SEG_ASSERT_TRY(seg_integer_value(n, &v));
   CU_ASSERT_EQUAL(v, -32l);
 
-  err = seg_integer(r, 1ll << 63, &i);
+  /* The immediate range ends at 56 bits. */
+  SEG_ASSERT_TRY(seg_integer(r, SEG_INTEGER_MAX, &i));
+  SEG_ASSERT_TRY(seg_integer_value(i, &v));
+  CU_ASSERT_EQUAL(v, SEG_INTEGER_MAX);
+  SEG_ASSERT_TRY(seg_integer(r, SEG_INTEGER_MIN, &n));
+  SEG_ASSERT_TRY(seg_integer_value(n, &v));
+  CU_ASSERT_EQUAL(v, SEG_INTEGER_MIN);
+
+  /* Beyond it, integers are allocated, but they're still Integers. */
+  SEG_ASSERT_TRY(seg_integer(r, INT64_MIN, &i));
+  CU_ASSERT_FALSE(SEG_IS_IMMEDIATE(i));
+  SEG_ASSERT_TRY(seg_object_class(r, i, &kls));
+  SEG_ASSERT_SAME(kls, boots->integer_class);
+
+  err = seg_integer_value(i, &v);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_TYPE);
+
+  SEG_ASSERT_TRY(seg_integer_to_int64(r, i, &v));
+  CU_ASSERT_EQUAL(v, INT64_MIN);
+
+  seg_delete_runtime(r);
+}
+
+static void test_immediate_float(void)
+{
+  seg_err err;
+
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  seg_memory_usage before;
+  seg_runtime_memory(r, &before);
+
+  /* Common values, and the edges of the immediate range, round-trip exactly without allocating. */
+  const double immediates[] = {
+    0.0, 1.0, -1.0, 0.1, -2.5, 3.141592653589793, 1e-70, -1e70,
+    0x1.0000000000001p-255, 0x1.fffffffffffffp+256, -0x1p-255
+  };
+
+  for (size_t i = 0; i < sizeof(immediates) / sizeof(immediates[0]); i++) {
+    seg_object f;
+    double v;
+
+    CU_ASSERT(seg_float_is_immediate(immediates[i]));
+    SEG_ASSERT_TRY(seg_float(r, immediates[i], &f));
+    CU_ASSERT(SEG_IS_IMMEDIATE(f));
+    SEG_ASSERT_TRY(seg_float_value(r, f, &v));
+    CU_ASSERT_EQUAL(memcmp(&v, &immediates[i], sizeof(double)), 0);
+
+    seg_object kls;
+    SEG_ASSERT_TRY(seg_object_class(r, f, &kls));
+    SEG_ASSERT_SAME(kls, boots->float_class);
+  }
+
+  seg_memory_usage after;
+  seg_runtime_memory(r, &after);
+  CU_ASSERT_EQUAL(after.buffers.count, before.buffers.count);
+
+  /* Everything else is boxed, and still round-trips. */
+  const double boxed[] = { -0.0, 0x1p-255, 0x1p+257, 1e300, 5e-324, 1.0 / 0.0, -1.0 / 0.0 };
+
+  for (size_t i = 0; i < sizeof(boxed) / sizeof(boxed[0]); i++) {
+    seg_object f;
+    double v;
+
+    CU_ASSERT_FALSE(seg_float_is_immediate(boxed[i]));
+    SEG_ASSERT_TRY(seg_float(r, boxed[i], &f));
+    CU_ASSERT_FALSE(SEG_IS_IMMEDIATE(f));
+    SEG_ASSERT_TRY(seg_float_value(r, f, &v));
+    CU_ASSERT_EQUAL(memcmp(&v, &boxed[i], sizeof(double)), 0);
+
+    seg_object kls;
+    SEG_ASSERT_TRY(seg_object_class(r, f, &kls));
+    SEG_ASSERT_SAME(kls, boots->float_class);
+  }
+
+  /* Integers aren't floats, and floats aren't integers. */
+  seg_object i, f;
+  double dv;
+  int64_t iv;
+  SEG_ASSERT_TRY(seg_integer(r, 3, &i));
+  SEG_ASSERT_TRY(seg_float(r, 3.0, &f));
+
+  err = seg_float_value(r, i, &dv);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_TYPE);
+
+  err = seg_integer_value(f, &iv);
   CU_ASSERT_PTR_NOT_NULL_FATAL(err);
-  CU_ASSERT_EQUAL(err->code, SEG_CODE_RANGE);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_TYPE);
 
   seg_delete_runtime(r);
 }
@@ -156,6 +246,7 @@ CU_pSuite initialize_object_suite(void)
   }
 
   ADD_TEST(test_immediate_integer);
+  ADD_TEST(test_immediate_float);
   ADD_TEST(test_immediate_string);
   ADD_TEST(test_immediate_symbol);
   ADD_TEST(test_slotted);
@@ -0,0 +1,312 @@
+#include <string.h>
+#include <CUnit/CUnit.h>
+
+#include "unit.h"
+#include "runtime/runtime.h"
+#include "runtime/gc.h"
+#include "runtime/nursery.h"
+#include "runtime/symboltable.h"
+#include "model/object.h"
+#include "model/klass.h"
+
+static void assert_contents(seg_object buffer, const char *expected)
+{
+  char *contents;
+  uint64_t length;
+
+  SEG_ASSERT_TRY(seg_buffer_contents(&buffer, &contents, &length));
+  CU_ASSERT_EQUAL(length, strlen(expected));
+  CU_ASSERT_EQUAL(strncmp(contents, expected, length), 0);
+}
+
+static void new_array(seg_runtime *r, uint64_t length, seg_object *out)
+{
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  SEG_ASSERT_TRY(seg_slotted(r, boots->array_class, out));
+  SEG_ASSERT_TRY(seg_slotted_grow(r, out, length));
+}
+
+static void test_minor(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+
+  /* Promote whatever bootstrapping left in the nursery. */
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  seg_object kept, garbage;
+  SEG_ASSERT_TRY(seg_cstring(r, "a string that survives", &kept));
+  SEG_ASSERT_TRY(seg_cstring(r, "a string that doesn't", &garbage));
+  SEG_ASSERT_TRY(seg_gc_push_root(gc, &kept));
+
+  seg_gc_stats before;
+  seg_gc_statistics(gc, &before);
+  CU_ASSERT_EQUAL(before.young_capacity, SEG_NURSERY_SIZE);
+  CU_ASSERT(before.young_bytes > 0);
+
+  seg_object_common *original = SEG_TOPOINTER(kept);
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  /* The survivor is moved out of the nursery and its root is updated. Garbage isn't copied. */
+  CU_ASSERT_PTR_NOT_EQUAL(SEG_TOPOINTER(kept), original);
+  assert_contents(kept, "a string that survives");
+
+  seg_gc_stats after;
+  seg_gc_statistics(gc, &after);
+  CU_ASSERT_EQUAL(after.minor_collections, 2);
+  CU_ASSERT_EQUAL(after.young_bytes, 0);
+  CU_ASSERT_EQUAL(after.old_objects, before.old_objects + 1);
+  CU_ASSERT(after.bytes_promoted >= before.bytes_promoted + 22);
+  CU_ASSERT(after.bytes_promoted < before.bytes_promoted + 22 + 64);
+
+  /* Old objects stay put. */
+  original = SEG_TOPOINTER(kept);
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+  CU_ASSERT_PTR_EQUAL(SEG_TOPOINTER(kept), original);
+
+  seg_gc_pop_roots(gc, 1);
+  seg_delete_runtime(r);
+}
+
+static void test_references(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  /* Young objects reachable only through other young objects survive, once each. */
+  seg_object array, string, out;
+  new_array(r, 3, &array);
+  SEG_ASSERT_TRY(seg_cstring(r, "referenced twice", &string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, array, 0, string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, array, 2, string));
+  SEG_ASSERT_TRY(seg_gc_push_root(gc, &array));
+
+  seg_gc_stats before;
+  seg_gc_statistics(gc, &before);
+
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  seg_object first, last;
+  SEG_ASSERT_TRY(seg_slot_at(array, 0, &first));
+  SEG_ASSERT_TRY(seg_slot_at(array, 2, &last));
+  SEG_ASSERT_SAME(first, last);
+  assert_contents(first, "referenced twice");
+
+  seg_gc_stats after;
+  seg_gc_statistics(gc, &after);
+  CU_ASSERT_EQUAL(after.old_objects, before.old_objects + 2);
+
+  /* A young object stored into an old one is found from it. */
+  SEG_ASSERT_TRY(seg_cstring(r, "stored after promotion", &string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, array, 1, string));
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  SEG_ASSERT_TRY(seg_slot_at(array, 1, &out));
+  assert_contents(out, "stored after promotion");
+
+  seg_gc_pop_roots(gc, 1);
+  seg_delete_runtime(r);
+}
+
+static void test_barrier(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+
+  seg_object old, young, string, integer, out;
+  new_array(r, 2, &old);
+  SEG_ASSERT_TRY(seg_gc_push_root(gc, &old));
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  seg_gc_stats before, after;
+  seg_gc_statistics(gc, &before);
+
+  /* Storing immediates, or young objects into young ones, remembers nothing. */
+  new_array(r, 1, &young);
+  SEG_ASSERT_TRY(seg_cstring(r, "stored into a young array", &string));
+  SEG_ASSERT_TRY(seg_integer(r, 42, &integer));
+  SEG_ASSERT_TRY(seg_slot_atput(r, young, 0, string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, old, 0, integer));
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  seg_gc_statistics(gc, &after);
+  CU_ASSERT_EQUAL(after.remembered_objects, before.remembered_objects);
+
+  /* An old object given young references is scanned once, however many stores it sees. */
+  SEG_ASSERT_TRY(seg_cstring(r, "stored twice", &string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, old, 0, string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, old, 1, string));
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  seg_gc_statistics(gc, &after);
+  CU_ASSERT_EQUAL(after.remembered_objects, before.remembered_objects + 1);
+  SEG_ASSERT_TRY(seg_slot_at(old, 1, &out));
+  assert_contents(out, "stored twice");
+
+  /*
+   * Growing an object copies its young references along with the rest of its slots. One too large
+   * for the nursery is grown in the old generation, and remembered in place of the original.
+   */
+  SEG_ASSERT_TRY(seg_cstring(r, "copied by grow", &string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, old, 0, string));
+  SEG_ASSERT_TRY(seg_slotted_grow(r, &old, SEG_NURSERY_MAX_OBJECT / sizeof(seg_object)));
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MINOR));
+
+  seg_gc_statistics(gc, &after);
+  CU_ASSERT_EQUAL(after.remembered_objects, before.remembered_objects + 2);
+  SEG_ASSERT_TRY(seg_slot_at(old, 0, &out));
+  assert_contents(out, "copied by grow");
+
+  seg_gc_pop_roots(gc, 1);
+  seg_delete_runtime(r);
+}
+
+static void test_major(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  seg_object klass;
+  SEG_ASSERT_TRY(seg_class(r, "Temporary", SEG_STORAGE_SLOTTED, &klass));
+  SEG_ASSERT_TRY(seg_class_ivars(r, klass, 2, "left", "right"));
+
+  seg_object instance, string;
+  SEG_ASSERT_TRY(seg_slotted(r, klass, &instance));
+  SEG_ASSERT_TRY(seg_cstring(r, "held by the instance", &string));
+  SEG_ASSERT_TRY(seg_slot_atput(r, instance, 0, string));
+  SEG_ASSERT_TRY(seg_gc_push_root(gc, &instance));
+
+  /* Reachable objects, and their classes, survive a major collection. */
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MAJOR));
+
+  seg_object out;
+  SEG_ASSERT_TRY(seg_object_class(r, instance, &out));
+  SEG_ASSERT_SAME(out, klass);
+  SEG_ASSERT_TRY(seg_slot_at(instance, 0, &out));
+  assert_contents(out, "held by the instance");
+
+  seg_gc_stats kept;
+  seg_gc_statistics(gc, &kept);
+  CU_ASSERT_EQUAL(kept.major_collections, 1);
+
+  /* Once nothing refers to them, the instance, its string, its class and its ivars are freed. */
+  seg_gc_pop_roots(gc, 1);
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MAJOR));
+
+  seg_gc_stats freed;
+  seg_gc_statistics(gc, &freed);
+  CU_ASSERT_EQUAL(freed.major_collections, 2);
+  CU_ASSERT(freed.objects_reclaimed >= kept.objects_reclaimed + 4);
+  CU_ASSERT(freed.bytes_reclaimed > kept.bytes_reclaimed);
+  CU_ASSERT(freed.old_objects <= kept.old_objects - 4);
+  CU_ASSERT(freed.major_pause_ns > 0);
+  CU_ASSERT(freed.max_pause_ns > 0);
+
+  /* The bootstrap objects are always reachable. */
+  SEG_ASSERT_TRY(seg_object_class(r, boots->string_class, &out));
+  SEG_ASSERT_SAME(out, boots->class_class);
+  SEG_ASSERT_TRY(seg_cstring(r, "allocated afterward", &string));
+  SEG_ASSERT_TRY(seg_object_class(r, string, &out));
+  SEG_ASSERT_SAME(out, boots->string_class);
+
+  seg_delete_runtime(r);
+}
+
+static void test_weak_symbols(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+  seg_symboltable *table = seg_runtime_symboltable(r);
+
+  seg_object array, referenced, unreferenced, permanent;
+  new_array(r, 1, &array);
+  SEG_ASSERT_TRY(seg_symboltable_intern_weak(table, "referenced_weak_symbol", 22, &referenced));
+  SEG_ASSERT_TRY(seg_symboltable_intern_weak(table, "unreferenced_weak_symbol", 24, &unreferenced));
+  SEG_ASSERT_TRY(seg_symboltable_cintern(table, "unreferenced_permanent_symbol", &permanent));
+  SEG_ASSERT_TRY(seg_slot_atput(r, array, 0, referenced));
+  SEG_ASSERT_TRY(seg_gc_push_root(gc, &array));
+
+  SEG_ASSERT_TRY(seg_gc_collect(gc, SEG_GC_MAJOR));
+
+  seg_gc_stats stats;
+  seg_gc_statistics(gc, &stats);
+  CU_ASSERT_EQUAL(stats.symbols_reclaimed, 1);
+
+  /* Only the weak symbol that nothing refers to is gone. */
+  seg_object out;
+  out = seg_symboltable_get(table, "referenced_weak_symbol", 22);
+  SEG_ASSERT_SAME(out, referenced);
+  out = seg_symboltable_get(table, "unreferenced_permanent_symbol", 29);
+  SEG_ASSERT_SAME(out, permanent);
+  out = seg_symboltable_get(table, "unreferenced_weak_symbol", 24);
+  SEG_ASSERT_SAME(out, SEG_NULL);
+
+  seg_gc_pop_roots(gc, 1);
+  seg_delete_runtime(r);
+}
+
+static void test_safepoint(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+  seg_gc *gc = seg_runtime_gc(r);
+
+  /* Nothing has been requested yet. */
+  SEG_ASSERT_TRY(seg_gc_safepoint(gc));
+
+  seg_gc_stats stats;
+  seg_gc_statistics(gc, &stats);
+  CU_ASSERT_EQUAL(stats.minor_collections, 0);
+  CU_ASSERT_EQUAL(stats.major_collections, 0);
+
+  /* Overflowing the nursery requests a minor collection, but doesn't perform one. */
+  seg_object string;
+  for (size_t used = 0; used <= SEG_NURSERY_SIZE; used += 64) {
+    SEG_ASSERT_TRY(seg_cstring(
+      r, "a string long enough to fill the nursery sixty-four bytes at a time", &string
+    ));
+  }
+
+  seg_gc_statistics(gc, &stats);
+  CU_ASSERT_EQUAL(stats.minor_collections, 0);
+  CU_ASSERT(stats.young_bytes > SEG_NURSERY_SIZE - 128);
+
+  SEG_ASSERT_TRY(seg_gc_safepoint(gc));
+
+  seg_gc_statistics(gc, &stats);
+  CU_ASSERT_EQUAL(stats.minor_collections, 1);
+  CU_ASSERT_EQUAL(stats.young_bytes, 0);
+  CU_ASSERT(stats.bytes_promoted < 1024);
+
+  /* The request is satisfied. */
+  SEG_ASSERT_TRY(seg_gc_safepoint(gc));
+  seg_gc_statistics(gc, &stats);
+  CU_ASSERT_EQUAL(stats.minor_collections, 1);
+
+  seg_delete_runtime(r);
+}
+
+CU_pSuite initialize_gc_suite(void)
+{
+  CU_pSuite pSuite = CU_add_suite("gc", NULL, NULL);
+  if (pSuite == NULL) {
+    return NULL;
+  }
+
+  ADD_TEST(test_minor);
+  ADD_TEST(test_references);
+  ADD_TEST(test_barrier);
+  ADD_TEST(test_major);
+  ADD_TEST(test_weak_symbols);
+  ADD_TEST(test_safepoint);
+
+  return pSuite;
+}
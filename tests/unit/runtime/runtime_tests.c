@@ -1,8 +1,11 @@
+#include <stdio.h>
+#include <stdbool.h>
 #include <CUnit/CUnit.h>
 
 #include "unit.h"
 #include "runtime/runtime.h"
 #include "runtime/symboltable.h"
+#include "runtime/nursery.h"
 #include "model/object.h"
 
 static void test_creation(void)
@@ -47,6 +50,182 @@ static void test_bootstrap(void)
   seg_delete_runtime(r);
 }
 
+static bool keep_none(seg_object symbol, void *state)
+{
+  return false;
+}
+
+static void test_memory(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_symboltable *symtable = seg_runtime_symboltable(r);
+  const seg_bootstrap_objects *boots = seg_runtime_bootstraps(r);
+
+  /* Bootstrapping allocates well-known symbols and the class objects. */
+  seg_memory_usage before;
+  seg_runtime_memory(r, &before);
+  CU_ASSERT_EQUAL(before.runtime.count, 1);
+  CU_ASSERT(before.runtime.bytes > 0);
+  CU_ASSERT(before.symboltable.bytes > 0);
+  CU_ASSERT(before.buffers.count > 0);
+  CU_ASSERT(before.slotted.count > 0);
+  CU_ASSERT_EQUAL(before.images.bytes, 0);
+  CU_ASSERT_EQUAL(before.ast.bytes, 0);
+  CU_ASSERT_EQUAL(before.nursery.count, 1);
+  CU_ASSERT_EQUAL(before.nursery.bytes, SEG_NURSERY_SIZE);
+  CU_ASSERT_EQUAL(before.total_bytes,
+    before.runtime.bytes + before.symboltable.bytes + before.images.bytes +
+    before.nursery.bytes + before.direct.bytes + before.ast.bytes);
+
+  /* Interning a new symbol allocates one buffer, and interning it again allocates nothing. */
+  seg_object symbol;
+  SEG_ASSERT_TRY(seg_symboltable_cintern(symtable, "a_long_symbol_name", &symbol));
+  SEG_ASSERT_TRY(seg_symboltable_cintern(symtable, "a_long_symbol_name", &symbol));
+
+  seg_memory_usage interned;
+  seg_runtime_memory(r, &interned);
+  CU_ASSERT_EQUAL(interned.buffers.count, before.buffers.count + 1);
+  CU_ASSERT(interned.buffers.bytes >= before.buffers.bytes + 18);
+  CU_ASSERT_EQUAL(interned.slotted.bytes, before.slotted.bytes);
+  CU_ASSERT_EQUAL(interned.direct.count, before.direct.count + 1);
+
+  /* Immediates aren't allocated at all. */
+  SEG_ASSERT_TRY(seg_symboltable_cintern(symtable, "short", &symbol));
+  seg_memory_usage immediate;
+  seg_runtime_memory(r, &immediate);
+  CU_ASSERT_EQUAL(immediate.buffers.bytes, interned.buffers.bytes);
+
+  seg_object instance;
+  SEG_ASSERT_TRY(seg_slotted(r, boots->array_class, &instance));
+  SEG_ASSERT_TRY(seg_slotted_grow(r, &instance, 10));
+
+  seg_memory_usage grown;
+  seg_runtime_memory(r, &grown);
+  CU_ASSERT_EQUAL(grown.slotted.count, interned.slotted.count + 1);
+  CU_ASSERT(grown.slotted.bytes >= interned.slotted.bytes + 10 * sizeof(seg_object));
+  CU_ASSERT_EQUAL(grown.direct.count, interned.direct.count);
+
+  /* Swept symbols are returned. */
+  seg_object weak;
+  uint64_t reclaimed;
+  SEG_ASSERT_TRY(seg_symboltable_intern_weak(symtable, "a_weak_symbol_name", 18, &weak));
+  SEG_ASSERT_TRY(seg_symboltable_sweep(symtable, &keep_none, NULL, &reclaimed));
+  CU_ASSERT_EQUAL(reclaimed, 1);
+
+  seg_memory_usage swept;
+  seg_runtime_memory(r, &swept);
+  CU_ASSERT_EQUAL(swept.buffers.count, grown.buffers.count);
+  CU_ASSERT_EQUAL(swept.buffers.bytes, grown.buffers.bytes);
+  CU_ASSERT_EQUAL(swept.direct.count, grown.direct.count);
+
+  seg_delete_runtime(r);
+}
+
+static void test_teardown(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_memory_usage before;
+  seg_runtime_memory(r, &before);
+
+  /*
+   * A runtime's counters go with it, so deleting a second symboltable stands in for deleting the
+   * runtime: it has to return its well-known symbols, and every symbol interned into it, including
+   * those interned across a resize.
+   */
+  seg_symboltable *table;
+  SEG_ASSERT_TRY(seg_new_symboltable(r, &table));
+
+  char name[32];
+  seg_object symbol;
+  for (int i = 0; i < 200; i++) {
+    snprintf(name, sizeof(name), "an_interned_symbol_%d", i);
+    SEG_ASSERT_TRY(seg_symboltable_cintern(table, name, &symbol));
+  }
+  SEG_ASSERT_TRY(seg_symboltable_intern_weak(table, "a_weak_symbol_name", 18, &symbol));
+
+  seg_memory_usage interned;
+  seg_runtime_memory(r, &interned);
+  CU_ASSERT(interned.buffers.count > before.buffers.count + 200);
+
+  seg_delete_symboltable(table);
+
+  seg_memory_usage deleted;
+  seg_runtime_memory(r, &deleted);
+  CU_ASSERT_EQUAL(deleted.buffers.count, before.buffers.count);
+  CU_ASSERT_EQUAL(deleted.buffers.bytes, before.buffers.bytes);
+  CU_ASSERT_EQUAL(deleted.direct.count, before.direct.count);
+  CU_ASSERT_EQUAL(deleted.direct.bytes, before.direct.bytes);
+
+  seg_delete_runtime(r);
+}
+
+static void test_allocate(void)
+{
+  seg_runtime *r = NULL;
+  SEG_ASSERT_TRY(seg_new_runtime(&r));
+
+  seg_memory_usage before;
+  seg_runtime_memory(r, &before);
+
+  /* Young objects are carved from the nursery, one after another, on eight-byte boundaries. */
+  void *first, *second;
+  SEG_ASSERT_TRY(seg_runtime_allocate(r, SEG_MEMORY_SLOTTED, SEG_ALLOC_YOUNG, 20, &first));
+  SEG_ASSERT_TRY(seg_runtime_allocate(r, SEG_MEMORY_SLOTTED, SEG_ALLOC_YOUNG, 8, &second));
+  CU_ASSERT_EQUAL((uintptr_t) first % 8, 0);
+  CU_ASSERT_PTR_EQUAL((char *) first + 24, second);
+
+  seg_memory_usage young;
+  seg_runtime_memory(r, &young);
+  CU_ASSERT_EQUAL(young.slotted.count, before.slotted.count + 2);
+  CU_ASSERT_EQUAL(young.slotted.bytes, before.slotted.bytes + 28);
+  CU_ASSERT_EQUAL(young.direct.count, before.direct.count);
+
+  /* Once the nursery is full, young objects are allocated individually instead. */
+  void *p;
+  for (size_t used = 0; used < SEG_NURSERY_SIZE; used += SEG_NURSERY_MAX_OBJECT) {
+    SEG_ASSERT_TRY(seg_runtime_allocate(
+      r, SEG_MEMORY_SLOTTED, SEG_ALLOC_YOUNG, SEG_NURSERY_MAX_OBJECT, &p
+    ));
+  }
+
+  seg_memory_usage filled;
+  seg_runtime_memory(r, &filled);
+  CU_ASSERT_EQUAL(filled.nursery.count, young.nursery.count);
+  CU_ASSERT_EQUAL(filled.nursery.bytes, young.nursery.bytes);
+  CU_ASSERT(filled.direct.count > young.direct.count);
+
+  /* Large young objects and pinned objects are allocated, and released, individually. */
+  void *large, *pinned;
+  SEG_ASSERT_TRY(seg_runtime_allocate(
+    r, SEG_MEMORY_SLOTTED, SEG_ALLOC_YOUNG, SEG_NURSERY_MAX_OBJECT + 1, &large
+  ));
+  SEG_ASSERT_TRY(seg_runtime_allocate(r, SEG_MEMORY_BUFFERS, SEG_ALLOC_PINNED, 24, &pinned));
+
+  seg_memory_usage direct;
+  seg_runtime_memory(r, &direct);
+  CU_ASSERT_EQUAL(direct.direct.count, filled.direct.count + 2);
+  CU_ASSERT_EQUAL(direct.direct.bytes, filled.direct.bytes + SEG_NURSERY_MAX_OBJECT + 25);
+  CU_ASSERT_EQUAL(direct.nursery.count, filled.nursery.count);
+
+  seg_runtime_release(r, SEG_MEMORY_SLOTTED, SEG_ALLOC_YOUNG, large, SEG_NURSERY_MAX_OBJECT + 1);
+  seg_runtime_release(r, SEG_MEMORY_BUFFERS, SEG_ALLOC_PINNED, pinned, 24);
+  seg_runtime_release(r, SEG_MEMORY_SLOTTED, SEG_ALLOC_YOUNG, second, 8);
+
+  seg_memory_usage released;
+  seg_runtime_memory(r, &released);
+  CU_ASSERT_EQUAL(released.direct.count, filled.direct.count);
+  CU_ASSERT_EQUAL(released.direct.bytes, filled.direct.bytes);
+  CU_ASSERT_EQUAL(released.buffers.count, filled.buffers.count);
+  CU_ASSERT_EQUAL(released.slotted.count, filled.slotted.count - 1);
+  CU_ASSERT_EQUAL(released.nursery.bytes, filled.nursery.bytes);
+
+  seg_delete_runtime(r);
+}
+
 CU_pSuite initialize_runtime_suite(void)
 {
   CU_pSuite pSuite = CU_add_suite("runtime", NULL, NULL);
@@ -56,6 +235,9 @@ CU_pSuite initialize_runtime_suite(void)
 
   ADD_TEST(test_creation);
   ADD_TEST(test_bootstrap);
+  ADD_TEST(test_memory);
+  ADD_TEST(test_teardown);
+  ADD_TEST(test_allocate);
 
   return pSuite;
 }
@@ -1,3 +1,7 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <CUnit/CUnit.h>
 
 #include "unit.h"
@@ -98,6 +102,593 @@ static void test_immediate(void)
   seg_delete_runtime(r);
 }
 
+static void test_stats(void)
+{
+  seg_err err;
+  char name[16];
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  uint64_t init_capacity = seg_symboltable_capacity(table);
+
+  for (int i = 0; i < 1000; i++) {
+    seg_object sym;
+    snprintf(name, sizeof(name), "statistic%d", i);
+
+    err = seg_symboltable_cintern(table, name, &sym);
+    SEG_ASSERT_OK(err);
+  }
+
+  seg_hashtable_stats stats;
+  seg_symboltable_stats(table, &stats);
+
+  CU_ASSERT_EQUAL(stats.count, seg_symboltable_count(table));
+  CU_ASSERT_EQUAL(stats.capacity, seg_symboltable_capacity(table));
+  CU_ASSERT_EQUAL(stats.slots - stats.empty_slots, stats.count);
+  CU_ASSERT(stats.counters.resizes >= 1);
+  CU_ASSERT(stats.capacity > init_capacity);
+
+  uint64_t entries = 0;
+  for (int i = 0; i < SEG_HT_HISTOGRAM_BINS; i++) {
+    entries += stats.histogram[i];
+  }
+  CU_ASSERT_EQUAL(entries, stats.count);
+
+  seg_delete_runtime(r);
+}
+
+static void test_cursor(void)
+{
+  seg_err err;
+  char name[24];
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+
+  for (int i = 0; i < 200; i++) {
+    seg_object sym;
+    snprintf(name, sizeof(name), "cursory%d", i);
+
+    err = seg_symboltable_cintern(table, name, &sym);
+    SEG_ASSERT_OK(err);
+  }
+
+  uint64_t visited = 0;
+  seg_hashtable_cursor c;
+  seg_symboltable_begin(table, &c);
+  for (; ! seg_hashtable_done(&c); seg_symboltable_next(table, &c)) {
+    seg_object sym = seg_symboltable_cursor_symbol(&c);
+    char *contents;
+    uint64_t length;
+
+    err = seg_buffer_contents(&sym, &contents, &length);
+    SEG_ASSERT_OK(err);
+
+    seg_object found = seg_symboltable_get(table, contents, length);
+    CU_ASSERT(SEG_SAME(found, sym));
+    visited++;
+  }
+  CU_ASSERT_EQUAL(visited, seg_symboltable_count(table));
+
+  /* Interning while a cursor is open grows the table underneath it. */
+  uint64_t before = seg_symboltable_count(table);
+  seg_symboltable_begin(table, &c);
+  visited = 0;
+
+  for (int i = 0; i < 2000; i++) {
+    seg_object sym;
+    snprintf(name, sizeof(name), "interleaved%d", i);
+
+    err = seg_symboltable_cintern(table, name, &sym);
+    SEG_ASSERT_OK(err);
+  }
+
+  for (; ! seg_hashtable_done(&c); seg_symboltable_next(table, &c)) {
+    visited++;
+  }
+  CU_ASSERT(visited >= before);
+  CU_ASSERT(visited <= seg_symboltable_count(table));
+
+  seg_delete_runtime(r);
+}
+
+#define STRESS_THREADS 8
+#define STRESS_NAMES 2000
+
+typedef struct {
+  seg_symboltable *table;
+  char (*names)[16];
+  int offset;
+  bool weak;
+  seg_object symbols[STRESS_NAMES];
+  seg_err err;
+} stress_state;
+
+static void *stress_intern(void *arg)
+{
+  stress_state *state = arg;
+  state->err = SEG_OK;
+
+  for (int i = 0; i < STRESS_NAMES && state->err == SEG_OK; i++) {
+    int n = (i + state->offset) % STRESS_NAMES;
+    const char *name = state->names[n];
+
+    if (state->weak) {
+      uint64_t length = strlen(name);
+      state->err = seg_symboltable_intern_weak(state->table, name, length, &state->symbols[n]);
+    } else {
+      state->err = seg_symboltable_cintern(state->table, name, &state->symbols[n]);
+    }
+  }
+
+  return NULL;
+}
+
+static void test_image(void)
+{
+  seg_err err;
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/segment-symbols-%d.img", (int) getpid());
+
+  seg_runtime *writer = NULL;
+  err = seg_new_runtime(&writer);
+  SEG_ASSERT_OK(err);
+  seg_symboltable *written = seg_runtime_symboltable(writer);
+
+  seg_object first, weak;
+  err = seg_symboltable_cintern(written, "imaged_symbol_one", &first);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_cintern(written, "imaged_symbol_two", &first);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_intern_weak(written, "weak_symbol_name", 16, &weak);
+  SEG_ASSERT_OK(err);
+
+  err = seg_symboltable_write_image(written, path);
+  SEG_ASSERT_OK(err);
+  seg_delete_runtime(writer);
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  uint64_t init_count = seg_symboltable_count(table);
+
+  err = seg_symboltable_load_image(table, path);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_symboltable_image_count(table), 2);
+
+  /* Imaged symbols are found without being interned, and are proper, numbered symbols. */
+  seg_object one = seg_symboltable_get(table, "imaged_symbol_one", 17);
+  CU_ASSERT_FALSE(SEG_SAME(one, SEG_NO_SYMBOL));
+
+  seg_object klass;
+  err = seg_object_class(r, one, &klass);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(klass, seg_runtime_bootstraps(r)->symbol_class);
+
+  seg_object interned;
+  err = seg_symboltable_cintern(table, "imaged_symbol_one", &interned);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(interned, one);
+  CU_ASSERT_EQUAL(seg_symboltable_count(table), init_count);
+
+  uint32_t id;
+  err = seg_symboltable_id(table, one, &id);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(seg_symboltable_symbol(table, id), one);
+
+  char *contents;
+  uint64_t length;
+  seg_buffer_contents(&one, &contents, &length);
+  CU_ASSERT_EQUAL(length, 17);
+  CU_ASSERT_NSTRING_EQUAL(contents, "imaged_symbol_one", 17);
+
+  /* Weak symbols aren't saved. */
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "weak_symbol_name", 16), SEG_NO_SYMBOL);
+
+  /* Names missing from the image are interned into the table as usual. */
+  seg_object overflow;
+  err = seg_symboltable_cintern(table, "not_in_the_image", &overflow);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_symboltable_count(table), init_count + 1);
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "not_in_the_image", 16), overflow);
+
+  /* Images can't be loaded twice, or over interned symbols. */
+  err = seg_symboltable_load_image(table, path);
+  CU_ASSERT_PTR_NOT_NULL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_INVAL);
+
+  /* Rewriting a loaded image keeps its symbols and adds the new ones. */
+  err = seg_symboltable_write_image(table, path);
+  SEG_ASSERT_OK(err);
+  seg_delete_runtime(r);
+
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+  table = seg_runtime_symboltable(r);
+  err = seg_symboltable_load_image(table, path);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(seg_symboltable_image_count(table), 3);
+  CU_ASSERT_FALSE(SEG_SAME(seg_symboltable_get(table, "imaged_symbol_two", 17), SEG_NO_SYMBOL));
+  CU_ASSERT_FALSE(SEG_SAME(seg_symboltable_get(table, "not_in_the_image", 16), SEG_NO_SYMBOL));
+  seg_delete_runtime(r);
+
+  /* An index slot that points into the middle of a symbol is rejected. */
+  FILE *file = fopen(path, "r+b");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+  uint64_t slot_count, slots_offset;
+  fseek(file, 40, SEEK_SET);
+  CU_ASSERT_EQUAL(fread(&slot_count, sizeof(slot_count), 1, file), 1);
+  CU_ASSERT_EQUAL(fread(&slots_offset, sizeof(slots_offset), 1, file), 1);
+  for (uint64_t i = 0; i < slot_count; i++) {
+    uint32_t slot[2];
+    fseek(file, (long) (slots_offset + i * sizeof(slot)), SEEK_SET);
+    CU_ASSERT_EQUAL(fread(slot, sizeof(slot), 1, file), 1);
+    if (slot[1] != 0) {
+      slot[1] += 8;
+      fseek(file, (long) (slots_offset + i * sizeof(slot)), SEEK_SET);
+      fwrite(slot, sizeof(slot), 1, file);
+      break;
+    }
+  }
+  fclose(file);
+
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+  table = seg_runtime_symboltable(r);
+  err = seg_symboltable_load_image(table, path);
+  CU_ASSERT_PTR_NOT_NULL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_INVAL);
+  CU_ASSERT_EQUAL(seg_symboltable_image_count(table), 0);
+  seg_delete_runtime(r);
+
+  /* Truncated and foreign files are rejected. */
+  file = fopen(path, "r+b");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+  fwrite("NOTSYMS", 1, 8, file);
+  fclose(file);
+
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+  table = seg_runtime_symboltable(r);
+  err = seg_symboltable_load_image(table, path);
+  CU_ASSERT_PTR_NOT_NULL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_INVAL);
+
+  file = fopen(path, "wb");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+  fwrite("SEGSYMS", 1, 8, file);
+  fclose(file);
+
+  err = seg_symboltable_load_image(table, path);
+  CU_ASSERT_PTR_NOT_NULL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_INVAL);
+  CU_ASSERT_EQUAL(seg_symboltable_image_count(table), 0);
+  seg_delete_runtime(r);
+
+  remove(path);
+}
+
+static void test_concurrent_intern(void)
+{
+  seg_err err;
+  static char names[STRESS_NAMES][16];
+  static stress_state states[STRESS_THREADS];
+  pthread_t threads[STRESS_THREADS];
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  uint64_t init_count = seg_symboltable_count(table);
+
+  for (int i = 0; i < STRESS_NAMES; i++) {
+    snprintf(names[i], sizeof(names[i]), "stress%06d", i);
+  }
+
+  /* Each thread interns every name, starting at a different point, while the table grows. */
+  for (int t = 0; t < STRESS_THREADS; t++) {
+    states[t].table = table;
+    states[t].names = names;
+    states[t].offset = (t * STRESS_NAMES) / STRESS_THREADS;
+    states[t].weak = false;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&threads[t], NULL, stress_intern, &states[t]), 0);
+  }
+
+  for (int t = 0; t < STRESS_THREADS; t++) {
+    pthread_join(threads[t], NULL);
+    SEG_ASSERT_OK(states[t].err);
+  }
+
+  uint64_t count = seg_symboltable_count(table);
+  CU_ASSERT_EQUAL(count - init_count, STRESS_NAMES);
+
+  for (int i = 0; i < STRESS_NAMES; i++) {
+    seg_object canonical = seg_symboltable_get(table, names[i], strlen(names[i]));
+    CU_ASSERT_FALSE(SEG_SAME(canonical, SEG_NO_SYMBOL));
+
+    for (int t = 0; t < STRESS_THREADS; t++) {
+      SEG_ASSERT_SAME(states[t].symbols[i], canonical);
+    }
+
+    uint32_t id;
+    err = seg_symboltable_id(table, canonical, &id);
+    SEG_ASSERT_OK(err);
+    SEG_ASSERT_SAME(seg_symboltable_symbol(table, id), canonical);
+  }
+
+  seg_delete_runtime(r);
+}
+
+static void test_wellknown(void)
+{
+  seg_err err;
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  uint64_t init_count = seg_symboltable_count(table);
+
+  seg_object conv = seg_symboltable_wellknown(table, SEG_WK_STRINGCONV);
+  CU_ASSERT(! SEG_IS_IMMEDIATE(conv));
+
+  char *contents;
+  uint64_t length;
+  err = seg_buffer_contents(&conv, &contents, &length);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(length, 9);
+  CU_ASSERT_NSTRING_EQUAL(contents, "as_string", 9);
+
+  seg_object interned;
+  err = seg_symboltable_cintern(table, "as_string", &interned);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(interned, conv);
+
+  seg_object got = seg_symboltable_get(table, "as_string", 9);
+  SEG_ASSERT_SAME(got, conv);
+
+  seg_object ivars;
+  err = seg_symboltable_cintern(table, "instance_variables", &ivars);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(ivars, seg_symboltable_wellknown(table, SEG_WK_INSTANCE_VARIABLES));
+
+  /* Names that share a length and the bytes the perfect hash reads are still told apart. */
+  seg_object lookalike;
+  err = seg_symboltable_cintern(table, "asXstXing", &lookalike);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_DIFFERENT(lookalike, conv);
+
+  CU_ASSERT_EQUAL(seg_symboltable_count(table) - init_count, 1);
+
+  seg_delete_runtime(r);
+}
+
+static void test_ids(void)
+{
+  seg_err err;
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  uint32_t init_limit = seg_symboltable_id_limit(table);
+
+  seg_object a, b, shortsym;
+  uint32_t a_id, b_id, short_id, again_id;
+  err = seg_symboltable_cintern(table, "numbered_a", &a);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_cintern(table, "numbered_b", &b);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_cintern(table, "short", &shortsym);
+  SEG_ASSERT_OK(err);
+
+  err = seg_symboltable_id(table, a, &a_id);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_id(table, b, &b_id);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(a_id, init_limit);
+  CU_ASSERT_EQUAL(b_id, init_limit + 1);
+
+  /* Immediates are numbered the first time they're asked about, and keep that ID. */
+  err = seg_symboltable_id(table, shortsym, &short_id);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(short_id, init_limit + 2);
+  err = seg_symboltable_id(table, shortsym, &again_id);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(again_id, short_id);
+  CU_ASSERT_EQUAL(seg_symboltable_id_limit(table), init_limit + 3);
+
+  SEG_ASSERT_SAME(seg_symboltable_symbol(table, a_id), a);
+  SEG_ASSERT_SAME(seg_symboltable_symbol(table, b_id), b);
+  SEG_ASSERT_SAME(seg_symboltable_symbol(table, short_id), shortsym);
+  SEG_ASSERT_SAME(seg_symboltable_symbol(table, init_limit + 3), SEG_NO_SYMBOL);
+
+  uint32_t wellknown_id;
+  seg_object wellknown = seg_symboltable_wellknown(table, SEG_WK_STRINGINTERN);
+  err = seg_symboltable_id(table, wellknown, &wellknown_id);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(wellknown_id, SEG_WK_STRINGINTERN);
+
+  /* Symbols that were never interned have no ID. */
+  seg_object loose;
+  uint32_t loose_id;
+  err = seg_symbol(r, "not_interned", 12, &loose);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_id(table, loose, &loose_id);
+  CU_ASSERT_PTR_NOT_NULL(err);
+  CU_ASSERT_EQUAL(err->code, SEG_CODE_INVAL);
+  seg_delete_symbol(r, loose);
+
+  /* Enough symbols to fill several registry chunks. */
+  char name[32];
+  for (int i = 0; i < 1000; i++) {
+    seg_object sym;
+    uint32_t id;
+
+    snprintf(name, sizeof(name), "numbered_%d", i);
+    err = seg_symboltable_cintern(table, name, &sym);
+    SEG_ASSERT_OK(err);
+    err = seg_symboltable_id(table, sym, &id);
+    SEG_ASSERT_OK(err);
+    SEG_ASSERT_SAME(seg_symboltable_symbol(table, id), sym);
+  }
+
+  seg_delete_runtime(r);
+}
+
+static bool keep_one(seg_object symbol, void *state)
+{
+  return SEG_SAME(symbol, *(seg_object *) state);
+}
+
+static bool keep_none(seg_object symbol, void *state)
+{
+  return false;
+}
+
+static void test_weak(void)
+{
+  seg_err err;
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+  uint64_t init_count = seg_symboltable_count(table);
+
+  seg_symboltable_reclamation before;
+  seg_symboltable_reclamation_stats(table, &before);
+
+  seg_object dropped, kept, permanent, weakened, promoted;
+  err = seg_symboltable_intern_weak(table, "dropped_name", 12, &dropped);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_intern_weak(table, "kept_name_", 10, &kept);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_cintern(table, "permanent_name", &permanent);
+  SEG_ASSERT_OK(err);
+
+  /* Interning a weak symbol's name permanently promotes it. */
+  err = seg_symboltable_intern_weak(table, "promoted_name", 13, &weakened);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_cintern(table, "promoted_name", &promoted);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(weakened, promoted);
+
+  /* Interning a permanent symbol's name weakly doesn't demote it. */
+  seg_object again;
+  err = seg_symboltable_intern_weak(table, "permanent_name", 14, &again);
+  SEG_ASSERT_OK(err);
+  SEG_ASSERT_SAME(again, permanent);
+
+  seg_symboltable_reclamation counts;
+  seg_symboltable_reclamation_stats(table, &counts);
+  CU_ASSERT_EQUAL(counts.permanent - before.permanent, 2);
+  CU_ASSERT_EQUAL(counts.weak - before.weak, 2);
+
+  uint32_t dropped_id;
+  err = seg_symboltable_id(table, dropped, &dropped_id);
+  SEG_ASSERT_OK(err);
+
+  uint64_t reclaimed;
+  err = seg_symboltable_sweep(table, &keep_one, &kept, &reclaimed);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(reclaimed, 1);
+  CU_ASSERT_EQUAL(seg_symboltable_count(table) - init_count, 3);
+
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "dropped_name", 12), SEG_NO_SYMBOL);
+  SEG_ASSERT_SAME(seg_symboltable_symbol(table, dropped_id), SEG_NO_SYMBOL);
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "kept_name_", 10), kept);
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "permanent_name", 14), permanent);
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "promoted_name", 13), promoted);
+
+  seg_symboltable_reclamation_stats(table, &counts);
+  CU_ASSERT_EQUAL(counts.weak - before.weak, 1);
+  CU_ASSERT_EQUAL(counts.reclaimed - before.reclaimed, 1);
+  CU_ASSERT_EQUAL(counts.sweeps - before.sweeps, 1);
+
+  /* A reclaimed name is interned afresh, with a new ID. */
+  seg_object reborn;
+  uint32_t reborn_id;
+  err = seg_symboltable_intern_weak(table, "dropped_name", 12, &reborn);
+  SEG_ASSERT_OK(err);
+  err = seg_symboltable_id(table, reborn, &reborn_id);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_NOT_EQUAL(reborn_id, dropped_id);
+
+  err = seg_symboltable_sweep(table, &keep_none, NULL, &reclaimed);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(reclaimed, 2);
+  CU_ASSERT_EQUAL(seg_symboltable_count(table) - init_count, 2);
+  SEG_ASSERT_SAME(seg_symboltable_get(table, "promoted_name", 13), promoted);
+
+  seg_hashtable_stats stats;
+  seg_symboltable_stats(table, &stats);
+  CU_ASSERT_EQUAL(stats.slots - stats.empty_slots, stats.count);
+
+  seg_delete_runtime(r);
+}
+
+static void test_concurrent_promotion(void)
+{
+  seg_err err;
+  static char names[STRESS_NAMES][16];
+  static stress_state states[STRESS_THREADS];
+  pthread_t threads[STRESS_THREADS];
+
+  seg_runtime *r = NULL;
+  err = seg_new_runtime(&r);
+  SEG_ASSERT_OK(err);
+
+  seg_symboltable *table = seg_runtime_symboltable(r);
+
+  seg_symboltable_reclamation before;
+  seg_symboltable_reclamation_stats(table, &before);
+
+  for (int i = 0; i < STRESS_NAMES; i++) {
+    snprintf(names[i], sizeof(names[i]), "promote%06d", i);
+  }
+
+  /*
+   * Half of the threads intern every name weakly and half permanently. Every name ends up
+   * permanent.
+   */
+  for (int t = 0; t < STRESS_THREADS; t++) {
+    states[t].table = table;
+    states[t].names = names;
+    states[t].offset = (t * STRESS_NAMES) / STRESS_THREADS;
+    states[t].weak = t % 2 == 0;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&threads[t], NULL, stress_intern, &states[t]), 0);
+  }
+
+  for (int t = 0; t < STRESS_THREADS; t++) {
+    pthread_join(threads[t], NULL);
+    SEG_ASSERT_OK(states[t].err);
+  }
+
+  seg_symboltable_reclamation counts;
+  seg_symboltable_reclamation_stats(table, &counts);
+  CU_ASSERT_EQUAL(counts.permanent - before.permanent, STRESS_NAMES);
+  CU_ASSERT_EQUAL(counts.weak, before.weak);
+
+  uint64_t reclaimed;
+  err = seg_symboltable_sweep(table, &keep_none, NULL, &reclaimed);
+  SEG_ASSERT_OK(err);
+  CU_ASSERT_EQUAL(reclaimed, 0);
+
+  seg_delete_runtime(r);
+}
+
 CU_pSuite initialize_symboltable_suite(void)
 {
   CU_pSuite pSuite = CU_add_suite("symboltable", NULL, NULL);
@@ -108,6 +699,14 @@ CU_pSuite initialize_symboltable_suite(void)
   ADD_TEST(test_access);
   ADD_TEST(test_get);
   ADD_TEST(test_immediate);
+  ADD_TEST(test_stats);
+  ADD_TEST(test_cursor);
+  ADD_TEST(test_wellknown);
+  ADD_TEST(test_ids);
+  ADD_TEST(test_weak);
+  ADD_TEST(test_image);
+  ADD_TEST(test_concurrent_intern);
+  ADD_TEST(test_concurrent_promotion);
 
   return pSuite;
 }
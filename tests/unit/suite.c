@@ -3,15 +3,20 @@
 
 /* Forward declarations for unit test suites */
 
+CU_pSuite initialize_errors_suite(void);
+
+CU_pSuite initialize_hash_suite(void);
 CU_pSuite initialize_plugtable_suite(void);
 CU_pSuite initialize_ptrtable_suite(void);
 CU_pSuite initialize_stringtable_suite(void);
 
 CU_pSuite initialize_object_suite(void);
 CU_pSuite initialize_klass_suite(void);
+CU_pSuite initialize_integer_suite(void);
 
 CU_pSuite initialize_runtime_suite(void);
 CU_pSuite initialize_symboltable_suite(void);
+CU_pSuite initialize_gc_suite(void);
 
 #define ADD_SUITE(name) \
   if (name() == NULL) { \
@@ -25,15 +30,20 @@ int main(void)
     return CU_get_error();
   }
 
+  ADD_SUITE(initialize_errors_suite);
+
+  ADD_SUITE(initialize_hash_suite);
   ADD_SUITE(initialize_plugtable_suite);
   ADD_SUITE(initialize_ptrtable_suite);
   ADD_SUITE(initialize_stringtable_suite);
 
   ADD_SUITE(initialize_object_suite);
   ADD_SUITE(initialize_klass_suite);
+  ADD_SUITE(initialize_integer_suite);
 
   ADD_SUITE(initialize_runtime_suite);
   ADD_SUITE(initialize_symboltable_suite);
+  ADD_SUITE(initialize_gc_suite);
 
   CU_basic_set_mode(CU_BRM_VERBOSE);
   CU_basic_run_tests();
@@ -2,6 +2,7 @@
 #define UNIT
 
 #include <stdio.h>
+#include <stdbool.h>
 
 /**
  * Register the test function +name+ with CUnit.  Use within an
@@ -37,6 +38,12 @@
     } \
   } while(0)
 
+/*
+ * Make every malloc, calloc and realloc from segment's own objects fail until called again with
+ * `false`. Defined in errors_tests.c, alongside the allocation counters.
+ */
+void seg_test_fail_allocations(bool fail);
+
 #define SEG_ASSERT_TRY(expr) \
   do { \
     seg_err err = (expr); \
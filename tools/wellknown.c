@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "model/object.h"
+#include "runtime/wellknown.h"
+
+/*
+ * Generate src/runtime/wellknown_table.h: search for seg_wellknown_hash parameters that send every
+ * name in wellknown.def to its own slot, then write them out along with the slot table. The search
+ * is deterministic, so the same list always produces the same header.
+ */
+
+#define SEG_WELLKNOWN(ID, NAME) NAME,
+static const char *names[] = {
+#include "runtime/wellknown.def"
+};
+#undef SEG_WELLKNOWN
+
+#define SEG_WELLKNOWN(ID, NAME) #ID,
+static const char *identifiers[] = {
+#include "runtime/wellknown.def"
+};
+#undef SEG_WELLKNOWN
+
+/* Candidate multipliers tried at each table size before doubling it. */
+#define ATTEMPTS 1000000
+
+/* Give up rather than generate a table with more than this many slots per name. */
+#define MAX_SPREAD 8
+
+static int try_multiplier(uint32_t multiplier, unsigned shift, int8_t *slots, uint32_t slot_count)
+{
+  memset(slots, -1, slot_count);
+
+  for (int i = 0; i < SEG_WELLKNOWN_COUNT; i++) {
+    uint32_t h = seg_wellknown_hash(names[i], strlen(names[i]), multiplier, shift);
+    if (slots[h] != -1) {
+      return 0;
+    }
+    slots[h] = (int8_t) i;
+  }
+
+  return 1;
+}
+
+int main(void)
+{
+  int8_t slots[SEG_WELLKNOWN_COUNT * MAX_SPREAD * 2];
+
+  if (SEG_WELLKNOWN_COUNT > INT8_MAX) {
+    fprintf(stderr, "wellknown: Too many well-known symbols.\n");
+    return 1;
+  }
+
+  for (int i = 0; i < SEG_WELLKNOWN_COUNT; i++) {
+    if (SEG_STR_WILLBEIMM(strlen(names[i]))) {
+      fprintf(stderr, "wellknown: \"%s\" is short enough to be an immediate.\n", names[i]);
+      return 1;
+    }
+
+    for (int j = 0; j < i; j++) {
+      if (! strcmp(names[i], names[j])) {
+        fprintf(stderr, "wellknown: \"%s\" is listed twice.\n", names[i]);
+        return 1;
+      }
+    }
+  }
+
+  unsigned bits = 1;
+  while ((1u << bits) < SEG_WELLKNOWN_COUNT) {
+    bits++;
+  }
+
+  for (; (1u << bits) <= SEG_WELLKNOWN_COUNT * MAX_SPREAD; bits++) {
+    uint32_t slot_count = 1u << bits;
+    unsigned shift = 32 - bits;
+    uint32_t state = 2463534242u;
+
+    for (int attempt = 0; attempt < ATTEMPTS; attempt++) {
+      /* xorshift32, forced odd so that the multiplication doesn't discard low key bits. */
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      uint32_t multiplier = state | 1;
+
+      if (! try_multiplier(multiplier, shift, slots, slot_count)) {
+        continue;
+      }
+
+      printf("/* Generated by tools/wellknown.c from src/runtime/wellknown.def. Do not edit. */\n");
+      printf("\n");
+      printf("#define SEG_WELLKNOWN_MULTIPLIER 0x%08xu\n", multiplier);
+      printf("#define SEG_WELLKNOWN_SHIFT %u\n", shift);
+      printf("#define SEG_WELLKNOWN_SLOTS %u\n", slot_count);
+      printf("\n");
+      printf("static const int8_t seg_wellknown_slots[SEG_WELLKNOWN_SLOTS] = {\n");
+      for (uint32_t s = 0; s < slot_count; s++) {
+        if (slots[s] < 0) {
+          printf("  -1,\n");
+        } else {
+          printf("  %s,\n", identifiers[slots[s]]);
+        }
+      }
+      printf("};\n");
+      return 0;
+    }
+  }
+
+  fprintf(stderr, "wellknown: Unable to find a perfect hash. Mix more bytes into the hash.\n");
+  return 1;
+}